@@ -0,0 +1,30 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+
+/*	Converts a native message to the other byte order and back. The
+	conversion works in place, so it gets a copy; a message that went over
+	and back without an error has to be the one it started as.
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "byteswap.h"
+
+extern "C" int
+LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+	is_swapped_flat_message(data, size);
+
+	std::vector<uint8> message(data, data + size);
+	if(swap_flat_message(message.data(), message.size()) != B_OK)
+		return 0;
+	if(swap_flat_message(message.data(), message.size()) != B_OK)
+		abort();
+	if(memcmp(message.data(), data, size) != 0)
+		abort();
+	return 0;
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+
+/*	Walks every field and item of a native message the way the viewers
+	do, nested messages included, and touches every byte the reader hands
+	out so that the sanitizers see any read past the buffer.
+*/
+#include <TypeConstants.h>
+#include <string.h>
+
+#include "flatmessage.h"
+
+static const int32 kMaxDepth = 16;
+
+static uint32 sSink;
+
+static void
+walk_message(const uint8_t* data, size_t size, int32 depth)
+{
+	FlatMessageReader reader(data, size);
+	if(reader.InitCheck() != B_OK)
+		return;
+
+	reader.FlattenedSize();
+	for(int32 i = 0; i < reader.CountFields(); i++) {
+		flat_field_header field;
+		if(reader.FieldAt(i, &field) != B_OK)
+			continue;
+
+		const char* name = reader.FieldName(field);
+		if(name)
+			sSink += strlen(name);
+
+		const uint8* fieldData = reader.FieldData(field);
+		if(fieldData && field.data_size > 0)
+			sSink += fieldData[field.data_size - 1];
+
+		flat_item item;
+		for(status_t status = reader.FirstItem(field, &item); status == B_OK;
+				status = reader.NextItem(field, &item)) {
+			if(item.size > 0)
+				sSink += item.data[0] + item.data[item.size - 1];
+			if(field.type == B_MESSAGE_TYPE && depth < kMaxDepth)
+				walk_message(item.data, item.size, depth + 1);
+		}
+	}
+}
+
+extern "C" int
+LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+	walk_message(data, size, 0);
+	return 0;
+}
@@ -0,0 +1,25 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef _ALIGNMENT_H
+#define _ALIGNMENT_H
+
+enum alignment {
+	B_ALIGN_LEFT,
+	B_ALIGN_RIGHT,
+	B_ALIGN_CENTER,
+	B_ALIGN_HORIZONTAL_UNSET	= -1,
+	B_ALIGN_USE_FULL_WIDTH		= -2
+};
+
+enum vertical_alignment {
+	B_ALIGN_TOP					= 0x10,
+	B_ALIGN_MIDDLE				= 0x20,
+	B_ALIGN_BOTTOM				= 0x30,
+	B_ALIGN_VERTICAL_UNSET		= -1,
+	B_ALIGN_USE_FULL_HEIGHT		= -2
+};
+
+#endif /* _ALIGNMENT_H */
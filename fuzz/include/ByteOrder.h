@@ -0,0 +1,39 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef _BYTEORDER_H
+#define _BYTEORDER_H
+
+#include <SupportDefs.h>
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#	define B_HOST_IS_LENDIAN 1
+#	define B_HOST_IS_BENDIAN 0
+#else
+#	define B_HOST_IS_LENDIAN 0
+#	define B_HOST_IS_BENDIAN 1
+#endif
+
+#define B_SWAP_INT16(value)	((int16)__builtin_bswap16((uint16)(value)))
+#define B_SWAP_INT32(value)	((int32)__builtin_bswap32((uint32)(value)))
+#define B_SWAP_INT64(value)	((int64)__builtin_bswap64((uint64)(value)))
+
+#if B_HOST_IS_LENDIAN
+#	define B_HOST_TO_LENDIAN_INT32(value)	((uint32)(value))
+#	define B_HOST_TO_LENDIAN_INT64(value)	((uint64)(value))
+#	define B_HOST_TO_BENDIAN_INT32(value)	((uint32)B_SWAP_INT32(value))
+#	define B_HOST_TO_BENDIAN_INT64(value)	((uint64)B_SWAP_INT64(value))
+#else
+#	define B_HOST_TO_LENDIAN_INT32(value)	((uint32)B_SWAP_INT32(value))
+#	define B_HOST_TO_LENDIAN_INT64(value)	((uint64)B_SWAP_INT64(value))
+#	define B_HOST_TO_BENDIAN_INT32(value)	((uint32)(value))
+#	define B_HOST_TO_BENDIAN_INT64(value)	((uint64)(value))
+#endif
+#define B_LENDIAN_TO_HOST_INT32(value)	B_HOST_TO_LENDIAN_INT32(value)
+#define B_LENDIAN_TO_HOST_INT64(value)	B_HOST_TO_LENDIAN_INT64(value)
+#define B_BENDIAN_TO_HOST_INT32(value)	B_HOST_TO_BENDIAN_INT32(value)
+#define B_BENDIAN_TO_HOST_INT64(value)	B_HOST_TO_BENDIAN_INT64(value)
+
+#endif /* _BYTEORDER_H */
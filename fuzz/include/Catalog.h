@@ -0,0 +1,11 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef _CATALOG_H
+#define _CATALOG_H
+
+#define B_TRANSLATE(string)	(string)
+
+#endif /* _CATALOG_H */
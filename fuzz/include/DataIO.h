@@ -0,0 +1,30 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef _DATA_IO_H
+#define _DATA_IO_H
+
+#include <SupportDefs.h>
+
+class BDataIO {
+public:
+	virtual					~BDataIO() {}
+
+	virtual	ssize_t			Read(void* buffer, size_t size) = 0;
+	virtual	ssize_t			Write(const void* buffer, size_t size) = 0;
+
+			status_t		ReadExactly(void* buffer, size_t size)
+							{
+								return Read(buffer, size) == (ssize_t)size
+									? B_OK : B_IO_ERROR;
+							}
+			status_t		WriteExactly(const void* buffer, size_t size)
+							{
+								return Write(buffer, size) == (ssize_t)size
+									? B_OK : B_IO_ERROR;
+							}
+};
+
+#endif /* _DATA_IO_H */
@@ -0,0 +1,46 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef _DATE_TIME_H_
+#define _DATE_TIME_H_
+
+#include <SupportDefs.h>
+#include <string.h>
+#include <time.h>
+
+// Broken down in UTC, which is all a fuzz run needs
+class BDate {
+public:
+							BDate(const struct tm& time) : fTime(time) {}
+			int32			Year() const { return fTime.tm_year + 1900; }
+			int32			Month() const { return fTime.tm_mon + 1; }
+			int32			Day() const { return fTime.tm_mday; }
+private:
+			struct tm		fTime;
+};
+
+class BTime {
+public:
+							BTime(const struct tm& time) : fTime(time) {}
+			int32			Hour() const { return fTime.tm_hour; }
+			int32			Minute() const { return fTime.tm_min; }
+			int32			Second() const { return fTime.tm_sec; }
+private:
+			struct tm		fTime;
+};
+
+class BDateTime {
+public:
+							BDateTime() { memset(&fTime, 0, sizeof(fTime)); }
+			void			SetTime_t(time_t seconds)
+								{ if(!gmtime_r(&seconds, &fTime))
+									memset(&fTime, 0, sizeof(fTime)); }
+			BDate			Date() const { return BDate(fTime); }
+			BTime			Time() const { return BTime(fTime); }
+private:
+			struct tm		fTime;
+};
+
+#endif /* _DATE_TIME_H_ */
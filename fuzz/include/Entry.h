@@ -0,0 +1,34 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef _ENTRY_H
+#define _ENTRY_H
+
+#include <SupportDefs.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct entry_ref {
+							entry_ref() : device(0), directory(0), name(NULL) {}
+							entry_ref(const entry_ref& other)
+								: device(other.device), directory(other.directory),
+								  name(other.name ? strdup(other.name) : NULL) {}
+							~entry_ref() { free(name); }
+
+			entry_ref&		operator=(const entry_ref& other)
+								{ device = other.device;
+									directory = other.directory;
+									set_name(other.name); return *this; }
+			status_t		set_name(const char* newName)
+								{ free(name);
+									name = newName ? strdup(newName) : NULL;
+									return !newName || name ? B_OK : B_NO_MEMORY; }
+
+			dev_t			device;
+			ino_t			directory;
+			char*			name;
+};
+
+#endif /* _ENTRY_H */
@@ -0,0 +1,18 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef _GRAPHICS_DEFS_H
+#define _GRAPHICS_DEFS_H
+
+#include <SupportDefs.h>
+
+struct rgb_color {
+	uint8		red;
+	uint8		green;
+	uint8		blue;
+	uint8		alpha;
+};
+
+#endif /* _GRAPHICS_DEFS_H */
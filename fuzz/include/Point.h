@@ -0,0 +1,15 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef _POINT_H
+#define _POINT_H
+
+class BPoint {
+public:
+	float		x;
+	float		y;
+};
+
+#endif /* _POINT_H */
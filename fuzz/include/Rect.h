@@ -0,0 +1,17 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef _RECT_H
+#define _RECT_H
+
+class BRect {
+public:
+	float		left;
+	float		top;
+	float		right;
+	float		bottom;
+};
+
+#endif /* _RECT_H */
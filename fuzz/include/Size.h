@@ -0,0 +1,15 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef _SIZE_H
+#define _SIZE_H
+
+class BSize {
+public:
+	float		width;
+	float		height;
+};
+
+#endif /* _SIZE_H */
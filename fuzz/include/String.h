@@ -0,0 +1,82 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef _STRING_H_
+#define _STRING_H_
+
+#include <SupportDefs.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string>
+
+// The part of BString the item decoder formats its text with
+class BString {
+public:
+							BString() {}
+							BString(const char* string)
+								: fString(string ? string : "") {}
+							BString(const char* string, int32 length)
+								{ SetTo(string, length); }
+
+			const char*		String() const { return fString.c_str(); }
+			int32			Length() const { return fString.size(); }
+
+			BString&		SetTo(const char* string, int32 length)
+								{ fString.assign(string, length); return *this; }
+			BString&		Append(const char* string, int32 length)
+								{ fString.append(string, length); return *this; }
+			BString&		Truncate(int32 length)
+								{ if(length < Length()) fString.resize(length);
+									return *this; }
+			BString&		SetToFormat(const char* format, ...)
+								__attribute__((format(printf, 2, 3)));
+
+			BString&		operator=(const char* string)
+								{ fString = string ? string : ""; return *this; }
+			BString&		operator<<(const char* string)
+								{ fString += string ? string : ""; return *this; }
+			BString&		operator<<(const BString& string)
+								{ fString += string.fString; return *this; }
+			BString&		operator<<(char c) { fString += c; return *this; }
+			BString&		operator<<(int value) { return _Format("%d", value); }
+			BString&		operator<<(unsigned int value)
+								{ return _Format("%u", value); }
+			BString&		operator<<(long value) { return _Format("%ld", value); }
+			BString&		operator<<(unsigned long value)
+								{ return _Format("%lu", value); }
+			BString&		operator<<(long long value)
+								{ return _Format("%lld", value); }
+			BString&		operator<<(unsigned long long value)
+								{ return _Format("%llu", value); }
+			BString&		operator<<(float value)
+								{ return _Format("%.2f", value); }
+			BString&		operator<<(double value)
+								{ return _Format("%.2f", value); }
+private:
+	template<typename T>
+			BString&		_Format(const char* format, T value)
+								{ char text[64];
+									snprintf(text, sizeof(text), format, value);
+									fString += text; return *this; }
+
+			std::string		fString;
+};
+
+inline BString&
+BString::SetToFormat(const char* format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	int length = vsnprintf(NULL, 0, format, args);
+	va_end(args);
+
+	fString.resize(length > 0 ? length : 0);
+	va_start(args, format);
+	vsnprintf(&fString[0], fString.size() + 1, format, args);
+	va_end(args);
+	return *this;
+}
+
+#endif /* _STRING_H_ */
@@ -0,0 +1,77 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef _SUPPORT_DEFS_H
+#define _SUPPORT_DEFS_H
+
+/*	Just enough of the Haiku headers to build the message parsers on a
+	Linux host for fuzzing, see Makefile.fuzz. Only what the parsers use
+	is here; error codes keep their Haiku values.
+*/
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+typedef int8_t		int8;
+typedef uint8_t		uint8;
+typedef int16_t		int16;
+typedef uint16_t	uint16;
+typedef int32_t		int32;
+typedef uint32_t	uint32;
+typedef int64_t		int64;
+typedef uint64_t	uint64;
+
+typedef int32		status_t;
+typedef uint32		type_code;
+typedef int64		bigtime_t;
+typedef uintptr_t	addr_t;
+
+#define _PACKED			__attribute__((packed))
+
+#define B_PRId32		PRId32
+#define B_PRIu32		PRIu32
+#define B_PRIx32		PRIx32
+#define B_PRId64		PRId64
+#define B_PRIu64		PRIu64
+#define B_PRIdSSIZE		"zd"
+#define B_PRIdDEV		"ju"
+#define B_PRIdINO		"ju"
+
+#define B_GENERAL_ERROR_BASE	INT32_MIN
+#define B_APP_ERROR_BASE		(B_GENERAL_ERROR_BASE + 0x3000)
+#define B_STORAGE_ERROR_BASE	(B_GENERAL_ERROR_BASE + 0x6000)
+
+enum {
+	B_OK					= 0,
+	B_ERROR					= -1,
+	B_NO_MEMORY				= B_GENERAL_ERROR_BASE + 0,
+	B_IO_ERROR,
+	B_PERMISSION_DENIED,
+	B_BAD_INDEX,
+	B_BAD_TYPE,
+	B_BAD_VALUE,
+	B_MISMATCHED_VALUES,
+	B_NAME_NOT_FOUND,
+	B_NAME_IN_USE,
+	B_TIMED_OUT,
+	B_INTERRUPTED,
+	B_WOULD_BLOCK,
+	B_CANCELED,
+	B_NO_INIT,
+	B_BUSY,
+	B_NOT_ALLOWED,
+	B_BAD_DATA,
+	B_DONT_DO_THAT,
+
+	B_NOT_SUPPORTED			= B_GENERAL_ERROR_BASE + 0x1000 + 0x0f,
+	B_NOT_A_MESSAGE			= B_APP_ERROR_BASE + 0x10,
+	B_ENTRY_NOT_FOUND		= B_STORAGE_ERROR_BASE + 3,
+	B_NAME_TOO_LONG			= B_STORAGE_ERROR_BASE + 4
+};
+
+#include <TypeConstants.h>
+
+#endif /* _SUPPORT_DEFS_H */
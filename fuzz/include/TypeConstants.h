@@ -0,0 +1,47 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef _TYPE_CONSTANTS_H
+#define _TYPE_CONSTANTS_H
+
+enum {
+	B_AFFINE_TRANSFORM_TYPE		= 'AMTX',
+	B_ALIGNMENT_TYPE			= 'ALGN',
+	B_ANY_TYPE					= 'ANYT',
+	B_BOOL_TYPE					= 'BOOL',
+	B_CHAR_TYPE					= 'CHAR',
+	B_DOUBLE_TYPE				= 'DBLE',
+	B_FLOAT_TYPE				= 'FLOT',
+	B_INT16_TYPE				= 'SHRT',
+	B_INT32_TYPE				= 'LONG',
+	B_INT64_TYPE				= 'LLNG',
+	B_INT8_TYPE					= 'BYTE',
+	B_LARGE_ICON_TYPE			= 'ICON',
+	B_MESSAGE_TYPE				= 'MSGG',
+	B_MESSENGER_TYPE			= 'MSNG',
+	B_MIME_TYPE					= 'MIME',
+	B_MINI_ICON_TYPE			= 'MICN',
+	B_NETWORK_ADDRESS_TYPE		= 'NWAD',
+	B_NODE_REF_TYPE				= 'NREF',
+	B_OFF_T_TYPE				= 'OFFT',
+	B_POINTER_TYPE				= 'PNTR',
+	B_POINT_TYPE				= 'BPNT',
+	B_RAW_TYPE					= 'RAWT',
+	B_RECT_TYPE					= 'RECT',
+	B_REF_TYPE					= 'RREF',
+	B_RGB_COLOR_TYPE			= 'RGBC',
+	B_SIZE_TYPE					= 'SIZE',
+	B_SIZE_T_TYPE				= 'SIZT',
+	B_SSIZE_T_TYPE				= 'SSZT',
+	B_STRING_TYPE				= 'CSTR',
+	B_TIME_TYPE					= 'TIME',
+	B_UINT16_TYPE				= 'USHT',
+	B_UINT32_TYPE				= 'ULNG',
+	B_UINT64_TYPE				= 'ULLG',
+	B_UINT8_TYPE				= 'UBYT',
+	B_VECTOR_ICON_TYPE			= 'VICN'
+};
+
+#endif /* _TYPE_CONSTANTS_H */
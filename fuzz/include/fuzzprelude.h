@@ -0,0 +1,21 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef __FUZZ_PRELUDE_H__
+#define __FUZZ_PRELUDE_H__
+
+/*	Forced in front of every source of the fuzz build. gettype.h pulls in
+	the whole user interface through mainwindow.h, so its guard is set
+	here and the one function the item decoder needs from it declared
+	instead; stubs.cpp has the definition.
+*/
+#define __GET_TYPE__
+
+#include <String.h>
+#include <sys/socket.h>
+
+BString		NetAddressFamilyString(sa_family_t family);
+
+#endif /* __FUZZ_PRELUDE_H__ */
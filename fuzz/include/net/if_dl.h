@@ -0,0 +1,31 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef _NET_IF_DL_H
+#define _NET_IF_DL_H
+
+#include <SupportDefs.h>
+#include <sys/socket.h>
+
+// Link level address as on Haiku, but led by a family where the sockaddr
+// of the host has it; Linux has no sa_len
+struct sockaddr_dl {
+	sa_family_t	sdl_family;
+	uint16		sdl_e_type;
+	uint32		sdl_index;
+	uint8		sdl_type;
+	uint8		sdl_nlen;
+	uint8		sdl_alen;
+	uint8		sdl_slen;
+	uint8		sdl_data[46];
+};
+
+#define LLADDR(s)	((uint8*)((s)->sdl_data + (s)->sdl_nlen))
+
+#ifndef AF_LINK
+#	define AF_LINK	18
+#endif
+
+#endif /* _NET_IF_DL_H */
@@ -0,0 +1,44 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+
+/*	Runs one item through every decoder. The first byte picks the type,
+	so that the mutations are spent on the item rather than on finding a
+	type code the decoders know; the rest is the item as stored.
+*/
+#include <String.h>
+
+#include "itemdecoder.h"
+
+static const type_code kTypes[] = {
+	B_AFFINE_TRANSFORM_TYPE, B_ALIGNMENT_TYPE, B_BOOL_TYPE, B_CHAR_TYPE,
+	B_DOUBLE_TYPE, B_FLOAT_TYPE, B_INT8_TYPE, B_INT16_TYPE, B_INT32_TYPE,
+	B_INT64_TYPE, B_UINT8_TYPE, B_UINT16_TYPE, B_UINT32_TYPE, B_UINT64_TYPE,
+	B_OFF_T_TYPE, B_SIZE_T_TYPE, B_SSIZE_T_TYPE, B_TIME_TYPE, B_MIME_TYPE,
+	B_STRING_TYPE, B_NETWORK_ADDRESS_TYPE, B_NODE_REF_TYPE, B_REF_TYPE,
+	B_POINT_TYPE, B_RECT_TYPE, B_RGB_COLOR_TYPE, B_SIZE_TYPE, B_RAW_TYPE
+};
+
+extern "C" int
+LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+	if(size < 1)
+		return 0;
+
+	type_code type = kTypes[data[0] % (sizeof(kTypes) / sizeof(kTypes[0]))];
+	// Never NULL, an empty item is still found somewhere in its message
+	const uint8_t* item = data + 1;
+	ssize_t length = size - 1;
+
+	BString text;
+	decode_item(type, item, length, text);
+
+	entry_ref ref;
+	decode_ref(item, length, &ref);
+
+	double number;
+	decode_number(type, item, length, &number);
+	return 0;
+}
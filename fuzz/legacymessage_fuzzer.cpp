@@ -0,0 +1,36 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+
+/*	Upgrades R5 and Dano messages. Whatever the upgrader accepts has to
+	come out as a native message that FlatMessageReader takes as it is.
+*/
+#include <stdlib.h>
+#include <vector>
+
+#include "flatmessage.h"
+#include "legacymessage.h"
+
+extern "C" int
+LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+	uint32 what;
+	ssize_t length = flattened_message_size(data, size, &what);
+	if(!is_legacy_message(data, size))
+		return 0;
+
+	std::vector<uint8> output;
+	size_t used = 0;
+	if(upgrade_legacy_message(data, size, output, &used) != B_OK)
+		return 0;
+
+	FlatMessageReader reader(output.data(), output.size());
+	if(used > size || reader.InitCheck() != B_OK
+		|| reader.FlattenedSize() != output.size())
+		abort();
+	if(length > 0 && (size_t)length != used)
+		abort();
+	return 0;
+}
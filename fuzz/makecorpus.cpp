@@ -0,0 +1,623 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+
+/*	Writes the seed corpus of every fuzz target into the directory given,
+	one subdirectory per target:
+
+		makecorpus fuzz/corpus
+
+	Native messages come from FlatMessageWriter and are swapped with
+	swap_flat_message(), patches from create_message_delta(). One more is
+	laid out by hand as BMessage::Flatten() writes it and has to be read
+	back by FlatMessageReader, or no corpus is written. Nothing in Kottan
+	writes R5 or Dano messages, so those are laid out here by hand after
+	the layout legacymessage.cpp reads, in both byte orders.
+*/
+#include <ByteOrder.h>
+#include <TypeConstants.h>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <net/if_dl.h>
+#include <netinet/in.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+#include "byteswap.h"
+#include "flatmessage.h"
+#include "legacymessage.h"
+#include "messagedelta.h"
+
+typedef std::vector<uint8> buffer;
+
+static std::string sRoot;
+
+static bool
+write_seed(const char* target, const char* name, const buffer& data)
+{
+	std::string directory = sRoot + "/" + target;
+	if(mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+		perror(directory.c_str());
+		return false;
+	}
+
+	std::string path = directory + "/" + name;
+	FILE* file = fopen(path.c_str(), "wb");
+	if(!file) {
+		perror(path.c_str());
+		return false;
+	}
+	bool written = fwrite(data.data(), 1, data.size(), file) == data.size();
+	return fclose(file) == 0 && written;
+}
+
+// #pragma mark - Native messages
+
+static buffer
+flatten(const FlatMessageWriter& writer)
+{
+	buffer output;
+	writer.Flatten(output);
+	return output;
+}
+
+static buffer
+settings_message()
+{
+	FlatMessageWriter writer('sett');
+	float frame[4] = { 10, 20, 410, 320 };
+	writer.AddData("frame", B_RECT_TYPE, frame, sizeof(frame), true);
+	writer.AddData("title", B_STRING_TYPE, "Kottan", 7, false);
+	for(int32 i = 0; i < 3; i++)
+		writer.AddData("index", B_INT32_TYPE, &i, sizeof(i), true);
+	double volume = 0.75;
+	writer.AddData("volume", B_DOUBLE_TYPE, &volume, sizeof(volume), true);
+	bool enabled = true;
+	writer.AddData("enabled", B_BOOL_TYPE, &enabled, sizeof(enabled), true);
+	writer.AddData("recent", B_STRING_TYPE, "/boot/home/a", 13, false);
+	writer.AddData("recent", B_STRING_TYPE, "/boot/home/longer name", 23,
+		false);
+	return flatten(writer);
+}
+
+static buffer
+nested_message()
+{
+	FlatMessageWriter tab('tab ');
+	tab.AddData("label", B_STRING_TYPE, "first", 6, false);
+	int64 id = 42;
+	tab.AddData("id", B_INT64_TYPE, &id, sizeof(id), true);
+	buffer first = flatten(tab);
+
+	FlatMessageWriter inner('tab ');
+	inner.AddData("label", B_STRING_TYPE, "second", 7, false);
+	buffer second = flatten(inner);
+
+	FlatMessageWriter writer('wind');
+	writer.AddData("tab", B_MESSAGE_TYPE, first.data(), first.size(), false);
+	writer.AddData("tab", B_MESSAGE_TYPE, second.data(), second.size(), false);
+	uint8 color[4] = { 255, 128, 0, 255 };
+	writer.AddData("color", B_RGB_COLOR_TYPE, color, sizeof(color), true);
+	return flatten(writer);
+}
+
+static buffer
+numbers_message()
+{
+	FlatMessageWriter writer('nums');
+	for(int16 i = 0; i < 8; i++)
+		writer.AddData("short", B_INT16_TYPE, &i, sizeof(i), true);
+	for(uint64 i = 0; i < 4; i++) {
+		uint64 value = i << 40;
+		writer.AddData("large", B_UINT64_TYPE, &value, sizeof(value), true);
+	}
+	float point[2] = { 1.5f, -2 };
+	writer.AddData("where", B_POINT_TYPE, point, sizeof(point), true);
+	uint8 raw[5] = { 1, 2, 3, 4, 5 };
+	writer.AddData("raw", B_RAW_TYPE, raw, sizeof(raw), false);
+	return flatten(writer);
+}
+
+static buffer
+swapped(const buffer& message)
+{
+	buffer output(message);
+	swap_flat_message(output.data(), output.size());
+	return output;
+}
+
+// #pragma mark - As BMessage::Flatten() writes them
+
+static void
+put16(buffer& output, uint16 value)
+{
+	output.insert(output.end(), (const uint8*)&value,
+		(const uint8*)&value + sizeof(value));
+}
+
+static void
+put32(buffer& output, uint32 value)
+{
+	output.insert(output.end(), (const uint8*)&value,
+		(const uint8*)&value + sizeof(value));
+}
+
+// BMessage::_HashName()
+static uint32
+haiku_hash(const char* name)
+{
+	uint32 result = 0;
+	for(char c; (c = *name++) != 0;) {
+		result = (result << 7) ^ (result >> 24);
+		result ^= c;
+	}
+	return result ^ (result << 12);
+}
+
+/*	A message laid out word by word after Haiku's Message.cpp and
+	MessagePrivate.h, not through flat_message_header, as BMessage would
+	flatten AddString("name", "Kottan") and AddInt32("count", 3): the 68
+	byte header with the target after the flags, the field headers, then
+	each name followed by its items.
+*/
+static buffer
+haiku_message()
+{
+	const char* names[2] = { "name", "count" };
+	int32 table[kFlatHashTableSize] = { -1, -1, -1, -1, -1 };
+	int32 next[2] = { -1, -1 };
+	for(int32 i = 0; i < 2; i++) {
+		int32* link = &table[haiku_hash(names[i]) % kFlatHashTableSize];
+		while(*link >= 0)
+			link = &next[*link];
+		*link = i;
+	}
+
+	buffer output;
+	put32(output, 'HMF1');		// format
+	put32(output, 'KTTN');		// what
+	put32(output, 0x0001);		// flags, MESSAGE_FLAG_VALID
+	put32(output, -1);			// target, B_NULL_TOKEN
+	put32(output, -1);			// current_specifier
+	put32(output, -1);			// message_area
+	put32(output, -1);			// reply_port
+	put32(output, -1);			// reply_target
+	put32(output, -1);			// reply_team
+	put32(output, 5 + 4 + 7 + 6 + 4);	// data_size
+	put32(output, 2);			// field_count
+	put32(output, kFlatHashTableSize);
+	for(int32 i = 0; i < kFlatHashTableSize; i++)
+		put32(output, table[i]);
+
+	// FIELD_FLAG_VALID, strings are not of a fixed size
+	put16(output, 0x0001);
+	put16(output, 5);
+	put32(output, B_STRING_TYPE);
+	put32(output, 1);
+	put32(output, 4 + 7);
+	put32(output, 0);
+	put32(output, next[0]);
+
+	// FIELD_FLAG_VALID | FIELD_FLAG_FIXED_SIZE
+	put16(output, 0x0003);
+	put16(output, 6);
+	put32(output, B_INT32_TYPE);
+	put32(output, 1);
+	put32(output, 4);
+	put32(output, 5 + 4 + 7);
+	put32(output, next[1]);
+
+	output.insert(output.end(), "name", "name" + 5);
+	put32(output, 7);
+	output.insert(output.end(), "Kottan", "Kottan" + 7);
+	output.insert(output.end(), "count", "count" + 6);
+	put32(output, 3);
+	return output;
+}
+
+// The reader has to find in it what BMessage put there
+static bool
+reads_as_haiku(const buffer& message)
+{
+	FlatMessageReader reader(message.data(), message.size());
+	flat_field_header name;
+	flat_field_header count;
+	flat_item text;
+	flat_item number;
+	int32 value = 0;
+	bool ok = reader.InitCheck() == B_OK
+		&& reader.FlattenedSize() == message.size()
+		&& reader.Header().what == 'KTTN' && reader.CountFields() == 2
+		&& reader.FieldAt(0, &name) == B_OK
+		&& reader.FieldAt(1, &count) == B_OK
+		&& reader.FieldName(name) != NULL
+		&& strcmp(reader.FieldName(name), "name") == 0
+		&& reader.FirstItem(name, &text) == B_OK && text.size == 7
+		&& strcmp((const char*)text.data, "Kottan") == 0
+		&& reader.FirstItem(count, &number) == B_OK && number.size == 4;
+	if(ok)
+		memcpy(&value, number.data, sizeof(value));
+	if(!ok || value != 3) {
+		fprintf(stderr, "makecorpus: FlatMessageReader does not read a "
+			"message as BMessage flattens it\n");
+		return false;
+	}
+	return true;
+}
+
+// #pragma mark - Legacy messages
+
+class LegacyWriter {
+public:
+	LegacyWriter(bool swap) : fSwap(swap) {}
+
+	void Put8(uint8 value) { fData.push_back(value); }
+	void Put32(uint32 value)
+	{
+		if(fSwap)
+			value = B_SWAP_INT32(value);
+		Put(&value, sizeof(value));
+	}
+	void Put(const void* data, size_t size)
+	{
+		const uint8* bytes = static_cast<const uint8*>(data);
+		fData.insert(fData.end(), bytes, bytes + size);
+	}
+	void PadTo8(size_t start)
+	{
+		while((fData.size() - start) % 8 != 0)
+			fData.push_back(0);
+	}
+	void Set32(size_t offset, uint32 value)
+	{
+		if(fSwap)
+			value = B_SWAP_INT32(value);
+		memcpy(&fData[offset], &value, sizeof(value));
+	}
+
+	size_t Size() const { return fData.size(); }
+	const buffer& Data() const { return fData; }
+	bool Swap() const { return fSwap; }
+private:
+	buffer	fData;
+	bool	fSwap;
+};
+
+enum {
+	R5_FIELD_VALID		= 0x01,
+	R5_FIELD_MINI_DATA	= 0x02,
+	R5_FIELD_FIXED_SIZE	= 0x04,
+	R5_FIELD_SINGLE_ITEM = 0x08
+};
+
+static void
+r5_name(LegacyWriter& writer, const char* name)
+{
+	writer.Put8(strlen(name));
+	writer.Put(name, strlen(name));
+}
+
+static buffer
+r5_message(bool swap, const buffer* nested)
+{
+	LegacyWriter writer(swap);
+	writer.Put32(kR5MessageFormat);
+	writer.Put32(0);			// checksum, not checked
+	writer.Put32(0);			// size, set below
+	writer.Put32('r5ms');
+	writer.Put8(0);
+
+	// One int32 with its count and size in a byte each
+	int32 value = 1999;
+	writer.Put8(R5_FIELD_VALID | R5_FIELD_MINI_DATA | R5_FIELD_FIXED_SIZE
+		| R5_FIELD_SINGLE_ITEM);
+	writer.Put32(B_INT32_TYPE);
+	writer.Put8(sizeof(value));
+	r5_name(writer, "year");
+	writer.Put32(value);
+
+	// Three fixed size items
+	writer.Put8(R5_FIELD_VALID | R5_FIELD_FIXED_SIZE);
+	writer.Put32(B_INT32_TYPE);
+	writer.Put32(3);
+	writer.Put32(3 * sizeof(int32));
+	r5_name(writer, "list");
+	for(int32 i = 0; i < 3; i++)
+		writer.Put32(i * 100);
+
+	// Two strings, each behind its size and padded to 8 with it
+	const char* strings[] = { "BeOS", "R5 rules" };
+	writer.Put8(R5_FIELD_VALID);
+	writer.Put32(B_STRING_TYPE);
+	writer.Put32(2);
+	size_t sizeOffset = writer.Size();
+	writer.Put32(0);
+	r5_name(writer, "names");
+	size_t start = writer.Size();
+	for(int32 i = 0; i < 2; i++) {
+		writer.Put32(strlen(strings[i]) + 1);
+		writer.Put(strings[i], strlen(strings[i]) + 1);
+		if(i == 0)
+			writer.PadTo8(start);
+	}
+	writer.Set32(sizeOffset, writer.Size() - start);
+
+	if(nested) {
+		writer.Put8(R5_FIELD_VALID | R5_FIELD_SINGLE_ITEM);
+		writer.Put32(B_MESSAGE_TYPE);
+		writer.Put32(nested->size());
+		r5_name(writer, "nested");
+		writer.Put(nested->data(), nested->size());
+	}
+
+	writer.Put8(0);
+	writer.Set32(8, writer.Size());
+	return writer.Data();
+}
+
+// Type, count or size, the terminated name, the data from the next 8
+static size_t
+dano_section(LegacyWriter& writer, uint32 code, type_code type, uint32 value,
+	const char* name)
+{
+	size_t start = writer.Size();
+	writer.Put32(code);
+	writer.Put32(0);
+	writer.Put32(type);
+	writer.Put32(value);
+	writer.Put8(strlen(name));
+	writer.Put(name, strlen(name) + 1);
+	writer.PadTo8(start);
+	return start;
+}
+
+static void
+dano_end_section(LegacyWriter& writer, size_t start)
+{
+	writer.Set32(start + 4, writer.Size() - start);
+}
+
+static buffer
+dano_message(bool swap)
+{
+	LegacyWriter writer(swap);
+	writer.Put32(kDanoMessageFormat);
+	writer.Put32(0);			// size of the sections, set below
+	writer.Put32(kDanoMessageFormat);
+	writer.Put32(16);
+	writer.Put32('dano');
+	writer.Put32(0);
+
+	double value = 5.1;
+	size_t start = dano_section(writer, 'SGDa', B_DOUBLE_TYPE, sizeof(value),
+		"version");
+	uint64 bits;
+	memcpy(&bits, &value, sizeof(bits));
+	if(swap)
+		bits = B_SWAP_INT64(bits);
+	writer.Put(&bits, sizeof(bits));
+	dano_end_section(writer, start);
+
+	start = dano_section(writer, 'FADa', B_INT32_TYPE, sizeof(int32), "ids");
+	for(int32 i = 0; i < 4; i++)
+		writer.Put32(i + 7);
+	dano_end_section(writer, start);
+
+	// Items padded to 8, then the table of where each one ends
+	const char* strings[] = { "Dano", "was", "never released" };
+	start = dano_section(writer, 'VADa', B_STRING_TYPE, 3, "words");
+	size_t data = writer.Size();
+	std::vector<uint32> ends;
+	for(int32 i = 0; i < 3; i++) {
+		writer.Put(strings[i], strlen(strings[i]) + 1);
+		ends.push_back(writer.Size() - data);
+		writer.PadTo8(data);
+	}
+	for(size_t i = 0; i < ends.size(); i++)
+		writer.Put32(ends[i]);
+	dano_end_section(writer, start);
+
+	writer.Put32('DDEn');
+	writer.Put32(8);
+
+	writer.Set32(4, writer.Size() - 8);
+	return writer.Data();
+}
+
+// #pragma mark - Items and patches
+
+struct item_seed {
+	const char*	name;
+	type_code	type;
+	buffer		data;
+};
+
+static buffer
+bytes(const void* data, size_t size)
+{
+	const uint8* start = static_cast<const uint8*>(data);
+	return buffer(start, start + size);
+}
+
+// The index of the type in the table of itemdecoder_fuzzer.cpp comes first
+static const type_code kItemTypes[] = {
+	B_AFFINE_TRANSFORM_TYPE, B_ALIGNMENT_TYPE, B_BOOL_TYPE, B_CHAR_TYPE,
+	B_DOUBLE_TYPE, B_FLOAT_TYPE, B_INT8_TYPE, B_INT16_TYPE, B_INT32_TYPE,
+	B_INT64_TYPE, B_UINT8_TYPE, B_UINT16_TYPE, B_UINT32_TYPE, B_UINT64_TYPE,
+	B_OFF_T_TYPE, B_SIZE_T_TYPE, B_SSIZE_T_TYPE, B_TIME_TYPE, B_MIME_TYPE,
+	B_STRING_TYPE, B_NETWORK_ADDRESS_TYPE, B_NODE_REF_TYPE, B_REF_TYPE,
+	B_POINT_TYPE, B_RECT_TYPE, B_RGB_COLOR_TYPE, B_SIZE_TYPE, B_RAW_TYPE
+};
+
+static bool
+write_item(const char* name, type_code type, const buffer& item)
+{
+	uint8 index = 0;
+	while(kItemTypes[index] != type)
+		index++;
+
+	buffer seed(1, index);
+	seed.insert(seed.end(), item.begin(), item.end());
+	return write_seed("itemdecoder", name, seed);
+}
+
+static bool
+write_items()
+{
+	double transform[6] = { 1, 0, 0, 1, 10, 20 };
+	int32 alignment[2] = { 2, 0x20 };
+	int64 time = 1700000000;
+	int32 time32 = 1000000000;
+	float rect[4] = { 0, 0, 639, 479 };
+
+	// Addresses in the layout of the host, which the decoder reads
+	sockaddr_in ipv4 = {};
+	ipv4.sin_family = AF_INET;
+	ipv4.sin_port = htons(80);
+	ipv4.sin_addr.s_addr = htonl(0xc0a80101);
+
+	sockaddr_in6 ipv6 = {};
+	ipv6.sin6_family = AF_INET6;
+	ipv6.sin6_port = htons(443);
+	ipv6.sin6_addr.s6_addr[0] = 0x20;
+	ipv6.sin6_addr.s6_addr[1] = 0x01;
+	ipv6.sin6_addr.s6_addr[2] = 0x0d;
+	ipv6.sin6_addr.s6_addr[3] = 0xb8;
+	ipv6.sin6_addr.s6_addr[15] = 1;
+
+	sockaddr_dl link = {};
+	link.sdl_family = AF_LINK;
+	link.sdl_alen = 6;
+	uint8 mac[6] = { 0x00, 0x1b, 0x21, 0x3c, 0x4d, 0x5e };
+	memcpy(link.sdl_data, mac, sizeof(mac));
+
+	// Device and directory as wide as the host has them, then the name
+	dev_t device = 3;
+	ino_t directory = 10000;
+	buffer nodeRef = bytes(&device, sizeof(device));
+	buffer directoryBytes = bytes(&directory, sizeof(directory));
+	nodeRef.insert(nodeRef.end(), directoryBytes.begin(),
+		directoryBytes.end());
+	buffer ref(nodeRef);
+	buffer name = bytes("settings", 9);
+	ref.insert(ref.end(), name.begin(), name.end());
+
+	return write_item("affine", B_AFFINE_TRANSFORM_TYPE,
+			bytes(transform, sizeof(transform)))
+		&& write_item("alignment", B_ALIGNMENT_TYPE,
+			bytes(alignment, sizeof(alignment)))
+		&& write_item("double", B_DOUBLE_TYPE, bytes(transform + 4, 8))
+		&& write_item("int32", B_INT32_TYPE, bytes(&time32, 4))
+		&& write_item("time64", B_TIME_TYPE, bytes(&time, 8))
+		&& write_item("time32", B_TIME_TYPE, bytes(&time32, 4))
+		&& write_item("string", B_STRING_TYPE, bytes("text/plain", 11))
+		&& write_item("unterminated", B_MIME_TYPE, bytes("text", 4))
+		&& write_item("rect", B_RECT_TYPE, bytes(rect, sizeof(rect)))
+		&& write_item("ipv4", B_NETWORK_ADDRESS_TYPE,
+			bytes(&ipv4, sizeof(ipv4)))
+		&& write_item("ipv6", B_NETWORK_ADDRESS_TYPE,
+			bytes(&ipv6, sizeof(ipv6)))
+		&& write_item("link", B_NETWORK_ADDRESS_TYPE,
+			bytes(&link, offsetof(sockaddr_dl, sdl_data) + sizeof(mac)))
+		&& write_item("ref", B_REF_TYPE, ref)
+		&& write_item("noderef", B_NODE_REF_TYPE, nodeRef)
+		&& write_item("char", B_CHAR_TYPE, bytes("K", 1));
+}
+
+// The length of the base in host order, the base, then the rest
+static buffer
+framed(const buffer& base, const buffer& rest)
+{
+	uint32 size = base.size();
+	buffer seed = bytes(&size, sizeof(size));
+	seed.insert(seed.end(), base.begin(), base.end());
+	seed.insert(seed.end(), rest.begin(), rest.end());
+	return seed;
+}
+
+static bool
+write_patches(const buffer& base, const buffer& edited, const buffer& other)
+{
+	buffer delta;
+	buffer replaced;
+	if(create_message_delta(base.data(), base.size(), edited.data(),
+			edited.size(), delta) != B_OK)
+		return false;
+	if(create_message_delta(base.data(), base.size(), other.data(),
+			other.size(), replaced) != B_OK)
+		return false;
+
+	return write_seed("messagedelta", "patch", framed(base, delta))
+		&& write_seed("messagedelta", "replace", framed(base, replaced))
+		&& write_seed("messagedelta", "messages", framed(base, edited))
+		&& write_seed("messagedelta", "same", framed(base, base));
+}
+
+// #pragma mark -
+
+int
+main(int argc, char** argv)
+{
+	if(argc != 2) {
+		fprintf(stderr, "usage: makecorpus directory\n");
+		return 2;
+	}
+	sRoot = argv[1];
+	if(mkdir(sRoot.c_str(), 0755) != 0 && errno != EEXIST) {
+		perror(sRoot.c_str());
+		return 1;
+	}
+
+	buffer settings = settings_message();
+	buffer nested = nested_message();
+	buffer numbers = numbers_message();
+	buffer empty = flatten(FlatMessageWriter('none'));
+	buffer haiku = haiku_message();
+	if(!reads_as_haiku(haiku))
+		return 1;
+
+	// The base with one item changed and a field added
+	FlatMessageWriter editedWriter('sett');
+	float frame[4] = { 10, 20, 800, 600 };
+	editedWriter.AddData("frame", B_RECT_TYPE, frame, sizeof(frame), true);
+	editedWriter.AddData("title", B_STRING_TYPE, "Kottan", 7, false);
+	for(int32 i = 0; i < 3; i++)
+		editedWriter.AddData("index", B_INT32_TYPE, &i, sizeof(i), true);
+	editedWriter.AddData("added", B_STRING_TYPE, "new", 4, false);
+	buffer edited = flatten(editedWriter);
+
+	buffer r5 = r5_message(false, NULL);
+	buffer r5Nested = r5_message(false, &r5);
+	buffer r5Swapped = r5_message(true, NULL);
+	buffer dano = dano_message(false);
+	buffer danoSwapped = dano_message(true);
+
+	bool ok = write_seed("flatmessage", "settings", settings)
+		&& write_seed("flatmessage", "nested", nested)
+		&& write_seed("flatmessage", "numbers", numbers)
+		&& write_seed("flatmessage", "empty", empty)
+		&& write_seed("flatmessage", "swapped", swapped(nested))
+		&& write_seed("flatmessage", "haiku", haiku)
+		&& write_seed("byteswap", "haiku", haiku)
+		&& write_seed("messagedelta", "haiku", framed(haiku, settings))
+		&& write_seed("byteswap", "settings", settings)
+		&& write_seed("byteswap", "nested", nested)
+		&& write_seed("byteswap", "numbers", numbers)
+		&& write_seed("byteswap", "swapped-settings", swapped(settings))
+		&& write_seed("byteswap", "swapped-nested", swapped(nested))
+		&& write_seed("legacymessage", "r5", r5)
+		&& write_seed("legacymessage", "r5-nested", r5Nested)
+		&& write_seed("legacymessage", "r5-swapped", r5Swapped)
+		&& write_seed("legacymessage", "dano", dano)
+		&& write_seed("legacymessage", "dano-swapped", danoSwapped)
+		&& write_items()
+		&& write_patches(settings, edited, nested);
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+
+/*	Input: the length of the base as an uint32 in host order, the base,
+	then either a patch for it or a second message. Patches are applied
+	without checking the base so that the edits are reached at all. A
+	patch made between two messages has to turn the first into the second,
+	not byte for byte but field for field: the result is laid out anew.
+*/
+#include <TypeConstants.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "flatmessage.h"
+#include "messagedelta.h"
+
+static const int32 kMaxDepth = 64;
+
+static bool
+same_message(const uint8* a, size_t aSize, const uint8* b, size_t bSize,
+	int32 depth)
+{
+	FlatMessageReader first(a, aSize);
+	FlatMessageReader second(b, bSize);
+	if(first.InitCheck() != B_OK || second.InitCheck() != B_OK)
+		return first.InitCheck() == second.InitCheck() && aSize == bSize
+			&& memcmp(a, b, aSize) == 0;
+	if(first.Header().what != second.Header().what
+		|| first.CountFields() != second.CountFields())
+		return false;
+
+	for(int32 i = 0; i < first.CountFields(); i++) {
+		flat_field_header firstField;
+		flat_field_header secondField;
+		if(first.FieldAt(i, &firstField) != B_OK
+			|| second.FieldAt(i, &secondField) != B_OK
+			|| firstField.type != secondField.type
+			|| firstField.count != secondField.count)
+			return false;
+
+		const char* firstName = first.FieldName(firstField);
+		const char* secondName = second.FieldName(secondField);
+		if(firstName == NULL || secondName == NULL
+			? firstName != secondName : strcmp(firstName, secondName) != 0)
+			return false;
+
+		flat_item firstItem;
+		flat_item secondItem;
+		status_t firstStatus = first.FirstItem(firstField, &firstItem);
+		status_t secondStatus = second.FirstItem(secondField, &secondItem);
+		while(firstStatus == B_OK && secondStatus == B_OK) {
+			bool same = firstField.type == B_MESSAGE_TYPE && depth < kMaxDepth
+				? same_message(firstItem.data, firstItem.size,
+					secondItem.data, secondItem.size, depth + 1)
+				: firstItem.size == secondItem.size
+					&& memcmp(firstItem.data, secondItem.data,
+						firstItem.size) == 0;
+			if(!same)
+				return false;
+			firstStatus = first.NextItem(firstField, &firstItem);
+			secondStatus = second.NextItem(secondField, &secondItem);
+		}
+		if(firstStatus != secondStatus)
+			return false;
+	}
+	return true;
+}
+
+extern "C" int
+LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+	uint32 baseSize;
+	if(size < sizeof(baseSize))
+		return 0;
+	memcpy(&baseSize, data, sizeof(baseSize));
+	data += sizeof(baseSize);
+	size -= sizeof(baseSize);
+	if(baseSize > size)
+		return 0;
+
+	const uint8_t* base = data;
+	const uint8_t* rest = data + baseSize;
+	size_t restSize = size - baseSize;
+
+	std::vector<uint8> result;
+	if(is_message_delta(rest, restSize)) {
+		apply_message_delta(base, baseSize, rest, restSize, result, false);
+		return 0;
+	}
+
+	std::vector<uint8> delta;
+	if(create_message_delta(base, baseSize, rest, restSize, delta) != B_OK)
+		return 0;
+	if(apply_message_delta(base, baseSize, delta.data(), delta.size(),
+			result) != B_OK
+		|| !same_message(result.data(), result.size(), rest, restSize, 0))
+		abort();
+	return 0;
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+
+/*	Stands in for libFuzzer where there is none, as with GCC: every file
+	given, and every file in a directory given, is run through the fuzz
+	target once. Good for replaying a corpus or a crash under the
+	sanitizers.
+*/
+#include <dirent.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+static int
+run_file(const std::string& path)
+{
+	FILE* file = fopen(path.c_str(), "rb");
+	if(!file) {
+		perror(path.c_str());
+		return 1;
+	}
+
+	std::vector<uint8_t> data;
+	uint8_t buffer[65536];
+	size_t read;
+	while((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+		data.insert(data.end(), buffer, buffer + read);
+	fclose(file);
+
+	// An empty vector has no data, the target still gets a valid pointer
+	data.reserve(1);
+	LLVMFuzzerTestOneInput(data.data(), data.size());
+	return 0;
+}
+
+int
+main(int argc, char** argv)
+{
+	int failed = 0;
+	int count = 0;
+	for(int i = 1; i < argc; i++) {
+		struct stat st;
+		if(stat(argv[i], &st) == 0 && S_ISDIR(st.st_mode)) {
+			DIR* directory = opendir(argv[i]);
+			struct dirent* entry;
+			while(directory && (entry = readdir(directory)) != NULL) {
+				if(entry->d_name[0] == '.')
+					continue;
+				failed += run_file(std::string(argv[i]) + "/" + entry->d_name);
+				count++;
+			}
+			if(directory)
+				closedir(directory);
+		} else {
+			failed += run_file(argv[i]);
+			count++;
+		}
+	}
+
+	fprintf(stderr, "%s: %d inputs run\n", argv[0], count);
+	return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,16 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+
+// What the parsers need from the parts of Kottan the fuzz build leaves out
+#include <String.h>
+
+BString
+NetAddressFamilyString(sa_family_t family)
+{
+	BString text;
+	text << (int)family;
+	return text;
+}
@@ -5,18 +5,32 @@
  */
 
 #include "app.h"
+#include "bulkedit.h"
+#include "bulkeditwindow.h"
+#include "capturewindow.h"
+#include "checksum.h"
+#include "flatmessage.h"
+#include "gallerywindow.h"
+#include "iconcache.h"
 #include "importerwindow.h"
 #include "kottandefs.h"
 #include "mainwindow.h"
+#include "messagedelta.h"
 #include "datawindow.h"
 #include "editwindow.h"
 #include "msginfowindow.h"
+#include "refpathcache.h"
+#include "replaywindow.h"
+#include "searchindex.h"
+#include "sizeprofilewindow.h"
 #include "whatwindow.h"
 
 #include <AboutWindow.h>
+#include <Alert.h>
 #include <Catalog.h>
 #include <Resources.h>
 #include <AppFileInfo.h>
+#include <ByteOrder.h>
 #include <Path.h>
 #include <File.h>
 #include <IconUtils.h>
@@ -24,6 +38,7 @@
 #include <NodeMonitor.h>
 #include <Roster.h>
 #include <stdio.h>
+#include <vector>
 
 
 #undef B_TRANSLATION_CONTEXT
@@ -41,9 +56,26 @@ App::App()
 
 {
 	fDataMessage = new BMessage();
+	fHistory.Reset(*fDataMessage);
 	fMessageList = new BObjectList<IndexMessage>(20, false);
 	fMessageFile = new BFile();
 	fDataWindow = NULL;
+	fSearchIndex = NULL;
+	fRecordScanner = new RecordScanner(BMessenger(this));
+	fRecordScanGeneration = 0;
+	fRecordScan = RECORD_SCAN_NONE;
+	fCompareOnScan = false;
+	fSaveChecksum = false;
+	fSaveCompressed = false;
+	fSaveByteOrder = SAVE_BYTE_ORDER_AS_OPENED;
+	fFileSwapped = false;
+	fStreamMode = false;
+	fSelectedRecord = -1;
+
+	/* Shared caches, each filled by its own thread */
+	fRefPathCache = new RefPathCache();
+	fRefPathCache->Run();
+	fIconCache = new IconCache();
 
 	/* File panels stuff */
 	BPath userDirectoryPath;
@@ -70,6 +102,11 @@ App::~App()
 	if(fMainWindow && fMainWindow->IsLocked())
 		fMainWindow->Quit();
 
+	delete fSearchIndex;
+	delete fRecordScanner;
+	if (fRefPathCache->Lock())
+		fRefPathCache->Quit();
+	delete fIconCache;
 	delete fDataMessage;
 	delete fMessageFile;
 	delete fOpenPanel;
@@ -104,54 +141,31 @@ App::MessageReceived(BMessage *msg)
 
 			msg->FindRef("msgfile", &fMessageFileRef);
 
-			status_t fileopen_result = fMessageFile->SetTo(&fMessageFileRef, B_READ_ONLY);
+			stop_record_scan();
+			fStreamMode = false;
+			fSelectedRecord = -1;
 
-			BString error_text;
-			bool message_read_success = false;
+			status_t fileopen_result = OpenMessageFile();
 
 			if (fileopen_result == B_OK)
 			{
-				status_t unflatten_result = fDataMessage->Unflatten(fMessageFile);
-
-				if (unflatten_result == B_OK)
-				{
-					message_read_success=true;
-				}
-				else
-				{
-					error_text = B_TRANSLATE("Error reading the message from the file!");
-				}
-			}
-			else
-			{
-				error_text = B_TRANSLATE("Error opening the message file!");
-			}
-
-			BMessage open_reply_msg(MW_OPEN_REPLY);
-			open_reply_msg.AddBool("success", message_read_success);
-
-			if (message_read_success)
-			{
-				open_reply_msg.AddPointer("data_msg_pointer", fDataMessage);
-
-				// start watching the file for changes
-				BEntry entry(&fMessageFileRef);
-				node_ref nref;
-				entry.GetNodeRef(&nref);
-				watch_node(&nref, B_WATCH_STAT|B_WATCH_INTERIM_STAT, be_app_messenger);
-
-				// add the file path to set the title with it
-				BPath filePath;
-				entry.GetPath(&filePath);
-				open_reply_msg.AddString("filePath", filePath.Path());
-			}
-			else
-			{
-				open_reply_msg.AddString("error_text", error_text.String());
+				// files of messages written one after the other are
+				// shown record by record; the file is shown as soon as
+				// the scanner knows which kind it is
+				fRecordScanGeneration = fRecordScanner->Scan(fMessageFileRef,
+					true);
+				fRecordScan = RECORD_SCAN_OPEN;
+				break;
 			}
 
-			fMainWindow->PostMessage(&open_reply_msg);
+			finish_open(fileopen_result, B_OK);
+			break;
+		}
 
+		// a batch of records found by the record scanner
+		case RS_RECORDS:
+		{
+			records_scanned(msg);
 			break;
 		}
 
@@ -176,6 +190,7 @@ App::MessageReceived(BMessage *msg)
 										fSelectedName,
 										fSelectedType,
 								        fSelectedItemCount);
+			fDataWindow->SetFileSwapped(fFileSwapped);
 
 			fDataWindow->CenterIn(fMainWindow->Frame());
 			fDataWindow->MoveBy(0, 128);
@@ -206,6 +221,7 @@ App::MessageReceived(BMessage *msg)
 			if(view) {
 				if(!fSelectedName || strlen(fSelectedName) == 0)
 					fSelectedName = msg->GetString(KottanFieldName);
+				view->SetFileSwapped(fFileSwapped);
 				view->SetTo(dw_message, fSelectedName, fSelectedType, fSelectedItemCount);
 			}
 
@@ -253,8 +269,22 @@ App::MessageReceived(BMessage *msg)
 			if(msg->FindInt32(KottanFieldIndex, &field_index) == B_OK &&
 			msg->FindString(KottanFieldName, &field_name) == B_OK &&
 			msg->FindUInt32(KottanFieldType, static_cast<uint32*>(&field_type)) == B_OK) {
-				fDataMessage->RemoveData(field_name, field_index);
-				fMainWindow->PostMessage(MW_UPDATE_MESSAGEVIEW); // Update message view
+				// The item lives in the nested copy the data view was given
+				BMessage *target_message = fDataMessage;
+				if (fMessageList->CountItems() > 0)
+					target_message = fMessageList->FirstItem()->message;
+
+				BMessage change(MV_MESSAGE_CHANGED);
+				add_change_path(&change);
+				change.AddString("name", field_name);
+
+				target_message->RemoveData(field_name, field_index);
+				store_nested_messages();
+
+				change.AddInt32("change", target_message->HasData(field_name, field_type)
+					? MV_FIELD_COUNT_CHANGED : MV_FIELD_REMOVED);
+				record_change(&change);
+				fMainWindow->PostMessage(&change); // Update the affected rows
 				fMainWindow->PostMessage(MW_WAS_EDITED); // Mark title bar as "has pending changes"
 			}
 
@@ -281,28 +311,29 @@ App::MessageReceived(BMessage *msg)
 		{
 			fDataWindow->SetFeel(B_MODAL_APP_WINDOW_FEEL);
 
-			if (fMessageList->CountItems() > 0)
-			{
-				for( int32 i = 1; i < fMessageList->CountItems(); ++i)
-				{
-					fMessageList->ItemAt(i)->message->ReplaceMessage(
-														fMessageList->ItemAt(i-1)->field_name,
-														fMessageList->ItemAt(i-1)->field_index,
-														fMessageList->ItemAt(i-1)->message);
-				}
-
-				fDataMessage->ReplaceMessage(fMessageList->LastItem()->field_name,
-											fMessageList->LastItem()->field_index,
-											fMessageList->LastItem()->message);
-			}
+			store_nested_messages();
 
 			void* target = NULL;
 			if(msg->FindPointer("target", &target) == B_OK) {// Call to update views
 				static_cast<BWindow*>(target)->PostMessage(DW_UPDATE); // Either main window or a data window
+				if(target != fMainWindow)
+					fMainWindow->PostMessage(DW_UPDATE); // Refresh the cached sizes
 			}
 
-			if(msg->GetBool(KottanFlagCreate)) // If creation mode, update main msg view
-				fMainWindow->PostMessage(MW_UPDATE_MESSAGEVIEW);
+			if(msg->GetBool(KottanFlagCreate)) { // If creation mode, add the new field to the main msg view
+				BMessage change(MV_MESSAGE_CHANGED);
+				change.AddInt32("change", MV_FIELD_ADDED);
+				change.AddString("name", msg->GetString(KottanFieldName, ""));
+				record_change(&change);
+				fMainWindow->PostMessage(&change);
+			}
+			else {
+				BMessage change(MV_MESSAGE_CHANGED);
+				add_change_path(&change);
+				change.AddInt32("change", MV_FIELD_COUNT_CHANGED);
+				change.AddString("name", msg->GetString(KottanFieldName, ""));
+				record_change(&change);
+			}
 			fMainWindow->PostMessage(MW_WAS_EDITED); // Mark window title as modified
 			break;
 		}
@@ -318,13 +349,15 @@ App::MessageReceived(BMessage *msg)
 		// save message data to file
 		case MW_SAVE_MESSAGEFILE:
 		{
-			if(!HasFile()) {
+			// a record is never written over the stream it came from
+			if(!HasFile() || fStreamMode) {
 				PostMessage(MW_SAVE_MESSAGEFILE_AS);
 				break;
 			}
 
+			fContainer.Unset();
 			fMessageFile->SetTo(&fMessageFileRef, B_WRITE_ONLY|B_ERASE_FILE);
-			fDataMessage->Flatten(fMessageFile);
+			WriteMessageFile(fMessageFile);
 			fMainWindow->PostMessage(MW_WAS_SAVED);
 			break;
 		}
@@ -357,12 +390,21 @@ App::MessageReceived(BMessage *msg)
 				break;
 			}
 
-			status_t result = fDataMessage->Flatten(&newFile);
+			status_t result = WriteMessageFile(&newFile);
 			if(result == B_OK) { // On success...
 				// update data members
+				fContainer.Unset();
 				fMessageFile->Unset();
-				fMessageFile->SetTo(&directory, name.String(), B_READ_ONLY);
 				fileEntry.GetRef(&fMessageFileRef);
+				OpenMessageFile();
+
+				// the record saved on its own is the document now
+				if(fStreamMode) {
+					fStreamMode = false;
+					fSelectedRecord = -1;
+					stop_record_scan();
+					post_record_index(0, true, B_OK);
+				}
 
 				// update monitoring target
 				node_ref nref;
@@ -387,8 +429,14 @@ App::MessageReceived(BMessage *msg)
 			watch_node(&nref, B_STOP_WATCHING, be_app_messenger);
 
 			// Update data
+			fContainer.Unset();
 			fMessageFile->Unset();
+			stop_record_scan();
+			fStreamMode = false;
+			fSelectedRecord = -1;
 			fDataMessage->MakeEmpty();
+			fHistory.Reset(*fDataMessage);
+			post_history_state();
 
 			// Notify the window
 			BMessage reply(MW_CLOSE_REPLY);
@@ -403,20 +451,30 @@ App::MessageReceived(BMessage *msg)
 			int32 stat_changed_flags;
 			msg->FindInt32("fields", &stat_changed_flags);
 
-			// only compare messages when the file was modified
-			if ((stat_changed_flags & B_STAT_MODIFICATION_TIME) != 0)
+			// records appended to a stream are indexed as they come in;
+			// a single message that was appended to becomes a stream.
+			// The scanner does the reading, records_scanned() the rest
+			if ((stat_changed_flags
+					& (B_STAT_MODIFICATION_TIME | B_STAT_SIZE)) != 0)
 			{
-				BMessage *temp_msg = new BMessage();
-				fMessageFile->SetTo(&fMessageFileRef, B_READ_ONLY);
-				temp_msg->Unflatten(fMessageFile);
+				OpenMessageFile();
 
-				//only request reload if the data in the message has actually changed
-				if (!(temp_msg->HasSameData(*fDataMessage, false, true)))
+				if (fStreamMode)
 				{
-					fMainWindow->PostMessage(MW_CONFIRM_RELOAD);
+					fRecordScanGeneration = fRecordScanner->Scan(
+						fMessageFileRef, false);
+					fRecordScan = RECORD_SCAN_STREAM;
+				}
+				else
+				{
+					// only compare messages when the file was modified
+					fCompareOnScan = (fRecordScan == RECORD_SCAN_CHANGED
+							&& fCompareOnScan)
+						|| (stat_changed_flags & B_STAT_MODIFICATION_TIME) != 0;
+					fRecordScanGeneration = fRecordScanner->Scan(
+						fMessageFileRef, true);
+					fRecordScan = RECORD_SCAN_CHANGED;
 				}
-
-				delete temp_msg;
 			}
 
 			break;
@@ -425,16 +483,111 @@ App::MessageReceived(BMessage *msg)
 		// reload message data from file and update main and data window
 		case MW_RELOAD_FROM_FILE:
 		{
-			fMessageFile->SetTo(&fMessageFileRef, B_READ_ONLY);
-			fDataMessage->Unflatten(fMessageFile);
+			OpenMessageFile();
+			status_t integrity = B_ENTRY_NOT_FOUND;
+			if (fStreamMode)
+			{
+				BMessage record;
+				if (fRecordIndex.ReadRecord(MessageSource(), fSelectedRecord,
+						&record, &fFileSwapped) == B_OK)
+				{
+					*fDataMessage = record;
+				}
+			}
+			else
+			{
+				ReadMessageFile(MessageSource(), fDataMessage, &integrity,
+					&fFileSwapped);
+			}
+			fHistory.Reset(*fDataMessage);
+			post_history_state();
 
 			fMainWindow->PostMessage(MW_UPDATE_MESSAGEVIEW);
+			if (integrity == B_BAD_DATA)
+			{
+				BMessage warning(MW_INTEGRITY_WARNING);
+				fMainWindow->PostMessage(&warning);
+			}
+
+			if (fDataWindow != NULL)
+			{
+				fDataWindow->PostMessage(DW_UPDATE);
+			}
+
+			break;
+		}
+
+		// show another record of a message stream
+		case MW_SELECT_RECORD:
+		{
+			int32 index = msg->GetInt32("index", -1);
+			if (!fStreamMode || index == fSelectedRecord)
+				break;
+
+			BMessage record;
+			status_t status = fRecordIndex.ReadRecord(MessageSource(), index,
+				&record, &fFileSwapped);
+			if (status != B_OK)
+			{
+				BString text;
+				text.SetToFormat(B_TRANSLATE("Record %" B_PRId32
+					" could not be read: %s"), index, strerror(status));
+				(new BAlert("", text, B_TRANSLATE("OK"), NULL, NULL,
+					B_WIDTH_AS_USUAL, B_STOP_ALERT))->Go(NULL);
+				break;
+			}
 
+			*fDataMessage = record;
+			fSelectedRecord = index;
+			if (fMessageList->CountItems() > 0)
+				fMessageList->MakeEmpty();
+			fHistory.Reset(*fDataMessage);
+			post_history_state();
+
+			fMainWindow->PostMessage(MW_UPDATE_MESSAGEVIEW);
 			if (fDataWindow != NULL)
 			{
 				fDataWindow->PostMessage(DW_UPDATE);
 			}
+			break;
+		}
+
+		// Step through the edit history
+		case MW_UNDO:
+		case MW_REDO:
+		{
+			BMessage changes;
+			status_t status = msg->what == MW_UNDO
+				? fHistory.Undo(fDataMessage, &changes)
+				: fHistory.Redo(fDataMessage, &changes);
+			if(status != B_OK)
+				break;
+
+			// The nested copies being edited belong to the old version
+			if(fMessageList->CountItems() > 0)
+				fMessageList->MakeEmpty();
 
+			BMessage change;
+			for(int32 i = 0; changes.FindMessage("change", i, &change) == B_OK; i++) {
+				change.what = MV_MESSAGE_CHANGED;
+				change.AddInt32("change", change.GetBool("replaced")
+					? MV_SUBTREE_REPLACED : MV_FIELD_COUNT_CHANGED);
+				fMainWindow->PostMessage(&change);
+			}
+
+			fMainWindow->PostMessage(MW_WAS_EDITED);
+			post_history_state();
+			break;
+		}
+
+		// Search the current version of the document
+		case MW_FIND:
+		{
+			const char *query = msg->GetString("query", "");
+			BMessage reply(MW_FIND_REPLY);
+			reply.AddString("query", query);
+			fSearchIndex->Find(query, &reply);
+			fMainWindow->PostMessage(&reply);
 			break;
 		}
 
@@ -453,11 +606,65 @@ App::MessageReceived(BMessage *msg)
 			uint32 what = 0;
 			if(msg->FindUInt32("what", &what) == B_OK) {
 				fDataMessage->what = what;
+				BMessage change(MV_MESSAGE_CHANGED); // No fields changed, only the root
+				record_change(&change);
 				fMainWindow->PostMessage(MW_WAS_EDITED);
 			}
 			break;
 		}
 
+		// Applies a bulk edit to a numeric field as a single edit
+		case BCMD_APPLY_REQUESTED:
+		{
+			const char *name = msg->GetString(KottanFieldName, "");
+			type_code type = msg->GetUInt32(KottanFieldType, B_ANY_TYPE);
+
+			// The field lives in the nested copy the data view was given
+			BMessage *target_message = fDataMessage;
+			if (fMessageList->CountItems() > 0)
+				target_message = fMessageList->FirstItem()->message;
+
+			BMessage change(MV_MESSAGE_CHANGED);
+			add_change_path(&change);
+
+			status_t status;
+			type_code convert_to;
+			if (msg->FindUInt32("convert_to", &convert_to) == B_OK) {
+				status = bulk_convert_field(target_message, name, type, convert_to);
+				change.AddInt32("change", MV_SUBTREE_REPLACED);
+				type = convert_to;
+			} else {
+				status = bulk_edit_field(target_message, name, type,
+					msg->GetInt32("first", 0), msg->GetInt32("last", -1),
+					static_cast<bulk_operation>(msg->GetInt32("operation", BULK_SET)),
+					msg->GetDouble("first_value", 0), msg->GetDouble("second_value", 0));
+				change.AddInt32("change", MV_FIELD_COUNT_CHANGED);
+				change.AddString("name", name);
+			}
+
+			if (status != B_OK) {
+				BString text;
+				text.SetToFormat(B_TRANSLATE("The items could not be changed: %s"),
+					strerror(status));
+				(new BAlert("", text, B_TRANSLATE("OK"), NULL, NULL,
+					B_WIDTH_AS_USUAL, B_STOP_ALERT))->Go(NULL);
+				break;
+			}
+
+			store_nested_messages();
+			record_change(&change);
+			fMainWindow->PostMessage(&change); // Update the affected rows
+
+			BWindow *caller = (BWindow*)msg->GetPointer("window");
+			if (caller != NULL && caller != fMainWindow) {
+				BMessage update(DW_UPDATE);
+				update.AddUInt32(KottanFieldType, type);
+				caller->PostMessage(&update);
+			}
+			fMainWindow->PostMessage(MW_WAS_EDITED);
+			break;
+		}
+
 		// Deletes all the data members of the message
 		case MW_MESSAGE_MAKE_EMPTY:
 		{
@@ -466,7 +673,10 @@ App::MessageReceived(BMessage *msg)
 			if(fMessageList->CountItems() > 0)
 				fMessageList->MakeEmpty();
 
-			fMainWindow->PostMessage(MW_UPDATE_MESSAGEVIEW); // Update message view
+			BMessage change(MV_MESSAGE_CHANGED);
+			change.AddInt32("change", MV_SUBTREE_REPLACED);
+			record_change(&change);
+			fMainWindow->PostMessage(&change); // Update message view
 			fMainWindow->PostMessage(MW_WAS_EDITED); // Mark title bar as "has pending changes"
 			if(fDataWindow)
 				fDataWindow->Close();
@@ -476,12 +686,299 @@ App::MessageReceived(BMessage *msg)
 		// Called to open a message information dialog box of the current message
 		case MW_MESSAGE_INFORMATION:
 		{
-			MsgInfoWindow* window = new MsgInfoWindow(BRect(), fDataMessage);
+			BMessage report;
+			msg->FindMessage("allocation_report", &report);
+			MsgInfoWindow* window = new MsgInfoWindow(BRect(), fDataMessage, &report,
+				msg->GetInt64("flattened_size", -1));
 			window->CenterIn(fMainWindow->Frame());
 			window->Show();
 			break;
 		}
 
+		// Whether saved files get a checksum footer
+		case MW_SAVE_CHECKSUM:
+		{
+			fSaveChecksum = msg->GetBool("enabled", fSaveChecksum);
+			break;
+		}
+
+		// Whether saved files are written as a block container
+		case MW_SAVE_COMPRESSED:
+		{
+			fSaveCompressed = msg->GetBool("enabled", fSaveCompressed);
+			break;
+		}
+
+		// The schema file the window validates with, "" for none
+		case MW_VALIDATION_SCHEMA:
+		{
+			fValidationSchema = msg->GetString("path", "");
+			break;
+		}
+
+		// The changes since the file was opened or saved, as a patch
+		case MW_SAVE_PATCH:
+		{
+			BMessenger messenger(this);
+			ShowFilePanel(fSavePanel, &messenger,
+				new BMessage(MW_SAVE_PATCH_REQUESTED), fGenericFilter);
+			break;
+		}
+
+		case MW_SAVE_PATCH_REQUESTED:
+		{
+			entry_ref directoryRef;
+			BString name;
+			if (!HasFile() || msg->FindRef("directory", &directoryRef) != B_OK
+				|| msg->FindString("name", &name) != B_OK)
+				break;
+
+			// the version on disk is the base, flattened the way the
+			// current one is
+			BMessage base;
+			status_t status = OpenMessageFile();
+			if (status == B_OK)
+			{
+				status = fStreamMode
+					? fRecordIndex.ReadRecord(MessageSource(), fSelectedRecord,
+						&base)
+					: ReadMessageFile(MessageSource(), &base);
+			}
+
+			std::vector<uint8> baseFlat(base.FlattenedSize());
+			std::vector<uint8> resultFlat(fDataMessage->FlattenedSize());
+			std::vector<uint8> delta;
+			if (status == B_OK)
+				status = base.Flatten((char*)baseFlat.data(), baseFlat.size());
+			if (status == B_OK)
+			{
+				status = fDataMessage->Flatten((char*)resultFlat.data(),
+					resultFlat.size());
+			}
+			if (status == B_OK)
+			{
+				status = create_message_delta(baseFlat.data(), baseFlat.size(),
+					resultFlat.data(), resultFlat.size(), delta);
+			}
+
+			if (status == B_OK)
+			{
+				BDirectory directory(&directoryRef);
+				BFile file(&directory, name.String(),
+					B_WRITE_ONLY | B_CREATE_FILE | B_ERASE_FILE);
+				status = file.InitCheck();
+				if (status == B_OK)
+					status = file.WriteExactly(delta.data(), delta.size());
+			}
+
+			if (status != B_OK)
+			{
+				BString text;
+				text.SetToFormat(B_TRANSLATE("The patch could not be saved: %s"),
+					strerror(status));
+				(new BAlert("", text, B_TRANSLATE("OK"), NULL, NULL,
+					B_WIDTH_AS_USUAL, B_STOP_ALERT))->Go(NULL);
+			}
+			break;
+		}
+
+		case MW_APPLY_PATCH:
+		{
+			BMessenger messenger(this);
+			ShowFilePanel(fOpenPanel, &messenger,
+				new BMessage(MW_APPLY_PATCH_REQUESTED), fGenericFilter);
+			break;
+		}
+
+		// The patched message is one edit, it can be undone
+		case MW_APPLY_PATCH_REQUESTED:
+		{
+			entry_ref ref;
+			if (msg->FindRef("refs", &ref) != B_OK)
+				break;
+
+			BFile file(&ref, B_READ_ONLY);
+			off_t size = 0;
+			status_t status = file.InitCheck();
+			if (status == B_OK)
+				status = file.GetSize(&size);
+			std::vector<uint8> delta(size);
+			if (status == B_OK)
+				status = file.ReadExactly(delta.data(), size);
+
+			std::vector<uint8> current(fDataMessage->FlattenedSize());
+			std::vector<uint8> patched;
+			if (status == B_OK)
+			{
+				status = fDataMessage->Flatten((char*)current.data(),
+					current.size());
+			}
+			if (status == B_OK)
+			{
+				status = apply_message_delta(current.data(), current.size(),
+					delta.data(), delta.size(), patched);
+			}
+
+			BMessage result;
+			if (status == B_OK)
+				status = result.Unflatten((const char*)patched.data());
+
+			if (status != B_OK)
+			{
+				BString text;
+				if (status == B_MISMATCHED_VALUES)
+				{
+					text = B_TRANSLATE("The patch was made for another "
+						"version of the message.");
+				}
+				else
+				{
+					text.SetToFormat(B_TRANSLATE("The patch could not be "
+						"applied: %s"), strerror(status));
+				}
+				(new BAlert("", text, B_TRANSLATE("OK"), NULL, NULL,
+					B_WIDTH_AS_USUAL, B_STOP_ALERT))->Go(NULL);
+				break;
+			}
+
+			*fDataMessage = result;
+			if (fMessageList->CountItems() > 0)
+				fMessageList->MakeEmpty();
+
+			BMessage change(MV_MESSAGE_CHANGED);
+			change.AddInt32("change", MV_SUBTREE_REPLACED);
+			record_change(&change);
+			fMainWindow->PostMessage(&change);
+			fMainWindow->PostMessage(MW_WAS_EDITED);
+			break;
+		}
+
+		// Byte order of saved files, SAVE_BYTE_ORDER_*
+		case MW_SAVE_BYTE_ORDER:
+		{
+			fSaveByteOrder = msg->GetInt32("order", fSaveByteOrder);
+			break;
+		}
+
+		// Called to open the size profile of the file being edited
+		case MW_MESSAGE_SIZE_PROFILE:
+		{
+			if(!HasFile())
+				break;
+
+			SizeProfileWindow* window = new SizeProfileWindow(
+				BRect(0, 0, 720, 420), fMessageFileRef);
+			window->CenterIn(fMainWindow->Frame());
+			window->Show();
+			break;
+		}
+
+		// One gallery at a time, it follows the document
+		case MW_ICON_GALLERY:
+		{
+			if (fGalleryWindow.LockTarget())
+			{
+				BLooper *looper;
+				fGalleryWindow.Target(&looper);
+				static_cast<BWindow*>(looper)->Activate();
+				looper->Unlock();
+				break;
+			}
+
+			GalleryWindow* window = new GalleryWindow(BRect(0, 0, 640, 480),
+				fHistory.Current(), BMessenger(fMainWindow));
+			window->CenterIn(fMainWindow->Frame());
+			window->Show();
+			fGalleryWindow = BMessenger(window);
+			break;
+		}
+
+		// One capture at a time as well, it may run in the background
+		case MW_CAPTURE_WINDOW:
+		{
+			if (fCaptureWindow.LockTarget())
+			{
+				BLooper *looper;
+				fCaptureWindow.Target(&looper);
+				static_cast<BWindow*>(looper)->Activate();
+				looper->Unlock();
+				break;
+			}
+
+			CaptureWindow* window = new CaptureWindow(BRect(0, 0, 560, 480),
+				BMessenger(fMainWindow));
+			window->CenterIn(fMainWindow->Frame());
+			window->Show();
+			fCaptureWindow = BMessenger(window);
+			break;
+		}
+
+		// The open file is offered, another stream can be chosen
+		case MW_REPLAY_WINDOW:
+		{
+			if (fReplayWindow.LockTarget())
+			{
+				BLooper *looper;
+				fReplayWindow.Target(&looper);
+				static_cast<BWindow*>(looper)->Activate();
+				looper->Unlock();
+				break;
+			}
+
+			ReplayWindow* window = new ReplayWindow(BRect(0, 0, 480, 260),
+				HasFile() ? &fMessageFileRef : NULL);
+			window->CenterIn(fMainWindow->Frame());
+			window->Show();
+			fReplayWindow = BMessenger(window);
+			break;
+		}
+
+		// A captured message becomes the document, without a file
+		case MW_OPEN_CAPTURED_MESSAGE:
+		{
+			const void *data;
+			ssize_t size;
+			if (msg->FindData("data", B_RAW_TYPE, &data, &size) != B_OK)
+				break;
+
+			std::vector<uint8> flat(static_cast<const uint8*>(data),
+				static_cast<const uint8*>(data) + size);
+			BMessage record;
+			bool swapped = false;
+			status_t status = unflatten_record(flat, &record, &swapped);
+
+			BMessage open_reply_msg(MW_OPEN_REPLY);
+			open_reply_msg.AddBool("success", status == B_OK);
+			if (status != B_OK)
+			{
+				open_reply_msg.AddString("error_text",
+					B_TRANSLATE("Error reading the captured message!"));
+				fMainWindow->PostMessage(&open_reply_msg);
+				break;
+			}
+
+			stop_watching(be_app_messenger);
+			fContainer.Unset();
+			fMessageFile->Unset();
+			fMessageFileRef = entry_ref();
+			stop_record_scan();
+			fStreamMode = false;
+			fSelectedRecord = -1;
+			fFileSwapped = swapped;
+
+			*fDataMessage = record;
+			if (fMessageList->CountItems() > 0)
+				fMessageList->MakeEmpty();
+			fHistory.Reset(*fDataMessage);
+			post_history_state();
+			post_record_index(0, true, B_OK);
+
+			open_reply_msg.AddPointer("data_msg_pointer", fDataMessage);
+			open_reply_msg.AddString("name", msg->GetString("name", ""));
+			fMainWindow->PostMessage(&open_reply_msg);
+			break;
+		}
+
 		// Used by the importer dialog box to call an open panel
 		case IMP_OPEN_REQUESTED:
 		{
@@ -510,7 +1007,17 @@ App::MessageReceived(BMessage *msg)
 
 				status_t result = ImportMessage(&message, memberMode, data);
 				if(result == B_OK) { // Call to update UI on success
-					fMainWindow->PostMessage(MW_UPDATE_MESSAGEVIEW); // Update message view
+					BMessage change(MV_MESSAGE_CHANGED);
+					change.AddInt32("change", MV_FIELD_ADDED);
+					if(memberMode)
+						change.AddString("name", static_cast<const char*>(data));
+					else {
+						char* name;
+						for(int32 i = 0; message.GetInfo(B_ANY_TYPE, i, &name, NULL) == B_OK; i++)
+							change.AddString("name", name);
+					}
+					record_change(&change);
+					fMainWindow->PostMessage(&change); // Update the new rows only
 					fMainWindow->PostMessage(MW_WAS_EDITED); // Mark title bar as "has pending changes"
 				}
 			}
@@ -662,6 +1169,14 @@ App::QuitRequested()
 	BMessage settings_message;
 	settings_message.Unflatten(settings_file);
 	settings_message.ReplaceRect("mainwindow_frame", mainwindow_frame);
+	settings_message.RemoveName("save_checksum");
+	settings_message.AddBool("save_checksum", fSaveChecksum);
+	settings_message.RemoveName("save_compressed");
+	settings_message.AddBool("save_compressed", fSaveCompressed);
+	settings_message.RemoveName("save_byte_order");
+	settings_message.AddInt32("save_byte_order", fSaveByteOrder);
+	settings_message.RemoveName("validation_schema");
+	settings_message.AddString("validation_schema", fValidationSchema);
 	settings_file->Seek(0, SEEK_SET); //rewind file position to beginning
 	settings_message.Flatten(settings_file);
 
@@ -707,8 +1222,18 @@ App::ReadyToRun()
 		settings_message.Flatten(settings_file);
 	}
 
+	fSaveChecksum = settings_message.GetBool("save_checksum", false);
+	fSaveCompressed = settings_message.GetBool("save_compressed", false);
+	fSaveByteOrder = settings_message.GetInt32("save_byte_order",
+		SAVE_BYTE_ORDER_AS_OPENED);
+	fValidationSchema = settings_message.GetString("validation_schema", "");
+
 	// create and show main window
 	fMainWindow = new MainWindow(mainwindow_frame);
+	fMainWindow->SetSaveChecksum(fSaveChecksum);
+	fMainWindow->SetSaveCompressed(fSaveCompressed);
+	fMainWindow->SetSaveByteOrder(fSaveByteOrder);
+	fMainWindow->SetValidationSchema(fValidationSchema.String());
 
 	if (!frame_retrieved)
 	{
@@ -716,6 +1241,9 @@ App::ReadyToRun()
 	}
 	fMainWindow->Show();
 
+	fSearchIndex = new SearchIndex(BMessenger(fMainWindow));
+	fSearchIndex->SetTo(fHistory.Current());
+
 	fVisualWindow = new VisualWindow(BRect(), NULL, NULL);
 
 	delete settings_file;
@@ -755,6 +1283,175 @@ App::RefsReceived(BMessage *msg)
 }
 
 
+/*	Opens the file of fMessageFileRef for reading. A block container is
+	read through fContainer, MessageSource() tells which of the two to
+	read from.
+
+	ReadMessageFile() unflattens the whole message, so a container that
+	holds one is inflated completely on open. Only streams are read in
+	ranges: the record scanner reads the headers and ReadRecord() the one
+	record shown.
+*/
+status_t
+App::OpenMessageFile()
+{
+
+	fContainer.Unset();
+	status_t status = fMessageFile->SetTo(&fMessageFileRef, B_READ_ONLY);
+	if (status != B_OK)
+		return status;
+
+	status = fContainer.SetTo(fMessageFile);
+	return status == B_BAD_TYPE ? B_OK : status;
+}
+
+
+BPositionIO*
+App::MessageSource()
+{
+
+	if (fContainer.InitCheck() == B_OK)
+		return &fContainer;
+	return fMessageFile;
+}
+
+
+/*	Unflattens the message from the current position of the file. When
+	asked, the checksum footer that may follow it is verified too; see
+	ChecksumIO::VerifyFooter() for the values stored in integrity.
+	swapped tells whether the file was written on a host of the other
+	byte order.
+*/
+status_t
+App::ReadMessageFile(BPositionIO* file, BMessage* message, status_t* integrity,
+	bool* swapped)
+{
+
+	uint32 magic;
+	if (file->ReadAt(0, &magic, sizeof(magic)) != sizeof(magic))
+		magic = 0;
+
+	if (swapped != NULL)
+	{
+		*swapped = magic == kFlatMessageFormatSwapped
+			|| magic == (uint32)B_SWAP_INT32(kR5MessageFormat)
+			|| magic == (uint32)B_SWAP_INT32(kDanoMessageFormat);
+	}
+
+	// Turned around in memory; the footer covers the bytes as stored
+	if (is_swapped_flat_message(&magic, sizeof(magic)))
+	{
+		ChecksumIO stream(file);
+		flat_message_header header;
+		status_t status = stream.ReadExactly(&header, sizeof(header));
+		if (status != B_OK)
+			return status;
+
+		ssize_t size = flattened_message_size(&header, sizeof(header));
+		if (size < (ssize_t)sizeof(header))
+			return size < 0 ? (status_t)size : B_BAD_DATA;
+
+		std::vector<uint8> flat(size);
+		memcpy(flat.data(), &header, sizeof(header));
+		status = stream.ReadExactly(flat.data() + sizeof(header),
+			size - sizeof(header));
+		if (status == B_OK)
+			status = swap_flat_message(flat.data(), flat.size());
+		if (status == B_OK)
+			status = message->Unflatten((const char*)flat.data());
+		if (status == B_OK && integrity != NULL)
+			*integrity = stream.VerifyFooter();
+
+		return status;
+	}
+
+	// R5 and Dano files go through our own decoder, BMessage only reads
+	// some of their variants
+	if (is_legacy_message(&magic, sizeof(magic)))
+	{
+		off_t size;
+		status_t status = file->GetSize(&size);
+		if (status != B_OK)
+			return status;
+
+		std::vector<uint8> legacy(size);
+		if (file->ReadAt(0, legacy.data(), size) != size)
+			return B_IO_ERROR;
+
+		std::vector<uint8> upgraded;
+		status = upgrade_legacy_message(legacy.data(), legacy.size(),
+			upgraded);
+		if (status == B_OK)
+			status = message->Unflatten((const char*)upgraded.data());
+
+		// there was no checksum footer before Kottan
+		if (status == B_OK && integrity != NULL)
+			*integrity = B_ENTRY_NOT_FOUND;
+
+		return status;
+	}
+
+	ChecksumIO stream(file);
+	status_t status = message->Unflatten(&stream);
+	if (status == B_OK && integrity != NULL)
+	{
+		*integrity = stream.VerifyFooter();
+	}
+
+	return status;
+}
+
+
+status_t
+App::WriteMessageFile(BFile* file)
+{
+
+	bool swap = fFileSwapped;
+	if (fSaveByteOrder != SAVE_BYTE_ORDER_AS_OPENED)
+	{
+		swap = (fSaveByteOrder == SAVE_BYTE_ORDER_LITTLE)
+			!= (B_HOST_IS_LENDIAN != 0);
+	}
+
+	// the whole image is compressed at once, the footer included
+	BMallocIO image;
+	ChecksumIO stream(fSaveCompressed ? (BDataIO*)&image : file);
+	status_t status;
+	if (swap)
+	{
+		std::vector<uint8> flat(fDataMessage->FlattenedSize());
+		status = fDataMessage->Flatten((char*)flat.data(), flat.size());
+		if (status == B_OK)
+			status = swap_flat_message(flat.data(), flat.size());
+		if (status == B_OK)
+			status = stream.WriteExactly(flat.data(), flat.size());
+	}
+	else
+	{
+		status = fDataMessage->Flatten(&stream);
+	}
+
+	if (status == B_OK && fSaveChecksum)
+	{
+		status = stream.WriteFooter();
+	}
+
+	if (status == B_OK && fSaveCompressed)
+	{
+		status = write_block_container(file, image.Buffer(),
+			image.BufferLength());
+	}
+
+	// the file is in the new order now
+	if (status == B_OK)
+	{
+		fFileSwapped = swap;
+	}
+
+	return status;
+}
+
+
 void
 App::get_selection_data(BMessage *selection_path_message)
 {
@@ -813,6 +1510,310 @@ App::get_selection_data(BMessage *selection_path_message)
 
 }
 
+
+void
+App::store_nested_messages()
+{
+
+	// write the edited copies back into their parents, innermost first
+	if (fMessageList->CountItems() > 0)
+	{
+		for( int32 i = 1; i < fMessageList->CountItems(); ++i)
+		{
+			fMessageList->ItemAt(i)->message->ReplaceMessage(
+												fMessageList->ItemAt(i-1)->field_name,
+												fMessageList->ItemAt(i-1)->field_index,
+												fMessageList->ItemAt(i-1)->message);
+		}
+
+		fDataMessage->ReplaceMessage(fMessageList->LastItem()->field_name,
+									fMessageList->LastItem()->field_index,
+									fMessageList->LastItem()->message);
+	}
+
+}
+
+
+void
+App::record_change(const BMessage *change)
+{
+
+	fHistory.Record(*fDataMessage, *change,
+		change->GetInt32("change", -1) == MV_SUBTREE_REPLACED);
+	post_history_state();
+
+}
+
+
+void
+App::post_history_state()
+{
+
+	BMessage state(MW_HISTORY_STATE);
+	state.AddBool("can_undo", fHistory.CanUndo());
+	state.AddBool("can_redo", fHistory.CanRedo());
+	fMainWindow->PostMessage(&state);
+
+	// every new version passes through here, the index follows it
+	if (fSearchIndex != NULL)
+	{
+		fSearchIndex->SetTo(fHistory.Current());
+	}
+
+	if (fGalleryWindow.IsValid())
+	{
+		BMessage update(GW_SET_VERSION);
+		PersistentMessage *version = fHistory.Current();
+		version->AcquireReference();
+		update.AddPointer("version", version);
+		if (fGalleryWindow.SendMessage(&update) != B_OK)
+		{
+			version->ReleaseReference();
+		}
+	}
+
+}
+
+
+/*	Sends the records of the stream from first on to the main window;
+	with reset the window starts its list over. Files that are no stream
+	send an empty list.
+*/
+void
+App::post_record_index(int32 first, bool reset, status_t scanStatus)
+{
+
+	BMessage update(MW_RECORD_INDEX);
+	update.AddBool("reset", reset);
+	update.AddInt32("selected", fSelectedRecord);
+	update.AddInt32("status", scanStatus);
+
+	int32 count = fRecordIndex.CountRecords();
+	if (fStreamMode && first < count)
+	{
+		update.AddData("records", B_RAW_TYPE, fRecordIndex.Records() + first,
+			(count - first) * sizeof(message_record));
+	}
+
+	fMainWindow->PostMessage(&update);
+
+}
+
+
+/*	Shows the file just opened, or why it could not be. The first records
+	of a file opened fine are in fRecordIndex by now.
+*/
+void
+App::finish_open(status_t openStatus, status_t scanStatus)
+{
+
+	BString error_text;
+	bool message_read_success = false;
+	status_t integrity = B_ENTRY_NOT_FOUND;
+
+	if (openStatus == B_OK)
+	{
+		// streams are shown record by record, starting with the first
+		fStreamMode = fRecordIndex.CountRecords() > 1;
+		fSelectedRecord = fStreamMode ? 0 : -1;
+
+		status_t unflatten_result;
+		if (fStreamMode)
+		{
+			unflatten_result = fRecordIndex.ReadRecord(MessageSource(), 0,
+				fDataMessage, &fFileSwapped);
+		}
+		else
+		{
+			fRecordIndex.Unset();
+			unflatten_result = ReadMessageFile(MessageSource(),
+				fDataMessage, &integrity, &fFileSwapped);
+		}
+
+		if (unflatten_result == B_OK)
+		{
+			message_read_success=true;
+		}
+		else
+		{
+			error_text = B_TRANSLATE("Error reading the message from the file!");
+		}
+	}
+	else
+	{
+		error_text = B_TRANSLATE("Error opening the message file!");
+	}
+
+	BMessage open_reply_msg(MW_OPEN_REPLY);
+	open_reply_msg.AddBool("success", message_read_success);
+
+	if (message_read_success)
+	{
+		fHistory.Reset(*fDataMessage);
+		post_history_state();
+		post_record_index(0, true, scanStatus);
+
+		open_reply_msg.AddPointer("data_msg_pointer", fDataMessage);
+		open_reply_msg.AddInt32("integrity", integrity);
+
+		// start watching the file for changes
+		BEntry entry(&fMessageFileRef);
+		node_ref nref;
+		entry.GetNodeRef(&nref);
+		watch_node(&nref, B_WATCH_STAT|B_WATCH_INTERIM_STAT, be_app_messenger);
+
+		// add the file path to set the title with it
+		BPath filePath;
+		entry.GetPath(&filePath);
+		open_reply_msg.AddString("filePath", filePath.Path());
+	}
+	else
+	{
+		stop_record_scan();
+		open_reply_msg.AddString("error_text", error_text.String());
+	}
+
+	fMainWindow->PostMessage(&open_reply_msg);
+
+}
+
+
+/*	Takes over a batch of the record scanner into fRecordIndex and goes on
+	with whatever the scan was started for. Batches of scans that were
+	replaced or stopped meanwhile are dropped.
+*/
+void
+App::records_scanned(BMessage *batch)
+{
+
+	if (fRecordScan == RECORD_SCAN_NONE
+		|| batch->GetUInt32("generation", 0) != fRecordScanGeneration)
+		return;
+
+	bool reset = batch->GetBool("reset", false);
+	bool done = batch->GetBool("done", true);
+	status_t scan_result = batch->GetInt32("status", B_OK);
+
+	if (reset)
+	{
+		fRecordIndex.Unset();
+	}
+
+	int32 first = fRecordIndex.CountRecords();
+	const void* records;
+	ssize_t size;
+	if (batch->FindData("records", B_RAW_TYPE, &records, &size) == B_OK)
+	{
+		fRecordIndex.AddRecords(static_cast<const message_record*>(records),
+			size / sizeof(message_record), batch->GetInt64("scanned", 0));
+	}
+	int32 count = fRecordIndex.CountRecords();
+
+	// the first batch of a scan from the start holds two records, or
+	// all there are
+	if (reset && count < 2 && !done)
+		return;
+
+	switch (fRecordScan)
+	{
+		case RECORD_SCAN_OPEN:
+		{
+			fRecordScan = RECORD_SCAN_STREAM;
+			finish_open(B_OK, done ? scan_result : B_OK);
+			if (!fStreamMode)
+			{
+				fRecordScan = RECORD_SCAN_NONE;
+			}
+			break;
+		}
+
+		case RECORD_SCAN_CHANGED:
+		{
+			if (count > 1)
+			{
+				// the message shown is the first record now
+				fStreamMode = true;
+				fSelectedRecord = 0;
+				fRecordScan = RECORD_SCAN_STREAM;
+				post_record_index(0, true, scan_result);
+				break;
+			}
+
+			bool compare = fCompareOnScan;
+			stop_record_scan();
+			if (compare)
+			{
+				compare_with_file();
+			}
+			break;
+		}
+
+		case RECORD_SCAN_STREAM:
+		{
+			if (reset)
+			{
+				// the file was truncated or rewritten, the message
+				// shown is no longer known to be any of its records
+				fStreamMode = count > 1;
+				fSelectedRecord = -1;
+				post_record_index(0, true, scan_result);
+			}
+			else if (count > first || scan_result != B_OK)
+			{
+				post_record_index(first, false, scan_result);
+			}
+			break;
+		}
+	}
+
+}
+
+
+void
+App::stop_record_scan()
+{
+
+	fRecordScanner->Stop();
+	fRecordIndex.Unset();
+	fRecordScan = RECORD_SCAN_NONE;
+	fCompareOnScan = false;
+
+}
+
+
+// asks whether to reload when the message in the file is no longer the one shown
+void
+App::compare_with_file()
+{
+
+	BMessage *temp_msg = new BMessage();
+	OpenMessageFile();
+	ReadMessageFile(MessageSource(), temp_msg);
+
+	//only request reload if the data in the message has actually changed
+	if (!(temp_msg->HasSameData(*fDataMessage, false, true)))
+	{
+		fMainWindow->PostMessage(MW_CONFIRM_RELOAD);
+	}
+
+	delete temp_msg;
+
+}
+
+
+void
+App::add_change_path(BMessage *change)
+{
+
+	// from the root down to the nested message being edited
+	for (int32 i = fMessageList->CountItems() - 1; i >= 0; --i)
+	{
+		change->AddString("path", fMessageList->ItemAt(i)->field_name);
+		change->AddInt32("member", fMessageList->ItemAt(i)->field_index);
+	}
+
+}
+
 status_t
 App::ImportMessage(BMessage* msg, bool memberMode, [[maybe_unused]] const void* data)
 {
@@ -830,11 +1831,9 @@ App::ImportMessage(BMessage* msg, bool memberMode, [[maybe_unused]] const void*
 			for(int32 j = 0; j < countfound; j++) {
 				const void* data = NULL;
 				ssize_t length = 0;
-				msg->FindData(name, type, j, &data, &length);
-				unsigned char* buffer = new unsigned char[length];
-				memcpy(buffer, data, length);
-				fDataMessage->AddData(name, type, buffer, length);
-				delete[] buffer;
+				if(msg->FindData(name, type, j, &data, &length) != B_OK)
+					continue;
+				fDataMessage->AddData(name, type, data, length);
 			}
 		}
 	}
@@ -7,6 +7,11 @@
 #ifndef APP_H
 #define APP_H
 
+#include "blockcontainer.h"
+#include "byteswap.h"
+#include "edithistory.h"
+#include "legacymessage.h"
+#include "recordindex.h"
 #include "visualwindow.h"
 #include <Application.h>
 #include <FilePanel.h>
@@ -17,7 +22,10 @@
 
 
 class DataWindow;
+class IconCache;
 class MainWindow;
+class RefPathCache;
+class SearchIndex;
 
 extern const char* kAppName;
 extern BBitmap* trashIcon;
@@ -52,6 +60,15 @@ private:
 		if(file.InitCheck() != B_OK)
 			return false;
 
+		// Kottan reads these itself, BMessage may not
+		uint32 magic;
+		if(file.Read(&magic, sizeof(magic)) == sizeof(magic)
+			&& (is_legacy_message(&magic, sizeof(magic))
+				|| is_swapped_flat_message(&magic, sizeof(magic))
+				|| is_block_container(&magic, sizeof(magic))))
+			return true;
+		file.Seek(0, SEEK_SET);
+
 		BMessage* data = new BMessage;
 		if(!data) // It's not like the file is not a flattened message...
 			return false; // but there was a memory issue
@@ -63,6 +80,14 @@ private:
 	}
 };
 
+// What the batches of the record scanner are for
+enum {
+	RECORD_SCAN_NONE = 0,
+	RECORD_SCAN_OPEN,		// the file is shown once it is known to be a stream
+	RECORD_SCAN_CHANGED,	// a single message file changed on disk
+	RECORD_SCAN_STREAM		// records of a stream, appended or rescanned
+};
+
 class App : public BApplication {
 public:
 	App();
@@ -80,7 +105,22 @@ private:
 		void		FreeSharedResources();
 		static void LoadIcon(int32 id, BBitmap** outBitmap);
 
+		status_t	OpenMessageFile();
+		BPositionIO*	MessageSource();
+		status_t	ReadMessageFile(BPositionIO* file, BMessage* message,
+						status_t* integrity = NULL, bool* swapped = NULL);
+		status_t	WriteMessageFile(BFile* file);
 		void 		get_selection_data(BMessage *selection_path_message);
+		void		store_nested_messages();
+		void		add_change_path(BMessage *change);
+		void		record_change(const BMessage *change);
+		void		post_history_state();
+		void		post_record_index(int32 first, bool reset,
+						status_t scanStatus);
+		void		finish_open(status_t openStatus, status_t scanStatus);
+		void		records_scanned(BMessage *batch);
+		void		stop_record_scan();
+		void		compare_with_file();
 		status_t 	ImportMessage(BMessage* msg, bool memberMode,
 						[[maybe_unused]] const void* data);
 		void 		ShowFilePanel(BFilePanel* panel, BMessenger* target,
@@ -94,9 +134,29 @@ private:
 
 		BMessage					*fDataMessage;
 		BObjectList<IndexMessage>	*fMessageList;
+		EditHistory					fHistory;
+		SearchIndex					*fSearchIndex;
+		RefPathCache				*fRefPathCache;
+		IconCache					*fIconCache;
+		BMessenger					fGalleryWindow;
+		BMessenger					fCaptureWindow;
+		BMessenger					fReplayWindow;
 		BFile						*fMessageFile;
+		BlockContainerIO			fContainer;
 		entry_ref					fMessageFileRef;
 		BString						fSettingsFileName;
+		bool						fSaveChecksum;
+		bool						fSaveCompressed;
+		int32						fSaveByteOrder;
+		BString						fValidationSchema;
+		bool						fFileSwapped;
+		RecordIndex					fRecordIndex;
+		RecordScanner				*fRecordScanner;
+		uint32						fRecordScanGeneration;
+		int32						fRecordScan;
+		bool						fCompareOnScan;
+		bool						fStreamMode;
+		int32						fSelectedRecord;
 
 		GenericFileFilter			*fGenericFilter;
 		MessageFileFilter			*fMessageFilter;
@@ -0,0 +1,447 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#include <ByteOrder.h>
+#include <OS.h>
+#include <zlib.h>
+#include <algorithm>
+#include <cstring>
+
+#include "blockcontainer.h"
+#include "checksum.h"
+
+static const int32 kMaxWorkers = 16;
+static const int32 kBatchBlocks = 64;
+static const int32 kCachedBlocks = 4;
+static const uint32 kMaxBlockSize = 64 * 1024 * 1024;
+static const int kCompressionLevel = 6;
+
+// #pragma mark - Parallel jobs
+
+struct parallel_job {
+	status_t	(*work)(void* cookie, int32 index);
+	void*		cookie;
+	int32		next;
+	int32		count;
+	int32		status;
+};
+
+static status_t
+parallel_worker(void* data)
+{
+	parallel_job* job = static_cast<parallel_job*>(data);
+	int32 index;
+	while((index = atomic_add(&job->next, 1)) < job->count) {
+		status_t status = job->work(job->cookie, index);
+		if(status != B_OK)
+			atomic_test_and_set(&job->status, status, B_OK);
+	}
+	return B_OK;
+}
+
+// Calls work for every index, the calling thread being one of the workers
+static status_t
+run_parallel(status_t (*work)(void*, int32), void* cookie, int32 count)
+{
+	parallel_job job = { work, cookie, 0, count, B_OK };
+
+	int32 workers = 1;
+	system_info info;
+	if(get_system_info(&info) == B_OK)
+		workers = std::max(1, std::min(kMaxWorkers, (int32)info.cpu_count));
+	workers = std::min(workers, count);
+
+	std::vector<thread_id> threads;
+	for(int32 i = 1; i < workers; i++) {
+		thread_id thread = spawn_thread(parallel_worker, "container worker",
+			B_NORMAL_PRIORITY, &job);
+		if(thread < 0)
+			break;
+		resume_thread(thread);
+		threads.push_back(thread);
+	}
+
+	parallel_worker(&job);
+	for(size_t i = 0; i < threads.size(); i++) {
+		status_t result;
+		wait_for_thread(threads[i], &result);
+	}
+	return job.status;
+}
+
+// #pragma mark - Writing
+
+struct compress_job {
+	const uint8*	data;
+	size_t			size;
+	uint32			blockSize;
+	int32			first;
+	std::vector<std::vector<uint8> > packed;
+	std::vector<uint32> checksums;
+};
+
+// Blocks that would not get smaller are stored as they are
+static status_t
+compress_block(void* cookie, int32 index)
+{
+	compress_job* job = static_cast<compress_job*>(cookie);
+	size_t offset = (size_t)(job->first + index) * job->blockSize;
+	const uint8* block = job->data + offset;
+	size_t size = std::min((size_t)job->blockSize, job->size - offset);
+
+	std::vector<uint8>& packed = job->packed[index];
+	uLongf packedSize = compressBound(size);
+	packed.resize(packedSize);
+	if(compress2(packed.data(), &packedSize, block, size, kCompressionLevel)
+			!= Z_OK || packedSize >= size)
+		packed.assign(block, block + size);
+	else
+		packed.resize(packedSize);
+
+	job->checksums[index] = crc32c(0, block, size);
+	return B_OK;
+}
+
+bool
+is_block_container(const void* data, size_t size)
+{
+	uint32 magic;
+	if(size < sizeof(magic))
+		return false;
+	memcpy(&magic, data, sizeof(magic));
+	return B_LENDIAN_TO_HOST_INT32(magic) == kBlockContainerMagic;
+}
+
+status_t
+write_block_container(BPositionIO* file, const void* data, size_t size,
+	uint32 blockSize)
+{
+	if(blockSize == 0 || blockSize > kMaxBlockSize)
+		return B_BAD_VALUE;
+
+	block_container_header header;
+	memset(&header, 0, sizeof(header));
+	off_t offset = sizeof(header);
+	int32 count = (size + blockSize - 1) / blockSize;
+	std::vector<block_container_entry> index(count);
+
+	// In batches, so that only a few compressed blocks wait in memory
+	compress_job job;
+	job.data = static_cast<const uint8*>(data);
+	job.size = size;
+	job.blockSize = blockSize;
+	for(job.first = 0; job.first < count; job.first += kBatchBlocks) {
+		int32 batch = std::min(kBatchBlocks, count - job.first);
+		job.packed.assign(batch, std::vector<uint8>());
+		job.checksums.assign(batch, 0);
+		status_t status = run_parallel(compress_block, &job, batch);
+		if(status != B_OK)
+			return status;
+
+		for(int32 i = 0; i < batch; i++) {
+			const std::vector<uint8>& packed = job.packed[i];
+			ssize_t written = file->WriteAt(offset, packed.data(),
+				packed.size());
+			if(written != (ssize_t)packed.size())
+				return written < 0 ? written : B_IO_ERROR;
+
+			block_container_entry& entry = index[job.first + i];
+			entry.offset = B_HOST_TO_LENDIAN_INT64(offset);
+			entry.size = B_HOST_TO_LENDIAN_INT32(packed.size());
+			entry.checksum = B_HOST_TO_LENDIAN_INT32(job.checksums[i]);
+			offset += packed.size();
+		}
+	}
+
+	size_t indexSize = index.size() * sizeof(block_container_entry);
+	ssize_t written = file->WriteAt(offset, index.data(), indexSize);
+	if(written != (ssize_t)indexSize)
+		return written < 0 ? written : B_IO_ERROR;
+
+	// Last, so that a container cut short has no valid header
+	header.magic = B_HOST_TO_LENDIAN_INT32(kBlockContainerMagic);
+	header.block_size = B_HOST_TO_LENDIAN_INT32(blockSize);
+	header.block_count = B_HOST_TO_LENDIAN_INT32(count);
+	header.raw_size = B_HOST_TO_LENDIAN_INT64(size);
+	header.index_offset = B_HOST_TO_LENDIAN_INT64(offset);
+	written = file->WriteAt(0, &header, sizeof(header));
+	if(written != (ssize_t)sizeof(header))
+		return written < 0 ? written : B_IO_ERROR;
+	return file->SetSize(offset + indexSize);
+}
+
+// #pragma mark - BlockContainerIO
+
+struct decode_job {
+	BlockContainerIO* io;
+	int32			first;
+	uint8*			output;
+	uint32			blockSize;
+};
+
+BlockContainerIO::BlockContainerIO()
+: fFile(NULL),
+  fUseCount(0),
+  fPosition(0),
+  fDecoded(0),
+  fStatus(B_NO_INIT)
+{
+	memset(&fHeader, 0, sizeof(fHeader));
+}
+
+status_t
+BlockContainerIO::SetTo(BPositionIO* file)
+{
+	Unset();
+
+	block_container_header header;
+	if(file->ReadAt(0, &header, sizeof(header)) != sizeof(header)
+		|| !is_block_container(&header, sizeof(header)))
+		return fStatus = B_BAD_TYPE;
+
+	header.block_size = B_LENDIAN_TO_HOST_INT32(header.block_size);
+	header.block_count = B_LENDIAN_TO_HOST_INT32(header.block_count);
+	header.raw_size = B_LENDIAN_TO_HOST_INT64(header.raw_size);
+	header.index_offset = B_LENDIAN_TO_HOST_INT64(header.index_offset);
+
+	// Nothing read from the file is used before it was checked
+	off_t fileSize;
+	status_t status = file->GetSize(&fileSize);
+	if(status != B_OK)
+		return fStatus = status;
+	uint64 indexSize = (uint64)header.block_count
+		* sizeof(block_container_entry);
+	if(header.block_size == 0 || header.block_size > kMaxBlockSize
+		|| header.raw_size > (uint64)fileSize * 1024
+		|| (header.raw_size + header.block_size - 1) / header.block_size
+			!= header.block_count
+		|| header.index_offset < sizeof(header)
+		|| header.index_offset + indexSize != (uint64)fileSize)
+		return fStatus = B_BAD_DATA;
+
+	fIndex.resize(header.block_count);
+	if(file->ReadAt(header.index_offset, fIndex.data(), indexSize)
+			!= (ssize_t)indexSize) {
+		fIndex.clear();
+		return fStatus = B_IO_ERROR;
+	}
+	for(size_t i = 0; i < fIndex.size(); i++) {
+		block_container_entry& entry = fIndex[i];
+		entry.offset = B_LENDIAN_TO_HOST_INT64(entry.offset);
+		entry.size = B_LENDIAN_TO_HOST_INT32(entry.size);
+		entry.checksum = B_LENDIAN_TO_HOST_INT32(entry.checksum);
+		if(entry.offset < sizeof(header) || entry.size > header.index_offset
+			|| entry.offset > header.index_offset - entry.size) {
+			fIndex.clear();
+			return fStatus = B_BAD_DATA;
+		}
+	}
+
+	fFile = file;
+	fHeader = header;
+	return fStatus = B_OK;
+}
+
+void
+BlockContainerIO::Unset()
+{
+	fFile = NULL;
+	memset(&fHeader, 0, sizeof(fHeader));
+	fIndex.clear();
+	fCache.clear();
+	fPosition = 0;
+	fStatus = B_NO_INIT;
+}
+
+ssize_t
+BlockContainerIO::Read(void* buffer, size_t size)
+{
+	ssize_t bytesRead = ReadAt(fPosition, buffer, size);
+	if(bytesRead > 0)
+		fPosition += bytesRead;
+	return bytesRead;
+}
+
+ssize_t
+BlockContainerIO::ReadAt(off_t position, void* buffer, size_t size)
+{
+	if(fStatus != B_OK)
+		return fStatus;
+	if(position < 0)
+		return B_BAD_VALUE;
+	if((uint64)position >= fHeader.raw_size || size == 0)
+		return 0;
+	size = std::min((uint64)size, fHeader.raw_size - position);
+
+	uint8* output = static_cast<uint8*>(buffer);
+	uint64 blockSize = fHeader.block_size;
+	uint64 end = position + size;
+	int32 first = position / blockSize;
+	int32 last = (end - 1) / blockSize;
+
+	// The blocks read in full go straight to the buffer
+	int32 fullFirst = position % blockSize == 0 ? first : first + 1;
+	int32 fullLast = last * blockSize + _BlockSize(last) == end
+		? last : last - 1;
+	status_t status = B_OK;
+	if(fullFirst <= fullLast) {
+		status = _DecodeRange(fullFirst, fullLast,
+			output + (fullFirst * blockSize - position));
+		if(status != B_OK)
+			return status;
+	}
+
+	if(first < fullFirst) {
+		const uint8* block = _CachedBlock(first, &status);
+		if(block == NULL)
+			return status;
+		size_t offset = position - first * blockSize;
+		memcpy(output, block + offset,
+			std::min((uint64)size, blockSize - offset));
+	}
+	if(last > fullLast && (last != first || first == fullFirst)) {
+		const uint8* block = _CachedBlock(last, &status);
+		if(block == NULL)
+			return status;
+		memcpy(output + (last * blockSize - position), block,
+			end - last * blockSize);
+	}
+	return size;
+}
+
+ssize_t
+BlockContainerIO::Write(const void* buffer, size_t size)
+{
+	return B_NOT_ALLOWED;
+}
+
+ssize_t
+BlockContainerIO::WriteAt(off_t position, const void* buffer, size_t size)
+{
+	return B_NOT_ALLOWED;
+}
+
+off_t
+BlockContainerIO::Seek(off_t position, uint32 seekMode)
+{
+	switch(seekMode) {
+		case SEEK_SET:
+			break;
+		case SEEK_CUR:
+			position += fPosition;
+			break;
+		case SEEK_END:
+			position += fHeader.raw_size;
+			break;
+		default:
+			return B_BAD_VALUE;
+	}
+	if(position < 0)
+		return B_BAD_VALUE;
+
+	return fPosition = position;
+}
+
+status_t
+BlockContainerIO::SetSize(off_t size)
+{
+	return B_NOT_ALLOWED;
+}
+
+status_t
+BlockContainerIO::GetSize(off_t* size) const
+{
+	if(fStatus != B_OK)
+		return fStatus;
+
+	*size = fHeader.raw_size;
+	return B_OK;
+}
+
+// #pragma mark - BlockContainerIO::Private
+
+status_t
+BlockContainerIO::_DecodeJob(void* cookie, int32 index)
+{
+	decode_job* job = static_cast<decode_job*>(cookie);
+	return job->io->_Decode(job->first + index,
+		job->output + (size_t)index * job->blockSize);
+}
+
+size_t
+BlockContainerIO::_BlockSize(int32 index) const
+{
+	uint64 start = (uint64)index * fHeader.block_size;
+	return std::min((uint64)fHeader.block_size, fHeader.raw_size - start);
+}
+
+// Called from several threads at once, the file is only read with ReadAt()
+status_t
+BlockContainerIO::_Decode(int32 index, uint8* output)
+{
+	const block_container_entry& entry = fIndex[index];
+	size_t size = _BlockSize(index);
+
+	if(entry.size == size) {
+		if(fFile->ReadAt(entry.offset, output, size) != (ssize_t)size)
+			return B_IO_ERROR;
+	} else {
+		std::vector<uint8> packed(entry.size);
+		if(fFile->ReadAt(entry.offset, packed.data(), packed.size())
+				!= (ssize_t)packed.size())
+			return B_IO_ERROR;
+
+		uLongf unpackedSize = size;
+		if(uncompress(output, &unpackedSize, packed.data(), packed.size())
+				!= Z_OK || unpackedSize != size)
+			return B_BAD_DATA;
+	}
+
+	atomic_add64(&fDecoded, 1);
+	return crc32c(0, output, size) == entry.checksum ? B_OK : B_BAD_DATA;
+}
+
+status_t
+BlockContainerIO::_DecodeRange(int32 first, int32 last, uint8* output)
+{
+	if(first == last)
+		return _Decode(first, output);
+
+	decode_job job = { this, first, output, fHeader.block_size };
+	return run_parallel(_DecodeJob, &job, last - first + 1);
+}
+
+const uint8*
+BlockContainerIO::_CachedBlock(int32 index, status_t* status)
+{
+	for(size_t i = 0; i < fCache.size(); i++) {
+		if(fCache[i].index == index) {
+			fCache[i].used = ++fUseCount;
+			return fCache[i].data.data();
+		}
+	}
+
+	// The one used longest ago makes room
+	size_t slot = fCache.size();
+	if(slot == (size_t)kCachedBlocks) {
+		slot = 0;
+		for(size_t i = 1; i < fCache.size(); i++) {
+			if(fCache[i].used < fCache[slot].used)
+				slot = i;
+		}
+	} else
+		fCache.resize(slot + 1);
+
+	cached_block& block = fCache[slot];
+	block.data.resize(_BlockSize(index));
+	*status = _Decode(index, block.data.data());
+	if(*status != B_OK) {
+		fCache.erase(fCache.begin() + slot);
+		return NULL;
+	}
+	block.index = index;
+	block.used = ++fUseCount;
+	return block.data.data();
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef __BLOCK_CONTAINER_H__
+#define __BLOCK_CONTAINER_H__
+
+#include <DataIO.h>
+#include <SupportDefs.h>
+#include <vector>
+
+static const uint32 kBlockContainerMagic = 'KBZ1';
+static const uint32 kDefaultContainerBlockSize = 128 * 1024;
+
+/*	Compressed file of a flattened message, or of anything else. The bytes
+	are cut into blocks of block_size that are deflated on their own, so
+	any of them can be read without the ones before. The index of the
+	blocks follows the last one. Stored little endian.
+*/
+struct block_container_header {
+	uint32		magic;
+	uint32		block_size;		// uncompressed, the last block may be short
+	uint32		block_count;
+	uint32		flags;			// none yet
+	uint64		raw_size;
+	uint64		index_offset;
+} _PACKED;
+
+struct block_container_entry {
+	uint64		offset;
+	uint32		size;			// as stored, the block size when uncompressed
+	uint32		checksum;		// CRC32C of the uncompressed bytes
+} _PACKED;
+
+bool		is_block_container(const void* data, size_t size);
+
+// Compresses the blocks on every CPU, at most a few dozen at a time
+status_t	write_block_container(BPositionIO* file, const void* data,
+				size_t size, uint32 blockSize = kDefaultContainerBlockSize);
+
+/*	The uncompressed bytes of a container, read-only. A read inflates the
+	blocks it covers and no others; the whole ones are inflated straight
+	into the caller's buffer, in parallel when there are several, and the
+	ends of partly read ones are kept for the reads that usually follow.
+
+	Only stream files benefit from this in the app, where the record
+	index reads headers and single records. A container holding one
+	message is inflated whole when it is opened, as the message is
+	unflattened at once, and the size profiler inflates it whole as well.
+*/
+class BlockContainerIO : public BPositionIO
+{
+public:
+							BlockContainerIO();
+
+			// B_BAD_TYPE when the file is no container. Not owned.
+			status_t		SetTo(BPositionIO* file);
+			void			Unset();
+			status_t		InitCheck() const { return fStatus; }
+
+	virtual	ssize_t			Read(void* buffer, size_t size);
+	virtual	ssize_t			ReadAt(off_t position, void* buffer, size_t size);
+	virtual	ssize_t			Write(const void* buffer, size_t size);
+	virtual	ssize_t			WriteAt(off_t position, const void* buffer,
+								size_t size);
+	virtual	off_t			Seek(off_t position, uint32 seekMode);
+	virtual	off_t			Position() const { return fPosition; }
+	virtual	status_t		SetSize(off_t size);
+	virtual	status_t		GetSize(off_t* size) const;
+
+			int32			CountBlocks() const { return fIndex.size(); }
+			// Blocks inflated so far, the same one counted every time
+			int64			BlocksDecoded() const { return fDecoded; }
+private:
+	struct cached_block {
+		int32			index;
+		uint32			used;
+		std::vector<uint8> data;
+	};
+
+	static	status_t		_DecodeJob(void* cookie, int32 index);
+
+			size_t			_BlockSize(int32 index) const;
+			status_t		_Decode(int32 index, uint8* output);
+			status_t		_DecodeRange(int32 first, int32 last,
+								uint8* output);
+			const uint8*	_CachedBlock(int32 index, status_t* status);
+private:
+			BPositionIO*	fFile;
+			block_container_header fHeader;
+	std::vector<block_container_entry> fIndex;
+	std::vector<cached_block> fCache;
+			uint32			fUseCount;
+			off_t			fPosition;
+			int64			fDecoded;
+			status_t		fStatus;
+};
+
+#endif /* __BLOCK_CONTAINER_H__ */
@@ -0,0 +1,428 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#include <cstring>
+#include <limits>
+#include <vector>
+#include "bulkedit.h"
+#include "numericitem.h"
+
+// #pragma mark - Kernels
+
+// Converts a double parameter, or a result worked out in long double,
+// without overflowing the item type
+template<typename T, typename F>
+static T
+saturate(F value)
+{
+	typedef std::numeric_limits<T> limits;
+	if(value != value)
+		return limits::is_integer ? 0 : static_cast<T>(value);
+	if(value <= static_cast<F>(limits::lowest()))
+		return limits::lowest();
+	if(value >= static_cast<F>(limits::max()))
+		return limits::max();
+	return static_cast<T>(value);
+}
+
+// Adds to an integer item, stopping at the ends of its range. The room
+// to either end always fits an uint64, whatever the type.
+template<typename T>
+static T
+add_saturated(T value, double amount)
+{
+	typedef std::numeric_limits<T> limits;
+	if(amount >= 0) {
+		uint64 room = static_cast<uint64>(limits::max())
+			- static_cast<uint64>(value);
+		uint64 step = saturate<uint64>(amount);
+		return step >= room ? limits::max()
+			: static_cast<T>(static_cast<uint64>(value) + step);
+	}
+
+	uint64 room = static_cast<uint64>(value)
+		- static_cast<uint64>(limits::lowest());
+	uint64 step = saturate<uint64>(-amount);
+	return step >= room ? limits::lowest()
+		: static_cast<T>(static_cast<uint64>(value) - step);
+}
+
+// Integer items that would leave their range under the vector kernels:
+// sums are clamped and products and sequences are worked out in long
+// double, which holds any 64 bit integer exactly, then rounded toward
+// zero and saturated, so a factor of 0.5 halves the items instead of
+// being truncated to 0 first
+template<typename T>
+static void
+apply_integer_items(T* items, size_t count, bulk_operation operation,
+	double a, double b)
+{
+	switch(operation) {
+		case BULK_ADD:
+			for(size_t i = 0; i < count; i++)
+				items[i] = add_saturated(items[i], a);
+			break;
+		case BULK_SCALE:
+			for(size_t i = 0; i < count; i++) {
+				items[i] = saturate<T>(static_cast<long double>(items[i])
+					* static_cast<long double>(a));
+			}
+			break;
+		case BULK_SEQUENCE:
+			for(size_t i = 0; i < count; i++) {
+				items[i] = saturate<T>(static_cast<long double>(a)
+					+ static_cast<long double>(i) * b);
+			}
+			break;
+		default:
+			break;
+	}
+}
+
+template<typename From, typename To>
+static To
+convert_item(From value)
+{
+	typedef std::numeric_limits<From> from;
+	typedef std::numeric_limits<To> to;
+	if(!from::is_integer || !to::is_integer)
+		return saturate<To>(static_cast<double>(value));
+
+	// Integer to integer: exact when it fits, saturated otherwise
+	if(from::is_signed && value < 0) {
+		if(!to::is_signed)
+			return 0;
+		if(static_cast<int64>(value) < static_cast<int64>(to::min()))
+			return to::min();
+	} else if(static_cast<uint64>(value) > static_cast<uint64>(to::max()))
+		return to::max();
+	return static_cast<To>(value);
+}
+
+// Runs kernel over whole vectors; the tail goes through the same kernel in
+// a zero padded vector, so there is only one version of every operation
+template<typename T, typename Kernel>
+static void
+run_kernel(T* items, size_t count, const Kernel& kernel)
+{
+	typedef typename Vector<T>::type vector;
+	const size_t lanes = Vector<T>::kLanes;
+
+	size_t i = 0;
+	for(; i + lanes <= count; i += lanes) {
+		vector v;
+		memcpy(&v, items + i, sizeof(v));
+		v = kernel(v, i);
+		memcpy(items + i, &v, sizeof(v));
+	}
+
+	if(i < count) {
+		vector v = vector();
+		memcpy(&v, items + i, (count - i) * sizeof(T));
+		v = kernel(v, i);
+		memcpy(items + i, &v, (count - i) * sizeof(T));
+	}
+}
+
+template<typename T>
+static void
+apply_items(T* items, size_t count, bulk_operation operation, double a,
+	double b)
+{
+	if(std::numeric_limits<T>::is_integer && operation != BULK_SET
+		&& operation != BULK_CLAMP) {
+		apply_integer_items(items, count, operation, a, b);
+		return;
+	}
+
+	typedef typename Vector<T>::type vector;
+	const vector first = vector() + saturate<T>(a);
+	const vector second = vector() + saturate<T>(b);
+
+	switch(operation) {
+		case BULK_SET:
+			run_kernel(items, count, [&](vector, size_t) { return first; });
+			break;
+		case BULK_ADD:
+			run_kernel(items, count,
+				[&](vector v, size_t) { return v + first; });
+			break;
+		case BULK_SCALE:
+			run_kernel(items, count,
+				[&](vector v, size_t) { return v * first; });
+			break;
+		case BULK_CLAMP:
+			run_kernel(items, count, [&](vector v, size_t) {
+				v = v < first ? first : v;
+				return v > second ? second : v;
+			});
+			break;
+		case BULK_SEQUENCE:
+		{
+			vector lane;
+			for(size_t i = 0; i < Vector<T>::kLanes; i++)
+				lane[i] = static_cast<T>(i);
+			run_kernel(items, count, [&](vector, size_t position) {
+				return first + (lane + static_cast<T>(position)) * second;
+			});
+			break;
+		}
+	}
+}
+
+static status_t
+apply_storage(item_storage storage, void* items, size_t count,
+	bulk_operation operation, double a, double b)
+{
+	switch(storage) {
+		case STORAGE_INT8:
+			apply_items(static_cast<int8*>(items), count, operation, a, b);
+			break;
+		case STORAGE_INT16:
+			apply_items(static_cast<int16*>(items), count, operation, a, b);
+			break;
+		case STORAGE_INT32:
+			apply_items(static_cast<int32*>(items), count, operation, a, b);
+			break;
+		case STORAGE_INT64:
+			apply_items(static_cast<int64*>(items), count, operation, a, b);
+			break;
+		case STORAGE_UINT8:
+			apply_items(static_cast<uint8*>(items), count, operation, a, b);
+			break;
+		case STORAGE_UINT16:
+			apply_items(static_cast<uint16*>(items), count, operation, a, b);
+			break;
+		case STORAGE_UINT32:
+			apply_items(static_cast<uint32*>(items), count, operation, a, b);
+			break;
+		case STORAGE_UINT64:
+			apply_items(static_cast<uint64*>(items), count, operation, a, b);
+			break;
+		case STORAGE_FLOAT:
+			apply_items(static_cast<float*>(items), count, operation, a, b);
+			break;
+		case STORAGE_DOUBLE:
+			apply_items(static_cast<double*>(items), count, operation, a, b);
+			break;
+		default:
+			return B_NOT_SUPPORTED;
+	}
+	return B_OK;
+}
+
+// A plain loop; widening conversions like int32 to int64 or float to
+// double come out as vector code from the compiler
+template<typename From, typename To>
+static void
+convert_items(const From* items, size_t count, To* out)
+{
+	for(size_t i = 0; i < count; i++)
+		out[i] = convert_item<From, To>(items[i]);
+}
+
+template<typename From>
+static status_t
+convert_from(const From* items, size_t count, item_storage to, void* out)
+{
+	switch(to) {
+		case STORAGE_INT8:
+			convert_items(items, count, static_cast<int8*>(out));
+			break;
+		case STORAGE_INT16:
+			convert_items(items, count, static_cast<int16*>(out));
+			break;
+		case STORAGE_INT32:
+			convert_items(items, count, static_cast<int32*>(out));
+			break;
+		case STORAGE_INT64:
+			convert_items(items, count, static_cast<int64*>(out));
+			break;
+		case STORAGE_UINT8:
+			convert_items(items, count, static_cast<uint8*>(out));
+			break;
+		case STORAGE_UINT16:
+			convert_items(items, count, static_cast<uint16*>(out));
+			break;
+		case STORAGE_UINT32:
+			convert_items(items, count, static_cast<uint32*>(out));
+			break;
+		case STORAGE_UINT64:
+			convert_items(items, count, static_cast<uint64*>(out));
+			break;
+		case STORAGE_FLOAT:
+			convert_items(items, count, static_cast<float*>(out));
+			break;
+		case STORAGE_DOUBLE:
+			convert_items(items, count, static_cast<double*>(out));
+			break;
+		default:
+			return B_NOT_SUPPORTED;
+	}
+	return B_OK;
+}
+
+static status_t
+convert_storage(item_storage from, const void* items, size_t count,
+	item_storage to, void* out)
+{
+	switch(from) {
+		case STORAGE_INT8:
+			return convert_from(static_cast<const int8*>(items), count, to, out);
+		case STORAGE_INT16:
+			return convert_from(static_cast<const int16*>(items), count, to, out);
+		case STORAGE_INT32:
+			return convert_from(static_cast<const int32*>(items), count, to, out);
+		case STORAGE_INT64:
+			return convert_from(static_cast<const int64*>(items), count, to, out);
+		case STORAGE_UINT8:
+			return convert_from(static_cast<const uint8*>(items), count, to, out);
+		case STORAGE_UINT16:
+			return convert_from(static_cast<const uint16*>(items), count, to, out);
+		case STORAGE_UINT32:
+			return convert_from(static_cast<const uint32*>(items), count, to, out);
+		case STORAGE_UINT64:
+			return convert_from(static_cast<const uint64*>(items), count, to, out);
+		case STORAGE_FLOAT:
+			return convert_from(static_cast<const float*>(items), count, to, out);
+		case STORAGE_DOUBLE:
+			return convert_from(static_cast<const double*>(items), count, to, out);
+		default:
+			return B_NOT_SUPPORTED;
+	}
+}
+
+// #pragma mark - Fields
+
+static status_t
+copy_field(const BMessage& from, BMessage* to, const char* name)
+{
+	type_code type;
+	int32 count;
+	bool fixedSize;
+	if(from.GetInfo(name, &type, &count) != B_OK
+		|| from.GetInfo(name, &type, &fixedSize) != B_OK)
+		return B_NAME_NOT_FOUND;
+
+	for(int32 i = 0; i < count; i++) {
+		status_t status;
+		if(type == B_MESSAGE_TYPE) {
+			BMessage member;
+			status = from.FindMessage(name, i, &member);
+			if(status == B_OK)
+				status = to->AddMessage(name, &member);
+		} else {
+			const void* data;
+			ssize_t size;
+			status = from.FindData(name, type, i, &data, &size);
+			if(status == B_OK)
+				status = to->AddData(name, type, data, size, fixedSize, count);
+		}
+		if(status != B_OK)
+			return status;
+	}
+	return B_OK;
+}
+
+bool
+bulk_type_supported(type_code type)
+{
+	return storage_of(type, native_size(type)) != STORAGE_NONE;
+}
+
+status_t
+bulk_edit_field(BMessage* message, const char* name, type_code type,
+	int32 first, int32 last, bulk_operation operation, double a, double b)
+{
+	type_code found;
+	int32 count;
+	if(message->GetInfo(name, &found, &count) != B_OK || found != type)
+		return B_NAME_NOT_FOUND;
+
+	if(first < 0)
+		first = 0;
+	if(last < 0 || last >= count)
+		last = count - 1;
+	if(first > last)
+		return B_BAD_INDEX;
+
+	const void* data;
+	ssize_t itemSize;
+	status_t status = message->FindData(name, type, first, &data, &itemSize);
+	if(status != B_OK)
+		return status;
+
+	item_storage storage = storage_of(type, itemSize);
+	if(storage == STORAGE_NONE)
+		return B_NOT_SUPPORTED;
+
+	int32 items = last - first + 1;
+	std::vector<uint8> buffer(items * itemSize);
+	status = gather_items(*message, name, type, first, items, itemSize,
+		&buffer[0]);
+	if(status == B_OK)
+		status = apply_storage(storage, &buffer[0], items, operation, a, b);
+
+	// Same size and position, so every item is replaced where it is
+	for(int32 i = 0; status == B_OK && i < items; i++) {
+		status = message->ReplaceData(name, type, first + i,
+			&buffer[i * itemSize], itemSize);
+	}
+	return status;
+}
+
+status_t
+bulk_convert_field(BMessage* message, const char* name, type_code type,
+	type_code to)
+{
+	type_code found;
+	int32 count;
+	if(message->GetInfo(name, &found, &count) != B_OK || found != type)
+		return B_NAME_NOT_FOUND;
+
+	const void* data;
+	ssize_t itemSize;
+	status_t status = message->FindData(name, type, 0, &data, &itemSize);
+	if(status != B_OK)
+		return status;
+
+	item_storage fromStorage = storage_of(type, itemSize);
+	ssize_t toSize = native_size(to);
+	item_storage toStorage = storage_of(to, toSize);
+	if(fromStorage == STORAGE_NONE || toStorage == STORAGE_NONE)
+		return B_NOT_SUPPORTED;
+
+	std::vector<uint8> source(count * itemSize);
+	std::vector<uint8> converted(count * toSize);
+	status = gather_items(*message, name, type, 0, count, itemSize, &source[0]);
+	if(status == B_OK) {
+		status = convert_storage(fromStorage, &source[0], count, toStorage,
+			&converted[0]);
+	}
+	if(status != B_OK)
+		return status;
+
+	// Removing and adding the name again would move it behind the others
+	BMessage rebuilt(message->what);
+	char* fieldName;
+	type_code fieldType;
+	for(int32 i = 0; status == B_OK
+		&& message->GetInfo(B_ANY_TYPE, i, &fieldName, &fieldType) == B_OK; i++) {
+		if(strcmp(fieldName, name) != 0) {
+			status = copy_field(*message, &rebuilt, fieldName);
+			continue;
+		}
+
+		for(int32 j = 0; status == B_OK && j < count; j++) {
+			status = rebuilt.AddData(name, to, &converted[j * toSize], toSize,
+				true, count);
+		}
+	}
+	if(status != B_OK)
+		return status;
+
+	*message = rebuilt;
+	return B_OK;
+}
@@ -0,0 +1,44 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef __BULK_EDIT_H__
+#define __BULK_EDIT_H__
+
+#include <Message.h>
+#include <SupportDefs.h>
+
+/*	Transforms over many items of a numeric field at once. The items are
+	gathered into one contiguous buffer and run through kernels written on
+	16 byte vectors (SSE2 on x86, NEON on ARM, plain code elsewhere), then
+	written back in place, so the field keeps its position and the caller
+	can record the whole thing as a single edit.
+
+	Parameters arrive as doubles and are saturated to the item type.
+	Integer fields are added to, scaled and numbered item by item instead,
+	so that results stop at the ends of the range rather than wrapping and
+	a fractional factor or step is applied as it is.
+*/
+enum bulk_operation {
+	BULK_SET = 0,		// a
+	BULK_ADD,			// item + a
+	BULK_SCALE,			// item * a
+	BULK_CLAMP,			// between a and b
+	BULK_SEQUENCE		// a + i * b, i counting from the first item
+};
+
+bool		bulk_type_supported(type_code type);
+
+// Applies the operation to items first to last of the field; a negative
+// last means up to the end of the field.
+status_t	bulk_edit_field(BMessage* message, const char* name, type_code type,
+				int32 first, int32 last, bulk_operation operation, double a,
+				double b);
+
+// Converts every item of the field to another numeric type. The message is
+// rebuilt so that the field stays where it was among the others.
+status_t	bulk_convert_field(BMessage* message, const char* name,
+				type_code type, type_code to);
+
+#endif /* __BULK_EDIT_H__ */
@@ -0,0 +1,233 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#include <Application.h>
+#include <Catalog.h>
+#include <LayoutBuilder.h>
+#include <MenuItem.h>
+#include <cstdlib>
+#include "bulkedit.h"
+#include "bulkeditwindow.h"
+#include "gettype.h"
+#include "kottandefs.h"
+
+#undef B_TRANSLATION_CONTEXT
+#define B_TRANSLATION_CONTEXT "BulkEditWindow"
+
+static const int32 kConvertOperation = -1;
+
+static const type_code kConvertTypes[] = {
+	B_INT8_TYPE, B_INT16_TYPE, B_INT32_TYPE, B_INT64_TYPE,
+	B_UINT8_TYPE, B_UINT16_TYPE, B_UINT32_TYPE, B_UINT64_TYPE,
+	B_FLOAT_TYPE, B_DOUBLE_TYPE
+};
+
+BulkEditWindow::BulkEditWindow(BRect frame, const char* name, type_code type,
+	int32 count, int32 first, int32 last, BWindow* caller)
+: BWindow(frame, B_TRANSLATE("Bulk edit"), B_TITLED_WINDOW_LOOK,
+	B_MODAL_APP_WINDOW_FEEL, B_ASYNCHRONOUS_CONTROLS | B_NOT_RESIZABLE
+		| B_NOT_ZOOMABLE | B_AUTO_UPDATE_SIZE_LIMITS | B_CLOSE_ON_ESCAPE),
+  fFieldName(name),
+  fFieldType(type),
+  fOperation(BULK_SET),
+  fCaller(caller)
+{
+	fPumOperation = new BPopUpMenu("");
+	fMfOperation = new BMenuField(B_TRANSLATE("Operation:"), fPumOperation);
+	BuildOperationMenu();
+
+	fPumConvertType = new BPopUpMenu("");
+	fMfConvertType = new BMenuField(B_TRANSLATE("Convert to:"), fPumConvertType);
+	BuildTypeMenu();
+
+	fTcFirstValue = new BTextControl("", "0", NULL);
+	fTcSecondValue = new BTextControl("", "0", NULL);
+
+	fRbAllItems = new BRadioButton(B_TRANSLATE("All items"),
+		new BMessage(BCMD_RANGE_SELECTED));
+	fRbItemRange = new BRadioButton(B_TRANSLATE("Items from"),
+		new BMessage(BCMD_RANGE_SELECTED));
+	fSpFirstItem = new BSpinner("", "", NULL);
+	fSpFirstItem->SetRange(0, count - 1);
+	fSpLastItem = new BSpinner("", B_TRANSLATE("to"), NULL);
+	fSpLastItem->SetRange(0, count - 1);
+
+	/* A selection of more than one item suggests where to apply it */
+	bool hasRange = first >= 0 && last > first;
+	fSpFirstItem->SetValue(hasRange ? first : 0);
+	fSpLastItem->SetValue(hasRange ? last : count - 1);
+	(hasRange ? fRbItemRange : fRbAllItems)->SetValue(B_CONTROL_ON);
+
+	fBtApply = new BButton(B_TRANSLATE("Apply"),
+		new BMessage(BCMD_APPLY_REQUESTED));
+	fBtCancel = new BButton(B_TRANSLATE("Cancel"),
+		new BMessage(BCMD_CLOSE_REQUESTED));
+
+	BLayoutBuilder::Group<>(this, B_VERTICAL)
+		.SetInsets(B_USE_SMALL_INSETS)
+		.AddGrid()
+			.AddMenuField(fMfOperation, 0, 0)
+			.AddTextControl(fTcFirstValue, 0, 1)
+			.AddTextControl(fTcSecondValue, 0, 2)
+			.AddMenuField(fMfConvertType, 0, 3)
+		.End()
+		.AddStrut(4.0f)
+		.Add(fRbAllItems)
+		.AddGroup(B_HORIZONTAL)
+			.Add(fRbItemRange)
+			.Add(fSpFirstItem)
+			.Add(fSpLastItem)
+		.End()
+		.AddStrut(4.0f)
+		.AddGroup(B_HORIZONTAL)
+			.AddGlue()
+			.Add(fBtApply)
+			.Add(fBtCancel)
+			.AddGlue()
+		.End()
+	.End();
+
+	SetDefaultButton(fBtApply);
+	UpdateControls();
+}
+
+void
+BulkEditWindow::MessageReceived(BMessage* msg)
+{
+	switch(msg->what)
+	{
+		case BCMD_OPERATION_SELECTED:
+			fOperation = msg->GetInt32("operation", BULK_SET);
+			UpdateControls();
+			break;
+		case BCMD_RANGE_SELECTED:
+			UpdateControls();
+			break;
+		case BCMD_APPLY_REQUESTED:
+		{
+			BMessage request(msg->what);
+			request.AddString(KottanFieldName, fFieldName);
+			request.AddUInt32(KottanFieldType, fFieldType);
+			request.AddPointer("window", fCaller);
+
+			if(fOperation == kConvertOperation) {
+				BMenuItem* marked = fPumConvertType->FindMarked();
+				if(!marked)
+					break;
+				request.AddUInt32("convert_to",
+					marked->Message()->GetUInt32("type", B_ANY_TYPE));
+			} else {
+				double first = 0, second = 0;
+				if(!ParseValue(fTcFirstValue, &first)
+					|| (fTcSecondValue->IsEnabled()
+						&& !ParseValue(fTcSecondValue, &second)))
+					break;
+
+				request.AddInt32("operation", fOperation);
+				request.AddDouble("first_value", first);
+				request.AddDouble("second_value", second);
+				if(fRbItemRange->Value() == B_CONTROL_ON) {
+					request.AddInt32("first", fSpFirstItem->Value());
+					request.AddInt32("last", fSpLastItem->Value());
+				}
+			}
+
+			be_app->PostMessage(&request);
+			Quit();
+			break;
+		}
+		case BCMD_CLOSE_REQUESTED:
+			Quit();
+			break;
+		default:
+			return BWindow::MessageReceived(msg);
+	}
+}
+
+void
+BulkEditWindow::BuildOperationMenu()
+{
+	struct {
+		int32 operation;
+		const char* label;
+	} operations[] = {
+		{ BULK_SET, B_TRANSLATE("Set to a value") },
+		{ BULK_ADD, B_TRANSLATE("Add a value") },
+		{ BULK_SCALE, B_TRANSLATE("Multiply by a value") },
+		{ BULK_CLAMP, B_TRANSLATE("Clamp to a range") },
+		{ BULK_SEQUENCE, B_TRANSLATE("Fill with a sequence") },
+		{ kConvertOperation, B_TRANSLATE("Convert to another type") }
+	};
+
+	for(const auto& it : operations) {
+		BMessage* message = new BMessage(BCMD_OPERATION_SELECTED);
+		message->AddInt32("operation", it.operation);
+		BMenuItem* item = new BMenuItem(it.label, message);
+		item->SetMarked(it.operation == fOperation);
+		fPumOperation->AddItem(item);
+	}
+}
+
+void
+BulkEditWindow::BuildTypeMenu()
+{
+	for(const auto& type : kConvertTypes) {
+		if(type == fFieldType)
+			continue;
+
+		BMessage* message = new BMessage(BCMD_OPERATION_SELECTED);
+		message->AddInt32("operation", kConvertOperation);
+		message->AddUInt32("type", type);
+		fPumConvertType->AddItem(new BMenuItem(get_type(type).String(), message));
+	}
+
+	BMenuItem* first = fPumConvertType->ItemAt(0);
+	if(first)
+		first->SetMarked(true);
+}
+
+void
+BulkEditWindow::UpdateControls()
+{
+	const char* firstLabel = B_TRANSLATE("Value:");
+	const char* secondLabel = "";
+	switch(fOperation) {
+		case BULK_SCALE:
+			firstLabel = B_TRANSLATE("Factor:");
+			break;
+		case BULK_CLAMP:
+			firstLabel = B_TRANSLATE("Minimum:");
+			secondLabel = B_TRANSLATE("Maximum:");
+			break;
+		case BULK_SEQUENCE:
+			firstLabel = B_TRANSLATE("Start:");
+			secondLabel = B_TRANSLATE("Step:");
+			break;
+	}
+
+	bool converting = fOperation == kConvertOperation;
+	fTcFirstValue->SetLabel(firstLabel);
+	fTcFirstValue->SetEnabled(!converting);
+	fTcSecondValue->SetLabel(secondLabel);
+	fTcSecondValue->SetEnabled(!converting && secondLabel[0] != '\0');
+	fMfConvertType->SetEnabled(converting);
+
+	/* Converting changes the type of the whole field */
+	fRbAllItems->SetEnabled(!converting);
+	fRbItemRange->SetEnabled(!converting);
+	bool useRange = !converting && fRbItemRange->Value() == B_CONTROL_ON;
+	fSpFirstItem->SetEnabled(useRange);
+	fSpLastItem->SetEnabled(useRange);
+}
+
+bool
+BulkEditWindow::ParseValue(BTextControl* control, double* value)
+{
+	char* end;
+	*value = strtod(control->Text(), &end);
+	bool valid = end != control->Text() && *end == '\0';
+	control->MarkAsInvalid(!valid);
+	return valid;
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef __BULK_EDIT_WINDOW_H__
+#define __BULK_EDIT_WINDOW_H__
+
+#include <Button.h>
+#include <MenuField.h>
+#include <PopUpMenu.h>
+#include <RadioButton.h>
+#include <TextControl.h>
+#include <Window.h>
+#include <private/interface/Spinner.h>
+
+enum BulkCmds {
+	BCMD_OPERATION_SELECTED = 'bk00',
+	BCMD_RANGE_SELECTED,
+	BCMD_APPLY_REQUESTED,
+	BCMD_CLOSE_REQUESTED
+};
+
+/*	Asks for one bulk operation over a numeric field and sends it to the
+	application as BCMD_APPLY_REQUESTED. The range starts out as the items
+	selected in the data view.
+*/
+class BulkEditWindow : public BWindow
+{
+public:
+							BulkEditWindow(BRect frame, const char* name,
+								type_code type, int32 count, int32 first,
+								int32 last, BWindow* caller);
+
+	virtual	void			MessageReceived(BMessage* msg);
+private:
+			void			BuildOperationMenu();
+			void			BuildTypeMenu();
+			void			UpdateControls();
+			bool			ParseValue(BTextControl* control, double* value);
+private:
+	BString					fFieldName;
+	type_code				fFieldType;
+	int32					fOperation;
+	BWindow*				fCaller;
+
+	BMenuField*				fMfOperation;
+	BPopUpMenu*				fPumOperation;
+	BMenuField*				fMfConvertType;
+	BPopUpMenu*				fPumConvertType;
+	BTextControl*			fTcFirstValue;
+	BTextControl*			fTcSecondValue;
+	BRadioButton*			fRbAllItems;
+	BRadioButton*			fRbItemRange;
+	BSpinner*				fSpFirstItem;
+	BSpinner*				fSpLastItem;
+	BButton*				fBtApply;
+	BButton*				fBtCancel;
+};
+
+#endif /* __BULK_EDIT_WINDOW_H__ */
@@ -0,0 +1,424 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#include <ByteOrder.h>
+#include <TypeConstants.h>
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <vector>
+#include "byteswap.h"
+#include "flatmessage.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__) \
+	&& __GNUC__ >= 5
+#define BYTESWAP_SSSE3 1
+#include <tmmintrin.h>
+#endif
+
+static const int32 kMaxNesting = 64;
+
+static status_t swap_message(uint8* data, size_t size, int32 depth);
+static bool swap_item_nested(type_code type, uint8* data, size_t size,
+	int32 depth);
+
+// Tails and machines without vector units
+static void
+swap_portable(uint8* data, size_t count, size_t width)
+{
+	switch(width) {
+		case 2:
+			for(size_t i = 0; i < count; i++, data += 2) {
+				uint16 value;
+				memcpy(&value, data, 2);
+				value = B_SWAP_INT16(value);
+				memcpy(data, &value, 2);
+			}
+			break;
+		case 4:
+			for(size_t i = 0; i < count; i++, data += 4) {
+				uint32 value;
+				memcpy(&value, data, 4);
+				value = B_SWAP_INT32(value);
+				memcpy(data, &value, 4);
+			}
+			break;
+		case 8:
+			for(size_t i = 0; i < count; i++, data += 8) {
+				uint64 value;
+				memcpy(&value, data, 8);
+				value = B_SWAP_INT64(value);
+				memcpy(data, &value, 8);
+			}
+			break;
+	}
+}
+
+#if defined(__SSE2__)
+
+// Without a byte shuffle: words are reversed as 16 bit lanes, then the two
+// bytes of every lane trade places
+static size_t
+swap_sse2(uint8* data, size_t count, size_t width)
+{
+	size_t bytes = count * width & ~(size_t)15;
+	for(size_t i = 0; i < bytes; i += 16) {
+		__m128i* block = reinterpret_cast<__m128i*>(data + i);
+		__m128i value = _mm_loadu_si128(block);
+		if(width == 4) {
+			value = _mm_shufflelo_epi16(value, _MM_SHUFFLE(2, 3, 0, 1));
+			value = _mm_shufflehi_epi16(value, _MM_SHUFFLE(2, 3, 0, 1));
+		} else if(width == 8) {
+			value = _mm_shufflelo_epi16(value, _MM_SHUFFLE(0, 1, 2, 3));
+			value = _mm_shufflehi_epi16(value, _MM_SHUFFLE(0, 1, 2, 3));
+		}
+		value = _mm_or_si128(_mm_slli_epi16(value, 8), _mm_srli_epi16(value, 8));
+		_mm_storeu_si128(block, value);
+	}
+	return bytes / width;
+}
+
+#endif // __SSE2__
+
+#ifdef BYTESWAP_SSSE3
+
+// One byte shuffle per 16 bytes, two blocks per round to hide the latency
+__attribute__((target("ssse3")))
+static size_t
+swap_ssse3(uint8* data, size_t count, size_t width)
+{
+	__m128i mask;
+	switch(width) {
+		case 2:
+			mask = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12,
+				15, 14);
+			break;
+		case 4:
+			mask = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14,
+				13, 12);
+			break;
+		default:
+			mask = _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11,
+				10, 9, 8);
+			break;
+	}
+
+	size_t bytes = count * width & ~(size_t)15;
+	size_t i = 0;
+	for(; i + 32 <= bytes; i += 32) {
+		__m128i* first = reinterpret_cast<__m128i*>(data + i);
+		__m128i* second = first + 1;
+		__m128i a = _mm_loadu_si128(first);
+		__m128i b = _mm_loadu_si128(second);
+		_mm_storeu_si128(first, _mm_shuffle_epi8(a, mask));
+		_mm_storeu_si128(second, _mm_shuffle_epi8(b, mask));
+	}
+	if(i < bytes) {
+		__m128i* block = reinterpret_cast<__m128i*>(data + i);
+		_mm_storeu_si128(block, _mm_shuffle_epi8(_mm_loadu_si128(block), mask));
+	}
+	return bytes / width;
+}
+
+#endif // BYTESWAP_SSSE3
+
+static void
+swap_array(void* data, size_t count, size_t width)
+{
+	uint8* bytes = static_cast<uint8*>(data);
+	size_t done = 0;
+#ifdef BYTESWAP_SSSE3
+	if(byteswap_is_accelerated())
+		done = swap_ssse3(bytes, count, width);
+#endif
+#if defined(__SSE2__)
+	if(done == 0)
+		done = swap_sse2(bytes, count, width);
+#endif
+	swap_portable(bytes + done * width, count - done, width);
+}
+
+void
+swap_int16_array(void* data, size_t count)
+{
+	swap_array(data, count, 2);
+}
+
+void
+swap_int32_array(void* data, size_t count)
+{
+	swap_array(data, count, 4);
+}
+
+void
+swap_int64_array(void* data, size_t count)
+{
+	swap_array(data, count, 8);
+}
+
+bool
+byteswap_is_accelerated()
+{
+#ifdef BYTESWAP_SSSE3
+	static const bool sHasSSSE3 = __builtin_cpu_supports("ssse3");
+	return sHasSSSE3;
+#else
+	return false;
+#endif
+}
+
+// #pragma mark -
+
+// Word size of the types that are plain arrays of one kind of number;
+// a few of them are as wide as the platform that wrote them
+static size_t
+word_width(type_code type, size_t size)
+{
+	switch(type) {
+		case B_INT16_TYPE:
+		case B_UINT16_TYPE:
+			return 2;
+		case B_INT32_TYPE:
+		case B_UINT32_TYPE:
+		case B_FLOAT_TYPE:
+		case B_POINT_TYPE:
+		case B_RECT_TYPE:
+		case B_SIZE_TYPE:
+		case B_ALIGNMENT_TYPE:
+		case B_MESSENGER_TYPE:
+			return 4;
+		case B_INT64_TYPE:
+		case B_UINT64_TYPE:
+		case B_DOUBLE_TYPE:
+		case B_OFF_T_TYPE:
+		case B_AFFINE_TRANSFORM_TYPE:
+			return 8;
+		case B_SIZE_T_TYPE:
+		case B_SSIZE_T_TYPE:
+		case B_TIME_TYPE:
+		case B_POINTER_TYPE:
+			return size == 4 || size == 8 ? size : 0;
+		default:
+			return 0;
+	}
+}
+
+static bool
+swap_item_nested(type_code type, uint8* data, size_t size, int32 depth)
+{
+	switch(type) {
+		case B_MESSAGE_TYPE:
+			return depth < kMaxNesting
+				&& swap_message(data, size, depth + 1) == B_OK;
+
+		// dev_t, then ino_t; the name of a ref is text
+		case B_REF_TYPE:
+			if(size < 12)
+				return false;
+			swap_int32_array(data, 1);
+			swap_int64_array(data + 4, 1);
+			return true;
+
+		// The same two members, ino_t aligned on 64 bit platforms
+		case B_NODE_REF_TYPE:
+			if(size != 12 && size != 16)
+				return false;
+			swap_int32_array(data, 1);
+			swap_int64_array(data + size - 8, 1);
+			return true;
+	}
+
+	size_t width = word_width(type, size);
+	if(width == 0 || size % width != 0)
+		return false;
+
+	swap_array(data, size / width, width);
+	return true;
+}
+
+bool
+swap_item(type_code type, void* data, size_t size)
+{
+	return swap_item_nested(type, static_cast<uint8*>(data), size, 0);
+}
+
+// flags and name_length, then the five 32 bit members
+static void
+swap_field_header(flat_field_header* field)
+{
+	uint8* bytes = reinterpret_cast<uint8*>(field);
+	swap_int16_array(bytes, 2);
+	swap_int32_array(bytes + 4, 5);
+}
+
+// The headers are kept in the byte order of the message
+static flat_field_header
+read_field_header(const uint8* fieldHeaders, uint32 index, bool toHost)
+{
+	flat_field_header field;
+	memcpy(&field, fieldHeaders + index * sizeof(flat_field_header),
+		sizeof(field));
+	if(toHost)
+		swap_field_header(&field);
+	return field;
+}
+
+static bool
+variable_items_valid(const uint8* items, uint32 size, uint32 count,
+	bool toHost)
+{
+	uint32 offset = 0;
+	for(uint32 k = 0; k < count; k++) {
+		if(size - offset < sizeof(uint32))
+			return false;
+		uint32 itemSize;
+		memcpy(&itemSize, items + offset, sizeof(uint32));
+		if(toHost)
+			itemSize = B_SWAP_INT32(itemSize);
+		offset += sizeof(uint32);
+		if(itemSize > size - offset)
+			return false;
+		offset += itemSize;
+	}
+	return true;
+}
+
+// Writers lay the fields out one after the other, only others are sorted
+static bool
+fields_disjoint(const uint8* fieldHeaders, uint32 count, bool toHost)
+{
+	std::vector<std::pair<uint64, uint64> > spans;
+	spans.reserve(count);
+	for(uint32 i = 0; i < count; i++) {
+		flat_field_header field = read_field_header(fieldHeaders, i, toHost);
+		spans.push_back(std::make_pair((uint64)field.offset,
+			(uint64)field.offset + field.name_length + field.data_size));
+	}
+	std::sort(spans.begin(), spans.end());
+	for(uint32 i = 1; i < count; i++) {
+		if(spans[i].first < spans[i - 1].second)
+			return false;
+	}
+	return true;
+}
+
+/*	Every field is checked before the first byte is swapped, so that a
+	message that cannot be read is left as it was and converting there
+	and back gives the message again; nested messages that cannot be read
+	stay as they are inside the converted one. Fields that share bytes
+	would have those swapped twice and are not accepted either.
+*/
+static status_t
+swap_message(uint8* data, size_t size, int32 depth)
+{
+	if(size < sizeof(flat_message_header))
+		return B_BAD_DATA;
+
+	// The headers are read from host order copies and written back as the
+	// raw bytes swapped at the end
+	flat_message_header header;
+	memcpy(&header, data, sizeof(header));
+	bool toHost = header.format == kFlatMessageFormatSwapped;
+	if(!toHost && header.format != kFlatMessageFormat)
+		return B_NOT_A_MESSAGE;
+
+	flat_message_header host = header;
+	if(toHost)
+		swap_int32_array(&host, sizeof(host) / sizeof(uint32));
+
+	uint64 needed = sizeof(flat_message_header)
+		+ (uint64)host.field_count * sizeof(flat_field_header) + host.data_size;
+	if(needed > size)
+		return B_BAD_DATA;
+
+	uint8* fieldHeaders = data + sizeof(flat_message_header);
+	uint8* fieldData = fieldHeaders
+		+ host.field_count * sizeof(flat_field_header);
+
+	uint64 previousEnd = 0;
+	bool ordered = true;
+	for(uint32 i = 0; i < host.field_count; i++) {
+		flat_field_header field = read_field_header(fieldHeaders, i, toHost);
+		uint64 end = (uint64)field.offset + field.name_length + field.data_size;
+		if(end > host.data_size || field.count == 0)
+			return B_BAD_DATA;
+
+		const uint8* items = fieldData + field.offset + field.name_length;
+		if((field.flags & kFlatFieldFixedSize) != 0) {
+			if(field.data_size % field.count != 0)
+				return B_BAD_DATA;
+		} else if(!variable_items_valid(items, field.data_size, field.count,
+				toHost))
+			return B_BAD_DATA;
+
+		if(field.offset < previousEnd)
+			ordered = false;
+		previousEnd = end;
+	}
+	if(!ordered && !fields_disjoint(fieldHeaders, host.field_count, toHost))
+		return B_BAD_DATA;
+
+	for(uint32 i = 0; i < host.field_count; i++) {
+		flat_field_header field = read_field_header(fieldHeaders, i, toHost);
+		uint8* items = fieldData + field.offset + field.name_length;
+		if((field.flags & kFlatFieldFixedSize) != 0) {
+			uint32 itemSize = field.data_size / field.count;
+
+			// Whole fields of plain numbers go through the kernels at once
+			size_t width = word_width(field.type, itemSize);
+			if(width != 0 && itemSize % width == 0)
+				swap_array(items, field.data_size / width, width);
+			else {
+				for(uint32 k = 0; k < field.count; k++) {
+					swap_item_nested(field.type, items + k * itemSize, itemSize,
+						depth);
+				}
+			}
+		} else {
+			uint32 offset = 0;
+			for(uint32 k = 0; k < field.count; k++) {
+				uint32 itemSize;
+				memcpy(&itemSize, items + offset, sizeof(uint32));
+				swap_int32_array(items + offset, 1);
+				if(toHost)
+					itemSize = B_SWAP_INT32(itemSize);
+				offset += sizeof(uint32);
+
+				swap_item_nested(field.type, items + offset, itemSize, depth);
+				offset += itemSize;
+			}
+		}
+
+		uint8* position = fieldHeaders + i * sizeof(flat_field_header);
+		flat_field_header raw;
+		memcpy(&raw, position, sizeof(raw));
+		swap_field_header(&raw);
+		memcpy(position, &raw, sizeof(raw));
+	}
+
+	swap_int32_array(&header, sizeof(header) / sizeof(uint32));
+	memcpy(data, &header, sizeof(header));
+	return B_OK;
+}
+
+status_t
+swap_flat_message(void* data, size_t size)
+{
+	return swap_message(static_cast<uint8*>(data), size, 0);
+}
+
+bool
+is_swapped_flat_message(const void* data, size_t size)
+{
+	uint32 format;
+	if(size < sizeof(format))
+		return false;
+	memcpy(&format, data, sizeof(format));
+	return format == kFlatMessageFormatSwapped;
+}
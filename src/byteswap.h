@@ -0,0 +1,40 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef __BYTE_SWAP_H__
+#define __BYTE_SWAP_H__
+
+#include <SupportDefs.h>
+
+// Byte order a document is written in
+enum {
+	SAVE_BYTE_ORDER_AS_OPENED = 0,
+	SAVE_BYTE_ORDER_LITTLE,
+	SAVE_BYTE_ORDER_BIG
+};
+
+// In place, any alignment
+void		swap_int16_array(void* data, size_t count);
+void		swap_int32_array(void* data, size_t count);
+void		swap_int64_array(void* data, size_t count);
+bool		byteswap_is_accelerated();
+
+/*	Swaps one item of a message field in place. Numbers, floating point
+	values and the geometry types are swapped word by word, refs and node
+	refs member by member, nested native messages as a whole. Returns
+	false for types that have no byte order (strings, colours, raw data)
+	or whose size does not fit their layout; those are left as they are.
+*/
+bool		swap_item(type_code type, void* data, size_t size);
+
+/*	Converts a flattened message in the native layout between the byte
+	orders in place: a message of the other byte order comes out in host
+	order and the other way round, told apart by the format code. A
+	corrupt message is left as it was.
+*/
+status_t	swap_flat_message(void* data, size_t size);
+bool		is_swapped_flat_message(const void* data, size_t size);
+
+#endif /* __BYTE_SWAP_H__ */
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#include <cstdlib>
+#include <cstring>
+#include "capturering.h"
+
+CaptureRing::CaptureRing(size_t capacity)
+: fBuffer(NULL),
+  fMask(0),
+  fHead(0),
+  fCachedTail(0),
+  fTail(0),
+  fCachedHead(0)
+{
+	// Positions are taken modulo the capacity with a mask
+	size_t size = 64;
+	while(size < capacity)
+		size *= 2;
+
+	fBuffer = static_cast<uint8*>(malloc(size));
+	if(fBuffer)
+		fMask = size - 1;
+}
+
+CaptureRing::~CaptureRing()
+{
+	free(fBuffer);
+}
+
+bool
+CaptureRing::Write(const void* data, size_t size)
+{
+	if(size > MaxRecordSize())
+		return false;
+
+	int64 head = fHead;
+	int64 needed = sizeof(uint32) + size;
+	if(head + needed - fCachedTail > (int64)Capacity()) {
+		fCachedTail = atomic_get64(&fTail);
+		if(head + needed - fCachedTail > (int64)Capacity())
+			return false;
+	}
+
+	uint32 length = size;
+	_CopyIn(head, &length, sizeof(length));
+	_CopyIn(head + sizeof(length), data, size);
+
+	// Publishes the bytes above along with the position
+	atomic_set64(&fHead, head + needed);
+	return true;
+}
+
+bool
+CaptureRing::Read(std::vector<uint8>& output)
+{
+	int64 tail = fTail;
+	if(tail == fCachedHead) {
+		fCachedHead = atomic_get64(&fHead);
+		if(tail == fCachedHead)
+			return false;
+	}
+
+	uint32 length;
+	_CopyOut(tail, &length, sizeof(length));
+	size_t start = output.size();
+	output.resize(start + length);
+	_CopyOut(tail + sizeof(length), output.data() + start, length);
+
+	// The writer may reuse the space from here on
+	atomic_set64(&fTail, tail + sizeof(length) + length);
+	return true;
+}
+
+size_t
+CaptureRing::Used() const
+{
+	int64 tail = atomic_get64(const_cast<int64*>(&fTail));
+	int64 head = atomic_get64(const_cast<int64*>(&fHead));
+	return head - tail;
+}
+
+void
+CaptureRing::Reset()
+{
+	fHead = fCachedTail = 0;
+	fTail = fCachedHead = 0;
+}
+
+// #pragma mark - CaptureRing::Private
+
+void
+CaptureRing::_CopyIn(int64 position, const void* data, size_t size)
+{
+	size_t offset = position & fMask;
+	size_t first = size < Capacity() - offset ? size : Capacity() - offset;
+	memcpy(fBuffer + offset, data, first);
+	memcpy(fBuffer, static_cast<const uint8*>(data) + first, size - first);
+}
+
+void
+CaptureRing::_CopyOut(int64 position, void* data, size_t size) const
+{
+	size_t offset = position & fMask;
+	size_t first = size < Capacity() - offset ? size : Capacity() - offset;
+	memcpy(data, fBuffer + offset, first);
+	memcpy(static_cast<uint8*>(data) + first, fBuffer, size - first);
+}
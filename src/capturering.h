@@ -0,0 +1,64 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef __CAPTURE_RING_H__
+#define __CAPTURE_RING_H__
+
+#include <SupportDefs.h>
+#include <vector>
+
+/*	Byte ring between exactly one writing and one reading thread. Records
+	are stored as their uint32 length followed by their bytes and may wrap
+	around the end of the buffer. The two positions only ever grow; each
+	side stores its own with release and loads the other one's with
+	acquire semantics, so neither side ever waits on a lock. Each side
+	also keeps the last position of the other one it has seen and only
+	loads it again when that one says the ring is full or empty.
+*/
+class CaptureRing
+{
+public:
+							CaptureRing(size_t capacity);
+							~CaptureRing();
+
+			status_t		InitCheck() const
+								{ return fBuffer ? B_OK : B_NO_MEMORY; }
+			size_t			Capacity() const { return fMask + 1; }
+			// Largest record that fits at all
+			size_t			MaxRecordSize() const
+								{ return Capacity() - sizeof(uint32); }
+
+			// Writer: the whole record, or false while there is no room
+			bool			Write(const void* data, size_t size);
+
+			// Reader: appends the next record to output, false when empty
+			bool			Read(std::vector<uint8>& output);
+
+			// Either side; a snapshot that may be out of date already
+			size_t			Used() const;
+
+			// Only while neither side runs
+			void			Reset();
+private:
+			void			_CopyIn(int64 position, const void* data,
+								size_t size);
+			void			_CopyOut(int64 position, void* data,
+								size_t size) const;
+private:
+			uint8*			fBuffer;
+			size_t			fMask;
+
+			// Written by the writer only, on their own cache lines
+			char			fPadding0[64];
+			int64			fHead;
+			int64			fCachedTail;
+			char			fPadding1[64];
+			// Written by the reader only
+			int64			fTail;
+			int64			fCachedHead;
+			char			fPadding2[64];
+};
+
+#endif /* __CAPTURE_RING_H__ */
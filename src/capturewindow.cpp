@@ -0,0 +1,311 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#include <Alert.h>
+#include <Catalog.h>
+#include <Directory.h>
+#include <Entry.h>
+#include <FindDirectory.h>
+#include <LayoutBuilder.h>
+#include <Path.h>
+#include <cstring>
+#include <unistd.h>
+#include <algorithm>
+#include <vector>
+
+#include "capturewindow.h"
+#include "mainwindow.h"
+
+#undef B_TRANSLATION_CONTEXT
+#define B_TRANSLATION_CONTEXT "CaptureWindow"
+
+static const char* kDefaultPath = "/tmp/kottan-capture";
+static const size_t kCopySize = 1024 * 1024;
+static const bigtime_t kRateInterval = 500000;
+
+CaptureWindow::CaptureWindow(BRect frame, BMessenger target)
+: BWindow(frame, B_TRANSLATE("Capture messages"), B_DOCUMENT_WINDOW,
+	B_ASYNCHRONOUS_CONTROLS | B_AUTO_UPDATE_SIZE_LIMITS),
+  fTarget(target),
+  fCapture(NULL),
+  fListedSize(0),
+  fSavePanel(NULL),
+  fRateTime(0),
+  fRateMessages(0),
+  fRate(0)
+{
+	// One spool per running Kottan, emptied when the window opens
+	BPath spoolPath;
+	find_directory(B_SYSTEM_TEMP_DIRECTORY, &spoolPath);
+	BString name;
+	name.SetToFormat("kottan-spool-%d", (int)getpid());
+	spoolPath.Append(name);
+	fSpoolPath = spoolPath.Path();
+	fSpool.SetTo(fSpoolPath, B_READ_WRITE | B_CREATE_FILE | B_ERASE_FILE);
+
+	fCapture = new MessageCapture(BMessenger(this));
+
+	fPath = new BTextControl("path", B_TRANSLATE("Socket or pipe:"),
+		kDefaultPath, NULL);
+	fStartButton = new BButton("start", B_TRANSLATE("Start"),
+		new BMessage(CW_START_STOP));
+	fRecordPanel = new RecordPanel("records");
+	fStatus = new BStringView("status", "");
+	fError = new BStringView("error", "");
+	fOpenButton = new BButton("open", B_TRANSLATE("Open in main window"),
+		new BMessage(CW_OPEN_RECORD));
+	fSaveButton = new BButton("save",
+		B_TRANSLATE("Save as stream" B_UTF8_ELLIPSIS),
+		new BMessage(CW_SAVE_STREAM));
+
+	BLayoutBuilder::Group<>(this, B_VERTICAL, B_USE_SMALL_SPACING)
+		.SetInsets(B_USE_WINDOW_INSETS)
+		.AddGroup(B_HORIZONTAL, B_USE_SMALL_SPACING)
+			.Add(fPath)
+			.Add(fStartButton)
+		.End()
+		.Add(fRecordPanel)
+		.Add(fStatus)
+		.Add(fError)
+		.AddGroup(B_HORIZONTAL, B_USE_SMALL_SPACING)
+			.AddGlue()
+			.Add(fOpenButton)
+			.Add(fSaveButton)
+		.End()
+	.End();
+
+	AddShortcut('W', B_COMMAND_KEY, new BMessage(B_QUIT_REQUESTED));
+
+	_UpdateStatus(NULL);
+	_UpdateControls();
+}
+
+CaptureWindow::~CaptureWindow()
+{
+	delete fCapture;
+	delete fSavePanel;
+
+	fSpool.Unset();
+	BEntry(fSpoolPath).Remove();
+}
+
+void
+CaptureWindow::MessageReceived(BMessage* msg)
+{
+	switch(msg->what)
+	{
+		case CW_START_STOP:
+			if(fCapture->IsRunning()) {
+				// The button comes back with MC_STOPPED
+				fCapture->RequestStop();
+				fStartButton->SetEnabled(false);
+			} else
+				_Start();
+			break;
+
+		case MC_RECORDS_CAPTURED:
+		{
+			const void* records;
+			ssize_t size;
+			if(msg->FindData("records", B_RAW_TYPE, &records, &size) == B_OK
+				&& size > 0) {
+				int32 count = size / sizeof(message_record);
+				const message_record* added
+					= static_cast<const message_record*>(records);
+				fRecordPanel->AddRecords(added, count);
+				fListedSize = added[count - 1].offset + added[count - 1].size;
+			}
+			_UpdateStatus(msg);
+			_UpdateControls();
+			break;
+		}
+
+		// The connection is gone, the others carry on
+		case MC_CONNECTION_ERROR:
+		{
+			BString error;
+			error.SetToFormat(B_TRANSLATE("A sender was disconnected: %s"),
+				strerror(msg->GetInt32("status", B_ERROR)));
+			fError->SetText(error);
+			break;
+		}
+
+		case MC_STOPPED:
+			_Stopped(msg->GetInt32("status", B_OK));
+			break;
+
+		case RV_RECORD_SELECTED:
+			_UpdateControls();
+			break;
+
+		case RV_RECORD_INVOKED:
+			_OpenRecord(msg->GetInt32("index", -1));
+			break;
+
+		case CW_OPEN_RECORD:
+			_OpenRecord(fRecordPanel->ListView()->CurrentSelection());
+			break;
+
+		case CW_SAVE_STREAM:
+		{
+			if(!fSavePanel) {
+				BMessenger target(this);
+				fSavePanel = new BFilePanel(B_SAVE_PANEL, &target, NULL,
+					B_FILE_NODE, false);
+			}
+			fSavePanel->Show();
+			break;
+		}
+
+		case B_SAVE_REQUESTED:
+			_SaveStream(msg);
+			break;
+
+		default:
+			BWindow::MessageReceived(msg);
+	}
+}
+
+bool
+CaptureWindow::QuitRequested()
+{
+	fCapture->Stop();
+	return true;
+}
+
+// #pragma mark - CaptureWindow::Private
+
+void
+CaptureWindow::_Start()
+{
+	status_t status = fCapture->Start(fPath->Text(), fSpoolPath);
+	if(status != B_OK) {
+		BString text;
+		text.SetToFormat(B_TRANSLATE("The capture could not be started on "
+			"%s: %s"), fPath->Text(), strerror(status));
+		(new BAlert("", text, B_TRANSLATE("OK"), NULL, NULL,
+			B_WIDTH_AS_USUAL, B_STOP_ALERT))->Go(NULL);
+		return;
+	}
+
+	fError->SetText("");
+	fRateTime = system_time();
+	_UpdateControls();
+}
+
+void
+CaptureWindow::_Stopped(status_t status)
+{
+	fCapture->Stop();
+	fStartButton->SetEnabled(true);
+	_UpdateControls();
+
+	if(status != B_OK) {
+		BString text;
+		text.SetToFormat(B_TRANSLATE("The capture stopped: %s"),
+			strerror(status));
+		(new BAlert("", text, B_TRANSLATE("OK"), NULL, NULL,
+			B_WIDTH_AS_USUAL, B_STOP_ALERT))->Go(NULL);
+	}
+}
+
+// The main window asks before it replaces a changed document
+void
+CaptureWindow::_OpenRecord(int32 index)
+{
+	RecordListView* list = fRecordPanel->ListView();
+	if(index < 0 || index >= list->CountRecords())
+		return;
+
+	const message_record& record = list->RecordAt(index);
+	std::vector<uint8> data(record.size);
+	ssize_t bytesRead = fSpool.ReadAt(record.offset, data.data(), data.size());
+	if(bytesRead != (ssize_t)data.size()) {
+		BString error;
+		error.SetToFormat(B_TRANSLATE("Record %" B_PRId32 " could not be "
+			"read: %s"), index, strerror(bytesRead < 0 ? bytesRead : B_IO_ERROR));
+		fError->SetText(error);
+		return;
+	}
+
+	BMessage open(MW_OPEN_CAPTURED_MESSAGE);
+	open.AddData("data", B_RAW_TYPE, data.data(), data.size());
+	BString name;
+	name.SetToFormat(B_TRANSLATE("Captured record %" B_PRId32), index);
+	open.AddString("name", name);
+	fTarget.SendMessage(&open);
+}
+
+// Everything listed so far, records still on their way are left out
+void
+CaptureWindow::_SaveStream(BMessage* message)
+{
+	entry_ref directoryRef;
+	const char* name;
+	if(message->FindRef("directory", &directoryRef) != B_OK
+		|| message->FindString("name", &name) != B_OK)
+		return;
+
+	BDirectory directory(&directoryRef);
+	BFile file(&directory, name, B_WRITE_ONLY | B_CREATE_FILE | B_ERASE_FILE);
+	status_t status = file.InitCheck();
+
+	std::vector<uint8> buffer(kCopySize);
+	for(off_t offset = 0; status == B_OK && offset < fListedSize;) {
+		size_t size = std::min((off_t)kCopySize, fListedSize - offset);
+		ssize_t bytesRead = fSpool.ReadAt(offset, buffer.data(), size);
+		if(bytesRead != (ssize_t)size) {
+			status = bytesRead < 0 ? bytesRead : B_IO_ERROR;
+			break;
+		}
+		ssize_t written = file.Write(buffer.data(), size);
+		if(written != (ssize_t)size)
+			status = written < 0 ? written : B_DEVICE_FULL;
+		offset += size;
+	}
+
+	if(status != B_OK) {
+		BString error;
+		error.SetToFormat(B_TRANSLATE("The capture could not be saved: %s"),
+			strerror(status));
+		fError->SetText(error);
+	}
+}
+
+void
+CaptureWindow::_UpdateControls()
+{
+	bool running = fCapture->IsRunning();
+	fStartButton->SetLabel(running ? B_TRANSLATE("Stop") : B_TRANSLATE("Start"));
+	fPath->SetEnabled(!running);
+
+	RecordListView* list = fRecordPanel->ListView();
+	fOpenButton->SetEnabled(list->CurrentSelection() >= 0);
+	fSaveButton->SetEnabled(list->CountRecords() > 0);
+}
+
+void
+CaptureWindow::_UpdateStatus(const BMessage* update)
+{
+	if(!update) {
+		fStatus->SetText(B_TRANSLATE("Not capturing"));
+		return;
+	}
+
+	int64 messages = update->GetInt64("messages", 0);
+	bigtime_t now = system_time();
+	if(now - fRateTime >= kRateInterval) {
+		fRate = (messages - fRateMessages) * 1000000.0f / (now - fRateTime);
+		fRateTime = now;
+		fRateMessages = messages;
+	}
+
+	BString status;
+	status.SetToFormat(B_TRANSLATE("%" B_PRId64 " messages, %.1f MiB, "
+		"%.0f messages/s, waited for room %" B_PRId64 " times"), messages,
+		update->GetInt64("bytes", 0) / (1024.0 * 1024.0), fRate,
+		update->GetInt64("stalls", 0));
+	fStatus->SetText(status);
+}
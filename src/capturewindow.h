@@ -0,0 +1,68 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef __CAPTURE_WINDOW_H__
+#define __CAPTURE_WINDOW_H__
+
+#include <Button.h>
+#include <File.h>
+#include <FilePanel.h>
+#include <Messenger.h>
+#include <String.h>
+#include <StringView.h>
+#include <TextControl.h>
+#include <Window.h>
+
+#include "messagecapture.h"
+#include "recordlistview.h"
+
+enum {
+	CW_START_STOP = 'cw00',
+	CW_OPEN_RECORD,
+	CW_SAVE_STREAM
+};
+
+/*	Captures the messages sent to a socket or named pipe while they come
+	in. They are spooled to a temporary file that is removed with the
+	window; the list shows them as they arrive, any of them can be opened
+	in the main window and the whole capture saved as a stream file.
+*/
+class CaptureWindow : public BWindow
+{
+public:
+					CaptureWindow(BRect frame, BMessenger target);
+					~CaptureWindow();
+
+	virtual void	MessageReceived(BMessage* msg);
+	virtual bool	QuitRequested();
+private:
+			void	_Start();
+			void	_Stopped(status_t status);
+			void	_OpenRecord(int32 index);
+			void	_SaveStream(BMessage* message);
+			void	_UpdateControls();
+			void	_UpdateStatus(const BMessage* update);
+private:
+	BMessenger		fTarget;
+	MessageCapture*	fCapture;
+	BString			fSpoolPath;
+	BFile			fSpool;
+	off_t			fListedSize;
+
+	BTextControl*	fPath;
+	BButton*		fStartButton;
+	BButton*		fOpenButton;
+	BButton*		fSaveButton;
+	RecordPanel*	fRecordPanel;
+	BStringView*	fStatus;
+	BStringView*	fError;
+	BFilePanel*		fSavePanel;
+
+	bigtime_t		fRateTime;
+	int64			fRateMessages;
+	float			fRate;
+};
+
+#endif /* __CAPTURE_WINDOW_H__ */
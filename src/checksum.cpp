@@ -0,0 +1,271 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#include <ByteOrder.h>
+#include <cstring>
+#include "checksum.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__) \
+	&& __GNUC__ >= 5
+#define CRC32C_SSE42 1
+#include <nmmintrin.h>
+#endif
+
+static const uint32 kPolynomial = 0x82f63b78;	// reflected 0x1edc6f41
+static const size_t kLaneSize = 4096;
+
+/*	Tables for the portable slicing-by-8 version, plus the operator that
+	advances a CRC state over kLaneSize zero bytes. The latter lets the
+	hardware version run three independent streams and merge them.
+*/
+struct crc32c_tables {
+	uint32		slice[8][256];
+	uint32		shift[4][256];
+
+				crc32c_tables();
+};
+
+static void
+gf2_matrix_times(const uint32* matrix, uint32 vector, uint32* result)
+{
+	uint32 sum = 0;
+	for(int32 i = 0; vector != 0; i++, vector >>= 1) {
+		if(vector & 1)
+			sum ^= matrix[i];
+	}
+	*result = sum;
+}
+
+static void
+gf2_matrix_multiply(const uint32* a, const uint32* b, uint32* result)
+{
+	for(int32 i = 0; i < 32; i++)
+		gf2_matrix_times(a, b[i], &result[i]);
+}
+
+crc32c_tables::crc32c_tables()
+{
+	for(uint32 i = 0; i < 256; i++) {
+		uint32 crc = i;
+		for(int32 bit = 0; bit < 8; bit++)
+			crc = (crc >> 1) ^ (crc & 1 ? kPolynomial : 0);
+		slice[0][i] = crc;
+	}
+	for(uint32 i = 0; i < 256; i++) {
+		for(int32 k = 1; k < 8; k++)
+			slice[k][i] = (slice[k - 1][i] >> 8) ^ slice[0][slice[k - 1][i] & 0xff];
+	}
+
+	// One zero bit, squared three times gives one zero byte
+	uint32 op[32];
+	uint32 square[32];
+	op[0] = kPolynomial;
+	for(int32 i = 1; i < 32; i++)
+		op[i] = 1u << (i - 1);
+	for(int32 i = 0; i < 3; i++) {
+		gf2_matrix_multiply(op, op, square);
+		memcpy(op, square, sizeof(op));
+	}
+
+	// Raise it to kLaneSize by repeated squaring
+	uint32 lane[32];
+	for(int32 i = 0; i < 32; i++)
+		lane[i] = 1u << i;
+	for(size_t length = kLaneSize; length != 0; length >>= 1) {
+		uint32 product[32];
+		if(length & 1) {
+			gf2_matrix_multiply(op, lane, product);
+			memcpy(lane, product, sizeof(lane));
+		}
+		gf2_matrix_multiply(op, op, square);
+		memcpy(op, square, sizeof(op));
+	}
+
+	for(int32 k = 0; k < 4; k++) {
+		for(uint32 i = 0; i < 256; i++)
+			gf2_matrix_times(lane, i << (8 * k), &shift[k][i]);
+	}
+}
+
+static const crc32c_tables&
+tables()
+{
+	static const crc32c_tables sTables;
+	return sTables;
+}
+
+static inline uint32
+crc32c_shift(const crc32c_tables& t, uint32 crc)
+{
+	return t.shift[0][crc & 0xff] ^ t.shift[1][(crc >> 8) & 0xff]
+		^ t.shift[2][(crc >> 16) & 0xff] ^ t.shift[3][crc >> 24];
+}
+
+static uint32
+crc32c_portable(uint32 crc, const uint8* data, size_t length)
+{
+	const crc32c_tables& t = tables();
+
+	for(; length > 0 && (reinterpret_cast<addr_t>(data) & 7) != 0; length--)
+		crc = (crc >> 8) ^ t.slice[0][(crc ^ *data++) & 0xff];
+
+	for(; length >= 8; length -= 8, data += 8) {
+		uint32 low;
+		uint32 high;
+		memcpy(&low, data, 4);
+		memcpy(&high, data + 4, 4);
+		low = B_HOST_TO_LENDIAN_INT32(low) ^ crc;
+		high = B_HOST_TO_LENDIAN_INT32(high);
+		crc = t.slice[7][low & 0xff] ^ t.slice[6][(low >> 8) & 0xff]
+			^ t.slice[5][(low >> 16) & 0xff] ^ t.slice[4][low >> 24]
+			^ t.slice[3][high & 0xff] ^ t.slice[2][(high >> 8) & 0xff]
+			^ t.slice[1][(high >> 16) & 0xff] ^ t.slice[0][high >> 24];
+	}
+
+	while(length-- > 0)
+		crc = (crc >> 8) ^ t.slice[0][(crc ^ *data++) & 0xff];
+
+	return crc;
+}
+
+#ifdef CRC32C_SSE42
+
+#ifdef __x86_64__
+typedef uint64 crc_word;
+#define crc32c_word(crc, data) _mm_crc32_u64(crc, data)
+#else
+typedef uint32 crc_word;
+#define crc32c_word(crc, data) _mm_crc32_u32(crc, data)
+#endif
+
+__attribute__((target("sse4.2")))
+static uint32
+crc32c_sse42(uint32 crc, const uint8* data, size_t length)
+{
+	for(; length > 0 && (reinterpret_cast<addr_t>(data) & 7) != 0; length--)
+		crc = _mm_crc32_u8(crc, *data++);
+
+	// The instruction has a latency of three cycles but can start one per
+	// cycle; three interleaved lanes keep it busy, the partial results are
+	// then shifted into place and merged
+	if(length >= 3 * kLaneSize) {
+		const crc32c_tables& t = tables();
+		for(; length >= 3 * kLaneSize; length -= 3 * kLaneSize) {
+			crc_word crc0 = crc;
+			crc_word crc1 = 0;
+			crc_word crc2 = 0;
+			const crc_word* lane0 = reinterpret_cast<const crc_word*>(data);
+			const crc_word* lane1 = lane0 + kLaneSize / sizeof(crc_word);
+			const crc_word* lane2 = lane1 + kLaneSize / sizeof(crc_word);
+			for(size_t i = 0; i < kLaneSize / sizeof(crc_word); i++) {
+				crc0 = crc32c_word(crc0, lane0[i]);
+				crc1 = crc32c_word(crc1, lane1[i]);
+				crc2 = crc32c_word(crc2, lane2[i]);
+			}
+			crc = crc32c_shift(t, crc32c_shift(t, (uint32)crc0) ^ (uint32)crc1)
+				^ (uint32)crc2;
+			data += 3 * kLaneSize;
+		}
+	}
+
+	crc_word wide = crc;
+	for(; length >= sizeof(crc_word); length -= sizeof(crc_word)) {
+		crc_word word;
+		memcpy(&word, data, sizeof(word));
+		wide = crc32c_word(wide, word);
+		data += sizeof(crc_word);
+	}
+	crc = (uint32)wide;
+
+	while(length-- > 0)
+		crc = _mm_crc32_u8(crc, *data++);
+
+	return crc;
+}
+
+#endif // CRC32C_SSE42
+
+uint32
+crc32c(uint32 crc, const void* data, size_t length)
+{
+	const uint8* bytes = static_cast<const uint8*>(data);
+	crc = ~crc;
+#ifdef CRC32C_SSE42
+	if(crc32c_is_accelerated())
+		return ~crc32c_sse42(crc, bytes, length);
+#endif
+	return ~crc32c_portable(crc, bytes, length);
+}
+
+bool
+crc32c_is_accelerated()
+{
+#ifdef CRC32C_SSE42
+	static const bool sHasSSE42 = __builtin_cpu_supports("sse4.2");
+	return sHasSSE42;
+#else
+	return false;
+#endif
+}
+
+// #pragma mark - ChecksumIO
+
+ChecksumIO::ChecksumIO(BDataIO* stream)
+: fStream(stream),
+  fChecksum(0),
+  fLength(0)
+{
+}
+
+ssize_t
+ChecksumIO::Read(void* buffer, size_t size)
+{
+	ssize_t bytesRead = fStream->Read(buffer, size);
+	if(bytesRead > 0) {
+		fChecksum = crc32c(fChecksum, buffer, bytesRead);
+		fLength += bytesRead;
+	}
+	return bytesRead;
+}
+
+ssize_t
+ChecksumIO::Write(const void* buffer, size_t size)
+{
+	ssize_t bytesWritten = fStream->Write(buffer, size);
+	if(bytesWritten > 0) {
+		fChecksum = crc32c(fChecksum, buffer, bytesWritten);
+		fLength += bytesWritten;
+	}
+	return bytesWritten;
+}
+
+status_t
+ChecksumIO::WriteFooter()
+{
+	checksum_footer footer;
+	footer.magic = B_HOST_TO_LENDIAN_INT32(kChecksumFooterMagic);
+	footer.checksum = B_HOST_TO_LENDIAN_INT32(fChecksum);
+	footer.length = B_HOST_TO_LENDIAN_INT64(fLength);
+	return fStream->WriteExactly(&footer, sizeof(footer));
+}
+
+/*	Reads the footer right after what was read so far. B_ENTRY_NOT_FOUND
+	means the file has none (saved without it, or by another program),
+	B_BAD_DATA that it has one and the contents don't match it.
+*/
+status_t
+ChecksumIO::VerifyFooter()
+{
+	checksum_footer footer;
+	if(fStream->ReadExactly(&footer, sizeof(footer)) != B_OK
+		|| B_LENDIAN_TO_HOST_INT32(footer.magic) != kChecksumFooterMagic)
+		return B_ENTRY_NOT_FOUND;
+
+	if(B_LENDIAN_TO_HOST_INT64(footer.length) != fLength
+		|| B_LENDIAN_TO_HOST_INT32(footer.checksum) != fChecksum)
+		return B_BAD_DATA;
+
+	return B_OK;
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef __CHECKSUM_H__
+#define __CHECKSUM_H__
+
+#include <DataIO.h>
+#include <SupportDefs.h>
+
+static const uint32 kChecksumFooterMagic = 'KCRC';
+
+/*	Trailer appended after a flattened message. BMessage::Unflatten() stops
+	reading at the end of the message, so readers that don't know about it
+	never look at these bytes. Stored little endian.
+*/
+struct checksum_footer {
+	uint32		magic;
+	uint32		checksum;	// CRC32C of the message bytes
+	uint64		length;		// number of message bytes covered
+} _PACKED;
+
+// CRC32C (Castagnoli). Pass 0 to start, then the previous result.
+uint32	crc32c(uint32 crc, const void* data, size_t length);
+bool	crc32c_is_accelerated();
+
+/*	Pass-through stream that checksums everything read from or written to
+	the stream it wraps, so the file is never buffered or read twice.
+*/
+class ChecksumIO : public BDataIO
+{
+public:
+							ChecksumIO(BDataIO* stream);
+
+	virtual	ssize_t			Read(void* buffer, size_t size);
+	virtual	ssize_t			Write(const void* buffer, size_t size);
+
+			uint32			Checksum() const { return fChecksum; }
+			uint64			Length() const { return fLength; }
+
+			status_t		WriteFooter();
+			status_t		VerifyFooter();
+private:
+			BDataIO*		fStream;
+			uint32			fChecksum;
+			uint64			fLength;
+};
+
+#endif /* __CHECKSUM_H__ */
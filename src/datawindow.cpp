@@ -6,22 +6,23 @@
 
 #include "datawindow.h"
 #include "app.h"
+#include "bulkedit.h"
+#include "bulkeditwindow.h"
+#include "byteswap.h"
 #include "gettype.h"
+#include "hexview.h"
+#include "itemdecoder.h"
 #include "kottandefs.h"
+#include "sortkeys.h"
+#include "statsview.h"
 
 #include <Alert.h>
 #include <LayoutBuilder.h>
 #include <Catalog.h>
-#include <NetworkAddress.h>
 #include <private/interface/ColumnTypes.h>
-#include <Entry.h>
-#include <Path.h>
 #include <Application.h>
 #include <StatusBar.h>
 #include <ControlLook.h>
-#include <iomanip>
-#include <sstream>
-#include <sys/socket.h>
 
 #undef B_TRANSLATION_CONTEXT
 #define B_TRANSLATION_CONTEXT "DataView"
@@ -31,13 +32,17 @@ DataView::DataView()
   fDataMessage(NULL),
   fFieldName(""),
   fFieldType(B_ANY_TYPE),
-  fItemCount(0)
+  fItemCount(0),
+  fFileSwapped(false),
+  fUnresolvedRefs(0)
 {
 	SetupControls();
 }
 
 DataView::DataView(BMessage* data, BString name, type_code type, int32 count)
-: BView(NULL, B_SUPPORTS_LAYOUT | B_AUTO_UPDATE_SIZE_LIMITS, NULL)
+: BView(NULL, B_SUPPORTS_LAYOUT | B_AUTO_UPDATE_SIZE_LIMITS, NULL),
+  fFileSwapped(false),
+  fUnresolvedRefs(0)
 {
 	SetupControls();
 	SetTo(data, name, type, count);
@@ -54,15 +59,14 @@ DataView::SetTo(BMessage* data, BString name, type_code type, int32 count)
 	LockLooper();
 
 	if(!data) {
-		SetLabel(NULL, NULL);
-		fDataView->Clear();
+		Clear();
 		if(Window()->IsLocked())
 			UnlockLooper();
 		return B_NO_INIT;
 	}
 
 	if(type == B_MESSAGE_TYPE) {
-		fDataView->Clear();
+		Clear();
 		SetLabel(fFieldName.String(), get_type(fFieldType).String());
 		if(Window()->IsLocked())
 			UnlockLooper();
@@ -73,369 +77,47 @@ DataView::SetTo(BMessage* data, BString name, type_code type, int32 count)
 
 	SetLabel(fFieldName.String(), get_type(fFieldType).String());
 
+	bool raw = false;
+	std::vector<const void*> items(count, NULL);
+	std::vector<ssize_t> sizes(count, 0);
+	std::vector<ValueField*> fields(count, NULL);
 	for(int i = 0; i < count; i++) {
+		const void* ptr = NULL;
+		ssize_t length = 0;
 		BString itemData;
 
-		switch(fFieldType)
-		{
-			case B_AFFINE_TRANSFORM_TYPE:
-			{
-				const void* ptr = NULL;
-				ssize_t length = 0;
-				fDataMessage->FindData(fFieldName, fFieldType, i, &ptr, &length);
-
-				double tx, ty, sx, sy, shx, shy;
-
-				/* The code commented below is not working as expected... */
-				// BAffineTransform affineTransform;
-				// affineTransform.Unflatten(B_AFFINE_TRANSFORM_TYPE, ptr, length);
-				// affineTransform.GetAffineParameters(&tx, &ty, NULL, &sx, &sy, &shx, &shy);
-
-				/* so let's try with raw manipulation */
-				const double* raw = static_cast<const double*>(ptr);
-				tx = raw[4];
-				ty = raw[5];
-				sx = raw[0];
-				sy = raw[3];
-				shx = raw[2];
-				shy = raw[1];
-
-				itemData << B_TRANSLATE("translation") << "(" << tx << ", " << ty << "); "
-						 << B_TRANSLATE("scale") << "(" << sx << ", " << sy << "); "
-						 << B_TRANSLATE("shear") << "(" << shx << ", " << shy << ")";
-				break;
-			}
-
-			case B_ALIGNMENT_TYPE:
-			{
-				BAlignment alignment = fDataMessage->GetAlignment(fFieldName, i, BAlignment());
-
-				switch(alignment.Horizontal()) {
-					case B_ALIGN_LEFT:
-						itemData << B_TRANSLATE("left");
-						break;
-					case B_ALIGN_RIGHT:
-						itemData << B_TRANSLATE("right");
-						break;
-					case B_ALIGN_CENTER:
-						itemData << B_TRANSLATE("center");
-						break;
-					case B_ALIGN_USE_FULL_WIDTH:
-						itemData << B_TRANSLATE("full width");
-						break;
-					case B_ALIGN_HORIZONTAL_UNSET:
-						itemData << B_TRANSLATE("(unset)");
-						break;
-					default:
-						itemData << B_TRANSLATE("(invalid)");
-						break;
-				}
-
-				itemData << ", ";
-
-				switch(alignment.Vertical()) {
-					case B_ALIGN_TOP:
-						itemData << B_TRANSLATE("top");
-						break;
-					case B_ALIGN_MIDDLE:
-						itemData << B_TRANSLATE("middle");
-						break;
-					case B_ALIGN_BOTTOM:
-						itemData << B_TRANSLATE("bottom");
-						break;
-					case B_ALIGN_USE_FULL_HEIGHT:
-						itemData << B_TRANSLATE("full height");
-						break;
-					case B_ALIGN_VERTICAL_UNSET:
-						itemData << B_TRANSLATE("(unset)");
-						break;
-					default:
-						itemData << B_TRANSLATE("(invalid)");
-						break;
-				}
-
-				break;
-			}
-
-			case B_BOOL_TYPE:
-			{
-				bool bool_value = fDataMessage->GetBool(fFieldName, i, false);
-				if (bool_value)
-					itemData = B_TRANSLATE("true");
-				else
-					itemData = B_TRANSLATE("false");
-
-				break;
-			}
-
-			case B_CHAR_TYPE:
-			{
-				const void* ptr = NULL;
-				ssize_t length = 0;
-				fDataMessage->FindData(fFieldName, fFieldType, i, &ptr, &length);
-				char c = *(static_cast<const char*>(ptr));
-				if(isprint(static_cast<unsigned char>(c)) != 0)
-					itemData << c;
-				else
-					itemData << B_TRANSLATE("data cannot be displayed");
-				break;
-			}
-
-			case B_DOUBLE_TYPE:
-			{
-				std::stringstream convert_stream;
-				convert_stream << std::fixed << std::setprecision(4) << fDataMessage->GetDouble(fFieldName, i, 0);
-				itemData << BString(convert_stream.str().c_str());
-				break;
-			}
-
-			case B_FLOAT_TYPE:
-			{
-				std::stringstream convert_stream;
-				convert_stream << std::fixed << std::setprecision(4) << fDataMessage->GetFloat(fFieldName, i, 0);
-				itemData << BString(convert_stream.str().c_str());
-				break;
-			}
-
-			case B_INT8_TYPE:
-			{
-				itemData << fDataMessage->GetInt8(fFieldName, i, 0);
-				break;
-			}
-
-			case B_INT16_TYPE:
-			{
-				itemData << fDataMessage->GetInt16(fFieldName, i, 0);
-				break;
-			}
-
-			case B_INT32_TYPE:
-			{
-				itemData << fDataMessage->GetInt32(fFieldName, i, 0);
-				break;
-			}
-
-			case B_INT64_TYPE:
-			{
-				itemData << fDataMessage->GetInt64(fFieldName, i, 0);
-				break;
-			}
-
-			case B_MIME_TYPE:
-			{
-				const void* ptr = NULL;
-				ssize_t length = 0;
-				fDataMessage->FindData(fFieldName, fFieldType, i, &ptr, &length);
-				char* buffer = new char[length + 1];
-				buffer[length] = '\0';
-				strncpy(buffer, static_cast<const char*>(ptr), length);
-				BString mimeData = buffer;
-				itemData << mimeData;
-				delete[] buffer;
-				break;
-			}
-
-			case B_NETWORK_ADDRESS_TYPE:
-			{
-				const void* ptr = NULL;
-				ssize_t length = 0;
-				fDataMessage->FindData(fFieldName, fFieldType, i, &ptr, &length);
-				sockaddr_storage storage;
-				memcpy(&storage, ptr, length);
-				BNetworkAddress address(storage);
-				BString addrString = address.ToString(true);
-				itemData << B_TRANSLATE("family: ")
-				         << NetAddressFamilyString(storage.ss_family) << ", "
-				         << B_TRANSLATE("length: ")
-						 << storage.ss_len << ", "
-						 << B_TRANSLATE("address: ")
-						 << (addrString.Length() > 0 ? addrString.String() : B_TRANSLATE("(no resolvable address)"));
-				break;
-			}
-
-			case B_OFF_T_TYPE:
-			{
-				const void* ptr = NULL;
-				ssize_t length = 0;
-				fDataMessage->FindData(fFieldName, fFieldType, i, &ptr, &length);
-
-				off_t offset = 0;
-				memcpy(&offset, ptr, length);
-
-				itemData << offset;
-				break;
-			}
-
-			case B_POINT_TYPE:
-			{
-				BPoint point = fDataMessage->GetPoint(fFieldName, i, BPoint());
-				itemData << point.x << ", " << point.y;
-				break;
-			}
-
-			case B_RECT_TYPE:
-			{
-				BRect rect = fDataMessage->GetRect(fFieldName, i, BRect());
-				itemData << rect.left  << ", " << rect.top << ", "
-				         << rect.right << ", " << rect.bottom;
-				break;
-			}
-
-			case B_REF_TYPE:
-			{
-				entry_ref ref;
-				status_t result = fDataMessage->FindRef(fFieldName, i, &ref);
-				if(result == B_OK) {
-					BEntry entry(&ref);
-					if(entry.Exists()) { // Entry exists: show path
-						BPath path(&entry);
-						itemData << path.Path();
-					}
-					else { // Abstract entry: show what we have
-						BString data;
-						data.SetToFormat(B_TRANSLATE("device: %" B_PRIdDEV ", "
-							"directory: %" B_PRIdINO ", name: %s"),
-							ref.device, ref.directory, ref.name);
-						itemData << data.String();
-					}
-				}
-				break;
-			}
-
-			case B_NODE_REF_TYPE:
-			{
-				node_ref nref;
-				status_t result = fDataMessage->FindNodeRef(fFieldName, i, &nref);
-				if(result == B_OK) {
-					BString data;
-					data.SetToFormat(B_TRANSLATE("device: %" B_PRIdDEV ", node: %"
-						B_PRIdINO), nref.device, nref.node);
-					itemData << data;
-				}
-				break;
-			}
-
-			case B_RGB_COLOR_TYPE:
-			{
-				// BMessage->FindColor() or GetColor() don´t seem to work on B_RGB_COLOR_TYPE so we
-				// have to use the raw FindData() here
-				const void *color_ptr;
-				ssize_t data_size = sizeof(rgb_color);
-				fDataMessage->FindData(fFieldName, B_RGB_COLOR_TYPE, i, &color_ptr, &data_size);
-				rgb_color color = *(static_cast<const rgb_color*>(color_ptr));
-
-				itemData << color.red;
-				itemData += ", ";
-				itemData << color.green;
-				itemData += ", ";
-				itemData << color.blue;
-				itemData += ", ";
-				itemData << color.alpha;
-
-				break;
-			}
-
-			case B_SIZE_TYPE:
-			{
-				BSize size = fDataMessage->GetSize(fFieldName, i, BSize());
-				itemData << size.width << ", " << size.height;
-				break;
-			}
-
-			case B_SIZE_T_TYPE:
-			{
-				const void* ptr = NULL;
-				ssize_t length = 0;
-				fDataMessage->FindData(fFieldName, fFieldType, i, &ptr, &length);
-
-				size_t size = 0;
-				memcpy(&size, ptr, length);
-
-				itemData << size;
-				break;
-			}
-
-			case B_SSIZE_T_TYPE:
-			{
-				const void* ptr = NULL;
-				ssize_t length = 0;
-				fDataMessage->FindData(fFieldName, fFieldType, i, &ptr, &length);
-
-				ssize_t size = 0;
-				memcpy(&size, ptr, length);
-
-				itemData << size;
-				break;
-			}
-
-			case B_STRING_TYPE:
-				itemData = fDataMessage->GetString(fFieldName, i, "");
-				break;
-
-			case B_TIME_TYPE:
-			{
-				const void* ptr = NULL;
-				ssize_t length = 0;
-				fDataMessage->FindData(fFieldName, fFieldType, i, &ptr, &length);
-				unsigned char* buffer = new unsigned char[length];
-				memcpy(buffer, ptr, length);
-				time_t time = *(reinterpret_cast<time_t*>(buffer));
-				BDateTime datetime;
-				datetime.SetTime_t(time);
-
-				itemData
-						<< datetime.Date().Year() << "-"
-						<< (datetime.Date().Month() < 10 ? "0" : "")
-						<< datetime.Date().Month() << "-"
-						<< (datetime.Date().Day() < 10 ? "0" : "")
-						<< datetime.Date().Day() << " "
-						<< (datetime.Time().Hour() < 10 ? "0" : "")
-						<< datetime.Time().Hour() << ":"
-						<< (datetime.Time().Minute() < 10 ? "0" : "")
-						<< datetime.Time().Minute() << ":"
-						<< (datetime.Time().Second() < 10 ? "0" : "")
-						<< datetime.Time().Second();
-
-				delete[] buffer;
-				break;
-			}
-
-			case B_UINT8_TYPE:
-			{
-				itemData << fDataMessage->GetUInt8(fFieldName, i, 0);
-				break;
-			}
-
-			case B_UINT16_TYPE:
-			{
-				itemData << fDataMessage->GetUInt16(fFieldName, i, 0);
-				break;
-			}
-
-			case B_UINT32_TYPE:
-			{
-				itemData << fDataMessage->GetUInt32(fFieldName, i, 0);
-				break;
-			}
-
-			case B_UINT64_TYPE:
-			{
-				itemData << fDataMessage->GetUInt64(fFieldName, i, 0);
-				break;
+		if(fDataMessage->FindData(fFieldName, fFieldType, i, &ptr, &length) == B_OK) {
+			items[i] = ptr;
+			sizes[i] = length;
+			if(decode_item(fFieldType, ptr, length, itemData) == B_NOT_SUPPORTED) {
+				// No text form, the bytes go to the hex panel instead
+				itemData.SetToFormat(B_TRANSLATE("%" B_PRIdSSIZE " bytes"), length);
+				raw = true;
 			}
+		} else
+			itemData << B_TRANSLATE("data cannot be displayed");
 
-			default:
-				itemData << B_TRANSLATE("data cannot be displayed");
-				break;
-		}
-
+		fields[i] = new ValueField(itemData);
 		BRow* row = new BRow();
 		row->SetField(new BIntegerField(i), 0);
-		row->SetField(new BStringField(itemData), 1);
+		row->SetField(fields[i], 1);
 		fDataView->AddRow(row);
+
+		if(fFieldType == B_REF_TYPE && ptr)
+			ShowRefPath(ptr, length, row);
 	}
+	SetSortKeys(items, sizes, fields);
 
 	DataAreaView()->ResizeAllColumnsToPreferred();
+	fToolbar->FindButton(DV_BULK_EDIT_REQUESTED)->SetEnabled(
+		count > 0 && bulk_type_supported(fFieldType));
+	ShowStats();
+
+	if(raw) {
+		ShowRawItem(0);
+		if(fHexPanel->IsHidden(fHexPanel))
+			fHexPanel->Show();
+	}
 
 	if(Window()->IsLocked())
 		UnlockLooper();
@@ -447,14 +129,26 @@ DataView::Clear()
 {
 	fDataLabel->SetText("");
 	fDataView->Clear();
+	fToolbar->FindButton(DV_BULK_EDIT_REQUESTED)->SetEnabled(false);
+	fPendingRefs.clear();
+	fUnresolvedRefs = 0;
+	fHexPanel->SetData(NULL, 0);
+	if(!fHexPanel->IsHidden(fHexPanel))
+		fHexPanel->Hide();
+	if(!fStatsView->IsHidden(fStatsView))
+		fStatsView->Hide();
 }
 
 void
 DataView::AttachedToWindow()
 {
 	fDataView->SetTarget(this);
-	for(const auto& command : {DV_REMOVE_ENTRY_REQUESTED, DV_CLOSE_VIEW_REQUESTED})
+	for(const auto& command : {DV_REMOVE_ENTRY_REQUESTED, DV_CLOSE_VIEW_REQUESTED,
+			DV_BULK_EDIT_REQUESTED})
 		fToolbar->FindButton(command)->SetTarget(this);
+
+	// Anything asked for before there was a looper to reply to
+	RequestRefPaths();
 }
 
 void
@@ -465,6 +159,10 @@ DataView::MessageReceived(BMessage* msg)
 		case DV_ENTRY_SELECTED:
 		{
 			fToolbar->FindButton(DV_REMOVE_ENTRY_REQUESTED)->SetEnabled(true);
+
+			BRow* selection = fDataView->CurrentSelection();
+			if(selection && !fHexPanel->IsHidden(fHexPanel))
+				ShowRawItem(((BIntegerField*)selection->GetField(0))->Value());
 			break;
 		}
 		case DV_ENTRY_INVOKED:
@@ -499,6 +197,16 @@ DataView::MessageReceived(BMessage* msg)
 			Window()->PostMessage(&request);
 			break;
 		}
+		case DV_BULK_EDIT_REQUESTED:
+		{
+			OpenBulkEditor();
+			break;
+		}
+		case RPC_PATHS_RESOLVED:
+		{
+			ApplyRefPaths(msg);
+			break;
+		}
 		default:
 			return BView::MessageReceived(msg);
 	}
@@ -514,6 +222,10 @@ DataView::SetupControls()
 	fToolbar = new BToolBar(B_HORIZONTAL);
 	fToolbar->AddView(fDataLabel);
 	fToolbar->AddGlue();
+	fToolbar->AddAction(DV_BULK_EDIT_REQUESTED, this, NULL,
+		B_TRANSLATE("Change many items at once"),
+		B_TRANSLATE("Bulk edit" B_UTF8_ELLIPSIS), false);
+	fToolbar->FindButton(DV_BULK_EDIT_REQUESTED)->SetEnabled(false);
 	fToolbar->AddAction(DV_REMOVE_ENTRY_REQUESTED, this, trashIcon, B_TRANSLATE("Delete"), B_TRANSLATE("Delete"), false);
 	fToolbar->FindButton(DV_REMOVE_ENTRY_REQUESTED)->SetEnabled(false);
 	fToolbar->AddAction(DV_CLOSE_VIEW_REQUESTED, this, removeIcon, B_TRANSLATE("Close"), B_TRANSLATE("Close"), false);
@@ -525,16 +237,194 @@ DataView::SetupControls()
 	fDataView->SetInvocationMessage(new BMessage(DV_ENTRY_INVOKED));
 	fDataView->AddColumn(new BIntegerColumn(B_TRANSLATE("Index"), 70,
 		StringWidth(B_TRANSLATE("Index")) + be_control_look->DefaultLabelSpacing() * 2, 100), 0);
-	fDataView->AddColumn(new BStringColumn(B_TRANSLATE("Value"), 200,
+	fDataView->AddColumn(new ValueColumn(B_TRANSLATE("Value"), 200,
 		StringWidth(B_TRANSLATE("Value")) + be_control_look->DefaultLabelSpacing() * 2, 1000, 0), 1);
 	fDataView->AddStatusView(fStatusView);
 
+	fHexPanel = new HexPanel("hexpanel");
+	fHexPanel->Hide();
+
+	fStatsView = new StatsView("statsview");
+	fStatsView->Hide();
+
 	BLayoutBuilder::Group<>(this, B_VERTICAL, 0)
 		.Add(fToolbar)
-		.Add(fDataView)
+		.AddSplit(B_VERTICAL, B_USE_SMALL_SPACING)
+			.AddGroup(B_VERTICAL, 0)
+				.Add(fDataView)
+				.Add(fStatsView)
+			.End()
+			.Add(fHexPanel)
+		.End()
 	.Layout();
 }
 
+void
+DataView::ShowRawItem(int32 index)
+{
+	// The panel reads the bytes in place, they stay valid until the
+	// next SetTo() or Clear(). Items of a file in the other byte order
+	// are shown from a swapped copy, as they are stored on disk.
+	const void* ptr = NULL;
+	ssize_t length = 0;
+	if(!fDataMessage
+		|| fDataMessage->FindData(fFieldName, fFieldType, index, &ptr, &length) != B_OK) {
+		fHexPanel->SetData(NULL, 0);
+		return;
+	}
+
+	if(fFileSwapped) {
+		const uint8* bytes = static_cast<const uint8*>(ptr);
+		fRawItem.assign(bytes, bytes + length);
+		if(swap_item(fFieldType, fRawItem.data(), fRawItem.size()))
+			ptr = fRawItem.data();
+	}
+	fHexPanel->SetData(ptr, length);
+}
+
+void
+DataView::ShowStats()
+{
+	// Only refigured when the bytes of the field are new to the cache
+	field_stats stats;
+	if(fItemCount == 0 || !stats_type_supported(fFieldType)
+		|| fStatsCache.Get(*fDataMessage, fFieldName, fFieldType, &stats) != B_OK)
+		return;
+
+	fStatsView->SetStats(stats);
+	if(fStatsView->IsHidden(fStatsView))
+		fStatsView->Show();
+}
+
+void
+DataView::SetSortKeys(const std::vector<const void*>& items,
+	const std::vector<ssize_t>& sizes, const std::vector<ValueField*>& fields)
+{
+	// Worked out once here, so sorting on the value column only compares
+	// numbers and never decodes or formats an item again
+	int32 count = fields.size();
+	if(count == 0)
+		return;
+
+	std::vector<int32> ranks(count);
+	if(!rank_numbers(fFieldType, &items[0], &sizes[0], count, &ranks[0])) {
+		std::vector<const char*> texts(count);
+		for(int32 i = 0; i < count; i++)
+			texts[i] = fields[i]->String();
+		rank_strings(&texts[0], count, &ranks[0]);
+	}
+
+	for(int32 i = 0; i < count; i++)
+		fields[i]->SetRank(ranks[i]);
+}
+
+// Shows the path when it is known already; otherwise the row keeps the
+// raw device, directory and name until the cache has looked it up
+void
+DataView::ShowRefPath(const void* data, ssize_t length, BRow* row)
+{
+	RefPathCache* cache = RefPathCache::Default();
+	entry_ref ref;
+	if(!cache || !decode_ref(data, length, &ref))
+		return;
+
+	ref_info info;
+	if(cache->Lookup(ref, &info, BMessenger(this), fPendingRefs.size())) {
+		if(info.exists)
+			((ValueField*)row->GetField(1))->SetString(info.path);
+		return;
+	}
+
+	pending_ref pending;
+	pending.ref = ref;
+	pending.row = row;
+	fPendingRefs.push_back(pending);
+	fUnresolvedRefs++;
+}
+
+void
+DataView::RequestRefPaths()
+{
+	RefPathCache* cache = RefPathCache::Default();
+	if(!cache || fUnresolvedRefs == 0)
+		return;
+
+	BMessage reply(RPC_PATHS_RESOLVED);
+	for(size_t i = 0; i < fPendingRefs.size(); i++) {
+		ref_info info;
+		if(fPendingRefs[i].row
+			&& cache->Lookup(fPendingRefs[i].ref, &info, BMessenger(this), i)) {
+			reply.AddInt32("cookie", i);
+			reply.AddRef("refs", &fPendingRefs[i].ref);
+			reply.AddString("path", info.path);
+			reply.AddBool("exists", info.exists);
+		}
+	}
+	ApplyRefPaths(&reply);
+}
+
+void
+DataView::ApplyRefPaths(BMessage* reply)
+{
+	int32 cookie;
+	for(int32 i = 0; reply->FindInt32("cookie", i, &cookie) == B_OK; i++) {
+		// Replies to rows that were cleared since do not match any more
+		entry_ref ref;
+		if(cookie < 0 || cookie >= (int32)fPendingRefs.size()
+			|| !fPendingRefs[cookie].row
+			|| reply->FindRef("refs", i, &ref) != B_OK
+			|| !(ref == fPendingRefs[cookie].ref))
+			continue;
+
+		BRow* row = fPendingRefs[cookie].row;
+		fPendingRefs[cookie].row = NULL;
+		fUnresolvedRefs--;
+		if(reply->GetBool("exists", i, false)) {
+			((ValueField*)row->GetField(1))->SetString(
+				reply->GetString("path", i, ""));
+			fDataView->UpdateRow(row);
+		}
+	}
+
+	if(fUnresolvedRefs > 0 || fPendingRefs.empty())
+		return;
+
+	// All paths are in, sort on them rather than on the raw form
+	int32 count = fDataView->CountRows();
+	std::vector<ValueField*> fields(count);
+	std::vector<const char*> texts(count);
+	for(int32 i = 0; i < count; i++) {
+		BRow* row = fDataView->RowAt(i);
+		fields[i] = (ValueField*)row->GetField(1);
+		texts[i] = fields[i]->String();
+	}
+	std::vector<int32> ranks(count);
+	rank_strings(&texts[0], count, &ranks[0]);
+	for(int32 i = 0; i < count; i++)
+		fields[i]->SetRank(ranks[i]);
+	fPendingRefs.clear();
+}
+
+void
+DataView::OpenBulkEditor()
+{
+	// The selected rows give the range to start with
+	int32 first = -1, last = -1;
+	for(BRow* row = fDataView->CurrentSelection(); row;
+			row = fDataView->CurrentSelection(row)) {
+		int32 index = ((BIntegerField*)row->GetField(0))->Value();
+		if(first < 0 || index < first)
+			first = index;
+		if(index > last)
+			last = index;
+	}
+
+	BulkEditWindow* window = new BulkEditWindow(BRect(), fFieldName,
+		fFieldType, fItemCount, first, last, Window());
+	window->CenterIn(Window()->Frame());
+	window->Show();
+}
+
 void
 DataView::SetLabel(const char* name, const char* typeString)
 {
@@ -548,6 +438,20 @@ DataView::SetLabel(const char* name, const char* typeString)
 	fDataLabel->SetText(label);
 }
 
+// #pragma mark - ValueColumn
+
+ValueColumn::ValueColumn(const char* title, float width, float minWidth,
+	float maxWidth, uint32 truncate)
+: BStringColumn(title, width, minWidth, maxWidth, truncate)
+{
+}
+
+int
+ValueColumn::CompareFields(BField* field1, BField* field2)
+{
+	return ((ValueField*)field1)->Rank() - ((ValueField*)field2)->Rank();
+}
+
 #undef B_TRANSLATION_CONTEXT
 #define B_TRANSLATION_CONTEXT "DataWindow"
 
@@ -601,6 +505,8 @@ DataWindow::MessageReceived(BMessage *msg)
 
 		case DW_UPDATE:
 		{
+			// A bulk conversion changes the type of the field
+			fFieldType = msg->GetUInt32(KottanFieldType, fFieldType);
 			fDataView->Clear();
 			fDataView->SetTo(fDataMessage, fFieldName, fFieldType, fItemCount);
 			break;
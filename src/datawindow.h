@@ -10,15 +10,23 @@
 #include <Window.h>
 #include <String.h>
 #include <private/interface/ColumnListView.h>
+#include <private/interface/ColumnTypes.h>
 #include <private/shared/ToolBar.h>
 #include <Button.h>
 #include <StringView.h>
+#include <vector>
+#include "fieldstats.h"
+#include "refpathcache.h"
+
+class HexPanel;
+class StatsView;
 
 enum DataViewDefs {
 	DV_ENTRY_SELECTED = 'dv00',
 	DV_ENTRY_INVOKED,
 	DV_REMOVE_ENTRY_REQUESTED,
 	DV_CLOSE_VIEW_REQUESTED,
+	DV_BULK_EDIT_REQUESTED,
 };
 
 enum
@@ -29,6 +37,28 @@ enum
 	DW_UPDATE
 };
 
+// Value cell that sorts on the position of its item in value order
+class ValueField : public BStringField
+{
+public:
+						ValueField(const char* value)
+							: BStringField(value), fRank(0) {}
+
+			int32		Rank() const { return fRank; }
+			void		SetRank(int32 rank) { fRank = rank; }
+private:
+			int32		fRank;
+};
+
+class ValueColumn : public BStringColumn
+{
+public:
+						ValueColumn(const char* title, float width,
+							float minWidth, float maxWidth, uint32 truncate);
+
+	virtual	int			CompareFields(BField* field1, BField* field2);
+};
+
 class DataView : public BView
 {
 public:
@@ -45,16 +75,41 @@ public:
 	BColumnListView*	DataAreaView() { return fDataView; }
 
 			void		SetLabel(const char* name, const char* typeString);
+			void		SetFileSwapped(bool swapped) { fFileSwapped = swapped; }
 private:
 			void		SetupControls();
+			void		ShowRawItem(int32 index);
+			void		ShowStats();
+			void		SetSortKeys(const std::vector<const void*>& items,
+							const std::vector<ssize_t>& sizes,
+							const std::vector<ValueField*>& fields);
+			void		ShowRefPath(const void* data, ssize_t length,
+							BRow* row);
+			void		RequestRefPaths();
+			void		ApplyRefPaths(BMessage* reply);
+			void		OpenBulkEditor();
 private:
 	BMessage*			fDataMessage;
 	BString 			fFieldName;
 	type_code			fFieldType;
 	int32				fItemCount;
+	// Raw bytes are shown in the byte order of the file
+	bool				fFileSwapped;
+	std::vector<uint8>	fRawItem;
 
 	BStringView*		fDataLabel;
 	BColumnListView*	fDataView;
+	HexPanel*			fHexPanel;
+	StatsView*			fStatsView;
+	FieldStatsCache		fStatsCache;
+
+	struct pending_ref {
+		entry_ref		ref;
+		BRow*			row;
+	};
+	// Refs waiting for RefPathCache, the index is the cookie
+	std::vector<pending_ref> fPendingRefs;
+	int32				fUnresolvedRefs;
 	BView* 				fStatusView;
 	BButton*			fCloseButton;
 	BToolBar*			fToolbar;
@@ -68,6 +123,7 @@ public:
 			   int32 item_count);
 
 	void MessageReceived(BMessage *msg);
+	void SetFileSwapped(bool swapped) { fDataView->SetFileSwapped(swapped); }
 
 
 private:
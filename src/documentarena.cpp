@@ -0,0 +1,202 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#include <cstdlib>
+#include <cstring>
+#include "documentarena.h"
+
+static inline size_t
+align_up(size_t value, size_t alignment)
+{
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+DocumentArena::DocumentArena(size_t blockSize)
+: fBlockSize(blockSize),
+  fBlocks(NULL),
+  fCurrent(NULL),
+  fEnd(NULL),
+  fFinalizers(NULL)
+{
+	memset(fFree, 0, sizeof(fFree));
+	memset(&fStats, 0, sizeof(fStats));
+}
+
+DocumentArena::~DocumentArena()
+{
+	Release();
+	free(fBlocks);
+}
+
+void*
+DocumentArena::Allocate(size_t size, size_t alignment)
+{
+	if(size == 0)
+		size = 1;
+
+	// A recycled chunk of the class is at least as large as the request
+	if(size <= kMaxRecycledSize && alignment <= sizeof(void*)) {
+		size_t index = (size + kRecycleGranularity - 1) / kRecycleGranularity;
+		free_chunk* chunk = fFree[index];
+		if(chunk) {
+			fFree[index] = chunk->next;
+			fStats.allocations++;
+			fStats.bytes_wasted -= chunk->size;
+			return chunk;
+		}
+	}
+
+	uint8* start = reinterpret_cast<uint8*>(
+		align_up(reinterpret_cast<addr_t>(fCurrent), alignment));
+	if(!fCurrent || start + size > fEnd) {
+		if(!_AddBlock(size + alignment))
+			return NULL;
+		start = reinterpret_cast<uint8*>(
+			align_up(reinterpret_cast<addr_t>(fCurrent), alignment));
+	}
+
+	fStats.allocations++;
+	fStats.bytes_used += (start - fCurrent) + size;
+	fCurrent = start + size;
+	return start;
+}
+
+char*
+DocumentArena::CopyString(const char* string, int32 length)
+{
+	if(!string)
+		return NULL;
+	if(length < 0)
+		length = strlen(string);
+
+	char* copy = static_cast<char*>(Allocate(length + 1, 1));
+	if(!copy)
+		return NULL;
+
+	memcpy(copy, string, length);
+	copy[length] = '\0';
+	return copy;
+}
+
+void
+DocumentArena::Recycle(void* memory, size_t size)
+{
+	if(!memory || size == 0)
+		return;
+
+	fStats.bytes_wasted += size;
+
+	// Chunks go to the largest class they can serve in full; those too
+	// small or too large for one, or not aligned for any object, are lost
+	// until the release
+	size_t index = size / kRecycleGranularity;
+	if(index == 0 || size > kMaxRecycledSize
+		|| reinterpret_cast<addr_t>(memory) % sizeof(void*) != 0)
+		return;
+
+	free_chunk* chunk = static_cast<free_chunk*>(memory);
+	chunk->size = size;
+	chunk->next = fFree[index];
+	fFree[index] = chunk;
+}
+
+void
+DocumentArena::Release()
+{
+	// Run the pending destructors, newest first
+	for(finalizer* item = fFinalizers; item != NULL; item = item->next)
+		item->destroy(item->object);
+	fFinalizers = NULL;
+
+	// Keep one block of the usual size so that opening the next document
+	// does not need to go to the heap again; blocks made larger for a
+	// single allocation are never kept
+	block* kept = NULL;
+	while(fBlocks) {
+		block* next = fBlocks->next;
+		if(!kept && fBlocks->size == fBlockSize) {
+			kept = fBlocks;
+			kept->next = NULL;
+		} else {
+			fStats.block_bytes -= fBlocks->size;
+			free(fBlocks);
+		}
+		fBlocks = next;
+	}
+	fBlocks = kept;
+	if(kept) {
+		fCurrent = reinterpret_cast<uint8*>(kept) + align_up(sizeof(block), 16);
+		fEnd = reinterpret_cast<uint8*>(kept) + kept->size;
+	} else {
+		fCurrent = NULL;
+		fEnd = NULL;
+	}
+
+	memset(fFree, 0, sizeof(fFree));
+	fStats.allocations = 0;
+	fStats.bytes_used = 0;
+	fStats.bytes_wasted = 0;
+	fStats.finalizers = 0;
+	fStats.releases++;
+}
+
+void
+DocumentArena::GetStats(arena_stats* stats) const
+{
+	if(stats)
+		*stats = fStats;
+}
+
+void
+DocumentArena::GetReport(BMessage* report) const
+{
+	if(!report)
+		return;
+
+	report->MakeEmpty();
+	report->AddUInt64("allocations", fStats.allocations);
+	report->AddUInt64("bytes_used", fStats.bytes_used);
+	report->AddUInt64("blocks", fStats.blocks);
+	report->AddUInt64("block_bytes", fStats.block_bytes);
+	report->AddUInt64("finalizers", fStats.finalizers);
+	report->AddUInt64("releases", fStats.releases);
+	report->AddUInt64("bytes_wasted", fStats.bytes_wasted);
+}
+
+// #pragma mark - DocumentArena::Private
+
+bool
+DocumentArena::_AddBlock(size_t minSize)
+{
+	size_t headerSize = align_up(sizeof(block), 16);
+	size_t size = fBlockSize;
+	if(minSize + headerSize > size)
+		size = minSize + headerSize;
+
+	block* newBlock = static_cast<block*>(malloc(size));
+	if(!newBlock)
+		return false;
+
+	newBlock->next = fBlocks;
+	newBlock->size = size;
+	fBlocks = newBlock;
+	fCurrent = reinterpret_cast<uint8*>(newBlock) + headerSize;
+	fEnd = reinterpret_cast<uint8*>(newBlock) + size;
+
+	fStats.blocks++;
+	fStats.block_bytes += size;
+	return true;
+}
+
+void
+DocumentArena::_PushFinalizer(finalizer* item, void (*destroy)(void*),
+	void* object)
+{
+	item->destroy = destroy;
+	item->object = object;
+	item->next = fFinalizers;
+	fFinalizers = item;
+	fStats.finalizers++;
+}
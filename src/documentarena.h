@@ -0,0 +1,156 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef __DOCUMENT_ARENA_H__
+#define __DOCUMENT_ARENA_H__
+
+#include <Message.h>
+#include <SupportDefs.h>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+struct arena_stats {
+	uint64		allocations;	// objects and strings handed out
+	uint64		bytes_used;		// bytes handed out, alignment included
+	uint64		blocks;			// blocks requested from the heap
+	uint64		block_bytes;	// size of the blocks currently held
+	uint64		finalizers;		// objects with a destructor to run on release
+	uint64		releases;		// times the arena was released as a whole
+	uint64		bytes_wasted;	// given back and not handed out again yet
+};
+
+/*	Bump allocator owning everything decoded for one open document: tree
+	nodes, names, nested message copies and the rows of the message view.
+	Release() drops all of it at once and keeps one block of the usual size
+	around for the next document.
+
+	Memory that an edit no longer needs can be handed back with Recycle().
+	Small pieces go to a free list per 16 byte size class and serve later
+	allocations of the same class, so the nodes and rows of a document
+	that is edited again and again don't pile up; anything else stays
+	where it is until the release and only shows up as wasted bytes.
+*/
+class DocumentArena
+{
+public:
+	static	const size_t	kDefaultBlockSize = 64 * 1024;
+	static	const size_t	kRecycleGranularity = 16;
+	static	const size_t	kMaxRecycledSize = 256;
+
+							DocumentArena(size_t blockSize = kDefaultBlockSize);
+							~DocumentArena();
+
+			void*			Allocate(size_t size,
+								size_t alignment = sizeof(void*));
+			char*			CopyString(const char* string, int32 length = -1);
+			void			Recycle(void* memory, size_t size);
+
+	template<class T, class... Args>
+			T*				New(Args&&... args);
+
+			void			Release();
+			void			GetStats(arena_stats* stats) const;
+			void			GetReport(BMessage* report) const;
+private:
+	struct block {
+		block*		next;
+		size_t		size;
+	};
+
+	struct free_chunk {
+		free_chunk*	next;
+		size_t		size;
+	};
+
+	struct finalizer {
+		void		(*destroy)(void* object);
+		void*		object;
+		finalizer*	next;
+	};
+
+	template<class T>
+	static	void			_Destroy(void* object)
+								{ static_cast<T*>(object)->~T(); }
+
+			bool			_AddBlock(size_t minSize);
+			void			_PushFinalizer(finalizer* item,
+								void (*destroy)(void*), void* object);
+private:
+			size_t			fBlockSize;
+			block*			fBlocks;
+			uint8*			fCurrent;
+			uint8*			fEnd;
+			finalizer*		fFinalizers;
+			free_chunk*		fFree[kMaxRecycledSize / kRecycleGranularity + 1];
+			arena_stats		fStats;
+};
+
+
+template<class T, class... Args>
+T*
+DocumentArena::New(Args&&... args)
+{
+	finalizer* item = NULL;
+	if(!std::is_trivially_destructible<T>::value) {
+		item = static_cast<finalizer*>(Allocate(sizeof(finalizer)));
+		if(!item)
+			return NULL;
+	}
+
+	void* memory = Allocate(sizeof(T), alignof(T));
+	if(!memory)
+		return NULL;
+
+	T* object = new(memory) T(std::forward<Args>(args)...);
+	if(item)
+		_PushFinalizer(item, &DocumentArena::_Destroy<T>, object);
+	return object;
+}
+
+
+/*	Mixin for objects whose owner deletes them the usual way, such as rows
+	and fields handed to a BColumnListView. Each object remembers its arena
+	in front of itself, so deleting it runs the destructor and recycles
+	the memory.
+*/
+template<class Base>
+class ArenaObject : public Base
+{
+public:
+	using Base::Base;
+
+	static	void*			operator new(size_t size, DocumentArena& arena) noexcept;
+	static	void			operator delete(void* object, DocumentArena&) noexcept
+								{ operator delete(object, sizeof(ArenaObject)); }
+	static	void			operator delete(void* object, size_t size) noexcept;
+};
+
+
+template<class Base>
+void*
+ArenaObject<Base>::operator new(size_t size, DocumentArena& arena) noexcept
+{
+	void* memory = arena.Allocate(sizeof(DocumentArena*) + size);
+	if(!memory)
+		return NULL;
+
+	*static_cast<DocumentArena**>(memory) = &arena;
+	return static_cast<uint8*>(memory) + sizeof(DocumentArena*);
+}
+
+template<class Base>
+void
+ArenaObject<Base>::operator delete(void* object, size_t size) noexcept
+{
+	if(!object)
+		return;
+
+	uint8* memory = static_cast<uint8*>(object) - sizeof(DocumentArena*);
+	(*reinterpret_cast<DocumentArena**>(memory))->Recycle(memory,
+		sizeof(DocumentArena*) + size);
+}
+
+#endif /* __DOCUMENT_ARENA_H__ */
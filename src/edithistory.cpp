@@ -0,0 +1,84 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#include "edithistory.h"
+
+EditHistory::EditHistory(int32 limit)
+: fCurrent(-1),
+  fLimit(limit)
+{
+}
+
+void
+EditHistory::Reset(const BMessage& root)
+{
+	fVersions.clear();
+	fVersions.push_back(BReference<PersistentMessage>(
+		PersistentMessage::Create(root), true));
+	fCurrent = 0;
+}
+
+void
+EditHistory::Record(const BMessage& root, const BMessage& change,
+	bool wholeLevel)
+{
+	if(fCurrent < 0) {
+		Reset(root);
+		return;
+	}
+
+	PersistentMessage* version = fVersions[fCurrent]->Update(root, change,
+		wholeLevel);
+	if(!version) {
+		// The change doesn't match what we have, take the whole message
+		version = PersistentMessage::Create(root);
+	}
+
+	// A new edit drops whatever could have been redone
+	fVersions.resize(fCurrent + 1);
+	fVersions.push_back(BReference<PersistentMessage>(version, true));
+	if((int32)fVersions.size() > fLimit + 1)
+		fVersions.pop_front();
+	fCurrent = fVersions.size() - 1;
+}
+
+status_t
+EditHistory::Undo(BMessage* root, BMessage* changes)
+{
+	if(!CanUndo())
+		return B_NOT_ALLOWED;
+	return _MoveTo(fCurrent - 1, root, changes);
+}
+
+status_t
+EditHistory::Redo(BMessage* root, BMessage* changes)
+{
+	if(!CanRedo())
+		return B_NOT_ALLOWED;
+	return _MoveTo(fCurrent + 1, root, changes);
+}
+
+// #pragma mark - EditHistory::Private
+
+status_t
+EditHistory::_MoveTo(int32 index, BMessage* root, BMessage* changes)
+{
+	status_t status = PersistentMessage::Apply(fVersions[fCurrent].Get(),
+		fVersions[index].Get(), root, changes);
+	if(status != B_OK) {
+		// Leave the message matching the version we claim to be at
+		root->MakeEmpty();
+		fVersions[index]->Materialize(root);
+		if(changes) {
+			BMessage descriptor;
+			descriptor.AddBool("replaced", true);
+			changes->MakeEmpty();
+			changes->AddMessage("change", &descriptor);
+		}
+	}
+
+	fCurrent = index;
+	return B_OK;
+}
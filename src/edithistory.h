@@ -0,0 +1,50 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef __EDIT_HISTORY_H__
+#define __EDIT_HISTORY_H__
+
+#include <Message.h>
+#include <deque>
+#include "persistentmessage.h"
+
+/*	Undo and redo for the message being edited. Every step is a version of
+	a PersistentMessage, so a step costs the messages on the path to the
+	change rather than a copy of the whole document. Moving through the
+	history patches the live message in place and fills changes with one
+	descriptor per message that had to be touched.
+*/
+class EditHistory
+{
+public:
+	static	const int32		kDefaultLimit = 4096;
+
+							EditHistory(int32 limit = kDefaultLimit);
+
+			void			Reset(const BMessage& root);
+			void			Record(const BMessage& root, const BMessage& change,
+								bool wholeLevel = false);
+
+			PersistentMessage*	Current() const
+								{ return fCurrent >= 0
+									? fVersions[fCurrent].Get() : NULL; }
+
+			bool			CanUndo() const { return fCurrent > 0; }
+			bool			CanRedo() const
+								{ return fCurrent + 1 < (int32)fVersions.size(); }
+
+			status_t		Undo(BMessage* root, BMessage* changes);
+			status_t		Redo(BMessage* root, BMessage* changes);
+private:
+			status_t		_MoveTo(int32 index, BMessage* root,
+								BMessage* changes);
+private:
+			// Oldest first, steps beyond the limit fall off the front
+			std::deque<BReference<PersistentMessage> > fVersions;
+			int32			fCurrent;
+			int32			fLimit;
+};
+
+#endif /* __EDIT_HISTORY_H__ */
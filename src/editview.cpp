@@ -5,6 +5,9 @@
  */
 
 #include "editview.h"
+#include "hexview.h"
+#include "itemdecoder.h"
+#include "refpathcache.h"
 #include <Box.h>
 #include <Button.h>
 #include <LayoutBuilder.h>
@@ -14,11 +17,12 @@
 #include <Path.h>
 #include <ios>
 #include <private/interface/ColumnTypes.h>
-#include <IconUtils.h>
+#include <algorithm>
 #include <limits>
 #include <cctype>
 #include <cstdlib>
 #include <cstdio>
+#include <cstring>
 
 #undef B_TRANSLATION_CONTEXT
 #define B_TRANSLATION_CONTEXT "EditView"
@@ -54,15 +58,27 @@ rowIndex(BColumnListView* view, int32 colIndex, const char* name)
 // #pragma mark -
 
 PreviewableView::PreviewableView(BRect frame, BBitmap* bitmap)
-	: BView(frame, "preview", B_FOLLOW_ALL, B_WILL_DRAW),
-	fBitmap(bitmap)
+	: BView(frame, "preview", B_FOLLOW_ALL,
+		B_WILL_DRAW | B_FRAME_EVENTS | B_FULL_UPDATE_ON_RESIZE),
+	fBitmap(bitmap),
+	fIconSize(0)
 {
 	bgColor = ui_color(B_DOCUMENT_BACKGROUND_COLOR);
 }
 
+void
+PreviewableView::AttachedToWindow()
+{
+	BView::AttachedToWindow();
+	request_icon();
+}
+
 void
 PreviewableView::Draw(BRect rect)
 {
+	SetHighColor(bgColor);
+	FillRect(Bounds());
+
 	SetHighUIColor(B_CONTROL_BORDER_COLOR);
 	SetPenSize(2.0f);
 	BRect border = BRect(Bounds().left + 1, Bounds().top + 1,
@@ -70,34 +86,64 @@ PreviewableView::Draw(BRect rect)
 	MovePenTo(Bounds().left, Bounds().top);
 	StrokeRect(border);
 
-	SetHighColor(bgColor);
-	FillRect(Bounds());
-
 	if(fBitmap) {
 		BRect imageRect = fBitmap->Bounds();
-		BRect viewRect = Frame().InsetByCopy(4.0f, 4.0f);
+		BRect viewRect = Bounds().InsetByCopy(4.0f, 4.0f);
 		BRect resultRect;
 		proportional_view(viewRect, imageRect, &resultRect);
+		resultRect.OffsetBy(viewRect.LeftTop());
 
 		auto dmode = DrawingMode();
 		SetDrawingMode(B_OP_ALPHA);
 		DrawBitmap(fBitmap, resultRect);
 		SetDrawingMode(dmode);
 	}
+}
 
-	Invalidate();
+void
+PreviewableView::FrameResized(float width, float height)
+{
+	BView::FrameResized(width, height);
+	request_icon();
+}
+
+void
+PreviewableView::MessageReceived(BMessage* msg)
+{
+	switch(msg->what)
+	{
+		case IC_ICON_READY:
+			request_icon();
+			break;
+		default:
+			BView::MessageReceived(msg);
+	}
 }
 
 void
 PreviewableView::BorrowBitmap(BBitmap* bitmap)
 {
 	fBitmap = bitmap;
+	Invalidate();
 }
 
 void
 PreviewableView::ReturnBitmap()
 {
 	fBitmap = NULL;
+	Invalidate();
+}
+
+void
+PreviewableView::SetIcon(const void* data, ssize_t length)
+{
+	const uint8* bytes = static_cast<const uint8*>(data);
+	fIconData.assign(bytes, bytes + length);
+	fIcon.reset();
+	fIconSize = 0;
+	fBitmap = NULL;
+	request_icon();
+	Invalidate();
 }
 
 void
@@ -116,6 +162,36 @@ PreviewableView::proportional_view(BRect viewRect, BRect imageRect, BRect* resul
     resultRect->Set(sx, sy, sx + w, sy + h);
 }
 
+void
+PreviewableView::request_icon()
+{
+	if(fIconData.empty() || !Window())
+		return;
+
+	// Rendered in steps of 32 pixels, the last one is scaled until the
+	// next size is ready
+	int32 edge = (int32)std::min(Bounds().Width(), Bounds().Height()) - 8;
+	int32 size = std::max(32, std::min(1024, (edge + 31) / 32 * 32));
+	if(size == fIconSize)
+		return;
+
+	IconCache::bitmap_ref icon;
+	IconCache* cache = IconCache::Default();
+	if(cache) {
+		if(!cache->Lookup(B_VECTOR_ICON_TYPE, fIconData.data(),
+				fIconData.size(), size, &icon, BMessenger(this)))
+			return;
+	} else {
+		icon = IconCache::Rasterize(B_VECTOR_ICON_TYPE, fIconData.data(),
+			fIconData.size(), size);
+	}
+
+	fIcon = icon;
+	fIconSize = size;
+	fBitmap = fIcon.get();
+	Invalidate();
+}
+
 // #pragma mark -
 
 EditView::EditView(BMessage* msg, type_code type, const char* label, int32 index, bool creating)
@@ -125,8 +201,7 @@ EditView::EditView(BMessage* msg, type_code type, const char* label, int32 index
 	fDataType(type),
 	fDataLabel(label),
 	fDataIndex(index),
-	fIsCreating(creating),
-	fPreviewableBitmap(NULL)
+	fIsCreating(creating)
 {
 	fDescFont = be_plain_font;
 	fDescFont.SetFace(B_ITALIC_FACE);
@@ -181,8 +256,6 @@ EditView::EditView(BMessage* msg, type_code type, const char* label, int32 index
 
 EditView::~EditView()
 {
-	if(fPreviewableBitmap)
-		delete fPreviewableBitmap;
 }
 
 bool
@@ -200,6 +273,15 @@ EditView::IsSaveable()
 		return IsEditable();
 }
 
+const char*
+EditView::FieldName() const
+{
+	if(fIsCreating)
+		return fTextCtrlName->Text();
+	else
+		return fDataLabel;
+}
+
 void
 EditView::SetDataFor(type_code type, const void* data)
 {
@@ -208,8 +290,9 @@ EditView::SetDataFor(type_code type, const void* data)
 		case B_NODE_REF_TYPE:
 		{
 			const entry_ref* ref = static_cast<const entry_ref*>(data);
-			node_ref nref;
-			BEntry(ref).GetNodeRef(&nref);
+			ref_info info;
+			resolve_ref(*ref, &info);
+			node_ref nref = info.node;
 			BString dev_t_data = BString().SetToFormat("%" B_PRIdDEV, nref.device);
 			BString ino_t_data = BString().SetToFormat("%" B_PRIdINO, nref.node);
 
@@ -261,9 +344,8 @@ EditView::SetDataFor(type_code type, const void* data)
 			const entry_ref* ref = static_cast<const entry_ref*>(data);
 			BString dev_t_data = BString().SetToFormat("%" B_PRIdDEV, ref->device);
 			BString ino_t_data = BString().SetToFormat("%" B_PRIdINO, ref->directory);
-			BEntry entry(ref);
-			BPath path;
-			entry.GetPath(&path);
+			ref_info info;
+			resolve_ref(*ref, &info);
 
 			if(fIsCreating) { // Pre create the rows when in creation mode
 				BRow* deviceRow = new BRow();
@@ -290,7 +372,7 @@ EditView::SetDataFor(type_code type, const void* data)
 			((BStringField*)fDataViewer->RowAt(rowIndex(fDataViewer, 0,
 				B_TRANSLATE("Name")))->GetField(1))->SetString(ref->name);
 
-			fTextCtrl1->SetText(path.Path());
+			fTextCtrl1->SetText(info.path);
 
 			Window()->PostMessage(EV_DATA_CHANGED);
 			break;
@@ -1032,12 +1114,11 @@ EditView::SetupControls()
 		/* Non editable data below */
 		case B_VECTOR_ICON_TYPE:
 		{
-			fPreviewableBitmap = new BBitmap(BRect(0, 0, 300, 300), B_RGBA32);
+			PreviewableView* bitmapView = new PreviewableView(BRect(0, 0, 127, 127), NULL);
 			const void* data = NULL;
 			ssize_t length = 0;
-			fDataMessage->FindData(fDataLabel, B_VECTOR_ICON_TYPE, fDataIndex, &data, &length);
-			BIconUtils::GetVectorIcon(static_cast<const uint8*>(data), length, fPreviewableBitmap);
-			PreviewableView* bitmapView = new PreviewableView(BRect(0, 0, 127, 127), fPreviewableBitmap);
+			if(fDataMessage->FindData(fDataLabel, B_VECTOR_ICON_TYPE, fDataIndex, &data, &length) == B_OK)
+				bitmapView->SetIcon(data, length);
 			fSvDescription->SetText(B_TRANSLATE("Preview:"));
 			not_editable_text->SetFont(&fDescFont);
 			not_editable_text->SetHighColor(fDescColor);
@@ -1050,6 +1131,15 @@ EditView::SetupControls()
 
 		default:
 		{
+			// Raw and unknown types can at least be looked at
+			const void* data = NULL;
+			ssize_t length = 0;
+			if(!fIsCreating && fDataMessage->FindData(fDataLabel, fDataType,
+					fDataIndex, &data, &length) == B_OK) {
+				HexPanel* hexPanel = new HexPanel("hexpanel");
+				hexPanel->SetData(data, length);
+				fMainLayout->AddView(hexPanel);
+			}
 			not_editable_text->SetFont(&fDescFont);
 			not_editable_text->SetHighColor(fDescColor);
 			fMainLayout->AddView(not_editable_text);
@@ -1071,6 +1161,8 @@ EditView::InitControlsData()
 				ssize_t length = 0;
 				fDataMessage->FindData(fDataLabel, B_AFFINE_TRANSFORM_TYPE,
 					fDataIndex, &ptr, &length);
+				if(!item_size_valid(B_AFFINE_TRANSFORM_TYPE, length) || !ptr)
+					break;
 
 				double tx, ty, sx, sy, shx, shy;
 
@@ -1080,7 +1172,8 @@ EditView::InitControlsData()
 				// affineTransform.GetAffineParameters(&tx, &ty, NULL, &sx, &sy, &shx, &shy);
 
 				/* so let's try with raw manipulation */
-				const double* raw = static_cast<const double*>(ptr);
+				double raw[6];
+				memcpy(raw, ptr, sizeof(raw));
 				tx = raw[4];
 				ty = raw[5];
 				sx = raw[0];
@@ -1150,6 +1243,8 @@ EditView::InitControlsData()
 				const void* ptr = NULL;
 				ssize_t length = 0;
 				fDataMessage->FindData(fDataLabel, B_CHAR_TYPE, fDataIndex, &ptr, &length);
+				if(!item_size_valid(B_CHAR_TYPE, length) || !ptr)
+					break;
 				c = *(static_cast<const unsigned char*>(ptr));
 				fIntegerSpinner1->SetValue(static_cast<int32>(c));
 
@@ -1198,8 +1293,10 @@ EditView::InitControlsData()
 			{
 				const void* ptr = NULL;
 				ssize_t length = 0;
-				fDataMessage->FindData(fDataLabel, B_MIME_TYPE, fDataIndex, &ptr, &length);
-				BString mimeString(static_cast<const char*>(ptr));
+				if(fDataMessage->FindData(fDataLabel, B_MIME_TYPE, fDataIndex, &ptr, &length) != B_OK)
+					break;
+				const char* mimePtr = static_cast<const char*>(ptr);
+				BString mimeString(mimePtr, strnlen(mimePtr, length));
 				fTextCtrl1->SetText(mimeString);
 				break;
 			}
@@ -1227,7 +1324,9 @@ EditView::InitControlsData()
 				const void* ptr = NULL;
 				ssize_t length = 0;
 				fDataMessage->FindData(fDataLabel, B_OFF_T_TYPE, fDataIndex, &ptr, &length);
-				memcpy(&offset, ptr, length);
+				if(!item_size_valid(B_OFF_T_TYPE, length) || !ptr)
+					break;
+				memcpy(&offset, ptr, sizeof(offset));
 				fIntegerSpinner1->SetValue(static_cast<int32>(offset));
 				break;
 			}
@@ -1253,12 +1352,11 @@ EditView::InitControlsData()
 			{
 				entry_ref ref;
 				fDataMessage->FindRef(fDataLabel, fDataIndex, &ref);
-				BEntry entry(&ref);
-				BPath path;
-				entry.GetPath(&path);
+				ref_info info;
+				resolve_ref(ref, &info);
 
-				if(entry.Exists()) {
-					fTextCtrl1->SetText(path.Path());
+				if(info.exists) {
+					fTextCtrl1->SetText(info.path);
 				}
 
 				BRow* deviceRow = new BRow();
@@ -1284,7 +1382,10 @@ EditView::InitControlsData()
 				const void *color_ptr = NULL;
 				ssize_t data_size = sizeof(rgb_color);
 				fDataMessage->FindData(fDataLabel, B_RGB_COLOR_TYPE, fDataIndex, &color_ptr, &data_size);
-				rgb_color data_rgbcolor = *(static_cast<const rgb_color*>(color_ptr));
+				if(!item_size_valid(B_RGB_COLOR_TYPE, data_size) || !color_ptr)
+					break;
+				rgb_color data_rgbcolor;
+				memcpy(&data_rgbcolor, color_ptr, sizeof(data_rgbcolor));
 				fIntegerSpinner1->SetValue(data_rgbcolor.red);
 				fIntegerSpinner2->SetValue(data_rgbcolor.green);
 				fIntegerSpinner3->SetValue(data_rgbcolor.blue);
@@ -1317,9 +1418,20 @@ EditView::InitControlsData()
 				const void* ptr = NULL;
 				ssize_t length = 0;
 				fDataMessage->FindData(fDataLabel, fDataType, fDataIndex, &ptr, &length);
-				unsigned char* buffer = new unsigned char[length];
-				memcpy(buffer, ptr, length);
-				time_t time = *(reinterpret_cast<time_t*>(buffer));
+				if(!item_size_valid(B_TIME_TYPE, length) || !ptr)
+					break;
+
+				// Written as 32 or 64 bit depending on the platform
+				time_t time;
+				if(length == sizeof(int32)) {
+					int32 time32;
+					memcpy(&time32, ptr, sizeof(time32));
+					time = time32;
+				} else {
+					int64 time64;
+					memcpy(&time64, ptr, sizeof(time64));
+					time = time64;
+				}
 				BDateTime datetime;
 				datetime.SetTime_t(time);
 
@@ -1329,8 +1441,6 @@ EditView::InitControlsData()
 				fIntegerSpinner3->SetValue(datetime.Time().Hour());
 				fIntegerSpinner4->SetValue(datetime.Time().Minute());
 				fIntegerSpinner5->SetValue(datetime.Time().Second());
-
-				delete[] buffer;
 				break;
 			}
 			case B_UINT8_TYPE:
@@ -20,6 +20,9 @@
 #include <private/interface/Spinner.h>
 #include <private/interface/ColumnListView.h>
 #include <private/interface/DecimalSpinner.h>
+#include <vector>
+
+#include "iconcache.h"
 
 enum
 {
@@ -33,14 +36,24 @@ class PreviewableView : public BView
 {
 public:
 	PreviewableView(BRect frame, BBitmap* bitmap);
+	virtual void AttachedToWindow();
 	virtual void Draw(BRect updateRect);
+	virtual void FrameResized(float width, float height);
+	virtual void MessageReceived(BMessage* msg);
 			void BorrowBitmap(BBitmap* bitmap);
 			void ReturnBitmap();
+			void SetIcon(const void* data, ssize_t length);
 private:
 	void proportional_view(BRect viewRect, BRect imageRect, BRect* resultRect);
+	void request_icon();
 private:
 	BBitmap* fBitmap;
 	rgb_color bgColor;
+
+	// Vector icon rendered by the IconCache at the size of the view
+	std::vector<uint8> fIconData;
+	IconCache::bitmap_ref fIcon;
+	int32 fIconSize;
 };
 
 class EditView : public BView {
@@ -54,6 +67,7 @@ public:
 			status_t 	SaveData();
 			void		SetDataFor(type_code type, const void* data);
 	const	type_code	Type() const { return fDataType; }
+			const char*	FieldName() const;
 
 private:
 			void		SetupControls();
@@ -95,7 +109,6 @@ private:
 	BTextControl		*fTextCtrl3;
 	BTextControl		*fTextCtrl4;
 
-	BBitmap				*fPreviewableBitmap;
 };
 
 #endif
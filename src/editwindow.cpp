@@ -69,6 +69,7 @@ EditWindow::MessageReceived(BMessage *msg)
 			fEditView->SaveData();
 			BMessage reply(msg->what);
 			reply.AddBool("create", isCreating);
+			reply.AddString(KottanFieldName, fEditView->FieldName());
 			if(callerMessenger)
 				reply.AddPointer("target", callerMessenger);
 			be_app->PostMessage(&reply);
@@ -0,0 +1,336 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+#include "checksum.h"
+#include "fieldstats.h"
+#include "numericitem.h"
+
+// #pragma mark - Kernels
+
+template<typename T>
+struct Lanes {
+	static const size_t kCount = Vector<T>::kLanes;
+
+	typedef typename Vector<T>::type vector;
+	typedef decltype(vector() != vector()) mask;
+	// The same lanes widened, for sums that must not overflow
+	typedef double wide __attribute__((vector_size(sizeof(double) * kCount)));
+	typedef int64 wide_mask
+		__attribute__((vector_size(sizeof(int64) * kCount)));
+};
+
+// Integers are always finite; for floats x - x is NaN for NaN and Inf
+template<typename T>
+static inline bool
+is_finite(T value)
+{
+	return value - value == 0;
+}
+
+// Range, sum and the items that are left out
+template<typename T>
+static void
+first_pass(const uint8* items, size_t count, field_stats* stats, double* sum)
+{
+	typedef Lanes<T> lanes;
+	typedef typename lanes::vector vector;
+	typedef typename lanes::mask mask;
+	typedef typename lanes::wide wide;
+	typedef std::numeric_limits<T> limits;
+
+	vector low = vector() + limits::max();
+	vector high = vector() + limits::lowest();
+	mask nans = mask();
+	mask excluded = mask();
+	wide total = wide();
+
+	size_t i = 0;
+	for(; i + lanes::kCount <= count; i += lanes::kCount) {
+		vector v;
+		memcpy(&v, items + i * sizeof(T), sizeof(v));
+		mask finite = v - v == vector();
+
+		nans -= v != v;		// true lanes are -1
+		excluded -= ~finite;
+		low = (finite & (v < low)) ? v : low;
+		high = (finite & (v > high)) ? v : high;
+		total += __builtin_convertvector(finite ? v : vector(), wide);
+	}
+
+	T min = limits::max();
+	T max = limits::lowest();
+	int64 nanCount = 0, excludedCount = 0;
+	*sum = 0;
+	for(size_t lane = 0; lane < lanes::kCount; lane++) {
+		min = low[lane] < min ? low[lane] : min;
+		max = high[lane] > max ? high[lane] : max;
+		nanCount += nans[lane];
+		excludedCount += excluded[lane];
+		*sum += total[lane];
+	}
+
+	for(; i < count; i++) {
+		T value;
+		memcpy(&value, items + i * sizeof(T), sizeof(T));
+		if(!is_finite(value)) {
+			excludedCount++;
+			nanCount += value != value;
+			continue;
+		}
+		min = value < min ? value : min;
+		max = value > max ? value : max;
+		*sum += value;
+	}
+
+	stats->finite = count - excludedCount;
+	stats->nans = nanCount;
+	stats->infinities = excludedCount - nanCount;
+	stats->min = min;
+	stats->max = max;
+}
+
+// Squared deviations from the mean and the histogram
+template<typename T>
+static double
+second_pass(const uint8* items, size_t count, field_stats* stats)
+{
+	typedef Lanes<T> lanes;
+	typedef typename lanes::vector vector;
+	typedef typename lanes::mask mask;
+	typedef typename lanes::wide wide;
+	typedef typename lanes::wide_mask wide_mask;
+
+	// Integer bins are whole numbers wide, so a small range is not spread
+	// over bins that can never be hit
+	double range = stats->max - stats->min;
+	stats->bins = kStatsBins;
+	if(std::numeric_limits<T>::is_integer) {
+		range += 1;
+		if(range < kStatsBins)
+			stats->bins = range;
+	}
+	const double scale = range > 0 ? stats->bins / range : 0;
+	const wide_mask lastBin = wide_mask() + (stats->bins - 1);
+
+	// Lanes that are not counted go to one bin past the end, so the scatter
+	// below has no branch in it
+	uint32 histogram[kStatsBins + 1] = {};
+	const wide_mask skipped = wide_mask() + kStatsBins;
+
+	wide deviations = wide();
+	size_t i = 0;
+	for(; i + lanes::kCount <= count; i += lanes::kCount) {
+		vector v;
+		memcpy(&v, items + i * sizeof(T), sizeof(v));
+		mask finite = v - v == vector();
+		wide_mask widened = __builtin_convertvector(finite, wide_mask);
+
+		wide x = __builtin_convertvector(v, wide);
+		wide deviation = x - stats->mean;
+		deviations += widened ? deviation * deviation : wide();
+
+		wide_mask bin = __builtin_convertvector((x - stats->min) * scale,
+			wide_mask);
+		bin = bin < 0 ? wide_mask() : bin;
+		bin = bin > lastBin ? lastBin : bin;
+		bin = widened ? bin : skipped;
+		for(size_t lane = 0; lane < lanes::kCount; lane++)
+			histogram[bin[lane]]++;
+	}
+
+	double sum = 0;
+	for(size_t lane = 0; lane < lanes::kCount; lane++)
+		sum += deviations[lane];
+
+	for(; i < count; i++) {
+		T value;
+		memcpy(&value, items + i * sizeof(T), sizeof(T));
+		if(!is_finite(value))
+			continue;
+
+		double deviation = value - stats->mean;
+		sum += deviation * deviation;
+
+		int64 bin = static_cast<int64>((value - stats->min) * scale);
+		bin = bin < 0 ? 0 : bin > stats->bins - 1 ? stats->bins - 1 : bin;
+		histogram[bin]++;
+	}
+
+	memcpy(stats->histogram, histogram, sizeof(stats->histogram));
+	return sum;
+}
+
+template<typename T>
+static void
+summarize_items(const uint8* items, size_t count, field_stats* stats)
+{
+	stats->integer = std::numeric_limits<T>::is_integer;
+
+	double sum;
+	first_pass<T>(items, count, stats, &sum);
+	if(stats->finite == 0) {
+		stats->min = stats->max = 0;
+		return;
+	}
+
+	stats->mean = sum / stats->finite;
+	stats->stddev = sqrt(second_pass<T>(items, count, stats) / stats->finite);
+}
+
+static status_t
+summarize(item_storage storage, const uint8* items, int32 count,
+	field_stats* stats)
+{
+	memset(stats, 0, sizeof(field_stats));
+	stats->count = count;
+
+	switch(storage) {
+		case STORAGE_INT8:
+			summarize_items<int8>(items, count, stats);
+			break;
+		case STORAGE_INT16:
+			summarize_items<int16>(items, count, stats);
+			break;
+		case STORAGE_INT32:
+			summarize_items<int32>(items, count, stats);
+			break;
+		case STORAGE_INT64:
+			summarize_items<int64>(items, count, stats);
+			break;
+		case STORAGE_UINT8:
+			summarize_items<uint8>(items, count, stats);
+			break;
+		case STORAGE_UINT16:
+			summarize_items<uint16>(items, count, stats);
+			break;
+		case STORAGE_UINT32:
+			summarize_items<uint32>(items, count, stats);
+			break;
+		case STORAGE_UINT64:
+			summarize_items<uint64>(items, count, stats);
+			break;
+		case STORAGE_FLOAT:
+			summarize_items<float>(items, count, stats);
+			break;
+		case STORAGE_DOUBLE:
+			summarize_items<double>(items, count, stats);
+			break;
+		default:
+			return B_NOT_SUPPORTED;
+	}
+	return B_OK;
+}
+
+// #pragma mark - Fields
+
+/*	Items of a fixed size field sit back to back in the message, so when
+	the last one is where it would be in an array the first one is the
+	array. Anything else is gathered into buffer.
+*/
+static status_t
+find_items(const BMessage& message, const char* name, type_code type,
+	int32* count, ssize_t* itemSize, item_storage* storage,
+	const uint8** items, std::vector<uint8>& buffer)
+{
+	type_code found;
+	if(message.GetInfo(name, &found, count) != B_OK || found != type)
+		return B_NAME_NOT_FOUND;
+
+	const void* first;
+	const void* last;
+	ssize_t size, lastSize;
+	status_t status = message.FindData(name, type, 0, &first, &size);
+	if(status == B_OK)
+		status = message.FindData(name, type, *count - 1, &last, &lastSize);
+	if(status != B_OK)
+		return status;
+
+	*itemSize = size;
+	*storage = storage_of(type, size);
+	if(*storage == STORAGE_NONE)
+		return B_NOT_SUPPORTED;
+
+	*items = static_cast<const uint8*>(first);
+	if(lastSize == size && static_cast<const uint8*>(last)
+			== *items + static_cast<size_t>(*count - 1) * size)
+		return B_OK;
+
+	buffer.resize(static_cast<size_t>(*count) * size);
+	*items = &buffer[0];
+	return gather_items(message, name, type, 0, *count, size, &buffer[0]);
+}
+
+bool
+stats_type_supported(type_code type)
+{
+	return storage_of(type, native_size(type)) != STORAGE_NONE;
+}
+
+status_t
+compute_field_stats(const BMessage& message, const char* name, type_code type,
+	field_stats* stats)
+{
+	int32 count;
+	ssize_t itemSize;
+	item_storage storage;
+	const uint8* items;
+	std::vector<uint8> buffer;
+	status_t status = find_items(message, name, type, &count, &itemSize,
+		&storage, &items, buffer);
+	if(status != B_OK)
+		return status;
+
+	return summarize(storage, items, count, stats);
+}
+
+// #pragma mark - FieldStatsCache
+
+status_t
+FieldStatsCache::Get(const BMessage& message, const char* name,
+	type_code type, field_stats* stats)
+{
+	int32 count;
+	ssize_t itemSize;
+	item_storage storage;
+	const uint8* items;
+	std::vector<uint8> buffer;
+	status_t status = find_items(message, name, type, &count, &itemSize,
+		&storage, &items, buffer);
+	if(status != B_OK)
+		return status;
+
+	uint32 checksum = crc32c(0, items, count * itemSize);
+	for(auto it = fEntries.begin(); it != fEntries.end(); it++) {
+		if(it->checksum == checksum && it->type == type && it->count == count
+			&& it->name == name) {
+			*stats = it->stats;
+			if(it != fEntries.begin()) {
+				entry hit = *it;
+				fEntries.erase(it);
+				fEntries.push_front(hit);
+			}
+			return B_OK;
+		}
+	}
+
+	status = summarize(storage, items, count, stats);
+	if(status != B_OK)
+		return status;
+
+	entry added;
+	added.name = name;
+	added.type = type;
+	added.count = count;
+	added.checksum = checksum;
+	added.stats = *stats;
+	fEntries.push_front(added);
+	if(fEntries.size() > kMaxEntries)
+		fEntries.pop_back();
+	return B_OK;
+}
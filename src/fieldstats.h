@@ -0,0 +1,69 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef __FIELD_STATS_H__
+#define __FIELD_STATS_H__
+
+#include <Message.h>
+#include <String.h>
+#include <SupportDefs.h>
+#include <deque>
+
+static const int32 kStatsBins = 32;
+
+/*	Summary of a numeric field. NaN and infinite items are counted on their
+	own and left out of everything else, so min to max is the range the
+	histogram covers.
+*/
+struct field_stats {
+	bool		integer;
+	int32		count;			// all items
+	int32		finite;			// items in min, max, mean and the histogram
+	int32		nans;
+	int32		infinities;
+	double		min;
+	double		max;
+	double		mean;
+	double		stddev;			// population standard deviation
+	int32		bins;			// histogram entries in use
+	uint32		histogram[kStatsBins];
+};
+
+bool		stats_type_supported(type_code type);
+
+/*	Works on the bytes of the field where the message keeps them; only a
+	field that is not stored in one piece is copied first. Two passes of
+	16 byte vector kernels: range, sum and NaN/Inf counts, then the
+	squared deviations and the histogram bins.
+*/
+status_t	compute_field_stats(const BMessage& message, const char* name,
+				type_code type, field_stats* stats);
+
+/*	Remembers the last few fields summarized. Entries are keyed on the
+	field name, type and a CRC32C of the item bytes, so an edit leaves its
+	entry behind without anybody telling the cache, while the nested copies
+	the application rebuilds on every selection still hit.
+*/
+class FieldStatsCache
+{
+public:
+	static	const size_t	kMaxEntries = 16;
+
+			status_t		Get(const BMessage& message, const char* name,
+								type_code type, field_stats* stats);
+			void			MakeEmpty() { fEntries.clear(); }
+private:
+	struct entry {
+		BString			name;
+		type_code		type;
+		int32			count;
+		uint32			checksum;
+		field_stats		stats;
+	};
+
+			std::deque<entry> fEntries; // most recent first
+};
+
+#endif /* __FIELD_STATS_H__ */
@@ -0,0 +1,320 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#include <cstring>
+#include "flatmessage.h"
+
+FlatMessageReader::FlatMessageReader(const void* data, size_t size)
+: fData(static_cast<const uint8*>(data)),
+  fSize(size),
+  fStatus(B_OK)
+{
+	if(!fData || fSize < sizeof(flat_message_header)) {
+		fStatus = B_BAD_DATA;
+		return;
+	}
+
+	memcpy(&fHeader, fData, sizeof(fHeader));
+	if(fHeader.format != kFlatMessageFormat) {
+		fStatus = B_NOT_A_MESSAGE;
+		return;
+	}
+
+	// The three parts must fit in the buffer; uint64 keeps the sum honest
+	uint64 needed = sizeof(flat_message_header)
+		+ (uint64)fHeader.field_count * sizeof(flat_field_header)
+		+ fHeader.data_size;
+	if(needed > fSize)
+		fStatus = B_BAD_DATA;
+}
+
+size_t
+FlatMessageReader::FlattenedSize() const
+{
+	if(fStatus != B_OK)
+		return 0;
+
+	return sizeof(flat_message_header)
+		+ fHeader.field_count * sizeof(flat_field_header) + fHeader.data_size;
+}
+
+int32
+FlatMessageReader::CountFields() const
+{
+	return fStatus == B_OK ? fHeader.field_count : 0;
+}
+
+status_t
+FlatMessageReader::FieldAt(int32 index, flat_field_header* field) const
+{
+	if(fStatus != B_OK)
+		return fStatus;
+	if(index < 0 || (uint32)index >= fHeader.field_count)
+		return B_BAD_INDEX;
+
+	memcpy(field, fData + sizeof(flat_message_header)
+		+ index * sizeof(flat_field_header), sizeof(flat_field_header));
+
+	uint64 end = (uint64)field->offset + field->name_length + field->data_size;
+	if(field->name_length == 0 || end > fHeader.data_size)
+		return B_BAD_DATA;
+	if(field->count == 0)
+		return B_BAD_DATA;
+	if((field->flags & kFlatFieldFixedSize) != 0
+		&& field->data_size % field->count != 0)
+		return B_BAD_DATA;
+
+	return B_OK;
+}
+
+const char*
+FlatMessageReader::FieldName(const flat_field_header& field) const
+{
+	const char* name = reinterpret_cast<const char*>(FieldData(field))
+		- field.name_length;
+	if(name[field.name_length - 1] != '\0')
+		return NULL;
+
+	return name;
+}
+
+status_t
+FlatMessageReader::FirstItem(const flat_field_header& field,
+	flat_item* item) const
+{
+	item->index = -1;
+	item->data = FieldData(field);
+	item->size = 0;
+	return NextItem(field, item);
+}
+
+status_t
+FlatMessageReader::NextItem(const flat_field_header& field,
+	flat_item* item) const
+{
+	if(item->index + 1 >= (int32)field.count)
+		return B_BAD_INDEX;
+
+	const uint8* next = item->data + item->size;
+	const uint8* end = FieldData(field) + field.data_size;
+
+	uint32 size;
+	if((field.flags & kFlatFieldFixedSize) != 0)
+		size = field.data_size / field.count;
+	else {
+		// Variable sized items carry their length in front
+		if(next + sizeof(uint32) > end)
+			return B_BAD_DATA;
+		memcpy(&size, next, sizeof(uint32));
+		next += sizeof(uint32);
+	}
+
+	if(size > (size_t)(end - next))
+		return B_BAD_DATA;
+
+	item->index++;
+	item->data = next;
+	item->size = size;
+	return B_OK;
+}
+
+const uint8*
+FlatMessageReader::FieldData(const flat_field_header& field) const
+{
+	return fData + sizeof(flat_message_header)
+		+ fHeader.field_count * sizeof(flat_field_header)
+		+ field.offset + field.name_length;
+}
+
+// #pragma mark - FlatMessageWriter
+
+FlatMessageWriter::FlatMessageWriter(uint32 what)
+: fWhat(what),
+  fDataSize(0)
+{
+	for(int32 i = 0; i < kFlatHashTableSize; i++)
+		fHashTable[i] = fChainEnds[i] = -1;
+}
+
+status_t
+FlatMessageWriter::AddData(const char* name, type_code type, const void* data,
+	uint32 size, bool fixedSize)
+{
+	if(!name || name[0] == '\0')
+		return B_BAD_VALUE;
+
+	uint32 hash = _HashName(name);
+	int32 index = _FindField(name, hash);
+	if(index < 0)
+		index = _NewField(name, type, fixedSize, hash);
+
+	field& current = fFields[index];
+	if(current.type != type)
+		return B_BAD_TYPE;
+	if(current.fixedSize && current.count > 0
+		&& current.data.size() / current.count != size)
+		return B_BAD_VALUE;
+
+	const uint8* bytes = static_cast<const uint8*>(data);
+	if(!current.fixedSize) {
+		uint8 length[sizeof(uint32)];
+		memcpy(length, &size, sizeof(uint32));
+		current.data.insert(current.data.end(), length, length + sizeof(uint32));
+		fDataSize += sizeof(uint32);
+	}
+	current.data.insert(current.data.end(), bytes, bytes + size);
+	current.count++;
+	fDataSize += size;
+	return B_OK;
+}
+
+/*	The whole field in one go, as a copy of what FieldData() returns for
+	it. The layout of the items is checked, a name that is in use already
+	is a B_NAME_IN_USE.
+*/
+status_t
+FlatMessageWriter::AddField(const char* name, type_code type, bool fixedSize,
+	uint32 count, const void* data, uint32 size)
+{
+	if(!name || name[0] == '\0' || count == 0)
+		return B_BAD_VALUE;
+
+	const uint8* bytes = static_cast<const uint8*>(data);
+	if(fixedSize) {
+		if(size % count != 0)
+			return B_BAD_DATA;
+	} else {
+		uint32 offset = 0;
+		for(uint32 i = 0; i < count; i++) {
+			uint32 length;
+			if(size - offset < sizeof(uint32))
+				return B_BAD_DATA;
+			memcpy(&length, bytes + offset, sizeof(uint32));
+			offset += sizeof(uint32);
+			if(length > size - offset)
+				return B_BAD_DATA;
+			offset += length;
+		}
+		if(offset != size)
+			return B_BAD_DATA;
+	}
+
+	uint32 hash = _HashName(name);
+	if(_FindField(name, hash) >= 0)
+		return B_NAME_IN_USE;
+
+	field& added = fFields[_NewField(name, type, fixedSize, hash)];
+	added.data.assign(bytes, bytes + size);
+	added.count = count;
+	fDataSize += size;
+	return B_OK;
+}
+
+size_t
+FlatMessageWriter::FlattenedSize() const
+{
+	return sizeof(flat_message_header)
+		+ fFields.size() * sizeof(flat_field_header) + fDataSize;
+}
+
+void
+FlatMessageWriter::Flatten(std::vector<uint8>& output) const
+{
+	output.resize(FlattenedSize());
+	uint8* position = output.data();
+
+	flat_message_header header;
+	memset(&header, 0, sizeof(header));
+	header.format = kFlatMessageFormat;
+	header.what = fWhat;
+	header.flags = kFlatMessageValid;
+	header.target = -1;
+	header.current_specifier = -1;
+	header.message_area = -1;
+	header.reply_port = -1;
+	header.reply_target = -1;
+	header.reply_team = -1;
+	header.data_size = fDataSize;
+	header.field_count = fFields.size();
+	header.hash_table_size = kFlatHashTableSize;
+	memcpy(header.hash_table, fHashTable, sizeof(header.hash_table));
+	memcpy(position, &header, sizeof(header));
+	position += sizeof(header);
+
+	uint8* data = position + fFields.size() * sizeof(flat_field_header);
+	uint32 offset = 0;
+	for(size_t i = 0; i < fFields.size(); i++) {
+		const field& current = fFields[i];
+
+		flat_field_header fieldHeader;
+		fieldHeader.flags = kFlatFieldValid
+			| (current.fixedSize ? kFlatFieldFixedSize : 0);
+		fieldHeader.name_length = current.name.length() + 1;
+		fieldHeader.type = current.type;
+		fieldHeader.count = current.count;
+		fieldHeader.data_size = current.data.size();
+		fieldHeader.offset = offset;
+		fieldHeader.next_field = current.next;
+		memcpy(position, &fieldHeader, sizeof(fieldHeader));
+		position += sizeof(fieldHeader);
+
+		memcpy(data + offset, current.name.c_str(), fieldHeader.name_length);
+		offset += fieldHeader.name_length;
+		if(!current.data.empty())
+			memcpy(data + offset, current.data.data(), current.data.size());
+		offset += current.data.size();
+	}
+}
+
+// Same hash as BMessage, so that readers can follow the chains
+uint32
+FlatMessageWriter::_HashName(const char* name)
+{
+	uint32 result = 0;
+	for(char c; (c = *name++) != 0;) {
+		result = (result << 7) ^ (result >> 24);
+		result ^= c;
+	}
+	result ^= result << 12;
+	return result;
+}
+
+// The field of that name, or -1
+int32
+FlatMessageWriter::_FindField(const char* name, uint32 hash) const
+{
+	typedef std::unordered_multimap<uint32, int32>::const_iterator iterator;
+	std::pair<iterator, iterator> range = fNames.equal_range(hash);
+	for(iterator i = range.first; i != range.second; i++) {
+		if(fFields[i->second].name == name)
+			return i->second;
+	}
+	return -1;
+}
+
+// New fields go to the end of their bucket's chain
+int32
+FlatMessageWriter::_NewField(const char* name, type_code type, bool fixedSize,
+	uint32 hash)
+{
+	field added;
+	added.name = name;
+	added.type = type;
+	added.fixedSize = fixedSize;
+	added.count = 0;
+	added.next = -1;
+	int32 index = fFields.size();
+	fFields.push_back(added);
+	fNames.insert(std::make_pair(hash, index));
+	fDataSize += added.name.length() + 1;
+
+	int32 bucket = hash % kFlatHashTableSize;
+	if(fChainEnds[bucket] < 0)
+		fHashTable[bucket] = index;
+	else
+		fFields[fChainEnds[bucket]].next = index;
+	fChainEnds[bucket] = index;
+	return index;
+}
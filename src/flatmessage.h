@@ -0,0 +1,133 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef __FLAT_MESSAGE_H__
+#define __FLAT_MESSAGE_H__
+
+#include <SupportDefs.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Native (Haiku) flattened message layout, see MessagePrivate.h
+static const uint32 kFlatMessageFormat = 'HMF1';
+static const uint32 kFlatMessageFormatSwapped = '1FMH';
+static const uint32 kFlatMessageValid = 0x0001;
+static const uint16 kFlatFieldValid = 0x0001;
+static const uint16 kFlatFieldFixedSize = 0x0002;
+static const int32 kFlatHashTableSize = 5;
+
+struct flat_message_header {
+	uint32		format;
+	uint32		what;
+	uint32		flags;
+	int32		target;
+	int32		current_specifier;
+	int32		message_area;
+	int32		reply_port;
+	int32		reply_target;
+	int32		reply_team;
+	uint32		data_size;
+	uint32		field_count;
+	uint32		hash_table_size;
+	int32		hash_table[5];
+} _PACKED;
+
+static_assert(sizeof(flat_message_header) == 68,
+	"flat_message_header must match Haiku's message_header");
+
+struct flat_field_header {
+	uint16		flags;
+	uint16		name_length;	// terminator included
+	type_code	type;
+	uint32		count;
+	uint32		data_size;		// items only, the name is not counted
+	uint32		offset;			// name, then items, from the data start
+	int32		next_field;
+} _PACKED;
+
+struct flat_item {
+	int32		index;
+	const uint8* data;
+	uint32		size;
+};
+
+/*	Read-only walker over a flattened message held in memory, typically a
+	mapped file. Nothing is copied or unflattened; every offset and size
+	read from the buffer is checked against it before it is used, so a
+	truncated or corrupt file is reported instead of being trusted.
+*/
+class FlatMessageReader
+{
+public:
+							FlatMessageReader(const void* data, size_t size);
+
+			status_t		InitCheck() const { return fStatus; }
+			const flat_message_header& Header() const { return fHeader; }
+			size_t			FlattenedSize() const;
+			int32			CountFields() const;
+
+			status_t		FieldAt(int32 index, flat_field_header* field) const;
+			const char*		FieldName(const flat_field_header& field) const;
+			status_t		FirstItem(const flat_field_header& field,
+								flat_item* item) const;
+			status_t		NextItem(const flat_field_header& field,
+								flat_item* item) const;
+
+			// The data_size bytes of items as stored, see AddField()
+			const uint8*	FieldData(const flat_field_header& field) const;
+private:
+	const	uint8*			fData;
+			size_t			fSize;
+			flat_message_header	fHeader;
+			status_t		fStatus;
+};
+
+/*	Builds a flattened message in the native layout the way
+	BMessage::Flatten() writes it: fields in the order they were added,
+	chained into the name hash table, the items of a field back to back.
+	Items added under a name that is already there join that field, as
+	they would with BMessage::AddData().
+*/
+class FlatMessageWriter
+{
+public:
+							FlatMessageWriter(uint32 what);
+
+			status_t		AddData(const char* name, type_code type,
+								const void* data, uint32 size,
+								bool fixedSize);
+			// Items as stored, each variable sized one behind its length
+			status_t		AddField(const char* name, type_code type,
+								bool fixedSize, uint32 count,
+								const void* data, uint32 size);
+
+			size_t			FlattenedSize() const;
+			void			Flatten(std::vector<uint8>& output) const;
+private:
+	struct field {
+		std::string		name;
+		type_code		type;
+		bool			fixedSize;
+		uint32			count;
+		int32			next;
+		std::vector<uint8> data;
+	};
+
+	static	uint32			_HashName(const char* name);
+			int32			_FindField(const char* name, uint32 hash) const;
+			int32			_NewField(const char* name, type_code type,
+								bool fixedSize, uint32 hash);
+private:
+			uint32			fWhat;
+			int32			fHashTable[kFlatHashTableSize];
+			int32			fChainEnds[kFlatHashTableSize];
+			std::vector<field> fFields;
+			// The chains get long in large messages, names are looked up here
+			std::unordered_multimap<uint32, int32> fNames;
+			size_t			fDataSize;
+};
+
+#endif /* __FLAT_MESSAGE_H__ */
@@ -0,0 +1,403 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#include <Catalog.h>
+#include <LayoutBuilder.h>
+#include <MenuField.h>
+#include <MenuItem.h>
+#include <PopUpMenu.h>
+#include <ScrollBar.h>
+#include <ScrollView.h>
+#include <algorithm>
+#include <cmath>
+
+#include "gallerywindow.h"
+#include "iconcache.h"
+#include "mainwindow.h"
+
+#undef B_TRANSLATION_CONTEXT
+#define B_TRANSLATION_CONTEXT "GalleryWindow"
+
+static const float kPadding = 6.0f;
+static const int32 kDefaultIconSize = 64;
+static const int32 kIconSizes[] = { 16, 32, 48, 64, 96, 128 };
+
+// #pragma mark - GalleryView
+
+GalleryView::GalleryView(BMessenger target)
+: BView("gallery", B_WILL_DRAW | B_FRAME_EVENTS | B_FULL_UPDATE_ON_RESIZE),
+  fTarget(target),
+  fIconSize(kDefaultIconSize),
+  fSelected(-1),
+  fToolTipCell(-1),
+  fLabelHeight(0),
+  fAscent(0)
+{
+	SetExplicitMinSize(BSize(160, 160));
+}
+
+void
+GalleryView::SetTo(PersistentMessage* version)
+{
+	fVersion.SetTo(version);
+	fIcons.clear();
+	fLocations.clear();
+	fSelected = -1;
+	fToolTipCell = -1;
+	SetToolTip((const char*)NULL);
+
+	if(version) {
+		std::vector<path_step> path;
+		_Walk(version, path);
+	}
+
+	_UpdateScrollBar();
+	Invalidate();
+}
+
+void
+GalleryView::SetIconSize(int32 size)
+{
+	if(size == fIconSize)
+		return;
+
+	// Keep the first visible row at the top
+	int32 first = (int32)(Bounds().top / _CellHeight()) * _Columns();
+	fIconSize = size;
+	_UpdateScrollBar();
+	ScrollTo(0, first / _Columns() * _CellHeight());
+	Invalidate();
+}
+
+void
+GalleryView::AttachedToWindow()
+{
+	BView::AttachedToWindow();
+	SetViewColor(B_TRANSPARENT_COLOR);
+	SetLowUIColor(B_DOCUMENT_BACKGROUND_COLOR);
+
+	font_height height;
+	GetFontHeight(&height);
+	fAscent = ceilf(height.ascent);
+	fLabelHeight = ceilf(height.ascent + height.descent + height.leading);
+	_UpdateScrollBar();
+}
+
+void
+GalleryView::Draw(BRect updateRect)
+{
+	FillRect(updateRect, B_SOLID_LOW);
+	if(fIcons.empty())
+		return;
+
+	int32 columns = _Columns();
+	int32 firstRow = (int32)(std::max(0.0f, updateRect.top) / _CellHeight());
+	int32 lastRow = (int32)(updateRect.bottom / _CellHeight());
+	int32 first = firstRow * columns;
+	int32 last = std::min((int32)fIcons.size(), (lastRow + 1) * columns) - 1;
+	for(int32 i = first; i <= last; i++) {
+		BRect frame = _CellFrame(i);
+		if(frame.Intersects(updateRect))
+			_DrawIcon(i, frame);
+	}
+}
+
+void
+GalleryView::FrameResized(float newWidth, float newHeight)
+{
+	BView::FrameResized(newWidth, newHeight);
+	_UpdateScrollBar();
+}
+
+void
+GalleryView::MessageReceived(BMessage* msg)
+{
+	switch(msg->what)
+	{
+		// Whatever came in will be picked up by the cells that are in view
+		case IC_ICON_READY:
+			Invalidate();
+			break;
+		default:
+			BView::MessageReceived(msg);
+	}
+}
+
+void
+GalleryView::MouseDown(BPoint where)
+{
+	int32 cell = _CellAt(where);
+	if(cell < 0)
+		return;
+
+	if(fSelected >= 0)
+		Invalidate(_CellFrame(fSelected));
+	fSelected = cell;
+	Invalidate(_CellFrame(fSelected));
+
+	// Laid out like a search match, MessageView::SelectField() takes it
+	const icon& current = fIcons[cell];
+	const std::vector<path_step>& path = fLocations[current.location];
+	BMessage select(MW_SELECT_FIELD);
+	for(size_t i = 0; i < path.size(); i++) {
+		select.AddString("path", path[i].name);
+		select.AddInt32("member", path[i].member);
+	}
+	select.AddString("name", current.field->Name());
+	select.AddInt32("item", current.item);
+	fTarget.SendMessage(&select);
+}
+
+void
+GalleryView::MouseMoved(BPoint where, uint32 code, const BMessage* dragMessage)
+{
+	int32 cell = _CellAt(where);
+	if(cell != fToolTipCell) {
+		fToolTipCell = cell;
+		if(cell < 0)
+			SetToolTip((const char*)NULL);
+		else
+			SetToolTip(_PathFor(cell).String());
+	}
+
+	BView::MouseMoved(where, code, dragMessage);
+}
+
+// #pragma mark - GalleryView::Private
+
+void
+GalleryView::_Walk(const PersistentMessage* message,
+	std::vector<path_step>& path)
+{
+	int32 location = -1;
+	for(int32 i = 0; i < message->CountFields(); i++) {
+		PersistentField* field = message->FieldAt(i);
+		if(IconCache::IsIconType(field->Type())) {
+			if(location < 0) {
+				location = fLocations.size();
+				fLocations.push_back(path);
+			}
+			for(int32 j = 0; j < field->CountItems(); j++) {
+				icon added;
+				added.field.SetTo(field);
+				added.item = j;
+				added.location = location;
+				fIcons.push_back(added);
+			}
+			continue;
+		}
+
+		if(field->Type() != B_MESSAGE_TYPE)
+			continue;
+
+		for(int32 j = 0; j < field->CountItems(); j++) {
+			const PersistentMessage* member = field->ItemAt(j)->Message();
+			if(!member)
+				continue;
+
+			path_step step;
+			step.name = field->Name();
+			step.member = j;
+			path.push_back(step);
+			_Walk(member, path);
+			path.pop_back();
+		}
+	}
+}
+
+void
+GalleryView::_DrawIcon(int32 index, BRect frame)
+{
+	const icon& current = fIcons[index];
+	const PersistentItem* item = current.field->ItemAt(current.item);
+
+	if(index == fSelected) {
+		SetHighUIColor(B_LIST_SELECTED_BACKGROUND_COLOR);
+		FillRect(frame);
+	}
+
+	BRect iconFrame(0, 0, fIconSize - 1, fIconSize - 1);
+	iconFrame.OffsetBy(floorf(frame.left + (frame.Width() - fIconSize) / 2),
+		frame.top + kPadding);
+
+	IconCache::bitmap_ref bitmap;
+	IconCache* cache = IconCache::Default();
+	bool ready = cache && cache->Lookup(current.field->Type(), item->Data(),
+		item->Size(), fIconSize, &bitmap, BMessenger(this));
+	if(ready && bitmap) {
+		SetDrawingMode(B_OP_ALPHA);
+		DrawBitmap(bitmap.get(), bitmap->Bounds(), iconFrame);
+		SetDrawingMode(B_OP_COPY);
+	} else {
+		// Not rendered yet, or no icon at all
+		SetHighUIColor(B_CONTROL_BORDER_COLOR);
+		StrokeRect(iconFrame);
+		if(ready) {
+			StrokeLine(iconFrame.LeftTop(), iconFrame.RightBottom());
+			StrokeLine(iconFrame.LeftBottom(), iconFrame.RightTop());
+		}
+	}
+
+	BString label(current.field->Name());
+	if(current.field->CountItems() > 1)
+		label << " [" << current.item << "]";
+	BFont font;
+	GetFont(&font);
+	font.TruncateString(&label, B_TRUNCATE_MIDDLE, frame.Width() - kPadding);
+
+	SetHighUIColor(index == fSelected ? B_LIST_SELECTED_ITEM_TEXT_COLOR
+		: B_DOCUMENT_TEXT_COLOR);
+	DrawString(label, BPoint(
+		floorf(frame.left + (frame.Width() - StringWidth(label)) / 2),
+		iconFrame.bottom + kPadding + fAscent));
+}
+
+BRect
+GalleryView::_CellFrame(int32 index) const
+{
+	int32 columns = _Columns();
+	float left = (index % columns) * _CellWidth();
+	float top = (index / columns) * _CellHeight();
+	return BRect(left, top, left + _CellWidth() - 1, top + _CellHeight() - 1);
+}
+
+int32
+GalleryView::_CellAt(BPoint where) const
+{
+	if(where.x < 0 || where.y < 0)
+		return -1;
+
+	int32 column = (int32)(where.x / _CellWidth());
+	if(column >= _Columns())
+		return -1;
+
+	int32 index = (int32)(where.y / _CellHeight()) * _Columns() + column;
+	return index < (int32)fIcons.size() ? index : -1;
+}
+
+int32
+GalleryView::_Columns() const
+{
+	return std::max(1, (int32)((Bounds().Width() + 1) / _CellWidth()));
+}
+
+// Wide enough for a short field name under the smaller sizes
+float
+GalleryView::_CellWidth() const
+{
+	return std::max(fIconSize, (int32)80) + kPadding * 2;
+}
+
+float
+GalleryView::_CellHeight() const
+{
+	return fIconSize + fLabelHeight + kPadding * 3;
+}
+
+BString
+GalleryView::_PathFor(int32 index) const
+{
+	const icon& current = fIcons[index];
+	const std::vector<path_step>& path = fLocations[current.location];
+
+	BString text;
+	for(size_t i = 0; i < path.size(); i++)
+		text << path[i].name << "[" << path[i].member << "]/";
+	text << current.field->Name() << "[" << current.item << "]";
+	return text;
+}
+
+void
+GalleryView::_UpdateScrollBar()
+{
+	BScrollBar* scrollBar = ScrollBar(B_VERTICAL);
+	if(!scrollBar)
+		return;
+
+	int32 rows = (fIcons.size() + _Columns() - 1) / _Columns();
+	float height = rows * _CellHeight();
+	float visible = Bounds().Height() + 1;
+	scrollBar->SetRange(0, std::max(0.0f, height - visible));
+	scrollBar->SetProportion(height > 0 ? std::min(1.0f, visible / height)
+		: 1.0f);
+	scrollBar->SetSteps(_CellHeight() / 2, std::max(_CellHeight(),
+		visible - _CellHeight()));
+}
+
+// #pragma mark - GalleryWindow
+
+GalleryWindow::GalleryWindow(BRect frame, PersistentMessage* version,
+	BMessenger target)
+: BWindow(frame, B_TRANSLATE("Icon gallery"), B_DOCUMENT_WINDOW,
+	B_ASYNCHRONOUS_CONTROLS | B_AUTO_UPDATE_SIZE_LIMITS)
+{
+	fGallery = new GalleryView(target);
+	BScrollView* scrollView = new BScrollView("gallery_scroll", fGallery, 0,
+		false, true, B_NO_BORDER);
+
+	BPopUpMenu* sizeMenu = new BPopUpMenu("size");
+	for(size_t i = 0; i < sizeof(kIconSizes) / sizeof(kIconSizes[0]); i++) {
+		BMessage* message = new BMessage(GW_SIZE_CHANGED);
+		message->AddInt32("size", kIconSizes[i]);
+		BString label;
+		label.SetToFormat(B_TRANSLATE("%d × %d"), kIconSizes[i], kIconSizes[i]);
+		BMenuItem* item = new BMenuItem(label, message);
+		item->SetMarked(kIconSizes[i] == kDefaultIconSize);
+		sizeMenu->AddItem(item);
+	}
+	BMenuField* sizeField = new BMenuField("size", B_TRANSLATE("Size:"),
+		sizeMenu);
+
+	fCount = new BStringView("count", "");
+
+	BLayoutBuilder::Group<>(this, B_VERTICAL, 0)
+		.AddGroup(B_HORIZONTAL, B_USE_SMALL_SPACING)
+			.SetInsets(B_USE_SMALL_INSETS)
+			.Add(sizeField)
+			.AddGlue()
+			.Add(fCount)
+		.End()
+		.Add(scrollView)
+	.End();
+
+	AddShortcut('W', B_COMMAND_KEY, new BMessage(B_QUIT_REQUESTED));
+
+	fGallery->SetTo(version);
+	_UpdateCount();
+}
+
+void
+GalleryWindow::MessageReceived(BMessage* msg)
+{
+	switch(msg->what)
+	{
+		case GW_SIZE_CHANGED:
+			fGallery->SetIconSize(msg->GetInt32("size", kDefaultIconSize));
+			break;
+
+		// The document changed, the reference comes with the message
+		case GW_SET_VERSION:
+		{
+			PersistentMessage* version = NULL;
+			if(msg->FindPointer("version", (void**)&version) != B_OK)
+				break;
+			fGallery->SetTo(version);
+			version->ReleaseReference();
+			_UpdateCount();
+			break;
+		}
+
+		default:
+			BWindow::MessageReceived(msg);
+	}
+}
+
+void
+GalleryWindow::_UpdateCount()
+{
+	BString count;
+	count.SetToFormat(B_TRANSLATE("%d icons"), (int)fGallery->CountIcons());
+	fCount->SetText(count);
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef __GALLERY_WINDOW_H__
+#define __GALLERY_WINDOW_H__
+
+#include <Messenger.h>
+#include <String.h>
+#include <StringView.h>
+#include <View.h>
+#include <Window.h>
+#include <vector>
+
+#include "persistentmessage.h"
+
+enum {
+	GW_SIZE_CHANGED = 'gw00',
+	GW_SET_VERSION			// "version" pointer, carries one reference
+};
+
+/*	Every B_VECTOR_ICON_TYPE, B_LARGE_ICON_TYPE and B_MINI_ICON_TYPE item of
+	the document as one grid. Only the cells in view are drawn and asked
+	for; the IconCache renders them on its workers and keeps them for the
+	next time. Clicking a cell selects its field in the main window.
+*/
+class GalleryView : public BView
+{
+public:
+					GalleryView(BMessenger target);
+
+			void	SetTo(PersistentMessage* version);
+			void	SetIconSize(int32 size);
+			int32	CountIcons() const { return fIcons.size(); }
+
+	virtual	void	AttachedToWindow();
+	virtual void	Draw(BRect updateRect);
+	virtual	void	FrameResized(float newWidth, float newHeight);
+	virtual	void	MessageReceived(BMessage* msg);
+	virtual	void	MouseDown(BPoint where);
+	virtual	void	MouseMoved(BPoint where, uint32 code,
+						const BMessage* dragMessage);
+private:
+	struct path_step {
+		BString		name;
+		int32		member;
+	};
+
+	struct icon {
+		BReference<PersistentField> field;
+		int32		item;
+		int32		location;	// index into fLocations
+	};
+
+			void	_Walk(const PersistentMessage* message,
+						std::vector<path_step>& path);
+			void	_DrawIcon(int32 index, BRect frame);
+			BRect	_CellFrame(int32 index) const;
+			int32	_CellAt(BPoint where) const;
+			int32	_Columns() const;
+			float	_CellWidth() const;
+			float	_CellHeight() const;
+			BString	_PathFor(int32 index) const;
+			void	_UpdateScrollBar();
+private:
+	BMessenger		fTarget;
+	BReference<PersistentMessage> fVersion;
+	std::vector<icon> fIcons;
+	std::vector<std::vector<path_step> > fLocations;
+	int32			fIconSize;
+	int32			fSelected;
+	int32			fToolTipCell;
+	float			fLabelHeight;
+	float			fAscent;
+};
+
+class GalleryWindow : public BWindow
+{
+public:
+					GalleryWindow(BRect frame, PersistentMessage* version,
+						BMessenger target);
+
+	virtual void	MessageReceived(BMessage* msg);
+private:
+			void	_UpdateCount();
+private:
+	GalleryView*	fGallery;
+	BStringView*	fCount;
+};
+
+#endif /* __GALLERY_WINDOW_H__ */
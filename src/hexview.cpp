@@ -0,0 +1,658 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#include <Catalog.h>
+#include <Directory.h>
+#include <LayoutBuilder.h>
+#include <Window.h>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include "hexview.h"
+
+#undef B_TRANSLATION_CONTEXT
+#define B_TRANSLATION_CONTEXT "HexView"
+
+static const char kHexDigits[] = "0123456789abcdef";
+static const float kMargin = 4.0f;
+static const size_t kExportChunkSize = 1024 * 1024;
+
+// Offset, two spaces, 16 bytes with a gap after the eighth, a space, text
+static const int32 kHexStart = 2;
+static const int32 kTextStart = kHexStart + HexView::kBytesPerLine * 3 + 2;
+static const int32 kMaxLineLength = 16 + kTextStart + HexView::kBytesPerLine;
+
+const uint8*
+find_bytes(const uint8* data, size_t size, const uint8* pattern, size_t length)
+{
+	if(length == 0 || length > size)
+		return NULL;
+
+	const uint8 first = pattern[0];
+	const uint8 last = pattern[length - 1];
+	const size_t end = size - length + 1; // candidates start below this
+	size_t i = 0;
+
+#if defined(__SSE2__)
+	// Compare the first and the last byte of the pattern at 16 positions
+	// at once; only positions where both agree get a full compare
+	const __m128i firstBytes = _mm_set1_epi8(first);
+	const __m128i lastBytes = _mm_set1_epi8(last);
+	for(; i + 16 <= end; i += 16) {
+		__m128i head = _mm_loadu_si128(
+			reinterpret_cast<const __m128i*>(data + i));
+		__m128i tail = _mm_loadu_si128(
+			reinterpret_cast<const __m128i*>(data + i + length - 1));
+		uint32 mask = _mm_movemask_epi8(_mm_and_si128(
+			_mm_cmpeq_epi8(head, firstBytes), _mm_cmpeq_epi8(tail, lastBytes)));
+		while(mask != 0) {
+			int32 bit = __builtin_ctz(mask);
+			if(memcmp(data + i + bit, pattern, length) == 0)
+				return data + i + bit;
+			mask &= mask - 1;
+		}
+	}
+#endif
+
+	while(i < end) {
+		const uint8* candidate = static_cast<const uint8*>(
+			memchr(data + i, first, end - i));
+		if(!candidate)
+			break;
+		if(memcmp(candidate, pattern, length) == 0)
+			return candidate;
+		i = candidate - data + 1;
+	}
+	return NULL;
+}
+
+// The scroll bar counts lines, so it drives the view instead of scrolling it
+class HexScrollBar : public BScrollBar
+{
+public:
+	HexScrollBar(HexView* view)
+		: BScrollBar("hexscrollbar", NULL, 0, 0, B_VERTICAL),
+		  fView(view)
+	{
+	}
+
+	virtual void ValueChanged(float value)
+	{
+		BScrollBar::ValueChanged(value);
+		fView->SetTopLine(static_cast<size_t>(value));
+	}
+private:
+	HexView*	fView;
+};
+
+HexView::HexView(const char* name)
+: BView(name, B_WILL_DRAW | B_FRAME_EVENTS | B_NAVIGABLE),
+  fData(NULL),
+  fSize(0),
+  fTopLine(0),
+  fOffsetDigits(8),
+  fSelectionStart(0),
+  fSelectionEnd(0),
+  fAnchor(0),
+  fTracking(false),
+  fScrollBar(NULL)
+{
+	SetFont(be_fixed_font);
+	_UpdateFont();
+}
+
+void
+HexView::SetData(const void* data, size_t size)
+{
+	fData = static_cast<const uint8*>(data);
+	fSize = fData ? size : 0;
+	fTopLine = 0;
+	fSelectionStart = fSelectionEnd = fAnchor = 0;
+	fOffsetDigits = (uint64)fSize > 0xffffffffULL ? 16 : 8;
+
+	if(fScrollBar)
+		fScrollBar->SetValue(0);
+	_UpdateScrollBar();
+	InvalidateLayout();
+	Invalidate();
+
+	if(Window())
+		Window()->PostMessage(HV_SELECTION_CHANGED, Parent());
+}
+
+void
+HexView::SetScrollBar(BScrollBar* scrollBar)
+{
+	fScrollBar = scrollBar;
+	_UpdateScrollBar();
+}
+
+void
+HexView::SetTopLine(size_t line)
+{
+	size_t lines = _CountLines();
+	size_t visible = _VisibleLines();
+	line = std::min(line, lines > visible ? lines - visible : 0);
+	if(line == fTopLine)
+		return;
+
+	fTopLine = line;
+	Invalidate();
+}
+
+void
+HexView::ScrollToOffset(size_t offset)
+{
+	size_t line = offset / kBytesPerLine;
+	size_t visible = std::max(_VisibleLines(), (size_t)1);
+	if(line >= fTopLine && line < fTopLine + visible)
+		return;
+
+	// Keep a little context above the line
+	_ScrollTo(line > visible / 3 ? line - visible / 3 : 0);
+}
+
+void
+HexView::Select(size_t start, size_t end)
+{
+	start = std::min(start, fSize);
+	end = std::min(std::max(start, end), fSize);
+	if(start == fSelectionStart && end == fSelectionEnd)
+		return;
+
+	fSelectionStart = start;
+	fSelectionEnd = end;
+	Invalidate();
+
+	if(Window())
+		Window()->PostMessage(HV_SELECTION_CHANGED, Parent());
+}
+
+void
+HexView::GetSelection(size_t* start, size_t* end) const
+{
+	*start = fSelectionStart;
+	*end = fSelectionEnd;
+}
+
+status_t
+HexView::Find(const uint8* pattern, size_t length)
+{
+	if(length == 0)
+		return B_BAD_VALUE;
+	if(!fData || length > fSize)
+		return B_ENTRY_NOT_FOUND;
+
+	size_t from = fSelectionEnd > fSelectionStart ? fSelectionStart + 1 : 0;
+	const uint8* found = find_bytes(fData + from, fSize - from, pattern, length);
+	if(!found && from > 0) {
+		found = find_bytes(fData, std::min(fSize, from - 1 + length), pattern,
+			length);
+	}
+	if(!found)
+		return B_ENTRY_NOT_FOUND;
+
+	size_t offset = found - fData;
+	Select(offset, offset + length);
+	ScrollToOffset(offset);
+	return B_OK;
+}
+
+status_t
+HexView::Export(BFile* file) const
+{
+	status_t status = file->InitCheck();
+	if(status != B_OK)
+		return status;
+
+	size_t start = fSelectionStart;
+	size_t end = fSelectionEnd;
+	if(start == end) {
+		start = 0;
+		end = fSize;
+	}
+
+	// Written straight from the source, a piece at a time
+	for(size_t position = start; position < end;) {
+		ssize_t written = file->Write(fData + position,
+			std::min(kExportChunkSize, end - position));
+		if(written < 0)
+			return written;
+		if(written == 0)
+			return B_IO_ERROR;
+		position += written;
+	}
+	return B_OK;
+}
+
+void
+HexView::AttachedToWindow()
+{
+	BView::AttachedToWindow();
+	SetViewColor(B_TRANSPARENT_COLOR);
+	SetLowUIColor(B_DOCUMENT_BACKGROUND_COLOR);
+	_UpdateScrollBar();
+}
+
+void
+HexView::Draw(BRect updateRect)
+{
+	FillRect(updateRect, B_SOLID_LOW);
+	if(!fData)
+		return;
+
+	int32 first = std::max(0, (int32)floorf(updateRect.top / fLineHeight));
+	int32 last = (int32)ceilf(updateRect.bottom / fLineHeight);
+	size_t lines = _CountLines();
+
+	char buffer[kMaxLineLength];
+	for(int32 row = first; row <= last; row++) {
+		size_t line = fTopLine + row;
+		if(line >= lines)
+			break;
+
+		float y = row * fLineHeight;
+		_DrawSelection(line, y);
+
+		int32 length = _FormatLine(line, buffer);
+		BPoint point(kMargin, y + fAscent);
+		SetHighColor(tint_color(ui_color(B_DOCUMENT_TEXT_COLOR),
+			B_LIGHTEN_1_TINT));
+		DrawString(buffer, fOffsetDigits, point);
+		SetHighUIColor(B_DOCUMENT_TEXT_COLOR);
+		point.x += fOffsetDigits * fCharWidth;
+		DrawString(buffer + fOffsetDigits, length - fOffsetDigits, point);
+	}
+}
+
+void
+HexView::FrameResized(float width, float height)
+{
+	BView::FrameResized(width, height);
+	_UpdateScrollBar();
+	SetTopLine(fTopLine);
+}
+
+void
+HexView::MessageReceived(BMessage* message)
+{
+	if(message->what == B_MOUSE_WHEEL_CHANGED) {
+		int32 delta = (int32)message->GetFloat("be:wheel_delta_y", 0.0f) * 3;
+		_ScrollTo(delta < 0 && fTopLine < (size_t)-delta ? 0 : fTopLine + delta);
+		return;
+	}
+
+	BView::MessageReceived(message);
+}
+
+void
+HexView::MouseDown(BPoint where)
+{
+	MakeFocus(true);
+	if(!fData)
+		return;
+
+	SetMouseEventMask(B_POINTER_EVENTS, B_LOCK_WINDOW_FOCUS);
+	fTracking = true;
+	fAnchor = _OffsetAt(where);
+	Select(fAnchor, fAnchor + 1);
+}
+
+void
+HexView::MouseMoved(BPoint where, uint32 transit, const BMessage* dragMessage)
+{
+	if(!fTracking) {
+		BView::MouseMoved(where, transit, dragMessage);
+		return;
+	}
+
+	// Dragging past the edges pulls more lines in
+	if(where.y < 0 && fTopLine > 0)
+		_ScrollTo(fTopLine - 1);
+	else if(where.y > Bounds().bottom)
+		_ScrollTo(fTopLine + 1);
+
+	size_t offset = _OffsetAt(where);
+	Select(std::min(fAnchor, offset), std::max(fAnchor, offset) + 1);
+}
+
+void
+HexView::MouseUp(BPoint where)
+{
+	fTracking = false;
+}
+
+BSize
+HexView::MinSize()
+{
+	return BSize(kMargin * 2 + fCharWidth * (fOffsetDigits + kTextStart
+		+ kBytesPerLine), fLineHeight * 4);
+}
+
+BSize
+HexView::PreferredSize()
+{
+	BSize size = MinSize();
+	size.height = fLineHeight * 16;
+	return size;
+}
+
+// #pragma mark - HexView::Private
+
+size_t
+HexView::_CountLines() const
+{
+	return (fSize + kBytesPerLine - 1) / kBytesPerLine;
+}
+
+size_t
+HexView::_VisibleLines() const
+{
+	return static_cast<size_t>(std::max(0.0f,
+		floorf((Bounds().Height() + 1) / fLineHeight)));
+}
+
+int32
+HexView::_FormatLine(size_t line, char* buffer) const
+{
+	size_t offset = line * kBytesPerLine;
+	int32 count = std::min((size_t)kBytesPerLine, fSize - offset);
+	const uint8* bytes = fData + offset;
+	char* out = buffer;
+
+	for(int32 i = fOffsetDigits - 1; i >= 0; i--)
+		*out++ = kHexDigits[((uint64)offset >> (i * 4)) & 0xf];
+	*out++ = ' ';
+	*out++ = ' ';
+
+	for(int32 i = 0; i < kBytesPerLine; i++) {
+		if(i == kBytesPerLine / 2)
+			*out++ = ' ';
+		if(i < count) {
+			*out++ = kHexDigits[bytes[i] >> 4];
+			*out++ = kHexDigits[bytes[i] & 0xf];
+		} else {
+			*out++ = ' ';
+			*out++ = ' ';
+		}
+		*out++ = ' ';
+	}
+	*out++ = ' ';
+
+	for(int32 i = 0; i < count; i++)
+		*out++ = bytes[i] >= 0x20 && bytes[i] < 0x7f ? bytes[i] : '.';
+
+	return out - buffer;
+}
+
+void
+HexView::_DrawSelection(size_t line, float y)
+{
+	size_t lineStart = line * kBytesPerLine;
+	size_t lineEnd = lineStart + kBytesPerLine;
+	if(fSelectionStart == fSelectionEnd || fSelectionEnd <= lineStart
+		|| fSelectionStart >= lineEnd)
+		return;
+
+	int32 first = std::max(fSelectionStart, lineStart) - lineStart;
+	int32 last = std::min(fSelectionEnd, lineEnd) - lineStart - 1;
+	float bottom = y + fLineHeight - 1;
+
+	SetHighUIColor(B_LIST_SELECTED_BACKGROUND_COLOR);
+	FillRect(BRect(_HexColumn(first), y,
+		_HexColumn(last) + fCharWidth * 2 - 1, bottom));
+	FillRect(BRect(_TextColumn(first), y, _TextColumn(last + 1) - 1, bottom));
+}
+
+size_t
+HexView::_OffsetAt(BPoint where) const
+{
+	size_t lines = _CountLines();
+	if(lines == 0)
+		return 0;
+
+	int64 line = (int64)fTopLine + (int64)floorf(where.y / fLineHeight);
+	line = std::max((int64)0, std::min(line, (int64)lines - 1));
+
+	float column = (where.x - kMargin) / fCharWidth - fOffsetDigits;
+	int32 byte;
+	if(column >= kTextStart - 1)
+		byte = (int32)(column - kTextStart);
+	else {
+		column -= kHexStart;
+		if(column >= kBytesPerLine / 2 * 3)
+			column -= 1;
+		byte = (int32)(column / 3);
+	}
+	byte = std::max((int32)0, std::min(byte, kBytesPerLine - 1));
+
+	return std::min((size_t)line * kBytesPerLine + byte, fSize - 1);
+}
+
+float
+HexView::_HexColumn(int32 byte) const
+{
+	int32 column = fOffsetDigits + kHexStart + byte * 3
+		+ (byte >= kBytesPerLine / 2 ? 1 : 0);
+	return kMargin + column * fCharWidth;
+}
+
+float
+HexView::_TextColumn(int32 byte) const
+{
+	return kMargin + (fOffsetDigits + kTextStart + byte) * fCharWidth;
+}
+
+void
+HexView::_ScrollTo(size_t line)
+{
+	// Through the scroll bar, so that it stays in step
+	if(fScrollBar)
+		fScrollBar->SetValue(line);
+	else
+		SetTopLine(line);
+}
+
+void
+HexView::_UpdateFont()
+{
+	font_height height;
+	GetFontHeight(&height);
+	fAscent = ceilf(height.ascent);
+	fLineHeight = ceilf(height.ascent + height.descent + height.leading);
+	fCharWidth = StringWidth("0");
+}
+
+void
+HexView::_UpdateScrollBar()
+{
+	if(!fScrollBar)
+		return;
+
+	size_t lines = _CountLines();
+	size_t visible = _VisibleLines();
+	float maximum = lines > visible ? lines - visible : 0;
+
+	fScrollBar->SetRange(0, maximum);
+	fScrollBar->SetProportion(lines > 0
+		? std::min(1.0f, (float)visible / lines) : 1.0f);
+	fScrollBar->SetSteps(1, std::max(1.0f, (float)visible - 1));
+}
+
+// #pragma mark - HexPanel
+
+HexPanel::HexPanel(const char* name)
+: BView(name, B_SUPPORTS_LAYOUT),
+  fSavePanel(NULL)
+{
+	fHexView = new HexView("hexview");
+	BScrollBar* scrollBar = new HexScrollBar(fHexView);
+	fHexView->SetScrollBar(scrollBar);
+
+	fFindText = new BTextControl("findtext", B_TRANSLATE("Find:"), "",
+		new BMessage(HV_FIND));
+	fFindButton = new BButton("findbutton", B_TRANSLATE("Find next"),
+		new BMessage(HV_FIND));
+	fExportButton = new BButton("exportbutton",
+		B_TRANSLATE("Export" B_UTF8_ELLIPSIS), new BMessage(HV_EXPORT));
+	fStatus = new BStringView("status", "");
+
+	BLayoutBuilder::Group<>(this, B_VERTICAL, B_USE_SMALL_SPACING)
+		.AddGroup(B_HORIZONTAL, 0)
+			.Add(fHexView)
+			.Add(scrollBar)
+		.End()
+		.AddGroup(B_HORIZONTAL, B_USE_SMALL_SPACING)
+			.Add(fFindText)
+			.Add(fFindButton)
+			.AddGlue()
+			.Add(fExportButton)
+		.End()
+		.Add(fStatus);
+}
+
+HexPanel::~HexPanel()
+{
+	delete fSavePanel;
+}
+
+void
+HexPanel::SetData(const void* data, size_t size)
+{
+	fHexView->SetData(data, size);
+	fExportButton->SetEnabled(data != NULL && size > 0);
+	_UpdateStatus();
+}
+
+void
+HexPanel::AttachedToWindow()
+{
+	BView::AttachedToWindow();
+	fFindText->SetTarget(this);
+	fFindButton->SetTarget(this);
+	fExportButton->SetTarget(this);
+	_UpdateStatus();
+}
+
+void
+HexPanel::MessageReceived(BMessage* message)
+{
+	switch(message->what) {
+		case HV_FIND:
+			_Find();
+			break;
+		case HV_SELECTION_CHANGED:
+			_UpdateStatus();
+			break;
+		case HV_EXPORT:
+		{
+			if(!fSavePanel) {
+				BMessenger target(this);
+				fSavePanel = new BFilePanel(B_SAVE_PANEL, &target, NULL,
+					B_FILE_NODE, false);
+			}
+			// A modal window would otherwise keep the panel out of reach
+			if(Window()->Feel() != B_NORMAL_WINDOW_FEEL)
+				fSavePanel->Window()->SetFeel(Window()->Feel());
+			fSavePanel->Show();
+			break;
+		}
+		case B_SAVE_REQUESTED:
+			_Export(message);
+			break;
+		default:
+			BView::MessageReceived(message);
+			break;
+	}
+}
+
+// #pragma mark - HexPanel::Private
+
+void
+HexPanel::_Find()
+{
+	const char* text = fFindText->Text();
+	size_t length = strlen(text);
+	bool quoted = length > 0 && text[0] == '"';
+
+	std::vector<uint8> pattern;
+	if(!quoted) {
+		int32 nibbles = 0;
+		uint8 value = 0;
+		for(size_t i = 0; i < length; i++) {
+			char c = text[i];
+			if(c == ' ' && nibbles % 2 == 0)
+				continue;
+
+			const char* digit = strchr(kHexDigits, tolower(c));
+			if(c == '\0' || digit == NULL) {
+				pattern.clear();
+				nibbles = 1;
+				break;
+			}
+			value = value << 4 | (digit - kHexDigits);
+			if(++nibbles % 2 == 0)
+				pattern.push_back(value);
+		}
+		if(nibbles % 2 != 0)
+			pattern.clear();
+	}
+
+	if(pattern.empty()) {
+		const char* start = quoted ? text + 1 : text;
+		size_t count = quoted ? length - 1 : length;
+		if(quoted && count > 0 && start[count - 1] == '"')
+			count--;
+		pattern.assign(start, start + count);
+	}
+	if(pattern.empty())
+		return;
+
+	if(fHexView->Find(&pattern[0], pattern.size()) != B_OK)
+		fStatus->SetText(B_TRANSLATE("Not found"));
+}
+
+void
+HexPanel::_Export(BMessage* message)
+{
+	entry_ref directoryRef;
+	const char* name;
+	if(message->FindRef("directory", &directoryRef) != B_OK
+		|| message->FindString("name", &name) != B_OK)
+		return;
+
+	BDirectory directory(&directoryRef);
+	BFile file(&directory, name, B_WRITE_ONLY | B_CREATE_FILE | B_ERASE_FILE);
+	status_t status = fHexView->Export(&file);
+	if(status != B_OK) {
+		BString error;
+		error.SetToFormat(B_TRANSLATE("Export failed: %s"), strerror(status));
+		fStatus->SetText(error);
+	} else
+		fStatus->SetText(B_TRANSLATE("Exported"));
+}
+
+void
+HexPanel::_UpdateStatus()
+{
+	size_t start, end;
+	fHexView->GetSelection(&start, &end);
+
+	BString status;
+	if(start == end) {
+		status.SetToFormat(B_TRANSLATE("%" B_PRIuSIZE " bytes"),
+			fHexView->Size());
+	} else {
+		status.SetToFormat(
+			B_TRANSLATE("%" B_PRIuSIZE " bytes selected at offset 0x%" B_PRIxSIZE),
+			end - start, start);
+	}
+	fStatus->SetText(status);
+}
@@ -0,0 +1,120 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef __HEX_VIEW_H__
+#define __HEX_VIEW_H__
+
+#include <Button.h>
+#include <File.h>
+#include <FilePanel.h>
+#include <ScrollBar.h>
+#include <StringView.h>
+#include <TextControl.h>
+#include <View.h>
+
+enum {
+	HV_SELECTION_CHANGED = 'hv00',
+	HV_FIND,
+	HV_EXPORT
+};
+
+// Returns the first occurrence of pattern inside data, or NULL
+const uint8*	find_bytes(const uint8* data, size_t size,
+					const uint8* pattern, size_t length);
+
+/*	Offset, hex and ASCII dump of a block of bytes the view does not own.
+	Only the lines on screen are ever formatted, and the scroll bar counts
+	lines rather than pixels, so the cost of a redraw does not depend on
+	the size of the block.
+*/
+class HexView : public BView
+{
+public:
+	static	const int32		kBytesPerLine = 16;
+
+							HexView(const char* name);
+
+			void			SetData(const void* data, size_t size);
+			const uint8*	Data() const { return fData; }
+			size_t			Size() const { return fSize; }
+
+			void			SetScrollBar(BScrollBar* scrollBar);
+			void			SetTopLine(size_t line);
+			void			ScrollToOffset(size_t offset);
+
+			void			Select(size_t start, size_t end);
+			void			GetSelection(size_t* start, size_t* end) const;
+
+			// Searches forward from the selection and wraps around once
+			status_t		Find(const uint8* pattern, size_t length);
+			// Writes the selection, or everything when nothing is selected
+			status_t		Export(BFile* file) const;
+
+	virtual	void			AttachedToWindow();
+	virtual	void			Draw(BRect updateRect);
+	virtual	void			FrameResized(float width, float height);
+	virtual	void			MessageReceived(BMessage* message);
+	virtual	void			MouseDown(BPoint where);
+	virtual	void			MouseMoved(BPoint where, uint32 transit,
+								const BMessage* dragMessage);
+	virtual	void			MouseUp(BPoint where);
+	virtual	BSize			MinSize();
+	virtual	BSize			PreferredSize();
+private:
+			size_t			_CountLines() const;
+			size_t			_VisibleLines() const;
+			int32			_FormatLine(size_t line, char* buffer) const;
+			void			_DrawSelection(size_t line, float y);
+			size_t			_OffsetAt(BPoint where) const;
+			float			_HexColumn(int32 byte) const;
+			float			_TextColumn(int32 byte) const;
+			void			_ScrollTo(size_t line);
+			void			_UpdateFont();
+			void			_UpdateScrollBar();
+private:
+			const uint8*	fData;
+			size_t			fSize;
+			size_t			fTopLine;
+			int32			fOffsetDigits;
+
+			size_t			fSelectionStart;
+			size_t			fSelectionEnd;
+			size_t			fAnchor;
+			bool			fTracking;
+
+			BScrollBar*		fScrollBar;
+			float			fLineHeight;
+			float			fCharWidth;
+			float			fAscent;
+};
+
+/*	HexView with its scroll bar, a search field and the export button.
+	Searches take hex bytes ("ff d8 ff") or, when that does not parse or
+	the text is quoted, the literal text.
+*/
+class HexPanel : public BView
+{
+public:
+							HexPanel(const char* name);
+	virtual					~HexPanel();
+
+			void			SetData(const void* data, size_t size);
+
+	virtual	void			AttachedToWindow();
+	virtual	void			MessageReceived(BMessage* message);
+private:
+			void			_Find();
+			void			_Export(BMessage* message);
+			void			_UpdateStatus();
+private:
+			HexView*		fHexView;
+			BTextControl*	fFindText;
+			BButton*		fFindButton;
+			BButton*		fExportButton;
+			BStringView*	fStatus;
+			BFilePanel*		fSavePanel;
+};
+
+#endif /* __HEX_VIEW_H__ */
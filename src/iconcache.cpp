@@ -0,0 +1,279 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#include <Autolock.h>
+#include <IconUtils.h>
+#include <algorithm>
+#include <cstring>
+#include "checksum.h"
+#include "iconcache.h"
+
+IconCache* IconCache::sDefault = NULL;
+
+bool
+IconCache::key::operator==(const key& other) const
+{
+	return type == other.type && size == other.size
+		&& checksum == other.checksum && length == other.length;
+}
+
+size_t
+IconCache::key_hash::operator()(const key& k) const
+{
+	return k.checksum ^ ((size_t)k.size * 2654435761u) ^ k.type;
+}
+
+IconCache::IconCache()
+: fLock("icon cache"),
+  fBytes(0),
+  fWork(create_sem(0, "icon cache work")),
+  fQuitting(false)
+{
+	system_info info;
+	int32 count = 1;
+	if(get_system_info(&info) == B_OK)
+		count = std::max(1, std::min(kMaxWorkers, (int32)info.cpu_count));
+
+	for(int32 i = 0; i < count; i++) {
+		thread_id worker = spawn_thread(_Worker, "icon cache worker",
+			B_LOW_PRIORITY, this);
+		if(worker < B_OK)
+			break;
+		fWorkers.push_back(worker);
+		resume_thread(worker);
+	}
+
+	sDefault = this;
+}
+
+IconCache::~IconCache()
+{
+	if(sDefault == this)
+		sDefault = NULL;
+
+	{
+		BAutolock _(fLock);
+		fQuitting = true;
+	}
+	for(size_t i = 0; i < fWorkers.size(); i++)
+		release_sem(fWork);
+	for(size_t i = 0; i < fWorkers.size(); i++) {
+		status_t result;
+		wait_for_thread(fWorkers[i], &result);
+	}
+	delete_sem(fWork);
+}
+
+bool
+IconCache::IsIconType(type_code type)
+{
+	return type == B_VECTOR_ICON_TYPE || type == B_LARGE_ICON_TYPE
+		|| type == B_MINI_ICON_TYPE;
+}
+
+// Bitmap icons have a size of their own, asking for another one would only
+// render the same pixels again
+int32
+IconCache::NativeSize(type_code type, int32 size)
+{
+	switch(type) {
+		case B_LARGE_ICON_TYPE:
+			return 32;
+		case B_MINI_ICON_TYPE:
+			return 16;
+		default:
+			return size;
+	}
+}
+
+bool
+IconCache::Lookup(type_code type, const void* data, size_t length,
+	int32 size, bitmap_ref* bitmap, BMessenger target)
+{
+	key k;
+	k.type = type;
+	k.size = NativeSize(type, size);
+	k.checksum = crc32c(0, data, length);
+	k.length = length;
+
+	std::vector<BMessenger> dropped;
+	{
+		BAutolock _(fLock);
+		entry_index::iterator found = _Find(k, data);
+		if(found != fIndex.end()) {
+			entry& cached = *found->second;
+			if(cached.targets.empty()) {
+				fEntries.splice(fEntries.begin(), fEntries, found->second);
+				*bitmap = cached.bitmap;
+				return true;
+			}
+
+			// Still on its way; views that draw often need only one answer
+			if(std::find(cached.targets.begin(), cached.targets.end(), target)
+					== cached.targets.end())
+				cached.targets.push_back(target);
+			return false;
+		}
+
+		// The oldest request is the one least likely to be in view still
+		if(fQueued.size() >= kMaxQueued) {
+			entry_list::iterator oldest = fQueued.begin();
+			dropped.swap(oldest->targets);
+			_Unindex(oldest);
+			fQueued.erase(oldest);
+		}
+
+		entry queued;
+		queued.k = k;
+		queued.data.assign((const uint8*)data, (const uint8*)data + length);
+		queued.targets.push_back(target);
+		fQueued.push_back(queued);
+		fIndex.insert(std::make_pair(k, --fQueued.end()));
+		release_sem(fWork);
+	}
+
+	for(size_t i = 0; i < dropped.size(); i++)
+		dropped[i].SendMessage(IC_ICON_READY);
+	return false;
+}
+
+IconCache::bitmap_ref
+IconCache::Rasterize(type_code type, const void* data, size_t length,
+	int32 size)
+{
+	size = NativeSize(type, size);
+	if(size <= 0)
+		return bitmap_ref();
+
+	bitmap_ref bitmap(new BBitmap(BRect(0, 0, size - 1, size - 1),
+		B_RGBA32));
+	if(bitmap->InitCheck() != B_OK)
+		return bitmap_ref();
+
+	status_t status = B_BAD_DATA;
+	switch(type) {
+		case B_VECTOR_ICON_TYPE:
+			status = BIconUtils::GetVectorIcon((const uint8*)data, length,
+				bitmap.get());
+			break;
+		case B_LARGE_ICON_TYPE:
+		case B_MINI_ICON_TYPE:
+			if(length == (size_t)size * size) {
+				status = BIconUtils::ConvertFromCMAP8((const uint8*)data, size,
+					size, size, bitmap.get());
+			}
+			break;
+	}
+
+	if(status != B_OK)
+		bitmap.reset();
+	return bitmap;
+}
+
+// #pragma mark - IconCache::Private
+
+status_t
+IconCache::_Worker(void* data)
+{
+	IconCache* cache = static_cast<IconCache*>(data);
+
+	while(acquire_sem(cache->fWork) == B_OK) {
+		entry_list::iterator current;
+		{
+			BAutolock _(cache->fLock);
+			if(cache->fQuitting)
+				break;
+
+			// Windows that were closed meanwhile don't need their icons
+			while(!cache->fQueued.empty()
+				&& !_IsWaitedFor(cache->fQueued.back())) {
+				cache->_Unindex(--cache->fQueued.end());
+				cache->fQueued.pop_back();
+			}
+			if(cache->fQueued.empty())
+				continue;
+
+			// Newest first; splicing keeps the iterators in fIndex valid
+			current = --cache->fQueued.end();
+			cache->fRendering.splice(cache->fRendering.begin(),
+				cache->fQueued, current);
+		}
+
+		// Nobody else writes to an entry while it is in fRendering
+		bitmap_ref bitmap = Rasterize(current->k.type, current->data.data(),
+			current->data.size(), current->k.size);
+
+		std::vector<BMessenger> targets;
+		{
+			BAutolock _(cache->fLock);
+			current->bitmap = bitmap;
+			targets.swap(current->targets);
+			cache->fEntries.splice(cache->fEntries.begin(), cache->fRendering,
+				current);
+			cache->fBytes += _Bytes(*current);
+			cache->_Evict();
+		}
+
+		for(size_t i = 0; i < targets.size(); i++)
+			targets[i].SendMessage(IC_ICON_READY);
+	}
+
+	return B_OK;
+}
+
+// What an entry holds on to; failed renders still keep their data
+size_t
+IconCache::_Bytes(const entry& cached)
+{
+	return sizeof(entry) + cached.data.size()
+		+ (cached.bitmap ? cached.bitmap->BitsLength() : 0);
+}
+
+bool
+IconCache::_IsWaitedFor(const entry& cached)
+{
+	for(size_t i = 0; i < cached.targets.size(); i++) {
+		if(cached.targets[i].IsValid())
+			return true;
+	}
+	return false;
+}
+
+IconCache::entry_index::iterator
+IconCache::_Find(const key& k, const void* data)
+{
+	std::pair<entry_index::iterator, entry_index::iterator> range
+		= fIndex.equal_range(k);
+	for(entry_index::iterator it = range.first; it != range.second; it++) {
+		if(memcmp(it->second->data.data(), data, k.length) == 0)
+			return it;
+	}
+	return fIndex.end();
+}
+
+void
+IconCache::_Unindex(entry_list::iterator cached)
+{
+	std::pair<entry_index::iterator, entry_index::iterator> range
+		= fIndex.equal_range(cached->k);
+	for(entry_index::iterator it = range.first; it != range.second; it++) {
+		if(it->second == cached) {
+			fIndex.erase(it);
+			break;
+		}
+	}
+}
+
+// The newest entry stays even when it is larger than the whole budget
+void
+IconCache::_Evict()
+{
+	while(fBytes > kMaxBytes && fEntries.size() > 1) {
+		entry_list::iterator oldest = --fEntries.end();
+		fBytes -= _Bytes(*oldest);
+		_Unindex(oldest);
+		fEntries.erase(oldest);
+	}
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef __ICON_CACHE_H__
+#define __ICON_CACHE_H__
+
+#include <Bitmap.h>
+#include <Locker.h>
+#include <Messenger.h>
+#include <OS.h>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+enum {
+	IC_ICON_READY = 'ic00'	// ask again, the icon is in the cache now
+};
+
+/*	Rasterized icons, keyed by the icon data and the edge length in pixels.
+	Looking up an icon that is not in the cache yet returns at once; a pool
+	of worker threads renders it and sends IC_ICON_READY to every target
+	that asked for it. The most recent requests are served first, so that
+	whatever was scrolled into view last shows up first.
+
+	Vector icons are rendered at the requested size, B_LARGE_ICON_TYPE and
+	B_MINI_ICON_TYPE ones at their own 32 and 16 pixels. Entries past
+	kMaxBytes, counting the icon data and failed renders as well, are
+	dropped least recently used first; views that still draw one keep it
+	alive through their reference.
+
+	At most kMaxQueued icons wait to be rendered. The oldest request goes
+	when another one comes in, its targets are told to ask again and only
+	those that still show the icon do; requests whose targets are all gone
+	are skipped.
+*/
+class IconCache
+{
+public:
+	typedef std::shared_ptr<BBitmap> bitmap_ref;
+
+	static	const size_t	kMaxBytes = 32 * 1024 * 1024;
+	static	const int32		kMaxWorkers = 8;
+	static	const size_t	kMaxQueued = 256;
+
+							IconCache();
+							~IconCache();
+
+	static	IconCache*		Default() { return sDefault; }
+
+	static	bool			IsIconType(type_code type);
+	static	int32			NativeSize(type_code type, int32 size);
+
+			// Returns false when the icon is still to be rendered. A bitmap
+			// of NULL means the data is no valid icon.
+			bool			Lookup(type_code type, const void* data,
+								size_t length, int32 size, bitmap_ref* bitmap,
+								BMessenger target);
+	static	bitmap_ref		Rasterize(type_code type, const void* data,
+								size_t length, int32 size);
+private:
+	struct key {
+		type_code		type;
+		int32			size;
+		uint32			checksum;
+		size_t			length;
+
+		bool			operator==(const key& other) const;
+	};
+
+	struct key_hash {
+		size_t			operator()(const key& k) const;
+	};
+
+	struct entry {
+		key				k;
+		std::vector<uint8> data;
+		bitmap_ref		bitmap;
+		std::vector<BMessenger> targets;	// while queued or rendering
+	};
+
+	typedef std::list<entry> entry_list;
+	typedef std::unordered_multimap<key, entry_list::iterator, key_hash>
+		entry_index;
+
+	static	status_t		_Worker(void* data);
+	static	size_t			_Bytes(const entry& cached);
+	static	bool			_IsWaitedFor(const entry& cached);
+			entry_index::iterator _Find(const key& k, const void* data);
+			void			_Unindex(entry_list::iterator cached);
+			void			_Evict();
+private:
+	static	IconCache*		sDefault;
+
+			BLocker			fLock;
+			entry_list		fEntries;	// rendered, most recent first
+			entry_list		fQueued;	// oldest first
+			entry_list		fRendering;
+			entry_index		fIndex;		// over all three lists
+			size_t			fBytes;
+
+			sem_id			fWork;
+			std::vector<thread_id> fWorkers;
+			bool			fQuitting;
+};
+
+#endif /* __ICON_CACHE_H__ */
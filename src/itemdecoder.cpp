@@ -0,0 +1,429 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#include <Alignment.h>
+#include <Catalog.h>
+#include <DateTime.h>
+#include <Entry.h>
+#include <GraphicsDefs.h>
+#include <Point.h>
+#include <Rect.h>
+#include <Size.h>
+#include <cctype>
+#include <cstddef>
+#include <cstring>
+#include <sys/socket.h>
+#include "gettype.h"
+#include "itemdecoder.h"
+#include "netaddress.h"
+
+// Shares its strings with the view that used to decode the items itself
+#undef B_TRANSLATION_CONTEXT
+#define B_TRANSLATION_CONTEXT "DataView"
+
+static const ssize_t kAffineTransformSize = 6 * sizeof(double);
+static const ssize_t kFlatNodeRefSize = sizeof(dev_t) + sizeof(ino_t);
+
+template<typename T>
+static inline T
+read_item(const void* data)
+{
+	T value;
+	memcpy(&value, data, sizeof(T));
+	return value;
+}
+
+// Integer stored with the width of whichever platform wrote the file
+static inline int64
+read_native_int(const void* data, ssize_t length)
+{
+	if(length == sizeof(int32))
+		return read_item<int32>(data);
+	return read_item<int64>(data);
+}
+
+static inline void
+append_two_digits(BString& text, int32 value)
+{
+	if(value < 10)
+		text << "0";
+	text << value;
+}
+
+static const char*
+horizontal_alignment_label(alignment value)
+{
+	switch(value) {
+		case B_ALIGN_LEFT:
+			return B_TRANSLATE("left");
+		case B_ALIGN_RIGHT:
+			return B_TRANSLATE("right");
+		case B_ALIGN_CENTER:
+			return B_TRANSLATE("center");
+		case B_ALIGN_USE_FULL_WIDTH:
+			return B_TRANSLATE("full width");
+		case B_ALIGN_HORIZONTAL_UNSET:
+			return B_TRANSLATE("(unset)");
+		default:
+			return B_TRANSLATE("(invalid)");
+	}
+}
+
+static const char*
+vertical_alignment_label(vertical_alignment value)
+{
+	switch(value) {
+		case B_ALIGN_TOP:
+			return B_TRANSLATE("top");
+		case B_ALIGN_MIDDLE:
+			return B_TRANSLATE("middle");
+		case B_ALIGN_BOTTOM:
+			return B_TRANSLATE("bottom");
+		case B_ALIGN_USE_FULL_HEIGHT:
+			return B_TRANSLATE("full height");
+		case B_ALIGN_VERTICAL_UNSET:
+			return B_TRANSLATE("(unset)");
+		default:
+			return B_TRANSLATE("(invalid)");
+	}
+}
+
+bool
+item_size_valid(type_code type, ssize_t length)
+{
+	if(length < 0)
+		return false;
+
+	switch(type) {
+		case B_AFFINE_TRANSFORM_TYPE:
+			return length == kAffineTransformSize;
+		case B_ALIGNMENT_TYPE:
+			return length == 2 * sizeof(int32);
+		case B_BOOL_TYPE:
+		case B_CHAR_TYPE:
+			return length >= 1;
+		case B_DOUBLE_TYPE:
+			return length == sizeof(double);
+		case B_FLOAT_TYPE:
+			return length == sizeof(float);
+		case B_INT8_TYPE:
+		case B_UINT8_TYPE:
+			return length == sizeof(int8);
+		case B_INT16_TYPE:
+		case B_UINT16_TYPE:
+			return length == sizeof(int16);
+		case B_INT32_TYPE:
+		case B_UINT32_TYPE:
+			return length == sizeof(int32);
+		case B_INT64_TYPE:
+		case B_UINT64_TYPE:
+		case B_OFF_T_TYPE:
+			return length == sizeof(int64);
+		case B_SIZE_T_TYPE:
+		case B_SSIZE_T_TYPE:
+		case B_TIME_TYPE:
+			// 32 and 64 bit builds write these with different widths
+			return length == sizeof(int32) || length == sizeof(int64);
+		case B_NETWORK_ADDRESS_TYPE:
+			// at least the length and family bytes
+			return length >= 2 && length <= (ssize_t)sizeof(sockaddr_storage);
+		case B_NODE_REF_TYPE:
+			return length >= kFlatNodeRefSize;
+		case B_REF_TYPE:
+			return length >= kFlatNodeRefSize;
+		case B_POINT_TYPE:
+			return length == sizeof(BPoint);
+		case B_RECT_TYPE:
+			return length == sizeof(BRect);
+		case B_RGB_COLOR_TYPE:
+			return length == sizeof(rgb_color);
+		case B_SIZE_TYPE:
+			return length == sizeof(BSize);
+		default:
+			return true;
+	}
+}
+
+status_t
+decode_item(type_code type, const void* data, ssize_t length, BString& text)
+{
+	text.Truncate(0);
+
+	if((data == NULL && length > 0) || !item_size_valid(type, length)) {
+		text.SetToFormat(B_TRANSLATE("(invalid data: %" B_PRIdSSIZE " bytes)"),
+			length);
+		return B_BAD_DATA;
+	}
+
+	const uint8* bytes = static_cast<const uint8*>(data);
+
+	switch(type) {
+		case B_AFFINE_TRANSFORM_TYPE:
+		{
+			// Stored as sx, shy, shx, sy, tx, ty
+			double raw[6];
+			memcpy(raw, data, sizeof(raw));
+			text << B_TRANSLATE("translation") << "(" << raw[4] << ", " << raw[5] << "); "
+				 << B_TRANSLATE("scale") << "(" << raw[0] << ", " << raw[3] << "); "
+				 << B_TRANSLATE("shear") << "(" << raw[2] << ", " << raw[1] << ")";
+			break;
+		}
+
+		case B_ALIGNMENT_TYPE:
+		{
+			// Flattened as two int32, horizontal first
+			int32 raw[2];
+			memcpy(raw, data, sizeof(raw));
+			text << horizontal_alignment_label(static_cast<alignment>(raw[0]))
+				 << ", "
+				 << vertical_alignment_label(static_cast<vertical_alignment>(raw[1]));
+			break;
+		}
+
+		case B_BOOL_TYPE:
+			text = bytes[0] != 0 ? B_TRANSLATE("true") : B_TRANSLATE("false");
+			break;
+
+		case B_CHAR_TYPE:
+		{
+			char c = static_cast<char>(bytes[0]);
+			if(isprint(bytes[0]) != 0)
+				text << c;
+			else {
+				text << B_TRANSLATE("data cannot be displayed");
+				return B_NOT_SUPPORTED;
+			}
+			break;
+		}
+
+		case B_DOUBLE_TYPE:
+			text.SetToFormat("%.4f", read_item<double>(data));
+			break;
+
+		case B_FLOAT_TYPE:
+			text.SetToFormat("%.4f", read_item<float>(data));
+			break;
+
+		case B_INT8_TYPE:
+			text << read_item<int8>(data);
+			break;
+
+		case B_INT16_TYPE:
+			text << read_item<int16>(data);
+			break;
+
+		case B_INT32_TYPE:
+			text << read_item<int32>(data);
+			break;
+
+		case B_INT64_TYPE:
+		case B_OFF_T_TYPE:
+			text << read_item<int64>(data);
+			break;
+
+		case B_UINT8_TYPE:
+			text << read_item<uint8>(data);
+			break;
+
+		case B_UINT16_TYPE:
+			text << read_item<uint16>(data);
+			break;
+
+		case B_UINT32_TYPE:
+			text << read_item<uint32>(data);
+			break;
+
+		case B_UINT64_TYPE:
+			text << read_item<uint64>(data);
+			break;
+
+		case B_SIZE_T_TYPE:
+			if(length == sizeof(uint32))
+				text << read_item<uint32>(data);
+			else
+				text << read_item<uint64>(data);
+			break;
+
+		case B_SSIZE_T_TYPE:
+			text << read_native_int(data, length);
+			break;
+
+		case B_MIME_TYPE:
+		case B_STRING_TYPE:
+		{
+			// The terminator may be missing, never read past the item
+			const char* string = static_cast<const char*>(data);
+			text.SetTo(string, strnlen(string, length));
+			break;
+		}
+
+		case B_NETWORK_ADDRESS_TYPE:
+		{
+			// ss_len is only shown, the item length is what gets read
+			const uint8* bytes = static_cast<const uint8*>(data);
+			sa_family_t family = bytes[offsetof(sockaddr, sa_family)];
+			char address[kSockaddrTextSize];
+			ssize_t addressLength = format_sockaddr(data, length, address,
+				sizeof(address));
+
+			text << B_TRANSLATE("family: ")
+				 << NetAddressFamilyString(family) << ", "
+				 << B_TRANSLATE("length: ")
+				 << (uint32)bytes[0] << ", "
+				 << B_TRANSLATE("address: ");
+			if(addressLength > 0)
+				text.Append(address, addressLength);
+			else if(addressLength == 0)
+				text << B_TRANSLATE("(no resolvable address)");
+			else
+				text << B_TRANSLATE("(malformed address)");
+			break;
+		}
+
+		case B_POINT_TYPE:
+		{
+			BPoint point = read_item<BPoint>(data);
+			text << point.x << ", " << point.y;
+			break;
+		}
+
+		case B_RECT_TYPE:
+		{
+			BRect rect = read_item<BRect>(data);
+			text << rect.left  << ", " << rect.top << ", "
+				 << rect.right << ", " << rect.bottom;
+			break;
+		}
+
+		case B_SIZE_TYPE:
+		{
+			BSize size = read_item<BSize>(data);
+			text << size.width << ", " << size.height;
+			break;
+		}
+
+		case B_RGB_COLOR_TYPE:
+		{
+			rgb_color color = read_item<rgb_color>(data);
+			text << color.red << ", " << color.green << ", "
+				 << color.blue << ", " << color.alpha;
+			break;
+		}
+
+		case B_NODE_REF_TYPE:
+		{
+			dev_t device = read_item<dev_t>(bytes);
+			ino_t node = read_item<ino_t>(bytes + sizeof(dev_t));
+			text.SetToFormat(B_TRANSLATE("device: %" B_PRIdDEV ", node: %"
+				B_PRIdINO), device, node);
+			break;
+		}
+
+		case B_REF_TYPE:
+		{
+			// Raw form only; the file system is left to RefPathCache
+			entry_ref ref;
+			decode_ref(data, length, &ref);
+			text.SetToFormat(B_TRANSLATE("device: %" B_PRIdDEV ", "
+				"directory: %" B_PRIdINO ", name: %s"),
+				ref.device, ref.directory, ref.name ? ref.name : "");
+			break;
+		}
+
+		case B_TIME_TYPE:
+		{
+			BDateTime datetime;
+			datetime.SetTime_t(static_cast<time_t>(read_native_int(data, length)));
+
+			text << datetime.Date().Year() << "-";
+			append_two_digits(text, datetime.Date().Month());
+			text << "-";
+			append_two_digits(text, datetime.Date().Day());
+			text << " ";
+			append_two_digits(text, datetime.Time().Hour());
+			text << ":";
+			append_two_digits(text, datetime.Time().Minute());
+			text << ":";
+			append_two_digits(text, datetime.Time().Second());
+			break;
+		}
+
+		default:
+			text << B_TRANSLATE("data cannot be displayed");
+			return B_NOT_SUPPORTED;
+	}
+
+	return B_OK;
+}
+
+bool
+decode_ref(const void* data, ssize_t length, entry_ref* ref)
+{
+	if(!item_size_valid(B_REF_TYPE, length))
+		return false;
+
+	// Flattened as device, directory and an optional name; the name is
+	// bounded by the item instead of its terminator
+	const uint8* bytes = static_cast<const uint8*>(data);
+	const char* name = reinterpret_cast<const char*>(bytes + kFlatNodeRefSize);
+	BString nameString(name, strnlen(name, length - kFlatNodeRefSize));
+
+	ref->device = read_item<dev_t>(bytes);
+	ref->directory = read_item<ino_t>(bytes + sizeof(dev_t));
+	return ref->set_name(nameString.String()) == B_OK;
+}
+
+bool
+decode_number(type_code type, const void* data, ssize_t length, double* value)
+{
+	if(data == NULL || !item_size_valid(type, length))
+		return false;
+
+	switch(type) {
+		case B_DOUBLE_TYPE:
+			*value = read_item<double>(data);
+			return true;
+		case B_FLOAT_TYPE:
+			*value = read_item<float>(data);
+			return true;
+		case B_INT8_TYPE:
+			*value = read_item<int8>(data);
+			return true;
+		case B_INT16_TYPE:
+			*value = read_item<int16>(data);
+			return true;
+		case B_INT32_TYPE:
+			*value = read_item<int32>(data);
+			return true;
+		case B_INT64_TYPE:
+		case B_OFF_T_TYPE:
+			*value = read_item<int64>(data);
+			return true;
+		case B_UINT8_TYPE:
+			*value = read_item<uint8>(data);
+			return true;
+		case B_UINT16_TYPE:
+			*value = read_item<uint16>(data);
+			return true;
+		case B_UINT32_TYPE:
+			*value = read_item<uint32>(data);
+			return true;
+		case B_UINT64_TYPE:
+			*value = read_item<uint64>(data);
+			return true;
+		case B_SIZE_T_TYPE:
+			if(length == sizeof(uint32))
+				*value = read_item<uint32>(data);
+			else
+				*value = read_item<uint64>(data);
+			return true;
+		case B_SSIZE_T_TYPE:
+		case B_TIME_TYPE:
+			*value = read_native_int(data, length);
+			return true;
+		default:
+			return false;
+	}
+}
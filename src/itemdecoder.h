@@ -0,0 +1,39 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef __ITEM_DECODER_H__
+#define __ITEM_DECODER_H__
+
+#include <Entry.h>
+#include <String.h>
+#include <SupportDefs.h>
+
+/*	Decoding of single field items straight from their raw bytes, as handed
+	out by BMessage::FindData(). Nothing here trusts the length stored in
+	the file: every type is checked against the sizes it can have before a
+	single byte is read, so a damaged or hostile message only ever shows up
+	as an "invalid data" item.
+*/
+
+// Returns true when length bytes can hold one item of the given type.
+// Types without a known layout accept any length.
+bool		item_size_valid(type_code type, ssize_t length);
+
+// Formats one item for display. Returns B_BAD_DATA when the size check
+// fails and B_NOT_SUPPORTED for types that have no text form; text is
+// filled with a placeholder in both cases.
+status_t	decode_item(type_code type, const void* data, ssize_t length,
+				BString& text);
+
+// Device, directory and name of a B_REF_TYPE item. Never looks at the
+// file system.
+bool		decode_ref(const void* data, ssize_t length, entry_ref* ref);
+
+// Numeric value of an item for integer, floating point, offset, size and
+// time types. Returns false for any other type or a bad length.
+bool		decode_number(type_code type, const void* data, ssize_t length,
+				double* value);
+
+#endif /* __ITEM_DECODER_H__ */
@@ -0,0 +1,415 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+
+/*	kottan-patch: makes a patch between two versions of a message file and
+	applies it to many copies of the old version at once.
+
+		kottan-patch diff [-o patch] old new
+		kottan-patch apply [-f] [-n] [-o directory] patch file...
+
+	diff writes the patch to standard output unless -o names a file.
+	apply rewrites the files in place unless -o names a directory for the
+	results; -n only checks that the patch applies. A file that is not
+	the version the patch was made for is left alone, one that is already
+	the new version is counted as such. -f applies the patch without
+	checking the old version first. Files in the other byte order are
+	patched and stay in their order, a checksum footer after the message
+	is renewed, other bytes after it are kept.
+*/
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <ByteOrder.h>
+#include <string>
+#include <vector>
+
+#include "byteswap.h"
+#include "checksum.h"
+#include "flatmessage.h"
+#include "legacymessage.h"
+#include "messagedelta.h"
+
+struct patch_stats {
+	uint64		files;
+	uint64		patched;
+	uint64		current;
+	uint64		failed;
+	uint64		bytesIn;
+	uint64		bytesOut;
+};
+
+// A file, mapped, and the message at its start in host byte order
+struct message_file {
+	int			fd;
+	void*		mapped;
+	size_t		size;
+	bool		swapped;
+	const uint8* message;
+	size_t		messageSize;
+	std::vector<uint8> native;
+};
+
+static bool
+write_all(int fd, const uint8* data, size_t size)
+{
+	while(size > 0) {
+		ssize_t written = write(fd, data, size);
+		if(written < 0) {
+			if(errno == EINTR)
+				continue;
+			return false;
+		}
+		data += written;
+		size -= written;
+	}
+	return true;
+}
+
+// The status codes of the decoder need not be errno values on every host
+static const char*
+status_text(status_t status)
+{
+	switch(status) {
+		case B_NOT_A_MESSAGE:
+			return "not a flattened message";
+		case B_BAD_DATA:
+			return "corrupt message or patch";
+		case B_BAD_TYPE:
+			return "not a patch";
+		case B_NOT_SUPPORTED:
+			return "patch made on a host of the other byte order";
+		case B_MISMATCHED_VALUES:
+			return "not the version the patch was made for";
+		default:
+			return strerror(status);
+	}
+}
+
+static void
+report_error(const char* path, const char* what)
+{
+	fprintf(stderr, "kottan-patch: %s: %s\n", path, what);
+}
+
+static std::string
+output_path(const char* directory, const char* path)
+{
+	const char* leaf = strrchr(path, '/');
+	std::string result(directory);
+	if(!result.empty() && result[result.size() - 1] != '/')
+		result += '/';
+	result += leaf ? leaf + 1 : path;
+	return result;
+}
+
+static void
+close_file(message_file& file)
+{
+	if(file.mapped != MAP_FAILED)
+		munmap(file.mapped, file.size);
+	if(file.fd >= 0)
+		close(file.fd);
+	file.mapped = MAP_FAILED;
+	file.fd = -1;
+}
+
+static bool
+open_file(const char* path, int mode, message_file& file)
+{
+	file.fd = open(path, mode);
+	file.mapped = MAP_FAILED;
+	struct stat st;
+	if(file.fd < 0 || fstat(file.fd, &st) != 0) {
+		report_error(path, strerror(errno));
+		close_file(file);
+		return false;
+	}
+
+	file.size = st.st_size;
+	if(file.size > 0) {
+		file.mapped = mmap(NULL, file.size, PROT_READ, MAP_PRIVATE, file.fd,
+			0);
+	}
+	if(file.mapped == MAP_FAILED) {
+		report_error(path, file.size > 0 ? strerror(errno) : "empty file");
+		close_file(file);
+		return false;
+	}
+
+	const uint8* data = static_cast<const uint8*>(file.mapped);
+	if(is_legacy_message(data, file.size)) {
+		report_error(path, "R5 or Dano message, upgrade it with "
+			"kottan-upgrade first");
+		close_file(file);
+		return false;
+	}
+
+	file.swapped = is_swapped_flat_message(data, file.size);
+	ssize_t size = flattened_message_size(data, file.size);
+	status_t status = size > 0 ? B_OK : size == 0 ? B_BAD_DATA : size;
+	if(status == B_OK && file.swapped) {
+		file.native.assign(data, data + size);
+		status = swap_flat_message(file.native.data(), size);
+		data = file.native.data();
+	}
+	if(status != B_OK) {
+		report_error(path, status_text(status));
+		close_file(file);
+		return false;
+	}
+
+	file.message = data;
+	file.messageSize = size;
+	return true;
+}
+
+static bool
+has_footer(const message_file& file)
+{
+	checksum_footer footer;
+	if(file.size - file.messageSize < sizeof(footer))
+		return false;
+	memcpy(&footer, static_cast<const uint8*>(file.mapped) + file.messageSize,
+		sizeof(footer));
+	return B_LENDIAN_TO_HOST_INT32(footer.magic) == kChecksumFooterMagic
+		&& B_LENDIAN_TO_HOST_INT64(footer.length) == file.messageSize;
+}
+
+static int
+make_patch(const char* basePath, const char* resultPath, const char* target)
+{
+	message_file base;
+	message_file result;
+	if(!open_file(basePath, O_RDONLY, base))
+		return 1;
+	if(!open_file(resultPath, O_RDONLY, result)) {
+		close_file(base);
+		return 1;
+	}
+
+	std::vector<uint8> delta;
+	status_t status = create_message_delta(base.message, base.messageSize,
+		result.message, result.messageSize, delta);
+	close_file(base);
+	close_file(result);
+	if(status != B_OK) {
+		report_error(resultPath, status_text(status));
+		return 1;
+	}
+
+	int fd = target ? open(target, O_WRONLY | O_CREAT | O_TRUNC, 0644)
+		: STDOUT_FILENO;
+	bool success = fd >= 0 && write_all(fd, delta.data(), delta.size());
+	if(!success)
+		report_error(target ? target : "-", strerror(errno));
+	if(target && fd >= 0)
+		close(fd);
+
+	fprintf(stderr, "%zu byte message, %zu byte patch\n",
+		result.messageSize, delta.size());
+	return success ? 0 : 1;
+}
+
+static bool
+patch_file(const char* path, const uint8* delta, size_t deltaSize,
+	const char* directory, bool dryRun, bool force, patch_stats& stats,
+	std::vector<uint8>& output)
+{
+	stats.files++;
+
+	message_file file;
+	if(!open_file(path, dryRun || directory ? O_RDONLY : O_RDWR, file)) {
+		stats.failed++;
+		return false;
+	}
+	stats.bytesIn += file.size;
+
+	status_t status = apply_message_delta(file.message, file.messageSize,
+		delta, deltaSize, output, !force);
+	if(status == B_MISMATCHED_VALUES) {
+		message_delta_header header;
+		memcpy(&header, delta, sizeof(header));
+		if(file.messageSize == header.result_size
+			&& crc32c(0, file.message, file.messageSize)
+				== header.result_checksum) {
+			close_file(file);
+			stats.current++;
+			return true;
+		}
+	}
+	if(status == B_OK && file.swapped)
+		status = swap_flat_message(output.data(), output.size());
+	if(status != B_OK) {
+		report_error(path, status_text(status));
+		close_file(file);
+		stats.failed++;
+		return false;
+	}
+
+	// The footer covers the message as stored
+	const uint8* data = static_cast<const uint8*>(file.mapped);
+	size_t rest = file.messageSize;
+	if(has_footer(file)) {
+		checksum_footer footer;
+		footer.magic = B_HOST_TO_LENDIAN_INT32(kChecksumFooterMagic);
+		footer.checksum = B_HOST_TO_LENDIAN_INT32(
+			crc32c(0, output.data(), output.size()));
+		footer.length = B_HOST_TO_LENDIAN_INT64(output.size());
+		const uint8* bytes = reinterpret_cast<const uint8*>(&footer);
+		output.insert(output.end(), bytes, bytes + sizeof(footer));
+		rest += sizeof(footer);
+	}
+	output.insert(output.end(), data + rest, data + file.size);
+	munmap(file.mapped, file.size);
+	file.mapped = MAP_FAILED;
+
+	bool success = true;
+	if(directory && !dryRun) {
+		struct stat st;
+		fstat(file.fd, &st);
+		std::string target = output_path(directory, path);
+		int targetFD = open(target.c_str(), O_WRONLY | O_CREAT | O_TRUNC,
+			st.st_mode & 0777);
+		success = targetFD >= 0
+			&& write_all(targetFD, output.data(), output.size());
+		if(!success)
+			report_error(target.c_str(), strerror(errno));
+		if(targetFD >= 0)
+			close(targetFD);
+	} else if(!dryRun) {
+		success = ftruncate(file.fd, 0) == 0 && lseek(file.fd, 0, SEEK_SET) == 0
+			&& write_all(file.fd, output.data(), output.size());
+		if(!success)
+			report_error(path, strerror(errno));
+	}
+	close_file(file);
+
+	if(!success) {
+		stats.failed++;
+		return false;
+	}
+	stats.patched++;
+	stats.bytesOut += output.size();
+	return true;
+}
+
+static int
+apply_patch(const char* patchPath, char** paths, int count,
+	const char* directory, bool dryRun, bool force)
+{
+	int fd = open(patchPath, O_RDONLY);
+	std::vector<uint8> delta;
+	struct stat st;
+	if(fd < 0 || fstat(fd, &st) != 0) {
+		report_error(patchPath, strerror(errno));
+		if(fd >= 0)
+			close(fd);
+		return 1;
+	}
+	delta.resize(st.st_size);
+	ssize_t bytesRead = read(fd, delta.data(), delta.size());
+	close(fd);
+	if(bytesRead != (ssize_t)delta.size()
+		|| delta.size() < sizeof(message_delta_header)
+		|| !is_message_delta(delta.data(), delta.size())) {
+		report_error(patchPath, status_text(B_BAD_TYPE));
+		return 1;
+	}
+
+	patch_stats stats;
+	memset(&stats, 0, sizeof(stats));
+	std::vector<uint8> output;
+
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	bool success = true;
+	for(int i = 0; i < count; i++) {
+		success &= patch_file(paths[i], delta.data(), delta.size(), directory,
+			dryRun, force, stats, output);
+	}
+
+	struct timespec end;
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double seconds = (end.tv_sec - start.tv_sec)
+		+ (end.tv_nsec - start.tv_nsec) / 1e9;
+
+	fprintf(stderr, "%llu files: %llu patched, %llu already current, "
+		"%llu failed; %.1f MB in, %.1f MB out, %.3f s (%.0f files/s)\n",
+		(unsigned long long)stats.files, (unsigned long long)stats.patched,
+		(unsigned long long)stats.current, (unsigned long long)stats.failed,
+		stats.bytesIn / 1e6, stats.bytesOut / 1e6, seconds,
+		seconds > 0 ? stats.files / seconds : 0.0);
+
+	return success ? 0 : 1;
+}
+
+static void
+print_usage()
+{
+	fprintf(stderr, "usage: kottan-patch diff [-o patch] old new\n"
+		"       kottan-patch apply [-f] [-n] [-o directory] patch file...\n");
+}
+
+int
+main(int argc, char** argv)
+{
+	if(argc < 2) {
+		print_usage();
+		return 2;
+	}
+
+	const char* command = argv[1];
+	bool diff = strcmp(command, "diff") == 0;
+	if(!diff && strcmp(command, "apply") != 0) {
+		print_usage();
+		return 2;
+	}
+
+	bool dryRun = false;
+	bool force = false;
+	const char* output = NULL;
+
+	int option;
+	optind = 2;
+	while((option = getopt(argc, argv, diff ? "o:h" : "fno:h")) != -1) {
+		switch(option) {
+			case 'f':
+				force = true;
+				break;
+			case 'n':
+				dryRun = true;
+				break;
+			case 'o':
+				output = optarg;
+				break;
+			default:
+				print_usage();
+				return 2;
+		}
+	}
+
+	if(diff) {
+		if(argc - optind != 2) {
+			print_usage();
+			return 2;
+		}
+		return make_patch(argv[optind], argv[optind + 1], output);
+	}
+
+	if(argc - optind < 2) {
+		print_usage();
+		return 2;
+	}
+	return apply_patch(argv[optind], argv + optind + 1, argc - optind - 1,
+		output, dryRun, force);
+}
@@ -0,0 +1,305 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+
+/*	kottan-upgrade: rewrites R5 and Dano message files in the native
+	layout, for archives too large to open one by one in Kottan.
+
+		kottan-upgrade [-n] [-o directory] file...
+		kottan-upgrade - < legacy-stream > native-stream
+
+	Files are upgraded in place unless -o names a directory for the
+	results; rewriting in place keeps the attributes of the file. Native
+	files are left alone, -n only counts. With "-" a stream of flattened
+	messages is copied from standard input to standard output, the legacy
+	ones upgraded on the way. Only POSIX calls are used, so that the tool
+	also runs on the machines the archives are stored on.
+*/
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "legacymessage.h"
+
+struct upgrade_stats {
+	uint64		files;
+	uint64		upgraded;
+	uint64		native;
+	uint64		failed;
+	uint64		bytesIn;
+	uint64		bytesOut;
+};
+
+static bool
+write_all(int fd, const uint8* data, size_t size)
+{
+	while(size > 0) {
+		ssize_t written = write(fd, data, size);
+		if(written < 0) {
+			if(errno == EINTR)
+				continue;
+			return false;
+		}
+		data += written;
+		size -= written;
+	}
+	return true;
+}
+
+// The status codes of the decoder need not be errno values on every host
+static const char*
+status_text(status_t status)
+{
+	switch(status) {
+		case B_NOT_A_MESSAGE:
+			return "not a flattened message";
+		case B_BAD_DATA:
+			return "corrupt message";
+		case B_BAD_TYPE:
+			return "field with items of different types";
+		case B_BAD_VALUE:
+			return "fixed size field with items of different sizes";
+		default:
+			return strerror(status);
+	}
+}
+
+static void
+report_error(const char* path, const char* what)
+{
+	fprintf(stderr, "kottan-upgrade: %s: %s\n", path, what);
+}
+
+static std::string
+output_path(const char* directory, const char* path)
+{
+	const char* leaf = strrchr(path, '/');
+	std::string result(directory);
+	if(!result.empty() && result[result.size() - 1] != '/')
+		result += '/';
+	result += leaf ? leaf + 1 : path;
+	return result;
+}
+
+// Whatever follows the message, a checksum footer or padding, is kept
+static bool
+upgrade_file(const char* path, const char* directory, bool dryRun,
+	upgrade_stats& stats, std::vector<uint8>& output)
+{
+	stats.files++;
+
+	int fd = open(path, dryRun || directory ? O_RDONLY : O_RDWR);
+	struct stat st;
+	if(fd < 0 || fstat(fd, &st) != 0) {
+		report_error(path, strerror(errno));
+		if(fd >= 0)
+			close(fd);
+		stats.failed++;
+		return false;
+	}
+
+	size_t size = st.st_size;
+	void* mapped = size > 0
+		? mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+	if(mapped == MAP_FAILED) {
+		report_error(path, size > 0 ? strerror(errno) : "empty file");
+		close(fd);
+		stats.failed++;
+		return false;
+	}
+
+	const uint8* data = static_cast<const uint8*>(mapped);
+	stats.bytesIn += size;
+
+	if(!is_legacy_message(data, size)) {
+		munmap(mapped, size);
+		close(fd);
+		stats.native++;
+		return true;
+	}
+
+	size_t used;
+	status_t status = upgrade_legacy_message(data, size, output, &used);
+	if(status != B_OK) {
+		report_error(path, status_text(status));
+		munmap(mapped, size);
+		close(fd);
+		stats.failed++;
+		return false;
+	}
+	output.insert(output.end(), data + used, data + size);
+	munmap(mapped, size);
+
+	bool success = true;
+	if(directory && !dryRun) {
+		std::string target = output_path(directory, path);
+		int targetFD = open(target.c_str(), O_WRONLY | O_CREAT | O_TRUNC,
+			st.st_mode & 0777);
+		success = targetFD >= 0
+			&& write_all(targetFD, output.data(), output.size());
+		if(!success)
+			report_error(target.c_str(), strerror(errno));
+		if(targetFD >= 0)
+			close(targetFD);
+	} else if(!dryRun) {
+		success = ftruncate(fd, 0) == 0 && lseek(fd, 0, SEEK_SET) == 0
+			&& write_all(fd, output.data(), output.size());
+		if(!success)
+			report_error(path, strerror(errno));
+	}
+	close(fd);
+
+	if(!success) {
+		stats.failed++;
+		return false;
+	}
+	stats.upgraded++;
+	stats.bytesOut += output.size();
+	return true;
+}
+
+// Reads until the buffer holds at least size bytes; false at end of input
+static bool
+fill_buffer(std::vector<uint8>& buffer, size_t& length, size_t size)
+{
+	if(buffer.size() < size)
+		buffer.resize(std::max(size, buffer.size() * 2));
+
+	while(length < size) {
+		ssize_t bytesRead = read(STDIN_FILENO, buffer.data() + length,
+			buffer.size() - length);
+		if(bytesRead < 0 && errno == EINTR)
+			continue;
+		if(bytesRead <= 0)
+			return false;
+		length += bytesRead;
+	}
+	return true;
+}
+
+static bool
+upgrade_stream(upgrade_stats& stats, std::vector<uint8>& output)
+{
+	std::vector<uint8> buffer(64 * 1024);
+	size_t length = 0;
+
+	while(true) {
+		ssize_t size;
+		size_t needed = sizeof(uint32);
+		while((size = flattened_message_size(buffer.data(), length)) == 0) {
+			if(!fill_buffer(buffer, length, needed)) {
+				if(length == 0)
+					return true;
+				report_error("-", "truncated message at end of input");
+				return false;
+			}
+			needed = length + 1;
+		}
+		if(size < 0) {
+			report_error("-", status_text(size));
+			return false;
+		}
+		if(!fill_buffer(buffer, length, size)) {
+			report_error("-", "truncated message at end of input");
+			return false;
+		}
+
+		stats.files++;
+		stats.bytesIn += size;
+		const uint8* data = buffer.data();
+		size_t written = size;
+		if(is_legacy_message(data, size)) {
+			status_t status = upgrade_legacy_message(data, size, output);
+			if(status != B_OK) {
+				report_error("-", status_text(status));
+				return false;
+			}
+			stats.upgraded++;
+			data = output.data();
+			written = output.size();
+		} else
+			stats.native++;
+
+		stats.bytesOut += written;
+		if(!write_all(STDOUT_FILENO, data, written)) {
+			report_error("-", strerror(errno));
+			return false;
+		}
+
+		memmove(buffer.data(), buffer.data() + size, length - size);
+		length -= size;
+	}
+}
+
+static void
+print_usage()
+{
+	fprintf(stderr, "usage: kottan-upgrade [-n] [-o directory] file...\n"
+		"       kottan-upgrade - < input > output\n");
+}
+
+int
+main(int argc, char** argv)
+{
+	bool dryRun = false;
+	const char* directory = NULL;
+
+	int option;
+	while((option = getopt(argc, argv, "no:h")) != -1) {
+		switch(option) {
+			case 'n':
+				dryRun = true;
+				break;
+			case 'o':
+				directory = optarg;
+				break;
+			default:
+				print_usage();
+				return 2;
+		}
+	}
+	if(optind >= argc) {
+		print_usage();
+		return 2;
+	}
+
+	upgrade_stats stats;
+	memset(&stats, 0, sizeof(stats));
+	std::vector<uint8> output;
+
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	bool success = true;
+	if(strcmp(argv[optind], "-") == 0)
+		success = upgrade_stream(stats, output);
+	else {
+		for(int i = optind; i < argc; i++)
+			success &= upgrade_file(argv[i], directory, dryRun, stats, output);
+	}
+
+	struct timespec end;
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double seconds = (end.tv_sec - start.tv_sec)
+		+ (end.tv_nsec - start.tv_nsec) / 1e9;
+
+	fprintf(stderr, "%llu messages: %llu upgraded, %llu native, %llu failed; "
+		"%.1f MB in, %.1f MB out, %.3f s (%.0f messages/s)\n",
+		(unsigned long long)stats.files, (unsigned long long)stats.upgraded,
+		(unsigned long long)stats.native, (unsigned long long)stats.failed,
+		stats.bytesIn / 1e6, stats.bytesOut / 1e6, seconds,
+		seconds > 0 ? stats.files / seconds : 0.0);
+
+	return success ? 0 : 1;
+}
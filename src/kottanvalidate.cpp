@@ -0,0 +1,376 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+
+/*	kottan-validate: checks many message files against a validation schema
+	at once, see schemavalidator.h for the schema format.
+
+		kottan-validate [-q] [-j threads] [-m max] schema file...
+
+	Every file that does not match is listed with up to max (10) of its
+	violations, -q only prints the totals. Native, legacy, swapped and
+	compressed files are read, every message of a stream file is checked.
+	The files are spread over as many threads as there are CPUs unless -j
+	says otherwise; the results are printed in the order of the files.
+	The exit status is 0 when all files match, 1 when one does not or
+	cannot be read and 2 when the schema cannot be used.
+*/
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <DataIO.h>
+#include <OS.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "blockcontainer.h"
+#include "byteswap.h"
+#include "gettype.h"
+#include "legacymessage.h"
+#include "schemavalidator.h"
+
+static const int32 kMaxThreads = 64;
+static const int32 kDefaultShown = 10;
+
+// What was found in one file, printed once all are done
+struct file_result {
+	status_t	status;
+	uint64		size;
+	int64		messages;
+	int64		violations;
+	std::string	report;
+};
+
+struct validation {
+	const SchemaValidator* validator;
+	char**		paths;
+	int32		count;
+	int32		next;
+	int32		shown;
+	std::vector<file_result> results;
+};
+
+// The status codes of the decoder need not be errno values on every host
+static const char*
+status_text(status_t status)
+{
+	switch(status) {
+		case B_NOT_A_MESSAGE:
+			return "not a flattened message";
+		case B_BAD_DATA:
+			return "corrupt message";
+		default:
+			return strerror(status);
+	}
+}
+
+static std::string
+type_list(const BMessage& violation, const char* name)
+{
+	std::string list;
+	type_code type;
+	for(int32 i = 0; violation.FindUInt32(name, i, &type) == B_OK; i++) {
+		if(i > 0)
+			list += ", ";
+		list += get_type(type).String();
+	}
+	return list;
+}
+
+static std::string
+violation_text(const BMessage& violation, int64 message, bool stream)
+{
+	std::string text("  ");
+	if(stream)
+		text += "#" + std::to_string(message) + " ";
+
+	const char* name;
+	for(int32 i = 0; violation.FindString("path", i, &name) == B_OK; i++) {
+		text += name;
+		text += "[" + std::to_string(violation.GetInt32("member", i, 0))
+			+ "]/";
+	}
+	text += violation.GetString("name", "");
+	text += ": ";
+
+	std::string found = violation.GetString("found", "");
+	std::string expected = violation.GetString("expected", "");
+	std::string item = std::to_string(violation.GetInt32("item", 0));
+	switch(violation.GetInt32("kind", -1)) {
+		case SCHEMA_UNKNOWN_FIELD:
+			text += "not in the schema";
+			break;
+		case SCHEMA_MISSING_FIELD:
+			text += "missing, expected "
+				+ type_list(violation, "expected_type");
+			break;
+		case SCHEMA_TYPE_MISMATCH:
+			text += type_list(violation, "found_type") + " instead of "
+				+ type_list(violation, "expected_type");
+			break;
+		case SCHEMA_COUNT_OUT_OF_RANGE:
+			text += found + " items, expected " + expected;
+			break;
+		case SCHEMA_VALUE_OUT_OF_RANGE:
+			text += "item " + item + " is " + found + ", expected " + expected;
+			break;
+		case SCHEMA_SIZE_OUT_OF_RANGE:
+			text += "item " + item + " is " + found + " bytes long, expected "
+				+ expected;
+			break;
+		case SCHEMA_WHAT_MISMATCH:
+			text += "the message is " + found + ", expected " + expected;
+			break;
+	}
+	return text + "\n";
+}
+
+// Runs every message of a file through the validator, whatever its
+// format; what follows the last one is not looked at
+static void
+validate_file(const char* path, const SchemaValidator& validator,
+	int32 shown, file_result& result)
+{
+	int fd = open(path, O_RDONLY);
+	struct stat st;
+	if(fd < 0 || fstat(fd, &st) != 0) {
+		result.status = errno;
+		if(fd >= 0)
+			close(fd);
+		return;
+	}
+
+	result.size = st.st_size;
+	void* mapped = st.st_size > 0
+		? mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+	close(fd);
+	if(mapped == MAP_FAILED) {
+		result.status = st.st_size > 0 ? errno : B_NOT_A_MESSAGE;
+		return;
+	}
+
+	const uint8* data = static_cast<const uint8*>(mapped);
+	size_t size = st.st_size;
+	status_t status = B_OK;
+
+	std::vector<uint8> inflated;
+	if(is_block_container(data, size)) {
+		BMemoryIO io(data, size);
+		BlockContainerIO container;
+		off_t rawSize = 0;
+		status = container.SetTo(&io);
+		if(status == B_OK)
+			status = container.GetSize(&rawSize);
+		if(status == B_OK) {
+			inflated.resize(rawSize);
+			if(container.ReadAt(0, inflated.data(), rawSize) != rawSize)
+				status = B_BAD_DATA;
+		}
+		data = inflated.data();
+		size = inflated.size();
+	}
+
+	std::vector<uint8> native;
+	std::string report;
+	size_t offset = 0;
+	while(status == B_OK && offset < size) {
+		ssize_t length = flattened_message_size(data + offset, size - offset);
+		if(length <= 0 || (size_t)length > size - offset) {
+			if(result.messages == 0)
+				status = length < 0 ? (status_t)length : B_NOT_A_MESSAGE;
+			break;
+		}
+
+		const uint8* message = data + offset;
+		size_t messageSize = length;
+		if(is_legacy_message(message, messageSize)) {
+			status = upgrade_legacy_message(message, messageSize, native);
+			message = native.data();
+			messageSize = native.size();
+		} else if(is_swapped_flat_message(message, messageSize)) {
+			native.assign(message, message + messageSize);
+			status = swap_flat_message(native.data(), messageSize);
+			message = native.data();
+		}
+
+		// Only the violations that are printed are laid out
+		BMessage violations;
+		bool details = shown > 0 && result.violations < shown;
+		ssize_t count = status == B_OK ? validator.Validate(message,
+			messageSize, details ? &violations : NULL) : status;
+		if(count < 0) {
+			status = count;
+			break;
+		}
+
+		// Messages are numbered when there is more than one
+		bool stream = result.messages > 0 || (offset + length < size
+			&& flattened_message_size(data + offset + length,
+				size - offset - length) > 0);
+		BMessage violation;
+		for(int32 i = 0; result.violations + i < shown
+			&& violations.FindMessage("deviation", i, &violation) == B_OK;
+			i++)
+			report += violation_text(violation, result.messages, stream);
+
+		result.violations += count;
+		result.messages++;
+		offset += length;
+	}
+	munmap(mapped, st.st_size);
+
+	result.status = status;
+	if(status != B_OK)
+		return;
+
+	if(result.violations > 0) {
+		result.report = std::string(path) + ": "
+			+ std::to_string(result.violations) + " violations\n" + report;
+		if(result.violations > shown && shown > 0)
+			result.report += "  ...\n";
+	}
+}
+
+static status_t
+validation_worker(void* data)
+{
+	validation* job = static_cast<validation*>(data);
+	int32 index;
+	while((index = atomic_add(&job->next, 1)) < job->count) {
+		validate_file(job->paths[index], *job->validator, job->shown,
+			job->results[index]);
+	}
+	return B_OK;
+}
+
+static void
+print_usage()
+{
+	fprintf(stderr, "usage: kottan-validate [-q] [-j threads] [-m max] "
+		"schema file...\n");
+}
+
+int
+main(int argc, char** argv)
+{
+	bool quiet = false;
+	int32 threads = 0;
+	int32 shown = kDefaultShown;
+
+	int option;
+	while((option = getopt(argc, argv, "qj:m:h")) != -1) {
+		switch(option) {
+			case 'q':
+				quiet = true;
+				break;
+			case 'j':
+				threads = atoi(optarg);
+				break;
+			case 'm':
+				shown = std::max(0, atoi(optarg));
+				break;
+			default:
+				print_usage();
+				return 2;
+		}
+	}
+
+	if(argc - optind < 2) {
+		print_usage();
+		return 2;
+	}
+
+	SchemaValidator validator;
+	BString error;
+	if(validator.Load(argv[optind], &error) != B_OK) {
+		fprintf(stderr, "kottan-validate: %s: %s\n", argv[optind],
+			error.String());
+		return 2;
+	}
+
+	validation job;
+	job.validator = &validator;
+	job.paths = argv + optind + 1;
+	job.count = argc - optind - 1;
+	job.next = 0;
+	job.shown = quiet ? 0 : shown;
+	file_result empty = { B_OK, 0, 0, 0, std::string() };
+	job.results.assign(job.count, empty);
+
+	system_info info;
+	if(threads <= 0)
+		threads = get_system_info(&info) == B_OK ? info.cpu_count : 1;
+	threads = std::max(1, std::min(std::min(threads, kMaxThreads),
+		job.count));
+
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	// The validator is only read, all threads share it
+	std::vector<thread_id> workers;
+	for(int32 i = 0; i < threads; i++) {
+		thread_id thread = spawn_thread(validation_worker, "validator",
+			B_NORMAL_PRIORITY, &job);
+		if(thread < 0)
+			continue;
+		resume_thread(thread);
+		workers.push_back(thread);
+	}
+	if(workers.empty())
+		validation_worker(&job);
+	for(size_t i = 0; i < workers.size(); i++) {
+		status_t result;
+		wait_for_thread(workers[i], &result);
+	}
+
+	struct timespec end;
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double seconds = (end.tv_sec - start.tv_sec)
+		+ (end.tv_nsec - start.tv_nsec) / 1e9;
+
+	uint64 valid = 0;
+	uint64 invalid = 0;
+	uint64 unreadable = 0;
+	uint64 messages = 0;
+	uint64 bytes = 0;
+	for(int32 i = 0; i < job.count; i++) {
+		const file_result& result = job.results[i];
+		bytes += result.size;
+		if(result.status != B_OK) {
+			fflush(stdout);
+			fprintf(stderr, "kottan-validate: %s: %s\n", job.paths[i],
+				status_text(result.status));
+			unreadable++;
+			continue;
+		}
+
+		messages += result.messages;
+		if(result.violations == 0) {
+			valid++;
+			continue;
+		}
+		invalid++;
+		if(!quiet)
+			fputs(result.report.c_str(), stdout);
+	}
+
+	fflush(stdout);
+	fprintf(stderr, "%d files: %llu valid, %llu invalid, %llu unreadable; "
+		"%llu messages, %.1f MB, %.3f s (%.0f files/s) on %d threads\n",
+		(int)job.count, (unsigned long long)valid,
+		(unsigned long long)invalid, (unsigned long long)unreadable,
+		(unsigned long long)messages, bytes / 1e6, seconds,
+		seconds > 0 ? job.count / seconds : 0.0,
+		std::max(1, (int)workers.size()));
+
+	return invalid == 0 && unreadable == 0 ? 0 : 1;
+}
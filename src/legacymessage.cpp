@@ -0,0 +1,597 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#include <ByteOrder.h>
+#include <TypeConstants.h>
+#include <climits>
+#include <cstring>
+#include "byteswap.h"
+#include "flatmessage.h"
+#include "legacymessage.h"
+
+// R5 message and field flags, as in Haiku's MessageAdapter.cpp
+enum {
+	R5_MESSAGE_INCLUDE_TARGET	= 0x02,
+	R5_MESSAGE_INCLUDE_REPLY	= 0x04
+};
+
+enum {
+	R5_FIELD_VALID				= 0x01,
+	R5_FIELD_MINI_DATA			= 0x02,
+	R5_FIELD_FIXED_SIZE			= 0x04,
+	R5_FIELD_SINGLE_ITEM		= 0x08
+};
+
+// Dano section codes; the header section reuses the format code
+static const uint32 kDanoSingleItem = 'SGDa';
+static const uint32 kDanoFixedSizeArray = 'FADa';
+static const uint32 kDanoVariableSizeArray = 'VADa';
+static const uint32 kDanoEndOfData = 'DDEn';
+
+// magic, checksum, flattened size, what, flags
+static const size_t kR5HeaderSize = 17;
+// magic, size, then the header section with what and padding
+static const size_t kDanoHeaderSize = 24;
+
+static inline uint32
+pad_to_8(uint32 size)
+{
+	return (size + 7) & ~(uint32)7;
+}
+
+static inline uint32
+read_uint32(const uint8* data, bool swap)
+{
+	uint32 value;
+	memcpy(&value, data, sizeof(value));
+	return swap ? (uint32)B_SWAP_INT32(value) : value;
+}
+
+/*	Bounds checked reading from the buffer, every multi-byte value comes
+	out in host order.
+*/
+class LegacyCursor
+{
+public:
+	LegacyCursor(const uint8* data, size_t size, bool swap)
+	: fData(data),
+	  fSize(size),
+	  fPosition(0),
+	  fSwap(swap)
+	{
+	}
+
+	bool Read(uint8& value)
+	{
+		if(fPosition >= fSize)
+			return false;
+		value = fData[fPosition++];
+		return true;
+	}
+
+	bool Read(uint32& value)
+	{
+		if(fSize - fPosition < sizeof(uint32))
+			return false;
+		value = read_uint32(fData + fPosition, fSwap);
+		fPosition += sizeof(uint32);
+		return true;
+	}
+
+	bool Read(int32& value)
+	{
+		uint32 bits;
+		if(!Read(bits))
+			return false;
+		value = (int32)bits;
+		return true;
+	}
+
+	// R5 fields with little data keep their count and size in a byte
+	bool Read(int32& value, bool small)
+	{
+		uint8 byte;
+		if(!small)
+			return Read(value);
+		if(!Read(byte))
+			return false;
+		value = byte;
+		return true;
+	}
+
+	const uint8* Take(size_t length)
+	{
+		if(length > fSize - fPosition)
+			return NULL;
+		const uint8* start = fData + fPosition;
+		fPosition += length;
+		return start;
+	}
+
+	bool Seek(size_t position)
+	{
+		if(position > fSize)
+			return false;
+		fPosition = position;
+		return true;
+	}
+
+	size_t Position() const { return fPosition; }
+	size_t Remaining() const { return fSize - fPosition; }
+private:
+	const uint8*	fData;
+	size_t			fSize;
+	size_t			fPosition;
+	bool			fSwap;
+};
+
+// Dano single items don't say whether they were added as fixed size
+static bool
+is_fixed_size_type(type_code type)
+{
+	switch(type) {
+		case B_STRING_TYPE:
+		case B_MIME_TYPE:
+		case B_MESSAGE_TYPE:
+		case B_REF_TYPE:
+		case B_RAW_TYPE:
+			return false;
+		default:
+			return true;
+	}
+}
+
+/*	Decodes one R5 or Dano message into a FlatMessageWriter. Nested legacy
+	messages get an upgrader of their own, one level deeper.
+*/
+class LegacyUpgrader
+{
+public:
+	LegacyUpgrader(int32 depth)
+	: fDepth(depth)
+	{
+	}
+
+	status_t Upgrade(const uint8* data, size_t size,
+		std::vector<uint8>& output, size_t* used);
+private:
+	struct item_span {
+		uint32		offset;
+		uint32		size;
+	};
+
+	status_t _UpgradeR5(const uint8* data, size_t size,
+		std::vector<uint8>& output, size_t* used);
+	status_t _UpgradeDano(const uint8* data, size_t size,
+		std::vector<uint8>& output, size_t* used);
+	status_t _AddDanoSection(FlatMessageWriter& writer, uint32 code,
+		const uint8* section, uint32 size);
+	bool _SplitR5Items(const uint8* data, uint32 size, int32 count,
+		int32 rule);
+	bool _SplitDanoItems(const uint8* data, uint32 size, uint32 count);
+	status_t _AddItem(FlatMessageWriter& writer, const char* name,
+		type_code type, const uint8* data, uint32 size, bool fixedSize);
+private:
+	int32			fDepth;
+	bool			fSwap;
+	std::vector<item_span> fSpans;
+	std::vector<uint8> fSwapped;
+};
+
+status_t
+LegacyUpgrader::Upgrade(const uint8* data, size_t size,
+	std::vector<uint8>& output, size_t* used)
+{
+	if(size < sizeof(uint32))
+		return B_NOT_A_MESSAGE;
+
+	uint32 magic = read_uint32(data, false);
+	fSwap = magic == (uint32)B_SWAP_INT32(kR5MessageFormat)
+		|| magic == (uint32)B_SWAP_INT32(kDanoMessageFormat);
+	if(fSwap)
+		magic = B_SWAP_INT32(magic);
+
+	switch(magic) {
+		case kR5MessageFormat:
+			return _UpgradeR5(data, size, output, used);
+		case kDanoMessageFormat:
+			return _UpgradeDano(data, size, output, used);
+		default:
+			return B_NOT_A_MESSAGE;
+	}
+}
+
+status_t
+LegacyUpgrader::_UpgradeR5(const uint8* data, size_t size,
+	std::vector<uint8>& output, size_t* used)
+{
+	LegacyCursor header(data, size, fSwap);
+	uint32 magic;
+	uint32 checksum;
+	int32 flattenedSize;
+	int32 what;
+	uint8 flags;
+	if(!header.Read(magic) || !header.Read(checksum)
+		|| !header.Read(flattenedSize) || !header.Read(what)
+		|| !header.Read(flags))
+		return B_BAD_DATA;
+	if(flattenedSize < (int32)kR5HeaderSize || (size_t)flattenedSize > size)
+		return B_BAD_DATA;
+
+	// The checksum only covers the header, the fields are checked below
+	LegacyCursor cursor(data, flattenedSize, fSwap);
+	cursor.Seek(kR5HeaderSize);
+	if((flags & R5_MESSAGE_INCLUDE_TARGET) != 0 && !cursor.Take(4))
+		return B_BAD_DATA;
+	if((flags & R5_MESSAGE_INCLUDE_REPLY) != 0 && !cursor.Take(16))
+		return B_BAD_DATA;
+
+	FlatMessageWriter writer(what);
+	char name[256];
+	while(true) {
+		uint8 fieldFlags;
+		if(!cursor.Read(fieldFlags))
+			return B_BAD_DATA;
+		if((fieldFlags & R5_FIELD_VALID) == 0)
+			break;
+
+		bool mini = (fieldFlags & R5_FIELD_MINI_DATA) != 0;
+		type_code type;
+		if(!cursor.Read(type))
+			return B_BAD_DATA;
+
+		int32 count = 1;
+		int32 dataSize;
+		if((fieldFlags & R5_FIELD_SINGLE_ITEM) == 0
+			&& !cursor.Read(count, mini))
+			return B_BAD_DATA;
+		if(!cursor.Read(dataSize, mini))
+			return B_BAD_DATA;
+
+		uint8 nameLength;
+		if(!cursor.Read(nameLength))
+			return B_BAD_DATA;
+		const uint8* nameData = cursor.Take(nameLength);
+		const uint8* fieldData = dataSize >= 0 ? cursor.Take(dataSize) : NULL;
+		if(!nameData || !fieldData || count <= 0)
+			return B_BAD_DATA;
+		memcpy(name, nameData, nameLength);
+		name[nameLength] = '\0';
+
+		status_t status = B_OK;
+		if((fieldFlags & R5_FIELD_FIXED_SIZE) != 0) {
+			// Without data any count divides it, into items of no size
+			if(dataSize == 0 || dataSize % count != 0)
+				return B_BAD_DATA;
+			uint32 itemSize = dataSize / count;
+			for(int32 i = 0; i < count && status == B_OK; i++) {
+				status = _AddItem(writer, name, type,
+					fieldData + i * itemSize, itemSize, true);
+			}
+		} else {
+			int32 rule = 0;
+			while(rule < 3 && !_SplitR5Items(fieldData, dataSize, count, rule))
+				rule++;
+			if(rule == 3) {
+				// A lone item without its size in front
+				if(count != 1)
+					return B_BAD_DATA;
+				fSpans.clear();
+				item_span whole = { 0, (uint32)dataSize };
+				fSpans.push_back(whole);
+			}
+			for(size_t i = 0; i < fSpans.size() && status == B_OK; i++) {
+				status = _AddItem(writer, name, type,
+					fieldData + fSpans[i].offset, fSpans[i].size, false);
+			}
+		}
+		if(status != B_OK)
+			return status;
+	}
+
+	writer.Flatten(output);
+	if(used)
+		*used = flattenedSize;
+	return B_OK;
+}
+
+status_t
+LegacyUpgrader::_UpgradeDano(const uint8* data, size_t size,
+	std::vector<uint8>& output, size_t* used)
+{
+	LegacyCursor header(data, size, fSwap);
+	uint32 magic;
+	int32 sectionsSize;
+	uint32 code;
+	int32 headerSize;
+	int32 what;
+	if(!header.Read(magic) || !header.Read(sectionsSize)
+		|| !header.Read(code) || !header.Read(headerSize)
+		|| !header.Read(what))
+		return B_BAD_DATA;
+
+	// The size counts the sections only, the header section included
+	size_t flattenedSize = 8 + (size_t)sectionsSize;
+	if(sectionsSize < (int32)(kDanoHeaderSize - 8) || flattenedSize > size
+		|| code != kDanoMessageFormat || headerSize < 16
+		|| headerSize > sectionsSize)
+		return B_BAD_DATA;
+
+	LegacyCursor cursor(data, flattenedSize, fSwap);
+	cursor.Seek(8 + headerSize);
+
+	FlatMessageWriter writer(what);
+	while(cursor.Remaining() > 0) {
+		size_t start = cursor.Position();
+		int32 sectionSize;
+		if(!cursor.Read(code) || !cursor.Read(sectionSize))
+			return B_BAD_DATA;
+		if(sectionSize < 8 || (size_t)sectionSize > flattenedSize - start)
+			return B_BAD_DATA;
+		if(code == kDanoEndOfData)
+			break;
+
+		// Offset tables, sorted indices and target information are only
+		// there for the Dano BMessage itself
+		if(code == kDanoSingleItem || code == kDanoFixedSizeArray
+			|| code == kDanoVariableSizeArray) {
+			status_t status = _AddDanoSection(writer, code, data + start,
+				sectionSize);
+			if(status != B_OK)
+				return status;
+		}
+		cursor.Seek(start + sectionSize);
+	}
+
+	writer.Flatten(output);
+	if(used)
+		*used = flattenedSize;
+	return B_OK;
+}
+
+/*	All three kinds of data section start with the type, a count or size,
+	the name length and the terminated name; the data follows at the next
+	multiple of eight from the start of the section. Variable size items
+	are padded to eight bytes each and followed by a table of their end
+	offsets.
+*/
+status_t
+LegacyUpgrader::_AddDanoSection(FlatMessageWriter& writer, uint32 code,
+	const uint8* section, uint32 size)
+{
+	LegacyCursor cursor(section, size, fSwap);
+	cursor.Seek(8);
+
+	type_code type;
+	uint32 value;
+	uint8 nameLength;
+	if(!cursor.Read(type) || !cursor.Read(value) || !cursor.Read(nameLength))
+		return B_BAD_DATA;
+	const char* name = (const char*)cursor.Take(nameLength + 1);
+	if(!name || name[nameLength] != '\0')
+		return B_BAD_DATA;
+
+	uint32 dataOffset = pad_to_8(cursor.Position());
+	if(dataOffset > size)
+		return B_BAD_DATA;
+	const uint8* data = section + dataOffset;
+	uint32 dataSize = size - dataOffset;
+
+	switch(code) {
+		case kDanoSingleItem:
+			if(value > dataSize)
+				return B_BAD_DATA;
+			return _AddItem(writer, name, type, data, value,
+				is_fixed_size_type(type));
+
+		case kDanoFixedSizeArray:
+		{
+			if(value == 0 || value > dataSize)
+				return B_BAD_DATA;
+			uint32 count = dataSize / value;
+			for(uint32 i = 0; i < count; i++) {
+				status_t status = _AddItem(writer, name, type,
+					data + i * value, value, true);
+				if(status != B_OK)
+					return status;
+			}
+			return B_OK;
+		}
+
+		case kDanoVariableSizeArray:
+		{
+			// The section itself may be padded after the table
+			uint32 padding = 0;
+			while(padding < 8 && padding <= dataSize
+				&& !_SplitDanoItems(data, dataSize - padding, value))
+				padding++;
+			if(padding == 8 || padding > dataSize)
+				return B_BAD_DATA;
+
+			for(size_t i = 0; i < fSpans.size(); i++) {
+				status_t status = _AddItem(writer, name, type,
+					data + fSpans[i].offset, fSpans[i].size, false);
+				if(status != B_OK)
+					return status;
+			}
+			return B_OK;
+		}
+	}
+
+	return B_BAD_DATA;
+}
+
+/*	R5 puts the size in front of every variable size item and pads the
+	items to eight bytes, but writers disagree on whether the size counts
+	for the padding. Rule 0 pads size and item together, rule 1 the item
+	alone, rule 2 not at all; the last item may go without padding. Only
+	a rule under which the items fill the field exactly is taken.
+*/
+bool
+LegacyUpgrader::_SplitR5Items(const uint8* data, uint32 size, int32 count,
+	int32 rule)
+{
+	fSpans.clear();
+	uint32 position = 0;
+	for(int32 i = 0; i < count; i++) {
+		if(size - position < sizeof(uint32))
+			return false;
+		uint32 itemSize = read_uint32(data + position, fSwap);
+		position += sizeof(uint32);
+		if(itemSize > size - position)
+			return false;
+
+		item_span span = { position, itemSize };
+		fSpans.push_back(span);
+		position += itemSize;
+
+		uint32 next = position;
+		if(rule == 0)
+			next = pad_to_8(position);
+		else if(rule == 1)
+			next = span.offset + pad_to_8(itemSize);
+
+		if(i == count - 1)
+			return position == size || next == size;
+		if(next > size)
+			return false;
+		position = next;
+	}
+	return false;
+}
+
+// The items end where the table of their end offsets begins
+bool
+LegacyUpgrader::_SplitDanoItems(const uint8* data, uint32 size, uint32 count)
+{
+	fSpans.clear();
+	if(count == 0 || count > size / sizeof(uint32))
+		return false;
+
+	uint32 itemsSize = size - count * sizeof(uint32);
+	const uint8* ends = data + itemsSize;
+	uint32 start = 0;
+	for(uint32 i = 0; i < count; i++) {
+		uint32 end = read_uint32(ends + i * sizeof(uint32), fSwap);
+		if(end < start || end > itemsSize)
+			return false;
+
+		item_span span = { start, end - start };
+		fSpans.push_back(span);
+		start = pad_to_8(end);
+	}
+	return start == itemsSize || fSpans.back().offset + fSpans.back().size
+		== itemsSize;
+}
+
+status_t
+LegacyUpgrader::_AddItem(FlatMessageWriter& writer, const char* name,
+	type_code type, const uint8* data, uint32 size, bool fixedSize)
+{
+	if(type == B_MESSAGE_TYPE && is_legacy_message(data, size)) {
+		if(fDepth >= kMaxLegacyNesting)
+			return B_BAD_DATA;
+
+		std::vector<uint8> nested;
+		LegacyUpgrader upgrader(fDepth + 1);
+		status_t status = upgrader.Upgrade(data, size, nested, NULL);
+		if(status != B_OK)
+			return status;
+		return writer.AddData(name, type, nested.data(), nested.size(),
+			fixedSize);
+	}
+
+	if(!fSwap)
+		return writer.AddData(name, type, data, size, fixedSize);
+
+	// Legacy messages carry no hint about the layout of their types, only
+	// those swap_item() knows are converted
+	fSwapped.assign(data, data + size);
+	swap_item(type, fSwapped.data(), size);
+	return writer.AddData(name, type, fSwapped.data(), size, fixedSize);
+}
+
+// #pragma mark -
+
+bool
+is_legacy_message(const void* data, size_t size)
+{
+	if(size < sizeof(uint32))
+		return false;
+
+	uint32 magic = read_uint32(static_cast<const uint8*>(data), false);
+	return magic == kR5MessageFormat || magic == kDanoMessageFormat
+		|| magic == (uint32)B_SWAP_INT32(kR5MessageFormat)
+		|| magic == (uint32)B_SWAP_INT32(kDanoMessageFormat);
+}
+
+ssize_t
+flattened_message_size(const void* data, size_t size, uint32* what)
+{
+	const uint8* bytes = static_cast<const uint8*>(data);
+	if(size < sizeof(uint32))
+		return 0;
+
+	uint32 magic = read_uint32(bytes, false);
+	if(magic == kFlatMessageFormat || magic == kFlatMessageFormatSwapped) {
+		if(size < sizeof(flat_message_header))
+			return 0;
+		flat_message_header header;
+		memcpy(&header, bytes, sizeof(header));
+		bool swap = magic == kFlatMessageFormatSwapped;
+		uint64 total = sizeof(flat_message_header)
+			+ (uint64)read_uint32((const uint8*)&header.field_count, swap)
+				* sizeof(flat_field_header)
+			+ read_uint32((const uint8*)&header.data_size, swap);
+		if(total > (uint64)SSIZE_MAX)
+			return B_BAD_DATA;
+		if(what)
+			*what = read_uint32((const uint8*)&header.what, swap);
+		return total;
+	}
+
+	bool swap = magic == (uint32)B_SWAP_INT32(kR5MessageFormat)
+		|| magic == (uint32)B_SWAP_INT32(kDanoMessageFormat);
+	if(swap)
+		magic = B_SWAP_INT32(magic);
+
+	// what follows the checksum and the size in R5 headers
+	if(magic == kR5MessageFormat) {
+		if(size < (what ? 4 : 3) * sizeof(uint32))
+			return 0;
+		int32 total = read_uint32(bytes + 8, swap);
+		if(total < (int32)kR5HeaderSize)
+			return B_BAD_DATA;
+		if(what)
+			*what = read_uint32(bytes + 12, swap);
+		return total;
+	}
+
+	// and the header section's code and size in Dano headers
+	if(magic == kDanoMessageFormat) {
+		if(size < (what ? 5 : 2) * sizeof(uint32))
+			return 0;
+		int32 sections = read_uint32(bytes + 4, swap);
+		if(sections < (int32)(kDanoHeaderSize - 8))
+			return B_BAD_DATA;
+		if(what)
+			*what = read_uint32(bytes + 16, swap);
+		return 8 + (ssize_t)sections;
+	}
+
+	return B_NOT_A_MESSAGE;
+}
+
+status_t
+upgrade_legacy_message(const void* data, size_t size,
+	std::vector<uint8>& output, size_t* used)
+{
+	if(!is_legacy_message(data, size))
+		return B_NOT_A_MESSAGE;
+
+	LegacyUpgrader upgrader(0);
+	return upgrader.Upgrade(static_cast<const uint8*>(data), size, output,
+		used);
+}
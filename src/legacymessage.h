@@ -0,0 +1,39 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef __LEGACY_MESSAGE_H__
+#define __LEGACY_MESSAGE_H__
+
+#include <SupportDefs.h>
+#include <vector>
+
+// Flattened message layouts of BeOS R5 and of Dano (BeOS 5.1)
+static const uint32 kR5MessageFormat = 'FOB1';
+static const uint32 kDanoMessageFormat = 'FOB2';
+
+static const int32 kMaxLegacyNesting = 64;
+
+// True for R5 and Dano messages written on either kind of host
+bool		is_legacy_message(const void* data, size_t size);
+
+/*	Length of the flattened message at the start of the buffer, native or
+	legacy and in either byte order, taken from its header alone. Returns
+	0 while the buffer is too short to tell, B_NOT_A_MESSAGE or B_BAD_DATA
+	when it holds no message. When what is given, the header must include
+	the message code as well.
+*/
+ssize_t		flattened_message_size(const void* data, size_t size,
+				uint32* what = NULL);
+
+/*	Decodes an R5 or Dano message and writes it out again in the native
+	layout, ready for BMessage::Unflatten() or FlatMessageReader. Data of
+	messages from a host of the other byte order is swapped for the types
+	whose layout is known, nested legacy messages are upgraded as well.
+	The number of bytes the message took up is stored in used.
+*/
+status_t	upgrade_legacy_message(const void* data, size_t size,
+				std::vector<uint8>& output, size_t* used = NULL);
+
+#endif /* __LEGACY_MESSAGE_H__ */
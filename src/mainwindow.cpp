@@ -5,14 +5,17 @@
  */
 
 #include "app.h"
+#include "byteswap.h"
 #include "gettype.h"
 #include "importerwindow.h"
 #include "kottandefs.h"
 #include "mainwindow.h"
+#include "searchindex.h"
 
 #include <Alert.h>
 #include <FindDirectory.h>
 #include <LayoutBuilder.h>
+#include <MenuItem.h>
 #include <Catalog.h>
 #include <Application.h>
 #include <private/interface/ColumnListView.h>
@@ -20,6 +23,7 @@
 #include <Entry.h>
 #include <Path.h>
 #include <stdio.h>
+#include <string.h>
 
 
 #undef B_TRANSLATION_CONTEXT
@@ -34,21 +38,56 @@ MainWindow::MainWindow(BRect geometry)
 	fTopMenuBar = new BMenuBar("topmenubar");
 	fMessageInfoView = new MessageView();
 	fDataView = new DataView();
+	fRecordPanel = new RecordPanel("recordpanel");
+	fSchemaPanel = new SchemaPanel("schemapanel");
+	fSchemaFolderPanel = NULL;
+	fValidatorPanel = NULL;
+	fShownRecord = -1;
+	fFindText = new BTextControl("findtext", B_TRANSLATE("Find:"), "",
+		new BMessage(MW_FIND_NEXT));
+	fFindText->SetModificationMessage(new BMessage(MW_FIND));
+	fFindStatus = new BStringView("findstatus", "");
+	fSelectFirstMatch = false;
+
+	BMessage* byteOrderAsOpened = new BMessage(MW_SAVE_BYTE_ORDER);
+	byteOrderAsOpened->AddInt32("order", SAVE_BYTE_ORDER_AS_OPENED);
+	BMessage* byteOrderLittle = new BMessage(MW_SAVE_BYTE_ORDER);
+	byteOrderLittle->AddInt32("order", SAVE_BYTE_ORDER_LITTLE);
+	BMessage* byteOrderBig = new BMessage(MW_SAVE_BYTE_ORDER);
+	byteOrderBig->AddInt32("order", SAVE_BYTE_ORDER_BIG);
 
 	//define menu layout
 	BLayoutBuilder::Menu<>(fTopMenuBar)
 		.AddMenu(B_TRANSLATE("File"))
 			.AddItem(B_TRANSLATE("Open" B_UTF8_ELLIPSIS), MW_OPEN_MESSAGEFILE, 'O')
 			.AddItem(B_TRANSLATE("Reload"), MW_RELOAD_FROM_FILE, 'R')
+			.AddItem(B_TRANSLATE("Capture messages" B_UTF8_ELLIPSIS), MW_CAPTURE_WINDOW)
+			.AddItem(B_TRANSLATE("Replay stream" B_UTF8_ELLIPSIS), MW_REPLAY_WINDOW)
 			.AddSeparator()
 			.AddItem(B_TRANSLATE("Save"), MW_SAVE_MESSAGEFILE, 'S')
 			.AddItem(B_TRANSLATE("Save as" B_UTF8_ELLIPSIS), MW_SAVE_MESSAGEFILE_AS, 'S', B_COMMAND_KEY | B_SHIFT_KEY)
+			.AddItem(B_TRANSLATE("Save changes as patch" B_UTF8_ELLIPSIS), MW_SAVE_PATCH)
+			.AddItem(B_TRANSLATE("Apply patch" B_UTF8_ELLIPSIS), MW_APPLY_PATCH)
+			.AddItem(B_TRANSLATE("Add checksum when saving"), MW_SAVE_CHECKSUM)
+			.AddItem(B_TRANSLATE("Compress when saving"), MW_SAVE_COMPRESSED)
+			.AddMenu(B_TRANSLATE("Byte order when saving"))
+				.GetMenu(fByteOrderMenu)
+				.AddItem(B_TRANSLATE("Same as the opened file"), byteOrderAsOpened)
+				.AddItem(B_TRANSLATE("Little endian (x86)"), byteOrderLittle)
+				.AddItem(B_TRANSLATE("Big endian (PowerPC)"), byteOrderBig)
+			.End()
 			.AddSeparator()
 			.AddItem(B_TRANSLATE("Close"), MW_CLOSE_MESSAGEFILE, 'W')
 			.AddSeparator()
 			.AddItem(B_TRANSLATE("Quit"), B_QUIT_REQUESTED, 'Q')
 		.End()
 		.AddMenu(B_TRANSLATE("Edit"))
+			.AddItem(B_TRANSLATE("Undo"), MW_UNDO, 'Z')
+			.AddItem(B_TRANSLATE("Redo"), MW_REDO, 'Z', B_COMMAND_KEY | B_SHIFT_KEY)
+			.AddSeparator()
+			.AddItem(B_TRANSLATE("Find" B_UTF8_ELLIPSIS), MW_SHOW_FIND, 'F')
+			.AddItem(B_TRANSLATE("Find next"), MW_FIND_NEXT, 'G')
+			.AddSeparator()
 			.AddItem(B_TRANSLATE("Add affine transformation" B_UTF8_ELLIPSIS), MW_ADD_AFFINE_TX)
             .AddItem(B_TRANSLATE("Add alignment" B_UTF8_ELLIPSIS), MW_ADD_ALIGNMENT)
             .AddItem(B_TRANSLATE("Add boolean" B_UTF8_ELLIPSIS), MW_ADD_BOOL)
@@ -90,32 +129,62 @@ MainWindow::MainWindow(BRect geometry)
             .AddItem(B_TRANSLATE("Set type (\'what\' field)" B_UTF8_ELLIPSIS), MW_MESSAGE_OPEN_SET_WHAT_DIALOG, 'T')
             .AddItem(B_TRANSLATE("Make empty" B_UTF8_ELLIPSIS), MW_MESSAGE_MAKE_EMPTY)
 			.AddItem(B_TRANSLATE("Information" B_UTF8_ELLIPSIS), MW_MESSAGE_INFORMATION, 'I')
+			.AddItem(B_TRANSLATE("Size profile" B_UTF8_ELLIPSIS), MW_MESSAGE_SIZE_PROFILE)
         .End()
 		.AddMenu(B_TRANSLATE("View"))
 			.AddItem(B_TRANSLATE("Data viewer panel"), MW_DATA_PANEL_VISIBLE)
+			.AddItem(B_TRANSLATE("Icon gallery" B_UTF8_ELLIPSIS), MW_ICON_GALLERY)
+			.AddSeparator()
+			.AddItem(B_TRANSLATE("Infer schema from folder" B_UTF8_ELLIPSIS), MW_INFER_SCHEMA)
+			.AddItem(B_TRANSLATE("Schema panel"), MW_SCHEMA_PANEL_VISIBLE)
+			.AddItem(B_TRANSLATE("Validate with schema file" B_UTF8_ELLIPSIS), MW_VALIDATION_SCHEMA)
+			.AddItem(B_TRANSLATE("Stop validating"), MW_CLEAR_VALIDATION_SCHEMA)
 		.End()
 		.AddMenu(B_TRANSLATE("Help"))
 			.AddItem(B_TRANSLATE("About" B_UTF8_ELLIPSIS), MW_MENU_ABOUT)
 		.End()
 	.End();
 
+	fByteOrderMenu->SetRadioMode(true);
+	SetSaveByteOrder(SAVE_BYTE_ORDER_AS_OPENED);
 	fTopMenuBar->FindItem(MW_SAVE_MESSAGEFILE)->SetEnabled(false);
 	fTopMenuBar->FindItem(MW_RELOAD_FROM_FILE)->SetEnabled(false);
+	fTopMenuBar->FindItem(MW_SAVE_PATCH)->SetEnabled(false);
 	fTopMenuBar->FindItem(MW_CLOSE_MESSAGEFILE)->SetEnabled(false);
 	fTopMenuBar->FindItem(MW_DATA_PANEL_VISIBLE)->SetMarked(!fDataView->IsHidden());
 	fTopMenuBar->FindItem(MW_MESSAGE_INFORMATION)->SetEnabled(false);
+	fTopMenuBar->FindItem(MW_MESSAGE_SIZE_PROFILE)->SetEnabled(false);
+	fTopMenuBar->FindItem(MW_UNDO)->SetEnabled(false);
+	fTopMenuBar->FindItem(MW_REDO)->SetEnabled(false);
+	fTopMenuBar->FindItem(MW_SCHEMA_PANEL_VISIBLE)->SetEnabled(false);
+	fTopMenuBar->FindItem(MW_CLEAR_VALIDATION_SCHEMA)->SetEnabled(false);
 
 	//define main layout
 	BLayoutBuilder::Group<>(this, B_VERTICAL,0)
 		.SetInsets(0)
 		.Add(fTopMenuBar)
-		.AddSplit(B_VERTICAL, B_USE_SMALL_SPACING)
+		.AddGroup(B_HORIZONTAL)
+			.GetView(&fFindBar)
+			.SetInsets(B_USE_SMALL_SPACING)
+			.Add(fFindText)
+			.Add(fFindStatus)
+		.End()
+		.AddSplit(B_HORIZONTAL, B_USE_SMALL_SPACING)
 			.SetInsets(-1,-1,-1,-1)
-			.Add(fMessageInfoView, 0.5f)
-			.Add(fDataView, 0.2f)
+			.Add(fRecordPanel, 0.3f)
+			.AddSplit(B_VERTICAL, B_USE_SMALL_SPACING)
+				.AddSplit(B_HORIZONTAL, B_USE_SMALL_SPACING, 0.5f)
+					.Add(fMessageInfoView, 0.65f)
+					.Add(fSchemaPanel, 0.35f)
+				.End()
+				.Add(fDataView, 0.2f)
+			.End()
 		.End()
 	.Layout();
 
+	fFindBar->Hide();
+	fRecordPanel->Hide();
+	fSchemaPanel->Hide();
 	fUnsaved = false;
 
 }
@@ -123,6 +192,8 @@ MainWindow::MainWindow(BRect geometry)
 
 MainWindow::~MainWindow()
 {
+	delete fSchemaFolderPanel;
+	delete fValidatorPanel;
 }
 
 
@@ -184,10 +255,25 @@ MainWindow::MessageReceived(BMessage *msg)
 			break;
 		}
 
-		// Save file menu was selected
+		// Save file menu was selected, a message that breaks the
+		// validation schema is only saved when confirmed
 		case MW_SAVE_MESSAGEFILE:
 		case MW_SAVE_MESSAGEFILE_AS:
 		{
+			std::vector<uint8> flat;
+			ssize_t violations = 0;
+			if(!fValidator.IsEmpty() && flatten_document(flat) == B_OK)
+				violations = fValidator.Validate(flat.data(), flat.size());
+			if(violations > 0) {
+				BString text;
+				text.SetToFormat(B_TRANSLATE("The message does not match the "
+					"validation schema in %" B_PRIdSSIZE " places. Do you want "
+					"to save it anyway?"), violations);
+				if(!continue_action(text, notsaved_alert_cancel,
+				B_TRANSLATE("Save anyway")))
+					break;
+			}
+
 			be_app->PostMessage(msg);
 			break;
 		}
@@ -227,7 +313,7 @@ MainWindow::MessageReceived(BMessage *msg)
 			bool open_success;
 			msg->FindBool("success", &open_success);
 
-			fMessageInfoView->Clear();
+			fMessageInfoView->ResetDocument();
 
 			if (open_success)
 			{
@@ -236,15 +322,27 @@ MainWindow::MessageReceived(BMessage *msg)
 
 				BMessage *data_message = static_cast<BMessage*>(data_msg_pointer);
 				fMessageInfoView->SetDataMessage(data_message);
-				fTopMenuBar->FindItem(MW_RELOAD_FROM_FILE)->SetEnabled(true);
+				check_schema();
+				fTopMenuBar->FindItem(MW_RELOAD_FROM_FILE)->SetEnabled(
+					msg->HasString("filePath"));
+				fTopMenuBar->FindItem(MW_SAVE_PATCH)->SetEnabled(
+					msg->HasString("filePath"));
 				fTopMenuBar->FindItem(MW_CLOSE_MESSAGEFILE)->SetEnabled(true);
 				fTopMenuBar->FindItem(MW_MESSAGE_INFORMATION)->SetEnabled(true);
+				fTopMenuBar->FindItem(MW_MESSAGE_SIZE_PROFILE)->SetEnabled(true);
 
 				// Set the window's title with the file path (if it was sent)
+				// or the name of a message that comes from no file
 				BString appTitle(kAppName), filePath;
-				if(msg->FindString("filePath", &filePath) == B_OK)
+				if(msg->FindString("filePath", &filePath) == B_OK
+					|| msg->FindString("name", &filePath) == B_OK)
 					appTitle << ": " << filePath;
 				SetTitle(appTitle);
+				fUnsaved = false;
+				fTopMenuBar->FindItem(MW_SAVE_MESSAGEFILE)->SetEnabled(false);
+
+				if(msg->GetInt32("integrity", B_OK) == B_BAD_DATA)
+					PostMessage(MW_INTEGRITY_WARNING);
 			}
 			else
 			{
@@ -259,6 +357,47 @@ MainWindow::MessageReceived(BMessage *msg)
 			break;
 		}
 
+		// The checksum stored in the file does not match what was read
+		case MW_INTEGRITY_WARNING:
+		{
+			BAlert* alert = new BAlert("Kottan",
+				B_TRANSLATE("The checksum stored in the file does not match its "
+				"contents. The file may be damaged, check the data before "
+				"saving over it."),
+				B_TRANSLATE("OK"), NULL, NULL, B_WIDTH_AS_USUAL, B_WARNING_ALERT);
+			alert->Go();
+			break;
+		}
+
+		case MW_SAVE_CHECKSUM:
+		{
+			BMenuItem* item = fTopMenuBar->FindItem(MW_SAVE_CHECKSUM);
+			SetSaveChecksum(!item->IsMarked());
+
+			BMessage option(MW_SAVE_CHECKSUM);
+			option.AddBool("enabled", item->IsMarked());
+			be_app->PostMessage(&option);
+			break;
+		}
+
+		case MW_SAVE_COMPRESSED:
+		{
+			BMenuItem* item = fTopMenuBar->FindItem(MW_SAVE_COMPRESSED);
+			SetSaveCompressed(!item->IsMarked());
+
+			BMessage option(MW_SAVE_COMPRESSED);
+			option.AddBool("enabled", item->IsMarked());
+			be_app->PostMessage(&option);
+			break;
+		}
+
+		// The menu marks the item itself
+		case MW_SAVE_BYTE_ORDER:
+		{
+			be_app->PostMessage(msg);
+			break;
+		}
+
 		// Reply after the file was closed
 		case MW_CLOSE_REPLY:
 		{
@@ -267,7 +406,12 @@ MainWindow::MessageReceived(BMessage *msg)
 				fUnsaved = false;
 
 				// Update controls
-				fMessageInfoView->Clear();
+				fMessageInfoView->ResetDocument();
+				fSchemaPanel->SetDeviations(NULL);
+				fRecordPanel->MakeEmpty();
+				if(!fRecordPanel->IsHidden())
+					fRecordPanel->Hide();
+				fShownRecord = -1;
 
 				// Reset title
 				SetTitle(kAppName);
@@ -275,9 +419,62 @@ MainWindow::MessageReceived(BMessage *msg)
 				// Reset menus
 				fTopMenuBar->FindItem(MW_SAVE_MESSAGEFILE)->SetEnabled(false);
 				fTopMenuBar->FindItem(MW_RELOAD_FROM_FILE)->SetEnabled(false);
+				fTopMenuBar->FindItem(MW_SAVE_PATCH)->SetEnabled(false);
 				fTopMenuBar->FindItem(MW_CLOSE_MESSAGEFILE)->SetEnabled(false);
 				fTopMenuBar->FindItem(MW_MESSAGE_INFORMATION)->SetEnabled(false);
+				fTopMenuBar->FindItem(MW_MESSAGE_SIZE_PROFILE)->SetEnabled(false);
+			}
+			break;
+		}
+
+		// Records of a message stream, all of them or the ones appended
+		case MW_RECORD_INDEX:
+		{
+			if(msg->GetBool("reset")) {
+				fRecordPanel->MakeEmpty();
+				fShownRecord = msg->GetInt32("selected", -1);
+			}
+
+			const void* records;
+			ssize_t size;
+			if(msg->FindData("records", B_RAW_TYPE, &records, &size) == B_OK) {
+				fRecordPanel->AddRecords(static_cast<const message_record*>(records),
+					size / sizeof(message_record));
 			}
+			fRecordPanel->SetScanStatus(msg->GetInt32("status", B_OK));
+
+			// Marked only, the record is already on display
+			if(msg->GetBool("reset") && fShownRecord >= 0)
+				fRecordPanel->ListView()->Select(fShownRecord);
+
+			bool stream = fRecordPanel->ListView()->CountRecords() > 0;
+			if(stream && fRecordPanel->IsHidden())
+				fRecordPanel->Show();
+			else if(!stream && !fRecordPanel->IsHidden())
+				fRecordPanel->Hide();
+			break;
+		}
+
+		// A record was picked in the list, the App reads it
+		case RV_RECORD_SELECTED:
+		{
+			int32 index = msg->GetInt32("index", -1);
+			if(index < 0 || index == fShownRecord)
+				break;
+
+			if(fUnsaved && !continue_action(
+				B_TRANSLATE("The message data was changed but not saved. "
+				"Do you really want to show another record?"),
+				notsaved_alert_cancel, B_TRANSLATE("Show record"))) {
+				if(fShownRecord >= 0)
+					fRecordPanel->ListView()->Select(fShownRecord);
+				break;
+			}
+
+			fShownRecord = index;
+			BMessage request(MW_SELECT_RECORD);
+			request.AddInt32("index", index);
+			be_app->PostMessage(&request);
 			break;
 		}
 
@@ -368,6 +565,8 @@ MainWindow::MessageReceived(BMessage *msg)
 				BString appTitle(kAppName);
 				appTitle << ": " << filePath.String();
 				SetTitle(appTitle);
+				fTopMenuBar->FindItem(MW_RELOAD_FROM_FILE)->SetEnabled(true);
+				fTopMenuBar->FindItem(MW_SAVE_PATCH)->SetEnabled(true);
 			}
 			switch_unsaved_state(false);
 			break;
@@ -410,11 +609,94 @@ MainWindow::MessageReceived(BMessage *msg)
 		case MW_UPDATE_MESSAGEVIEW:
 		{
 			fMessageInfoView->UpdateData();
+			check_schema();
 			fDataView->Clear();
 			switch_unsaved_state(false);
 			break;
 		}
 
+		case MW_UNDO:
+		case MW_REDO:
+			be_app->PostMessage(msg);
+			break;
+
+		// Keep the undo and redo items in step with the history
+		case MW_HISTORY_STATE:
+		{
+			fTopMenuBar->FindItem(MW_UNDO)->SetEnabled(msg->GetBool("can_undo"));
+			fTopMenuBar->FindItem(MW_REDO)->SetEnabled(msg->GetBool("can_redo"));
+			break;
+		}
+
+		case MW_SHOW_FIND:
+			ToggleFindBar();
+			break;
+
+		case MW_FIND:
+			fSelectFirstMatch = true;
+			send_find_query();
+			break;
+
+		case MW_FIND_NEXT:
+			fMessageInfoView->SelectNextMatch();
+			break;
+
+		// the index has caught up with the latest edit
+		case SI_INDEX_UPDATED:
+		{
+			if (!fFindBar->IsHidden() && fFindText->TextLength() > 0)
+			{
+				send_find_query();
+			}
+			break;
+		}
+
+		case MW_FIND_REPLY:
+		{
+			// answers to a query that was typed over since are dropped
+			if (fFindBar->IsHidden()
+				|| strcmp(msg->GetString("query", ""), fFindText->Text()) != 0)
+			{
+				break;
+			}
+
+			fMessageInfoView->SetMatches(msg);
+
+			BString status;
+			if (fFindText->TextLength() > 0)
+			{
+				int32 count = msg->GetInt32("count", 0);
+				status.SetToFormat(msg->GetBool("truncated")
+					? B_TRANSLATE("More than %d matches")
+					: B_TRANSLATE("%d matches"), count);
+				if (!msg->GetBool("ready", true))
+				{
+					status << " " << B_TRANSLATE("(indexing" B_UTF8_ELLIPSIS ")");
+				}
+			}
+			fFindStatus->SetText(status);
+
+			if (fSelectFirstMatch && fMessageInfoView->SelectNextMatch())
+			{
+				fSelectFirstMatch = false;
+			}
+			break;
+		}
+
+		// part of the message changed, patch the affected rows only
+		case MV_MESSAGE_CHANGED:
+		{
+			if(fMessageInfoView->ApplyChange(msg) != B_OK)
+				fMessageInfoView->UpdateData(); // Out of step, start over
+			check_schema();
+
+			if(fMessageInfoView->CurrentSelection() != NULL)
+				PostMessage(MV_SELECTION_CHANGED); // Reload the data panel
+			else
+				fDataView->Clear();
+			break;
+		}
+
 		// Add an entry of type...
 		case MW_ADD_AFFINE_TX:
 		case MW_ADD_ALIGNMENT:
@@ -471,10 +753,48 @@ MainWindow::MessageReceived(BMessage *msg)
 		// Call to open message information dialog box
 		case MW_MESSAGE_INFORMATION:
 		{
+			BMessage request(msg->what);
+			BMessage report;
+			fMessageInfoView->GetAllocationReport(&report);
+			request.AddMessage("allocation_report", &report);
+			request.AddInt64("flattened_size", fMessageInfoView->FlattenedSize());
+			be_app->PostMessage(&request);
+			break;
+		}
+
+		// Profile the file on disk in the background
+		case MW_MESSAGE_SIZE_PROFILE:
+			be_app->PostMessage(msg);
+			break;
+
+		case MW_ICON_GALLERY:
+		case MW_CAPTURE_WINDOW:
+		case MW_REPLAY_WINDOW:
+		case MW_SAVE_PATCH:
+		case MW_APPLY_PATCH:
+			be_app->PostMessage(msg);
+			break;
+
+		// Sent by the capture window, it replaces the document
+		case MW_OPEN_CAPTURED_MESSAGE:
+		{
+			Activate();
+			if(fUnsaved && !continue_action(
+				B_TRANSLATE("The message data was changed but not saved. "
+				"Do you really want to open the captured message?"),
+				notsaved_alert_cancel, B_TRANSLATE("Open"))) {
+				break;
+			}
 			be_app->PostMessage(msg);
 			break;
 		}
 
+		// A thumbnail in the icon gallery was clicked
+		case MW_SELECT_FIELD:
+			if (fMessageInfoView->SelectField(msg))
+				Activate();
+			break;
+
 		// Call to summon a EditWindow from the MainWindow-owned DataView
 		case DW_ROW_CLICKED:
 		{
@@ -487,6 +807,15 @@ MainWindow::MessageReceived(BMessage *msg)
 			break;
 		}
 
+		// An item of the selected field was edited
+		case DW_UPDATE:
+		{
+			fMessageInfoView->InvalidateSelection();
+			if(fMessageInfoView->CurrentSelection() != NULL)
+				PostMessage(MV_SELECTION_CHANGED); // Reload the data panel
+			break;
+		}
+
 		case DW_ROW_REMOVE_REQUESTED:
 		{
 			if((new BAlert("", B_TRANSLATE("Do you want to remove this item?"),
@@ -503,6 +832,80 @@ MainWindow::MessageReceived(BMessage *msg)
 			break;
 		}
 
+		// A folder of message files to infer a schema from
+		case MW_INFER_SCHEMA:
+		{
+			if(fSchemaFolderPanel == NULL) {
+				BMessenger messenger(this);
+				fSchemaFolderPanel = new BFilePanel(B_OPEN_PANEL, &messenger,
+					NULL, B_DIRECTORY_NODE, false,
+					new BMessage(MW_INFER_SCHEMA_REQUESTED));
+			}
+			fSchemaFolderPanel->Show();
+			break;
+		}
+
+		case MW_INFER_SCHEMA_REQUESTED:
+		{
+			entry_ref ref;
+			if(msg->FindRef("refs", &ref) != B_OK)
+				break;
+
+			fSchemaPanel->Infer(ref);
+			fTopMenuBar->FindItem(MW_SCHEMA_PANEL_VISIBLE)->SetEnabled(true);
+			if(fSchemaPanel->IsHidden())
+				ToggleSchemaPanelVisibility();
+			break;
+		}
+
+		case MW_SCHEMA_PANEL_VISIBLE:
+			ToggleSchemaPanelVisibility();
+			break;
+
+		// A schema file to validate messages with when they are opened,
+		// edited and saved
+		case MW_VALIDATION_SCHEMA:
+		{
+			if(fValidatorPanel == NULL) {
+				BMessenger messenger(this);
+				fValidatorPanel = new BFilePanel(B_OPEN_PANEL, &messenger,
+					NULL, B_FILE_NODE, false,
+					new BMessage(MW_VALIDATION_SCHEMA_REQUESTED));
+			}
+			fValidatorPanel->Show();
+			break;
+		}
+
+		case MW_VALIDATION_SCHEMA_REQUESTED:
+		case MW_CLEAR_VALIDATION_SCHEMA:
+		{
+			entry_ref ref;
+			BPath path;
+			if(msg->FindRef("refs", &ref) == B_OK)
+				path.SetTo(&ref);
+			SetValidationSchema(path.Path());
+
+			// The app keeps the schema for the next start
+			BMessage option(MW_VALIDATION_SCHEMA);
+			option.AddString("path", fValidator.IsEmpty() || path.Path() == NULL
+				? "" : path.Path());
+			be_app->PostMessage(&option);
+			break;
+		}
+
+		// The panel has a new schema, check the message against it
+		case SCHEMA_READY:
+			check_schema();
+			break;
+
+		case SCHEMA_DEVIATION_SELECTED:
+		{
+			BMessage location;
+			if(fSchemaPanel->SelectedDeviation(&location))
+				fMessageInfoView->SelectField(&location);
+			break;
+		}
+
 		//do nothing and don´t forward to base class
 		case MW_DO_NOTHING:
 			break;
@@ -594,6 +997,55 @@ MainWindow::switch_unsaved_state(bool unsaved_state)
 
 }
 
+void
+MainWindow::SetSaveChecksum(bool enabled)
+{
+	fTopMenuBar->FindItem(MW_SAVE_CHECKSUM)->SetMarked(enabled);
+}
+
+void
+MainWindow::SetSaveCompressed(bool enabled)
+{
+	fTopMenuBar->FindItem(MW_SAVE_COMPRESSED)->SetMarked(enabled);
+}
+
+void
+MainWindow::SetSaveByteOrder(int32 order)
+{
+	BMenuItem* item = fByteOrderMenu->ItemAt(order);
+	if(item)
+		item->SetMarked(true);
+}
+
+// Compiles the schema file at path, or stops validating when there is none
+void
+MainWindow::SetValidationSchema(const char *path)
+{
+	BString error;
+	if(path == NULL || path[0] == '\0')
+		fValidator.MakeEmpty();
+	else if(fValidator.Load(path, &error) != B_OK) {
+		BString text;
+		text.SetToFormat(B_TRANSLATE("The validation schema %s could not be "
+			"used:\n\n%s"), path, error.String());
+		(new BAlert("", text, B_TRANSLATE("OK"), NULL, NULL,
+			B_WIDTH_AS_USUAL, B_STOP_ALERT))->Go(NULL);
+	}
+
+	bool validating = !fValidator.IsEmpty();
+	fTopMenuBar->FindItem(MW_CLEAR_VALIDATION_SCHEMA)->SetEnabled(validating);
+	fTopMenuBar->FindItem(MW_VALIDATION_SCHEMA)->SetMarked(validating);
+	if(validating)
+		fTopMenuBar->FindItem(MW_SCHEMA_PANEL_VISIBLE)->SetEnabled(true);
+
+	if(validating || fSchemaPanel->HasSchema())
+		check_schema();
+	else {
+		fMessageInfoView->ClearDeviations();
+		fSchemaPanel->SetDeviations(NULL);
+	}
+}
+
 void
 MainWindow::ToggleDataViewVisibility()
 {
@@ -606,3 +1058,112 @@ MainWindow::ToggleDataViewVisibility()
 		fDataView->Hide();
 	}
 }
+
+
+void
+MainWindow::ToggleFindBar()
+{
+	if(fFindBar->IsHidden()) {
+		fTopMenuBar->FindItem(MW_SHOW_FIND)->SetMarked(true);
+		fFindBar->Show();
+		fFindText->MakeFocus(true);
+		fSelectFirstMatch = true;
+		send_find_query();
+	}
+	else {
+		fTopMenuBar->FindItem(MW_SHOW_FIND)->SetMarked(false);
+		fFindBar->Hide();
+		fFindStatus->SetText("");
+		fMessageInfoView->ClearMatches();
+	}
+}
+
+
+void
+MainWindow::send_find_query()
+{
+
+	BMessage query(MW_FIND);
+	query.AddString("query", fFindText->Text());
+	be_app->PostMessage(&query);
+
+}
+
+
+void
+MainWindow::ToggleSchemaPanelVisibility()
+{
+	if(fSchemaPanel->IsHidden()) {
+		fTopMenuBar->FindItem(MW_SCHEMA_PANEL_VISIBLE)->SetMarked(true);
+		fSchemaPanel->Show();
+	}
+	else {
+		fTopMenuBar->FindItem(MW_SCHEMA_PANEL_VISIBLE)->SetMarked(false);
+		fSchemaPanel->Hide();
+	}
+}
+
+
+// Flags the fields of the document that the inferred schema does not expect
+// and those that break the validation schema
+void
+MainWindow::check_schema()
+{
+
+	if (!fSchemaPanel->HasSchema() && fValidator.IsEmpty())
+	{
+		return;
+	}
+
+	// Both schemas work on the flattened form, like the files they are for
+	BMessage deviations;
+	std::vector<uint8> flat;
+	status_t status = flatten_document(flat);
+	if (status == B_OK && fSchemaPanel->HasSchema())
+	{
+		status = fSchemaPanel->Check(flat.data(), flat.size(), &deviations);
+	}
+	if (status == B_OK && !fValidator.IsEmpty())
+	{
+		ssize_t violations = fValidator.Validate(flat.data(), flat.size(),
+			&deviations);
+		if (violations < 0)
+		{
+			status = violations;
+		}
+	}
+
+	if (status != B_OK)
+	{
+		fMessageInfoView->ClearDeviations();
+		fSchemaPanel->SetDeviations(NULL);
+		return;
+	}
+
+	BMessage deviation;
+	for (int32 i = 0; deviations.FindMessage("deviation", i, &deviation) == B_OK; ++i)
+	{
+		deviation.AddString("text", SchemaPanel::DeviationText(&deviation));
+		deviations.ReplaceMessage("deviation", i, &deviation);
+	}
+
+	fMessageInfoView->SetDeviations(&deviations);
+	fSchemaPanel->SetDeviations(&deviations);
+
+}
+
+
+status_t
+MainWindow::flatten_document(std::vector<uint8> &flat)
+{
+
+	const BMessage *message = fMessageInfoView->DataMessage();
+	if (message == NULL)
+	{
+		return B_NO_INIT;
+	}
+
+	flat.resize(message->FlattenedSize());
+	return message->Flatten((char*)flat.data(), flat.size());
+
+}
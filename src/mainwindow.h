@@ -11,9 +11,15 @@
 #include <Window.h>
 #include <MenuBar.h>
 #include <FilePanel.h>
+#include <StringView.h>
+#include <TextControl.h>
+#include <vector>
 
 #include "datawindow.h"
 #include "messageview.h"
+#include "recordlistview.h"
+#include "schemapanel.h"
+#include "schemavalidator.h"
 
 
 enum
@@ -39,6 +45,27 @@ enum
 	MW_CLOSE_REPLY,
 	MW_CREATE_ENTRY_REQUESTED,
 	MW_CREATE_ENTRY_REPLY,
+	MW_SAVE_CHECKSUM,
+	MW_SAVE_BYTE_ORDER,
+	MW_INTEGRITY_WARNING,
+	MW_UNDO,
+	MW_REDO,
+	MW_HISTORY_STATE,
+	MW_SHOW_FIND,
+	MW_FIND,
+	MW_FIND_NEXT,
+	MW_FIND_REPLY,
+	MW_SELECT_FIELD,
+	MW_RECORD_INDEX,
+	MW_SELECT_RECORD,
+	MW_CAPTURE_WINDOW,
+	MW_OPEN_CAPTURED_MESSAGE,
+	MW_REPLAY_WINDOW,
+	MW_SAVE_COMPRESSED,
+	MW_SAVE_PATCH,
+	MW_SAVE_PATCH_REQUESTED,
+	MW_APPLY_PATCH,
+	MW_APPLY_PATCH_REQUESTED,
 
 	/* Message -> Add X commands */
 	MW_ADD_AFFINE_TX,
@@ -70,9 +97,17 @@ enum
 	MW_MESSAGE_OPEN_SET_WHAT_DIALOG,
 	MW_MESSAGE_MAKE_EMPTY,
 	MW_MESSAGE_INFORMATION,
+	MW_MESSAGE_SIZE_PROFILE,
 
 	/* View menu */
 	MW_DATA_PANEL_VISIBLE,
+	MW_ICON_GALLERY,
+	MW_INFER_SCHEMA,
+	MW_INFER_SCHEMA_REQUESTED,
+	MW_SCHEMA_PANEL_VISIBLE,
+	MW_VALIDATION_SCHEMA,
+	MW_VALIDATION_SCHEMA_REQUESTED,
+	MW_CLEAR_VALIDATION_SCHEMA,
 };
 
 class MainWindow : public BWindow {
@@ -81,6 +116,10 @@ public:
 	~MainWindow();
 	void MessageReceived(BMessage *msg);
 	bool QuitRequested();
+	void SetSaveChecksum(bool enabled);
+	void SetSaveCompressed(bool enabled);
+	void SetSaveByteOrder(int32 order);
+	void SetValidationSchema(const char *path);
 
 private:
 	bool continue_action(const char *alert_text,
@@ -88,10 +127,26 @@ private:
 						 const char *button_label_continue);
 	void switch_unsaved_state(bool unsaved_state);
 	void ToggleDataViewVisibility();
+	void ToggleSchemaPanelVisibility();
+	void ToggleFindBar();
+	void send_find_query();
+	void check_schema();
+	status_t flatten_document(std::vector<uint8> &flat);
 
 	BMenuBar			*fTopMenuBar;
+	BMenu				*fByteOrderMenu;
 	MessageView			*fMessageInfoView;
 	DataView			*fDataView;
+	RecordPanel			*fRecordPanel;
+	SchemaPanel			*fSchemaPanel;
+	BFilePanel			*fSchemaFolderPanel;
+	SchemaValidator		fValidator;
+	BFilePanel			*fValidatorPanel;
+	BView				*fFindBar;
+	BTextControl		*fFindText;
+	BStringView			*fFindStatus;
+	bool				fSelectFirstMatch;
+	int32				fShownRecord;
 	bool				fUnsaved;
 };
 
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#include <Path.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "mappedfile.h"
+
+MappedFile::MappedFile()
+: fData(NULL),
+  fSize(0),
+  fStatus(B_NO_INIT)
+{
+}
+
+MappedFile::~MappedFile()
+{
+	Unset();
+}
+
+status_t
+MappedFile::SetTo(const entry_ref* ref)
+{
+	Unset();
+
+	BPath path(ref);
+	if((fStatus = path.InitCheck()) != B_OK)
+		return fStatus;
+
+	int fd = open(path.Path(), O_RDONLY);
+	if(fd < 0)
+		return fStatus = errno;
+
+	struct stat st;
+	if(fstat(fd, &st) != 0 || st.st_size <= 0
+		|| (uint64)st.st_size > (uint64)SIZE_MAX) {
+		close(fd);
+		return fStatus = B_BAD_DATA;
+	}
+
+	void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(data == MAP_FAILED)
+		return fStatus = B_NO_MEMORY;
+
+	fData = static_cast<uint8*>(data);
+	fSize = st.st_size;
+	return fStatus = B_OK;
+}
+
+void
+MappedFile::Unset()
+{
+	if(fData)
+		munmap(fData, fSize);
+
+	fData = NULL;
+	fSize = 0;
+	fStatus = B_NO_INIT;
+}
@@ -0,0 +1,33 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef __MAPPED_FILE_H__
+#define __MAPPED_FILE_H__
+
+#include <Entry.h>
+#include <SupportDefs.h>
+
+/*	Read-only mapping of a whole file, so that large files can be walked
+	without reading them into the heap first.
+*/
+class MappedFile
+{
+public:
+							MappedFile();
+							~MappedFile();
+
+			status_t		SetTo(const entry_ref* ref);
+			void			Unset();
+			status_t		InitCheck() const { return fStatus; }
+
+			const uint8*	Data() const { return fData; }
+			size_t			Size() const { return fSize; }
+private:
+			uint8*			fData;
+			size_t			fSize;
+			status_t		fStatus;
+};
+
+#endif /* __MAPPED_FILE_H__ */
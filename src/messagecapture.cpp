@@ -0,0 +1,424 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#include <ByteOrder.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <algorithm>
+
+#include "legacymessage.h"
+#include "messagecapture.h"
+
+static const size_t kReadSize = 64 * 1024;
+static const size_t kSpoolBlockSize = 1024 * 1024;
+static const bigtime_t kPostInterval = 50000;
+static const bigtime_t kPostTimeout = 100000;
+static const bigtime_t kStallWait = 200;
+static const bigtime_t kIdleWait = 1000;
+
+MessageCapture::MessageCapture(BMessenger target)
+: fTarget(target),
+  fRing(kRingSize),
+  fListenFD(-1),
+  fIsPipe(false),
+  fSpoolSize(0),
+  fReceiver(-1),
+  fSpooler(-1),
+  fQuit(0),
+  fReceiverDone(0),
+  fStatus(B_OK),
+  fMessages(0),
+  fBytes(0),
+  fStalls(0)
+{
+	fWakeFDs[0] = fWakeFDs[1] = -1;
+}
+
+MessageCapture::~MessageCapture()
+{
+	Stop();
+}
+
+status_t
+MessageCapture::Start(const char* path, const char* spoolPath)
+{
+	if(IsRunning())
+		return B_BUSY;
+	if(fRing.InitCheck() != B_OK)
+		return B_NO_MEMORY;
+
+	// A capture started again goes on at the end of the spool
+	status_t status = fSpool.SetTo(spoolPath, B_READ_WRITE | B_CREATE_FILE);
+	if(status == B_OK)
+		status = fSpool.GetSize(&fSpoolSize);
+	if(status != B_OK)
+		return status;
+
+	if(pipe(fWakeFDs) != 0)
+		return errno;
+	status = _Listen(path);
+	if(status != B_OK) {
+		_CloseAll();
+		return status;
+	}
+
+	fRing.Reset();
+	fQuit = 0;
+	fReceiverDone = 0;
+	fStatus = B_OK;
+
+	fReceiver = spawn_thread(_ReceiveThread, "capture receiver",
+		B_DISPLAY_PRIORITY, this);
+	fSpooler = spawn_thread(_SpoolThread, "capture spooler",
+		B_NORMAL_PRIORITY, this);
+	if(fReceiver < 0 || fSpooler < 0) {
+		status = fReceiver < 0 ? fReceiver : fSpooler;
+		if(fReceiver >= 0)
+			kill_thread(fReceiver);
+		if(fSpooler >= 0)
+			kill_thread(fSpooler);
+		fReceiver = fSpooler = -1;
+		_CloseAll();
+		return status;
+	}
+
+	resume_thread(fReceiver);
+	resume_thread(fSpooler);
+	return B_OK;
+}
+
+void
+MessageCapture::RequestStop()
+{
+	if(!IsRunning() || atomic_get(&fQuit) != 0)
+		return;
+
+	atomic_set(&fQuit, 1);
+	char wake = 0;
+	write(fWakeFDs[1], &wake, 1);
+}
+
+void
+MessageCapture::Stop()
+{
+	if(!IsRunning())
+		return;
+
+	RequestStop();
+	status_t result;
+	wait_for_thread(fReceiver, &result);
+	wait_for_thread(fSpooler, &result);
+	fReceiver = fSpooler = -1;
+	_CloseAll();
+}
+
+// #pragma mark - MessageCapture::Private
+
+status_t
+MessageCapture::_ReceiveThread(void* data)
+{
+	MessageCapture* capture = static_cast<MessageCapture*>(data);
+	status_t status = capture->_Receive();
+	if(status != B_OK)
+		capture->fStatus = status;
+
+	// Published after the status, the spooler reads it when it sees this
+	atomic_set(&capture->fReceiverDone, 1);
+	return status;
+}
+
+status_t
+MessageCapture::_SpoolThread(void* data)
+{
+	MessageCapture* capture = static_cast<MessageCapture*>(data);
+	status_t status = capture->_Spool();
+	if(status == B_OK)
+		status = capture->fStatus;
+
+	BMessage stopped(MC_STOPPED);
+	stopped.AddInt32("status", status);
+	capture->_Post(&stopped);
+	return status;
+}
+
+status_t
+MessageCapture::_Listen(const char* path)
+{
+	fPath = path;
+	fIsPipe = false;
+
+	struct stat st;
+	bool exists = stat(path, &st) == 0;
+
+	// Opened for writing as well, so that the pipe does not end when the
+	// last sender closes it
+	if(exists && S_ISFIFO(st.st_mode)) {
+		int fd = open(path, O_RDWR);
+		if(fd < 0)
+			return errno;
+		fIsPipe = true;
+		connection source;
+		source.fd = fd;
+		source.length = 0;
+		fConnections.push_back(source);
+		return B_OK;
+	}
+
+	sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	if(strlen(path) >= sizeof(address.sun_path))
+		return B_NAME_TOO_LONG;
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path, path);
+
+	// A socket left behind by an earlier capture is replaced, files not
+	if(exists) {
+		if(!S_ISSOCK(st.st_mode))
+			return B_FILE_EXISTS;
+		unlink(path);
+	}
+
+	fListenFD = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(fListenFD < 0)
+		return errno;
+	if(bind(fListenFD, (sockaddr*)&address, sizeof(address)) != 0
+		|| listen(fListenFD, kMaxConnections) != 0)
+		return errno;
+	return B_OK;
+}
+
+status_t
+MessageCapture::_Receive()
+{
+	std::vector<pollfd> fds;
+	while(true) {
+		fds.clear();
+		pollfd wake = { fWakeFDs[0], POLLIN, 0 };
+		fds.push_back(wake);
+		if(fListenFD >= 0) {
+			pollfd listener = { fListenFD, POLLIN, 0 };
+			fds.push_back(listener);
+		}
+		size_t first = fds.size();
+		for(size_t i = 0; i < fConnections.size(); i++) {
+			pollfd source = { fConnections[i].fd, POLLIN, 0 };
+			fds.push_back(source);
+		}
+
+		if(poll(fds.data(), fds.size(), -1) < 0) {
+			if(errno == EINTR)
+				continue;
+			return errno;
+		}
+		if(fds[0].revents != 0)
+			return B_OK;
+
+		// Backwards, so that closing one does not move the ones to come
+		for(size_t i = fds.size(); i-- > first;) {
+			if(fds[i].revents == 0)
+				continue;
+			if(_ReadFrom(fConnections[i - first]))
+				continue;
+			if(atomic_get(&fQuit) != 0)
+				return B_OK;
+			if(fIsPipe)
+				return B_IO_ERROR;
+
+			close(fConnections[i - first].fd);
+			fConnections.erase(fConnections.begin() + (i - first));
+		}
+
+		if(fListenFD >= 0 && (fds[1].revents & POLLIN) != 0) {
+			int fd = accept(fListenFD, NULL, NULL);
+			if(fd >= 0 && (int32)fConnections.size() >= kMaxConnections)
+				close(fd);
+			else if(fd >= 0) {
+				connection source;
+				source.fd = fd;
+				source.length = 0;
+				fConnections.push_back(source);
+			}
+		}
+	}
+}
+
+/*	Reads what the connection has and passes the complete messages on.
+	False when the connection is done with: closed by the sender, broken,
+	or sending something that is no message.
+*/
+bool
+MessageCapture::_ReadFrom(connection& source)
+{
+	if(source.buffer.size() - source.length < kReadSize)
+		source.buffer.resize(source.length + kReadSize);
+
+	ssize_t bytesRead = read(source.fd, source.buffer.data() + source.length,
+		source.buffer.size() - source.length);
+	if(bytesRead < 0 && errno == EINTR)
+		return true;
+	if(bytesRead <= 0) {
+		// A message cut short is as bad as a broken connection
+		if(bytesRead < 0 || source.length > 0) {
+			BMessage error(MC_CONNECTION_ERROR);
+			error.AddInt32("status", bytesRead < 0 ? errno : B_BAD_DATA);
+			_Post(&error);
+		}
+		return false;
+	}
+	source.length += bytesRead;
+
+	const uint8* data = source.buffer.data();
+	size_t offset = 0;
+	while(source.length - offset >= sizeof(uint32)) {
+		uint32 size;
+		memcpy(&size, data + offset, sizeof(size));
+		size = B_LENDIAN_TO_HOST_INT32(size);
+
+		bool valid = size <= fRing.MaxRecordSize();
+		if(valid && source.length - offset - sizeof(size) < size) {
+			// Room for all of a large message, so it needs no second copy
+			if(source.buffer.size() < sizeof(size) + size + kReadSize / 2)
+				source.buffer.resize(sizeof(size) + size + kReadSize / 2);
+			break;
+		}
+
+		const uint8* message = data + offset + sizeof(size);
+		if(!valid || flattened_message_size(message, size) != (ssize_t)size) {
+			BMessage error(MC_CONNECTION_ERROR);
+			error.AddInt32("status", valid ? B_BAD_DATA : B_MESSAGE_TO_BIG);
+			_Post(&error);
+			return false;
+		}
+
+		if(!_Push(message, size))
+			return false;
+		offset += sizeof(size) + size;
+	}
+
+	memmove(source.buffer.data(), source.buffer.data() + offset,
+		source.length - offset);
+	source.length -= offset;
+	return true;
+}
+
+// Waits while the ring is full; the senders wait on their sockets meanwhile
+bool
+MessageCapture::_Push(const uint8* data, size_t size)
+{
+	if(fRing.Write(data, size))
+		return true;
+
+	atomic_add64(&fStalls, 1);
+	do {
+		if(atomic_get(&fQuit) != 0)
+			return false;
+		snooze(kStallWait);
+	} while(!fRing.Write(data, size));
+	return true;
+}
+
+status_t
+MessageCapture::_Spool()
+{
+	std::vector<uint8> block;
+	block.reserve(kSpoolBlockSize + kReadSize);
+	std::vector<message_record> records;
+	bigtime_t nextPost = 0;
+
+	while(true) {
+		// Seen before the ring is emptied, so nothing written after it
+		// is left behind
+		bool done = atomic_get(&fReceiverDone) != 0;
+
+		size_t start = 0;
+		while(block.size() < kSpoolBlockSize && fRing.Read(block)) {
+			message_record record;
+			record.offset = fSpoolSize + start;
+			record.size = block.size() - start;
+			record.what = 0;
+			flattened_message_size(block.data() + start, record.size,
+				&record.what);
+			records.push_back(record);
+			fMessages++;
+			fBytes += record.size;
+			start = block.size();
+		}
+
+		if(!block.empty()) {
+			ssize_t written = fSpool.WriteAt(fSpoolSize, block.data(),
+				block.size());
+			if(written != (ssize_t)block.size()) {
+				// The receiver stalls from here on until it is stopped
+				_PostRecords(records);
+				return written < 0 ? written : B_DEVICE_FULL;
+			}
+			fSpoolSize += block.size();
+			block.clear();
+		}
+
+		if(!records.empty() && (done || system_time() >= nextPost)) {
+			_PostRecords(records);
+			nextPost = system_time() + kPostInterval;
+		}
+
+		if(start == 0) {
+			if(done)
+				break;
+			snooze(kIdleWait);
+		}
+	}
+
+	if(!records.empty())
+		_PostRecords(records);
+	return B_OK;
+}
+
+// Never blocks for long, the target may be waiting in Stop()
+bool
+MessageCapture::_Post(BMessage* message)
+{
+	return fTarget.SendMessage(message, (BHandler*)NULL, kPostTimeout) == B_OK;
+}
+
+// Records that could not be delivered go with the next ones
+void
+MessageCapture::_PostRecords(std::vector<message_record>& records)
+{
+	BMessage update(MC_RECORDS_CAPTURED);
+	update.AddData("records", B_RAW_TYPE, records.data(),
+		records.size() * sizeof(message_record));
+	update.AddInt64("messages", fMessages);
+	update.AddInt64("bytes", fBytes);
+	update.AddInt64("stalls", atomic_get64(&fStalls));
+	update.AddInt64("ring", fRing.Used());
+	if(_Post(&update))
+		records.clear();
+}
+
+void
+MessageCapture::_CloseAll()
+{
+	for(size_t i = 0; i < fConnections.size(); i++)
+		close(fConnections[i].fd);
+	fConnections.clear();
+
+	if(fListenFD >= 0) {
+		close(fListenFD);
+		unlink(fPath.String());
+		fListenFD = -1;
+	}
+	for(int32 i = 0; i < 2; i++) {
+		if(fWakeFDs[i] >= 0)
+			close(fWakeFDs[i]);
+		fWakeFDs[i] = -1;
+	}
+	fSpool.Unset();
+}
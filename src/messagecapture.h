@@ -0,0 +1,92 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef __MESSAGE_CAPTURE_H__
+#define __MESSAGE_CAPTURE_H__
+
+#include <File.h>
+#include <Messenger.h>
+#include <String.h>
+#include <OS.h>
+#include <vector>
+
+#include "capturering.h"
+#include "recordindex.h"
+
+enum {
+	MC_RECORDS_CAPTURED = 'mc00',	// "records", "messages", "bytes", "stalls",
+									// "ring"
+	MC_CONNECTION_ERROR,			// "status"
+	MC_STOPPED						// "status"
+};
+
+/*	Receives flattened messages from programs being debugged and spools
+	them to a stream file, one after the other as RecordIndex reads them.
+	Senders connect to a Unix domain socket, or write to a named pipe when
+	the path is one, and send each message as a little endian uint32
+	length followed by the flattened message of any layout.
+
+	One thread receives from every connection and hands whole messages to
+	a second one through a CaptureRing; that one writes them to the spool
+	file in large blocks and tells the target about the new records a few
+	times a second. Nothing is dropped: while the ring is full the
+	receiving thread stops reading, and the senders wait on their socket.
+*/
+class MessageCapture
+{
+public:
+	static	const size_t	kRingSize = 16 * 1024 * 1024;
+	static	const int32		kMaxConnections = 32;
+
+							MessageCapture(BMessenger target);
+							~MessageCapture();
+
+			status_t		Start(const char* path, const char* spoolPath);
+			// Returns at once, MC_STOPPED follows the last records
+			void			RequestStop();
+			// Waits for the threads; what they still post may be lost
+			void			Stop();
+			bool			IsRunning() const { return fReceiver >= 0; }
+private:
+	struct connection {
+		int				fd;
+		std::vector<uint8> buffer;
+		size_t			length;
+	};
+
+	static	status_t		_ReceiveThread(void* data);
+	static	status_t		_SpoolThread(void* data);
+
+			status_t		_Listen(const char* path);
+			status_t		_Receive();
+			bool			_ReadFrom(connection& source);
+			bool			_Push(const uint8* data, size_t size);
+			status_t		_Spool();
+			bool			_Post(BMessage* message);
+			void			_PostRecords(std::vector<message_record>& records);
+			void			_CloseAll();
+private:
+			BMessenger		fTarget;
+			CaptureRing		fRing;
+			BString			fPath;
+			int				fListenFD;
+			bool			fIsPipe;
+			int				fWakeFDs[2];
+			std::vector<connection> fConnections;
+
+			BFile			fSpool;
+			off_t			fSpoolSize;
+
+			thread_id		fReceiver;
+			thread_id		fSpooler;
+			int32			fQuit;
+			int32			fReceiverDone;
+			status_t		fStatus;
+			int64			fMessages;
+			int64			fBytes;
+			int64			fStalls;
+};
+
+#endif /* __MESSAGE_CAPTURE_H__ */
@@ -0,0 +1,626 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#include <ByteOrder.h>
+#include <TypeConstants.h>
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+
+#include "checksum.h"
+#include "flatmessage.h"
+#include "messagedelta.h"
+
+static const int32 kMaxDeltaNesting = 64;
+
+enum {
+	kDeltaCopyFields = 1,	// first, count
+	kDeltaEditField,		// base index, new count, edits, appended items
+	kDeltaAddField			// name, type, fixed size, count, data
+};
+
+enum {
+	kDeltaReplaceItem = 1,	// gap, item
+	kDeltaPatchItem			// gap, length of the nested edits, edits
+};
+
+/*	Reads the patch front to back. Every read is checked against the end,
+	so a truncated or corrupt patch fails instead of reading past it.
+*/
+class DeltaCursor
+{
+public:
+	DeltaCursor(const void* data, size_t size)
+	: fPosition(static_cast<const uint8*>(data)),
+	  fEnd(static_cast<const uint8*>(data) + size)
+	{
+	}
+
+	bool Number(uint64* value);
+	bool Number(uint32* value);
+	bool UInt32(uint32* value);
+	bool Byte(uint8* value);
+	bool Bytes(uint64 size, const uint8** data);
+	bool AtEnd() const { return fPosition == fEnd; }
+private:
+	const uint8*	fPosition;
+	const uint8*	fEnd;
+};
+
+bool
+DeltaCursor::Number(uint64* value)
+{
+	*value = 0;
+	for(int32 shift = 0; shift < 64 && fPosition < fEnd; shift += 7) {
+		uint8 byte = *fPosition++;
+		*value |= (uint64)(byte & 0x7f) << shift;
+		if((byte & 0x80) == 0)
+			return true;
+	}
+	return false;
+}
+
+bool
+DeltaCursor::Number(uint32* value)
+{
+	uint64 number;
+	if(!Number(&number) || number > 0xffffffff)
+		return false;
+	*value = number;
+	return true;
+}
+
+bool
+DeltaCursor::UInt32(uint32* value)
+{
+	const uint8* data;
+	if(!Bytes(sizeof(uint32), &data))
+		return false;
+	memcpy(value, data, sizeof(uint32));
+	return true;
+}
+
+bool
+DeltaCursor::Byte(uint8* value)
+{
+	if(fPosition >= fEnd)
+		return false;
+	*value = *fPosition++;
+	return true;
+}
+
+bool
+DeltaCursor::Bytes(uint64 size, const uint8** data)
+{
+	if(size > (uint64)(fEnd - fPosition))
+		return false;
+	*data = fPosition;
+	fPosition += size;
+	return true;
+}
+
+// #pragma mark - writing
+
+static void
+put_number(std::vector<uint8>& output, uint64 value)
+{
+	while(value >= 0x80) {
+		output.push_back((value & 0x7f) | 0x80);
+		value >>= 7;
+	}
+	output.push_back(value);
+}
+
+static void
+put_bytes(std::vector<uint8>& output, const void* data, size_t size)
+{
+	const uint8* bytes = static_cast<const uint8*>(data);
+	output.insert(output.end(), bytes, bytes + size);
+}
+
+static void
+put_uint32(std::vector<uint8>& output, uint32 value)
+{
+	put_bytes(output, &value, sizeof(value));
+}
+
+// Items of a fixed size field go without their size, the base has it
+static void
+put_item(std::vector<uint8>& output, const flat_item& item, bool fixedSize)
+{
+	if(!fixedSize)
+		put_number(output, item.size);
+	put_bytes(output, item.data, item.size);
+}
+
+static bool
+is_fixed_size(const flat_field_header& field)
+{
+	return (field.flags & kFlatFieldFixedSize) != 0;
+}
+
+static status_t diff_message(const FlatMessageReader& base,
+	const FlatMessageReader& result, int32 depth, std::vector<uint8>& output);
+
+/*	The edits of a nested message instead of the whole item, when both
+	versions are native messages and that saves space.
+*/
+static bool
+diff_nested(const flat_item& baseItem, const flat_item& resultItem,
+	int32 depth, std::vector<uint8>& edits)
+{
+	if(depth >= kMaxDeltaNesting)
+		return false;
+
+	FlatMessageReader base(baseItem.data, baseItem.size);
+	FlatMessageReader result(resultItem.data, resultItem.size);
+	if(base.InitCheck() != B_OK || base.FlattenedSize() != baseItem.size
+		|| result.InitCheck() != B_OK
+		|| result.FlattenedSize() != resultItem.size)
+		return false;
+
+	edits.clear();
+	return diff_message(base, result, depth + 1, edits) == B_OK
+		&& edits.size() + sizeof(uint64) < resultItem.size;
+}
+
+static status_t
+diff_field(const FlatMessageReader& base, int32 baseIndex,
+	const flat_field_header& baseField, const FlatMessageReader& result,
+	const flat_field_header& resultField, int32 depth,
+	std::vector<uint8>& output)
+{
+	bool fixedSize = is_fixed_size(baseField);
+	std::vector<uint8> edits;
+	std::vector<uint8> nested;
+	uint32 editCount = 0;
+	int32 previous = -1;
+
+	flat_item baseItem;
+	flat_item resultItem;
+	status_t status = B_OK;
+	status_t baseStatus = base.FirstItem(baseField, &baseItem);
+	status_t resultStatus = result.FirstItem(resultField, &resultItem);
+	while(baseStatus == B_OK && resultStatus == B_OK) {
+		if(baseItem.size != resultItem.size
+			|| memcmp(baseItem.data, resultItem.data, baseItem.size) != 0) {
+			if(baseField.type == B_MESSAGE_TYPE && !fixedSize
+				&& diff_nested(baseItem, resultItem, depth, nested)) {
+				edits.push_back(kDeltaPatchItem);
+				put_number(edits, resultItem.index - previous - 1);
+				put_number(edits, nested.size());
+				put_bytes(edits, nested.data(), nested.size());
+			} else {
+				edits.push_back(kDeltaReplaceItem);
+				put_number(edits, resultItem.index - previous - 1);
+				put_item(edits, resultItem, fixedSize);
+			}
+			previous = resultItem.index;
+			editCount++;
+		}
+		baseStatus = base.NextItem(baseField, &baseItem);
+		resultStatus = result.NextItem(resultField, &resultItem);
+	}
+	if(baseStatus == B_BAD_DATA || resultStatus == B_BAD_DATA)
+		return B_BAD_DATA;
+
+	output.push_back(kDeltaEditField);
+	put_number(output, baseIndex);
+	put_number(output, resultField.count);
+	put_number(output, editCount);
+	put_bytes(output, edits.data(), edits.size());
+
+	// What is left of the new version is appended
+	for(; resultStatus == B_OK;
+		resultStatus = result.NextItem(resultField, &resultItem))
+		put_item(output, resultItem, fixedSize);
+	if(resultStatus == B_BAD_DATA)
+		status = B_BAD_DATA;
+
+	return status;
+}
+
+static void
+add_field(const FlatMessageReader& result, const flat_field_header& field,
+	const char* name, std::vector<uint8>& output)
+{
+	size_t length = strlen(name);
+	output.push_back(kDeltaAddField);
+	put_number(output, length);
+	put_bytes(output, name, length);
+	put_uint32(output, field.type);
+	output.push_back(is_fixed_size(field) ? 1 : 0);
+	put_number(output, field.count);
+	put_number(output, field.data_size);
+	put_bytes(output, result.FieldData(field), field.data_size);
+}
+
+static void
+copy_fields(int32 first, int32 count, std::vector<uint8>& output)
+{
+	output.push_back(kDeltaCopyFields);
+	put_number(output, first);
+	put_number(output, count);
+}
+
+/*	The fields of the new version in its order. Unchanged ones that
+	follow each other in the base as well are copied as one run.
+*/
+static status_t
+diff_message(const FlatMessageReader& base, const FlatMessageReader& result,
+	int32 depth, std::vector<uint8>& output)
+{
+	std::vector<flat_field_header> baseFields(base.CountFields());
+	std::unordered_map<std::string, int32> baseNames;
+	for(int32 i = 0; i < base.CountFields(); i++) {
+		const char* name;
+		if(base.FieldAt(i, &baseFields[i]) != B_OK
+			|| (name = base.FieldName(baseFields[i])) == NULL)
+			return B_BAD_DATA;
+		baseNames[name] = i;
+	}
+
+	std::vector<uint8> edits;
+	uint32 editCount = 0;
+	int32 runFirst = 0;
+	int32 runCount = 0;
+	for(int32 i = 0; i < result.CountFields(); i++) {
+		flat_field_header field;
+		const char* name;
+		if(result.FieldAt(i, &field) != B_OK
+			|| (name = result.FieldName(field)) == NULL)
+			return B_BAD_DATA;
+
+		std::unordered_map<std::string, int32>::const_iterator found
+			= baseNames.find(name);
+		int32 baseIndex = found != baseNames.end() ? found->second : -1;
+		const flat_field_header* baseField
+			= baseIndex >= 0 ? &baseFields[baseIndex] : NULL;
+
+		// A field can only be edited into one of the same kind
+		bool editable = baseField != NULL && baseField->type == field.type
+			&& is_fixed_size(*baseField) == is_fixed_size(field)
+			&& (!is_fixed_size(field) || baseField->data_size / baseField->count
+				== field.data_size / field.count);
+
+		// The count as well, the same bytes may be read as other items
+		if(editable && baseField->count == field.count
+			&& baseField->data_size == field.data_size
+			&& memcmp(base.FieldData(*baseField), result.FieldData(field),
+				field.data_size) == 0) {
+			if(runCount > 0 && runFirst + runCount == baseIndex)
+				runCount++;
+			else {
+				if(runCount > 0) {
+					copy_fields(runFirst, runCount, edits);
+					editCount++;
+				}
+				runFirst = baseIndex;
+				runCount = 1;
+			}
+			continue;
+		}
+
+		if(runCount > 0) {
+			copy_fields(runFirst, runCount, edits);
+			editCount++;
+			runCount = 0;
+		}
+
+		if(editable) {
+			status_t status = diff_field(base, baseIndex, *baseField, result,
+				field, depth, edits);
+			if(status != B_OK)
+				return status;
+		} else
+			add_field(result, field, name, edits);
+		editCount++;
+	}
+
+	if(runCount > 0) {
+		copy_fields(runFirst, runCount, edits);
+		editCount++;
+	}
+
+	put_uint32(output, result.Header().what);
+	put_number(output, editCount);
+	put_bytes(output, edits.data(), edits.size());
+	return B_OK;
+}
+
+// #pragma mark - applying
+
+static status_t apply_message(const FlatMessageReader& base,
+	DeltaCursor& delta, int32 depth, std::vector<uint8>& output);
+
+static status_t
+read_item(DeltaCursor& delta, bool fixedSize, uint32 itemSize,
+	std::vector<uint8>& items)
+{
+	uint32 size = itemSize;
+	const uint8* data;
+	if((!fixedSize && !delta.Number(&size)) || !delta.Bytes(size, &data))
+		return B_BAD_DATA;
+
+	if(!fixedSize)
+		put_uint32(items, size);
+	put_bytes(items, data, size);
+	return B_OK;
+}
+
+// The index of the next item edit, or -1 after the last one
+static status_t
+next_edit(DeltaCursor& delta, uint32* left, uint8* kind, int64* index)
+{
+	if(*left == 0) {
+		*index = -1;
+		return B_OK;
+	}
+
+	uint32 gap;
+	if(!delta.Byte(kind) || !delta.Number(&gap))
+		return B_BAD_DATA;
+	*index += (int64)gap + 1;
+	(*left)--;
+	return B_OK;
+}
+
+static status_t
+patch_item(const flat_item& item, DeltaCursor& delta, int32 depth,
+	std::vector<uint8>& patched)
+{
+	uint32 length;
+	const uint8* edits;
+	if(depth >= kMaxDeltaNesting || !delta.Number(&length)
+		|| !delta.Bytes(length, &edits))
+		return B_BAD_DATA;
+
+	FlatMessageReader nested(item.data, item.size);
+	if(nested.InitCheck() != B_OK)
+		return B_BAD_DATA;
+
+	DeltaCursor nestedDelta(edits, length);
+	status_t status = apply_message(nested, nestedDelta, depth + 1, patched);
+	if(status == B_OK && !nestedDelta.AtEnd())
+		status = B_BAD_DATA;
+	return status;
+}
+
+static status_t
+apply_field_edits(const FlatMessageReader& base, DeltaCursor& delta,
+	int32 depth, FlatMessageWriter& writer)
+{
+	uint32 baseIndex;
+	uint32 count;
+	uint32 editCount;
+	flat_field_header field;
+	if(!delta.Number(&baseIndex) || !delta.Number(&count)
+		|| !delta.Number(&editCount) || count == 0
+		|| base.FieldAt(baseIndex, &field) != B_OK)
+		return B_BAD_DATA;
+
+	const char* name = base.FieldName(field);
+	if(name == NULL)
+		return B_BAD_DATA;
+
+	bool fixedSize = is_fixed_size(field);
+	uint32 itemSize = fixedSize ? field.data_size / field.count : 0;
+	std::vector<uint8> items;
+	items.reserve(field.data_size);
+	std::vector<uint8> patched;
+
+	uint8 kind = 0;
+	int64 editIndex = -1;
+	status_t status = next_edit(delta, &editCount, &kind, &editIndex);
+
+	// The items kept from the base, some of them replaced
+	flat_item item;
+	status_t itemStatus = base.FirstItem(field, &item);
+	for(; status == B_OK && itemStatus == B_OK && (uint32)item.index < count;
+		itemStatus = base.NextItem(field, &item)) {
+		if(item.index != editIndex) {
+			if(!fixedSize)
+				put_uint32(items, item.size);
+			put_bytes(items, item.data, item.size);
+			continue;
+		}
+
+		if(kind == kDeltaReplaceItem)
+			status = read_item(delta, fixedSize, itemSize, items);
+		else if(kind == kDeltaPatchItem) {
+			patched.clear();
+			status = patch_item(item, delta, depth, patched);
+			if(status == B_OK && fixedSize && patched.size() != itemSize)
+				status = B_BAD_DATA;
+			if(status == B_OK) {
+				if(!fixedSize)
+					put_uint32(items, patched.size());
+				put_bytes(items, patched.data(), patched.size());
+			}
+		} else
+			status = B_BAD_DATA;
+
+		if(status == B_OK)
+			status = next_edit(delta, &editCount, &kind, &editIndex);
+	}
+	if(status != B_OK)
+		return status;
+	if(itemStatus == B_BAD_DATA || editIndex >= 0)
+		return B_BAD_DATA;
+
+	// and those the new version has in addition
+	for(uint32 i = std::min(count, field.count); i < count; i++) {
+		status = read_item(delta, fixedSize, itemSize, items);
+		if(status != B_OK)
+			return status;
+	}
+
+	status = writer.AddField(name, field.type, fixedSize, count, items.data(),
+		items.size());
+	return status == B_OK ? B_OK : B_BAD_DATA;
+}
+
+static status_t
+apply_copy(const FlatMessageReader& base, DeltaCursor& delta,
+	FlatMessageWriter& writer)
+{
+	uint32 first;
+	uint32 count;
+	if(!delta.Number(&first) || !delta.Number(&count)
+		|| (uint64)first + count > (uint64)base.CountFields())
+		return B_BAD_DATA;
+
+	for(uint32 i = first; i < first + count; i++) {
+		flat_field_header field;
+		const char* name;
+		if(base.FieldAt(i, &field) != B_OK
+			|| (name = base.FieldName(field)) == NULL
+			|| writer.AddField(name, field.type, is_fixed_size(field),
+				field.count, base.FieldData(field), field.data_size) != B_OK)
+			return B_BAD_DATA;
+	}
+	return B_OK;
+}
+
+static status_t
+apply_add(DeltaCursor& delta, FlatMessageWriter& writer)
+{
+	uint32 length;
+	const uint8* name;
+	type_code type;
+	uint8 fixedSize;
+	uint32 count;
+	uint32 size;
+	const uint8* data;
+	if(!delta.Number(&length) || !delta.Bytes(length, &name)
+		|| memchr(name, '\0', length) != NULL || !delta.UInt32(&type)
+		|| !delta.Byte(&fixedSize) || !delta.Number(&count)
+		|| !delta.Number(&size) || !delta.Bytes(size, &data))
+		return B_BAD_DATA;
+
+	std::string fieldName((const char*)name, length);
+	status_t status = writer.AddField(fieldName.c_str(), type, fixedSize != 0,
+		count, data, size);
+	return status == B_OK ? B_OK : B_BAD_DATA;
+}
+
+static status_t
+apply_message(const FlatMessageReader& base, DeltaCursor& delta, int32 depth,
+	std::vector<uint8>& output)
+{
+	uint32 what;
+	uint32 editCount;
+	if(!delta.UInt32(&what) || !delta.Number(&editCount))
+		return B_BAD_DATA;
+
+	FlatMessageWriter writer(what);
+	for(uint32 i = 0; i < editCount; i++) {
+		uint8 kind;
+		if(!delta.Byte(&kind))
+			return B_BAD_DATA;
+
+		status_t status;
+		switch(kind) {
+			case kDeltaCopyFields:
+				status = apply_copy(base, delta, writer);
+				break;
+			case kDeltaEditField:
+				status = apply_field_edits(base, delta, depth, writer);
+				break;
+			case kDeltaAddField:
+				status = apply_add(delta, writer);
+				break;
+			default:
+				status = B_BAD_DATA;
+				break;
+		}
+		if(status != B_OK)
+			return status;
+	}
+
+	writer.Flatten(output);
+	return B_OK;
+}
+
+// #pragma mark -
+
+bool
+is_message_delta(const void* data, size_t size)
+{
+	uint32 magic;
+	if(size < sizeof(magic))
+		return false;
+	memcpy(&magic, data, sizeof(magic));
+	return magic == kMessageDeltaMagic;
+}
+
+status_t
+create_message_delta(const void* base, size_t baseSize, const void* result,
+	size_t resultSize, std::vector<uint8>& delta)
+{
+	FlatMessageReader baseReader(base, baseSize);
+	FlatMessageReader resultReader(result, resultSize);
+	if(baseReader.InitCheck() != B_OK)
+		return baseReader.InitCheck();
+	if(resultReader.InitCheck() != B_OK)
+		return resultReader.InitCheck();
+
+	delta.assign(sizeof(message_delta_header), 0);
+	status_t status = diff_message(baseReader, resultReader, 0, delta);
+	if(status != B_OK)
+		return status;
+
+	// The result is checked as the patch rebuilds it, which need not be
+	// byte for byte what BMessage::Flatten() wrote
+	std::vector<uint8> rebuilt;
+	DeltaCursor cursor(delta.data() + sizeof(message_delta_header),
+		delta.size() - sizeof(message_delta_header));
+	status = apply_message(baseReader, cursor, 0, rebuilt);
+	if(status != B_OK)
+		return status;
+
+	message_delta_header header;
+	header.magic = kMessageDeltaMagic;
+	header.base_size = baseReader.FlattenedSize();
+	header.base_checksum = crc32c(0, base, header.base_size);
+	header.result_size = rebuilt.size();
+	header.result_checksum = crc32c(0, rebuilt.data(), rebuilt.size());
+	memcpy(delta.data(), &header, sizeof(header));
+	return B_OK;
+}
+
+status_t
+apply_message_delta(const void* base, size_t baseSize, const void* delta,
+	size_t deltaSize, std::vector<uint8>& result, bool verifyBase)
+{
+	message_delta_header header;
+	if(deltaSize < sizeof(header))
+		return B_BAD_DATA;
+	memcpy(&header, delta, sizeof(header));
+	if(header.magic != kMessageDeltaMagic) {
+		return header.magic == (uint32)B_SWAP_INT32(kMessageDeltaMagic)
+			? B_NOT_SUPPORTED : B_BAD_TYPE;
+	}
+
+	FlatMessageReader reader(base, baseSize);
+	if(reader.InitCheck() != B_OK)
+		return reader.InitCheck();
+	if(verifyBase && (reader.FlattenedSize() != header.base_size
+			|| crc32c(0, base, header.base_size) != header.base_checksum))
+		return B_MISMATCHED_VALUES;
+
+	result.clear();
+	result.reserve(header.result_size);
+	DeltaCursor cursor(static_cast<const uint8*>(delta) + sizeof(header),
+		deltaSize - sizeof(header));
+	status_t status = apply_message(reader, cursor, 0, result);
+	if(status == B_OK && (!cursor.AtEnd()
+			|| result.size() != header.result_size
+			|| crc32c(0, result.data(), result.size())
+				!= header.result_checksum))
+		status = B_BAD_DATA;
+	return status;
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef __MESSAGE_DELTA_H__
+#define __MESSAGE_DELTA_H__
+
+#include <SupportDefs.h>
+#include <vector>
+
+static const uint32 kMessageDeltaMagic = 'KDP1';
+
+/*	Start of a patch between two versions of a flattened message. The
+	checksums are CRC32C of the flattened messages, so that a patch is
+	not applied to another base and its result can be trusted.
+
+	The edits follow, one list for every message that changed, nested
+	ones included. Each gives the what of the new version and the fields
+	in their new order: runs of fields taken over from the base as they
+	are, base fields with some of their items replaced, patched, removed
+	from the end or appended, and new fields. Base fields no edit refers
+	to are gone. Counts, indices and lengths are unsigned LEB128, the
+	rest is in host byte order like the items of a native message, so a
+	patch applies on hosts of the byte order it was made on.
+*/
+struct message_delta_header {
+	uint32		magic;
+	uint32		base_checksum;
+	uint32		base_size;
+	uint32		result_checksum;
+	uint32		result_size;
+} _PACKED;
+
+bool		is_message_delta(const void* data, size_t size);
+
+/*	Both messages must be native flattened messages, bytes that follow
+	them are not looked at. Nested messages are patched rather than
+	replaced when that makes the patch smaller.
+*/
+status_t	create_message_delta(const void* base, size_t baseSize,
+				const void* result, size_t resultSize,
+				std::vector<uint8>& delta);
+
+/*	Reads the patch front to back and builds the new version as it goes:
+	unchanged fields of the base are copied as a whole, only the edited
+	ones are taken apart. B_MISMATCHED_VALUES when the patch was made
+	for another base, unless verifyBase is false; the result is always
+	checked.
+*/
+status_t	apply_message_delta(const void* base, size_t baseSize,
+				const void* delta, size_t deltaSize,
+				std::vector<uint8>& result, bool verifyBase = true);
+
+#endif /* __MESSAGE_DELTA_H__ */
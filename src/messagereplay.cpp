@@ -0,0 +1,346 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#include <ByteOrder.h>
+#include <DataIO.h>
+#include <Path.h>
+#include <TypeConstants.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cmath>
+
+#include "flatmessage.h"
+#include "messagereplay.h"
+
+static const size_t kWriteSize = 64 * 1024;
+static const bigtime_t kSpinTime = 500;
+static const bigtime_t kLongestSleep = 100000;
+static const bigtime_t kProgressInterval = 100000;
+static const bigtime_t kPostTimeout = 100000;
+
+MessageReplay::MessageReplay(BMessenger target)
+: fTarget(target),
+  fFD(-1),
+  fThread(-1),
+  fQuit(0),
+  fSent(0),
+  fFiltered(0),
+  fStart(0),
+  fLastDue(0),
+  fLateMax(0),
+  fLateSum(0),
+  fLateSquares(0)
+{
+}
+
+MessageReplay::~MessageReplay()
+{
+	Stop();
+}
+
+status_t
+MessageReplay::Start(const entry_ref* stream, const char* path,
+	const replay_options& options)
+{
+	if(IsRunning())
+		return B_BUSY;
+
+	// Bytes that are no message after the last record are left out
+	status_t status = fFile.SetTo(stream);
+	if(status != B_OK)
+		return status;
+	BMemoryIO io(fFile.Data(), fFile.Size());
+	status = fIndex.SetTo(&io);
+	if(status != B_OK && status != B_BAD_DATA)
+		return status;
+	if(fIndex.CountRecords() == 0)
+		return B_BAD_DATA;
+
+	status = _Connect(path);
+	if(status != B_OK)
+		return status;
+
+	fOptions = options;
+	std::sort(fOptions.whats.begin(), fOptions.whats.end());
+	fQuit = 0;
+	fThread = spawn_thread(_ReplayThread, "message replay",
+		B_URGENT_DISPLAY_PRIORITY, this);
+	if(fThread < 0) {
+		status = fThread;
+		close(fFD);
+		fFD = -1;
+		return status;
+	}
+
+	resume_thread(fThread);
+	return B_OK;
+}
+
+void
+MessageReplay::RequestStop()
+{
+	if(IsRunning())
+		atomic_set(&fQuit, 1);
+}
+
+void
+MessageReplay::Stop()
+{
+	if(!IsRunning())
+		return;
+
+	RequestStop();
+	status_t result;
+	wait_for_thread(fThread, &result);
+	fThread = -1;
+
+	close(fFD);
+	fFD = -1;
+	fIndex.Unset();
+	fFile.Unset();
+}
+
+// #pragma mark - MessageReplay::Private
+
+status_t
+MessageReplay::_ReplayThread(void* data)
+{
+	MessageReplay* replay = static_cast<MessageReplay*>(data);
+	status_t status = replay->_Replay();
+	replay->_PostProgress(MR_FINISHED, status);
+	return status;
+}
+
+status_t
+MessageReplay::_Connect(const char* path)
+{
+	// A receiver that goes away is reported by write(), not by a signal
+	signal(SIGPIPE, SIG_IGN);
+
+	struct stat st;
+	if(stat(path, &st) != 0)
+		return errno;
+
+	// Without a reader the pipe would block here, it fails instead
+	if(S_ISFIFO(st.st_mode)) {
+		fFD = open(path, O_WRONLY | O_NONBLOCK);
+		if(fFD < 0)
+			return errno == ENXIO ? B_NOT_ALLOWED : errno;
+		fcntl(fFD, F_SETFL, fcntl(fFD, F_GETFL) & ~O_NONBLOCK);
+		return B_OK;
+	}
+
+	sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	if(strlen(path) >= sizeof(address.sun_path))
+		return B_NAME_TOO_LONG;
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path, path);
+
+	fFD = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(fFD < 0)
+		return errno;
+	if(connect(fFD, (sockaddr*)&address, sizeof(address)) != 0) {
+		status_t status = errno;
+		close(fFD);
+		fFD = -1;
+		return status;
+	}
+	return B_OK;
+}
+
+status_t
+MessageReplay::_Replay()
+{
+	fSent = fFiltered = 0;
+	fLateMax = 0;
+	fLateSum = fLateSquares = 0;
+	fStart = fLastDue = system_time();
+
+	std::vector<uint8> buffer;
+	buffer.reserve(kWriteSize * 2);
+	std::vector<uint8> scratch;
+	bigtime_t offset = 0;
+	bigtime_t lastWhen = -1;
+	bigtime_t nextProgress = fStart + kProgressInterval;
+	status_t status = B_OK;
+
+	int32 count = fIndex.CountRecords();
+	for(int32 i = 0; i < count && status == B_OK; i++) {
+		if(atomic_get(&fQuit) != 0)
+			break;
+
+		const message_record& record = fIndex.RecordAt(i);
+		if(!_IsWanted(record.what)) {
+			fFiltered++;
+			continue;
+		}
+
+		// Out of order times count as no gap at all
+		bigtime_t due = system_time();
+		if(fOptions.speed > 0) {
+			bigtime_t when = _Timestamp(record, scratch);
+			if(when >= 0 && lastWhen >= 0)
+				offset += std::max((bigtime_t)0, when - lastWhen);
+			else if(fSent > 0)
+				offset += fOptions.interval;
+			if(when >= 0)
+				lastWhen = when;
+			due = fStart + (bigtime_t)(offset / fOptions.speed);
+		}
+
+		// What is due now goes out with the next write
+		if(due > system_time()) {
+			status = _Write(buffer);
+			if(status != B_OK || !_WaitUntil(due))
+				break;
+		}
+
+		bigtime_t late = system_time() - due;
+		fLateMax = std::max(fLateMax, late);
+		fLateSum += late;
+		fLateSquares += (double)late * late;
+		fLastDue = due;
+
+		uint32 size = B_HOST_TO_LENDIAN_INT32(record.size);
+		const uint8* data = fFile.Data() + record.offset;
+		buffer.insert(buffer.end(), (const uint8*)&size,
+			(const uint8*)&size + sizeof(size));
+		buffer.insert(buffer.end(), data, data + record.size);
+		fSent++;
+
+		if(buffer.size() >= kWriteSize)
+			status = _Write(buffer);
+		if(system_time() >= nextProgress) {
+			_PostProgress(MR_PROGRESS, B_OK);
+			nextProgress = system_time() + kProgressInterval;
+		}
+	}
+
+	if(status == B_OK)
+		status = _Write(buffer);
+	return status;
+}
+
+// The "when" of the message, or -1 when it has none
+bigtime_t
+MessageReplay::_Timestamp(const message_record& record,
+	std::vector<uint8>& scratch) const
+{
+	const uint8* data = fFile.Data() + record.offset;
+	size_t size = record.size;
+
+	uint32 magic = 0;
+	memcpy(&magic, data, std::min(sizeof(magic), size));
+	if(magic != kFlatMessageFormat) {
+		scratch.assign(data, data + size);
+		if(native_record(scratch) != B_OK)
+			return -1;
+		data = scratch.data();
+		size = scratch.size();
+	}
+
+	FlatMessageReader reader(data, size);
+	if(reader.InitCheck() != B_OK)
+		return -1;
+
+	int32 count = reader.CountFields();
+	for(int32 i = 0; i < count; i++) {
+		flat_field_header field;
+		if(reader.FieldAt(i, &field) != B_OK || field.type != B_INT64_TYPE)
+			continue;
+		const char* name = reader.FieldName(field);
+		if(name == NULL || strcmp(name, "when") != 0)
+			continue;
+
+		flat_item item;
+		int64 when;
+		if(reader.FirstItem(field, &item) != B_OK
+			|| item.size != sizeof(when))
+			return -1;
+		memcpy(&when, item.data, sizeof(when));
+		return when;
+	}
+	return -1;
+}
+
+bool
+MessageReplay::_IsWanted(uint32 what) const
+{
+	return fOptions.whats.empty() || std::binary_search(
+		fOptions.whats.begin(), fOptions.whats.end(), what);
+}
+
+/*	Sleeps until shortly before the time and spins for the rest, sleeping
+	alone wakes up a scheduler tick late. Long waits are cut into parts
+	so that a stop is seen in time.
+*/
+bool
+MessageReplay::_WaitUntil(bigtime_t due)
+{
+	while(due - system_time() > kSpinTime) {
+		if(atomic_get(&fQuit) != 0)
+			return false;
+		bigtime_t wake = std::min(due - kSpinTime,
+			system_time() + kLongestSleep);
+		snooze_until(wake, B_SYSTEM_TIMEBASE);
+	}
+	while(system_time() < due)
+		;
+	return true;
+}
+
+status_t
+MessageReplay::_Write(std::vector<uint8>& buffer)
+{
+	const uint8* data = buffer.data();
+	size_t left = buffer.size();
+	while(left > 0) {
+		ssize_t written = write(fFD, data, left);
+		if(written < 0 && errno == EINTR)
+			continue;
+		if(written <= 0)
+			return written < 0 ? errno : B_IO_ERROR;
+		data += written;
+		left -= written;
+	}
+
+	buffer.clear();
+	return B_OK;
+}
+
+void
+MessageReplay::_PostProgress(uint32 what, status_t status)
+{
+	bigtime_t now = system_time();
+	double late = fSent > 0 ? fLateSum / fSent : 0;
+	double variance = fSent > 0 ? fLateSquares / fSent - late * late : 0;
+
+	// The rate the schedule asked for, none when it asked for no waits
+	float requested = -1;
+	if(fOptions.speed > 0 && fSent > 1 && fLastDue > fStart)
+		requested = fSent * 1000000.0f / (fLastDue - fStart);
+	float achieved = now > fStart ? fSent * 1000000.0f / (now - fStart) : 0;
+
+	BMessage progress(what);
+	progress.AddInt64("sent", fSent);
+	progress.AddInt64("filtered", fFiltered);
+	progress.AddInt64("total", fIndex.CountRecords());
+	progress.AddFloat("requested", requested);
+	progress.AddFloat("achieved", achieved);
+	progress.AddInt64("late_mean", (int64)late);
+	progress.AddInt64("late_max", fLateMax);
+	progress.AddInt64("jitter", (int64)sqrt(std::max(0.0, variance)));
+	if(what == MR_FINISHED)
+		progress.AddInt32("status", status);
+	fTarget.SendMessage(&progress, (BHandler*)NULL, kPostTimeout);
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef __MESSAGE_REPLAY_H__
+#define __MESSAGE_REPLAY_H__
+
+#include <Entry.h>
+#include <Messenger.h>
+#include <OS.h>
+#include <vector>
+
+#include "mappedfile.h"
+#include "recordindex.h"
+
+enum {
+	MR_PROGRESS = 'mr00',	// "sent", "filtered", "total", "requested",
+							// "achieved", "late_mean", "late_max", "jitter"
+	MR_FINISHED				// the same and "status"
+};
+
+struct replay_options {
+	float			speed;		// 1 for the original timing, 0 for no waits
+	bigtime_t		interval;	// after messages that carry no "when"
+	std::vector<uint32> whats;	// only these are sent, all when empty
+};
+
+/*	Sends the records of a stream file to a Unix domain socket or named
+	pipe, framed the way MessageCapture receives them: a little endian
+	uint32 length, then the message as it was recorded. The file is
+	mapped, not read.
+
+	The timing comes from the "when" field the system puts in input and
+	other event messages, scaled by the speed. Each message is sent at
+	its time: the thread sleeps until shortly before it and spins for the
+	rest, and how late it actually went out is measured. Messages due at
+	the same time are written together.
+*/
+class MessageReplay
+{
+public:
+							MessageReplay(BMessenger target);
+							~MessageReplay();
+
+			status_t		Start(const entry_ref* stream, const char* path,
+								const replay_options& options);
+			// Returns at once, MR_FINISHED follows
+			void			RequestStop();
+			void			Stop();
+			bool			IsRunning() const { return fThread >= 0; }
+private:
+	static	status_t		_ReplayThread(void* data);
+
+			status_t		_Connect(const char* path);
+			status_t		_Replay();
+			bigtime_t		_Timestamp(const message_record& record,
+								std::vector<uint8>& scratch) const;
+			bool			_IsWanted(uint32 what) const;
+			bool			_WaitUntil(bigtime_t due);
+			status_t		_Write(std::vector<uint8>& buffer);
+			void			_PostProgress(uint32 what, status_t status);
+private:
+			BMessenger		fTarget;
+			MappedFile		fFile;
+			RecordIndex		fIndex;
+			replay_options	fOptions;
+			int				fFD;
+			thread_id		fThread;
+			int32			fQuit;
+
+			// Only touched by the replay thread once it runs
+			int64			fSent;
+			int64			fFiltered;
+			bigtime_t		fStart;
+			bigtime_t		fLastDue;
+			bigtime_t		fLateMax;
+			double			fLateSum;
+			double			fLateSquares;
+};
+
+#endif /* __MESSAGE_REPLAY_H__ */
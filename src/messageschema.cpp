@@ -0,0 +1,683 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#include <string.h>
+#include <algorithm>
+
+#include "flatmessage.h"
+#include "messageschema.h"
+#include "numericitem.h"
+
+static const char* kRangeDash = " \xE2\x80\x93 ";
+
+static int32
+values_of(item_storage storage)
+{
+	switch(storage) {
+		case STORAGE_INT8:
+		case STORAGE_INT16:
+		case STORAGE_INT32:
+		case STORAGE_INT64:
+			return SCHEMA_VALUES_SIGNED;
+		case STORAGE_UINT8:
+		case STORAGE_UINT16:
+		case STORAGE_UINT32:
+		case STORAGE_UINT64:
+			return SCHEMA_VALUES_UNSIGNED;
+		case STORAGE_FLOAT:
+		case STORAGE_DOUBLE:
+			return SCHEMA_VALUES_FLOAT;
+		default:
+			return SCHEMA_VALUES_NONE;
+	}
+}
+
+// The items of a message may sit at any alignment
+static schema_value
+read_value(item_storage storage, const uint8* data)
+{
+	schema_value value;
+	switch(storage) {
+		case STORAGE_INT8:
+			value.i = *(const int8*)data;
+			break;
+		case STORAGE_INT16:
+		{
+			int16 number;
+			memcpy(&number, data, sizeof(number));
+			value.i = number;
+			break;
+		}
+		case STORAGE_INT32:
+		{
+			int32 number;
+			memcpy(&number, data, sizeof(number));
+			value.i = number;
+			break;
+		}
+		case STORAGE_INT64:
+			memcpy(&value.i, data, sizeof(value.i));
+			break;
+		case STORAGE_UINT8:
+			value.u = *data;
+			break;
+		case STORAGE_UINT16:
+		{
+			uint16 number;
+			memcpy(&number, data, sizeof(number));
+			value.u = number;
+			break;
+		}
+		case STORAGE_UINT32:
+		{
+			uint32 number;
+			memcpy(&number, data, sizeof(number));
+			value.u = number;
+			break;
+		}
+		case STORAGE_UINT64:
+			memcpy(&value.u, data, sizeof(value.u));
+			break;
+		case STORAGE_FLOAT:
+		{
+			float number;
+			memcpy(&number, data, sizeof(number));
+			value.f = number;
+			break;
+		}
+		case STORAGE_DOUBLE:
+			memcpy(&value.f, data, sizeof(value.f));
+			break;
+		default:
+			value.u = 0;
+			break;
+	}
+	return value;
+}
+
+static int
+compare_values(int32 values, const schema_value& a, const schema_value& b)
+{
+	switch(values) {
+		case SCHEMA_VALUES_SIGNED:
+			return a.i < b.i ? -1 : a.i > b.i ? 1 : 0;
+		case SCHEMA_VALUES_UNSIGNED:
+			return a.u < b.u ? -1 : a.u > b.u ? 1 : 0;
+		case SCHEMA_VALUES_FLOAT:
+			return a.f < b.f ? -1 : a.f > b.f ? 1 : 0;
+		default:
+			return 0;
+	}
+}
+
+static BString
+value_text(int32 values, const schema_value& value)
+{
+	BString text;
+	switch(values) {
+		case SCHEMA_VALUES_SIGNED:
+			text.SetToFormat("%" B_PRId64, value.i);
+			break;
+		case SCHEMA_VALUES_UNSIGNED:
+			text.SetToFormat("%" B_PRIu64, value.u);
+			break;
+		case SCHEMA_VALUES_FLOAT:
+			text.SetToFormat("%g", value.f);
+			break;
+	}
+	return text;
+}
+
+static BString
+range_text(uint32 min, uint32 max)
+{
+	BString text;
+	text << min;
+	if(max != min)
+		text << kRangeDash << max;
+	return text;
+}
+
+static schema_type
+new_type(type_code code)
+{
+	schema_type type;
+	type.type = code;
+	type.occurrences = 0;
+	type.min_count = UINT32_MAX;
+	type.max_count = 0;
+	type.min_size = UINT32_MAX;
+	type.max_size = 0;
+	type.values = SCHEMA_VALUES_NONE;
+	type.min_value.u = 0;
+	type.max_value.u = 0;
+	type.nested = -1;
+	return type;
+}
+
+static int32
+type_index(schema_field& field, type_code code)
+{
+	for(size_t i = 0; i < field.types.size(); i++) {
+		if(field.types[i].type == code)
+			return i;
+	}
+	field.types.push_back(new_type(code));
+	return field.types.size() - 1;
+}
+
+static void
+widen_values(schema_type& type, int32 values, const schema_value& value)
+{
+	// Items of one type always hold the same kind of number
+	if(type.values == SCHEMA_VALUES_NONE) {
+		type.values = values;
+		type.min_value = value;
+		type.max_value = value;
+		return;
+	}
+	if(type.values != values)
+		return;
+
+	if(compare_values(values, value, type.min_value) < 0)
+		type.min_value = value;
+	if(compare_values(values, value, type.max_value) > 0)
+		type.max_value = value;
+}
+
+static void
+add_whats(schema_node& node, const uint32* whats, size_t count)
+{
+	for(size_t i = 0; i < count
+		&& (int32)node.whats.size() < kMaxSchemaWhats; i++) {
+		if(std::find(node.whats.begin(), node.whats.end(), whats[i])
+			== node.whats.end())
+			node.whats.push_back(whats[i]);
+	}
+}
+
+MessageSchema::MessageSchema()
+{
+	MakeEmpty();
+}
+
+void
+MessageSchema::MakeEmpty()
+{
+	fNodes.clear();
+	_NewNode();
+}
+
+status_t
+MessageSchema::AddMessage(const void* data, size_t size)
+{
+	return _Add(0, data, size, 0);
+}
+
+void
+MessageSchema::Merge(const MessageSchema& other)
+{
+	if(&other != this)
+		_Merge(0, other, 0);
+}
+
+uint64
+MessageSchema::CountMessages() const
+{
+	return fNodes[0].messages;
+}
+
+bool
+MessageSchema::IsOptional(const schema_node& node, const schema_field& field)
+{
+	return field.occurrences < node.messages;
+}
+
+status_t
+MessageSchema::Check(const void* data, size_t size,
+	BMessage* deviations) const
+{
+	std::vector<location> path;
+	return _Check(0, data, size, path, deviations);
+}
+
+status_t
+MessageSchema::Archive(BMessage* archive) const
+{
+	return _Archive(0, archive);
+}
+
+status_t
+MessageSchema::SetTo(const BMessage* archive)
+{
+	MakeEmpty();
+	status_t status = _Unarchive(0, archive, 0);
+	if(status != B_OK)
+		MakeEmpty();
+	return status;
+}
+
+BString
+MessageSchema::CountText(const schema_type& type)
+{
+	if(type.occurrences == 0)
+		return BString();
+	return range_text(type.min_count, type.max_count);
+}
+
+BString
+MessageSchema::SizeText(const schema_type& type)
+{
+	if(type.max_size < type.min_size)
+		return BString();
+
+	// Strings are counted without their terminator
+	if(type.type == B_STRING_TYPE && type.min_size > 0)
+		return range_text(type.min_size - 1, type.max_size - 1);
+	return range_text(type.min_size, type.max_size);
+}
+
+BString
+MessageSchema::ValueText(const schema_type& type)
+{
+	BString text = value_text(type.values, type.min_value);
+	if(compare_values(type.values, type.min_value, type.max_value) != 0)
+		text << kRangeDash << value_text(type.values, type.max_value);
+	return text;
+}
+
+// #pragma mark - MessageSchema::Private
+
+int32
+MessageSchema::_NewNode()
+{
+	schema_node node;
+	node.messages = 0;
+	fNodes.push_back(node);
+	return fNodes.size() - 1;
+}
+
+int32
+MessageSchema::_FieldFor(int32 node, const char* name)
+{
+	schema_node& current = fNodes[node];
+	std::pair<std::unordered_map<std::string, int32>::iterator, bool> found
+		= current.index.insert(std::make_pair(std::string(name),
+			(int32)current.fields.size()));
+	if(found.second) {
+		schema_field field;
+		field.name = name;
+		field.occurrences = 0;
+		current.fields.push_back(field);
+	}
+	return found.first->second;
+}
+
+status_t
+MessageSchema::_Add(int32 node, const void* data, size_t size, int32 depth)
+{
+	if(depth >= kMaxSchemaNesting)
+		return B_BAD_DATA;
+
+	FlatMessageReader reader(data, size);
+	if(reader.InitCheck() != B_OK)
+		return reader.InitCheck();
+
+	uint32 what = reader.Header().what;
+	fNodes[node].messages++;
+	add_whats(fNodes[node], &what, 1);
+
+	// Nodes are added while members are walked, so everything is looked
+	// up again by index after a nested message. Messages of one kind
+	// mostly list their fields in the same order, the field after the
+	// last one is tried before the name is hashed.
+	int32 nextField = 0;
+	for(int32 i = 0; i < reader.CountFields(); i++) {
+		flat_field_header header;
+		status_t status = reader.FieldAt(i, &header);
+		if(status != B_OK)
+			return status;
+
+		const char* name = reader.FieldName(header);
+		if(!name)
+			return B_BAD_DATA;
+
+		std::vector<schema_field>& fields = fNodes[node].fields;
+		int32 fieldIndex = nextField;
+		if(fieldIndex >= (int32)fields.size()
+			|| fields[fieldIndex].name != name)
+			fieldIndex = _FieldFor(node, name);
+		nextField = fieldIndex + 1;
+
+		schema_field& field = fNodes[node].fields[fieldIndex];
+		field.occurrences++;
+
+		int32 typeIndex = type_index(field, header.type);
+		schema_type* type = &field.types[typeIndex];
+		type->occurrences++;
+		type->min_count = std::min(type->min_count, header.count);
+		type->max_count = std::max(type->max_count, header.count);
+
+		int32 nested = type->nested;
+		if(header.type == B_MESSAGE_TYPE && nested < 0) {
+			nested = _NewNode();
+			fNodes[node].fields[fieldIndex].types[typeIndex].nested = nested;
+		}
+
+		flat_item item;
+		for(status = reader.FirstItem(header, &item); status == B_OK;
+			status = reader.NextItem(header, &item)) {
+			type = &fNodes[node].fields[fieldIndex].types[typeIndex];
+			type->min_size = std::min(type->min_size, item.size);
+			type->max_size = std::max(type->max_size, item.size);
+
+			item_storage storage = storage_of(header.type, item.size);
+			int32 values = values_of(storage);
+			if(values != SCHEMA_VALUES_NONE)
+				widen_values(*type, values, read_value(storage, item.data));
+
+			if(nested >= 0) {
+				status_t addStatus = _Add(nested, item.data, item.size,
+					depth + 1);
+				if(addStatus != B_OK)
+					return addStatus;
+			}
+		}
+
+		if(status != B_BAD_INDEX)
+			return status;
+	}
+
+	return B_OK;
+}
+
+void
+MessageSchema::_Merge(int32 node, const MessageSchema& other, int32 otherNode)
+{
+	const schema_node& source = other.fNodes[otherNode];
+	fNodes[node].messages += source.messages;
+	add_whats(fNodes[node], source.whats.data(), source.whats.size());
+
+	for(size_t i = 0; i < source.fields.size(); i++) {
+		const schema_field& sourceField = source.fields[i];
+		int32 fieldIndex = _FieldFor(node, sourceField.name.c_str());
+		fNodes[node].fields[fieldIndex].occurrences += sourceField.occurrences;
+
+		for(size_t j = 0; j < sourceField.types.size(); j++) {
+			const schema_type& sourceType = sourceField.types[j];
+			int32 typeIndex = type_index(fNodes[node].fields[fieldIndex],
+				sourceType.type);
+
+			schema_type& type = fNodes[node].fields[fieldIndex].types[typeIndex];
+			type.occurrences += sourceType.occurrences;
+			type.min_count = std::min(type.min_count, sourceType.min_count);
+			type.max_count = std::max(type.max_count, sourceType.max_count);
+			type.min_size = std::min(type.min_size, sourceType.min_size);
+			type.max_size = std::max(type.max_size, sourceType.max_size);
+			if(sourceType.values != SCHEMA_VALUES_NONE) {
+				widen_values(type, sourceType.values, sourceType.min_value);
+				widen_values(type, sourceType.values, sourceType.max_value);
+			}
+
+			if(sourceType.nested < 0)
+				continue;
+
+			int32 nested = type.nested;
+			if(nested < 0) {
+				nested = _NewNode();
+				fNodes[node].fields[fieldIndex].types[typeIndex].nested
+					= nested;
+			}
+			_Merge(nested, other, sourceType.nested);
+		}
+	}
+}
+
+status_t
+MessageSchema::_Check(int32 node, const void* data, size_t size,
+	std::vector<location>& path, BMessage* deviations) const
+{
+	if((int32)path.size() >= kMaxSchemaNesting)
+		return B_BAD_DATA;
+
+	FlatMessageReader reader(data, size);
+	if(reader.InitCheck() != B_OK)
+		return reader.InitCheck();
+
+	const schema_node& schema = fNodes[node];
+	std::vector<bool> seen(schema.fields.size(), false);
+
+	for(int32 i = 0; i < reader.CountFields(); i++) {
+		flat_field_header header;
+		status_t status = reader.FieldAt(i, &header);
+		if(status != B_OK)
+			return status;
+
+		const char* name = reader.FieldName(header);
+		if(!name)
+			return B_BAD_DATA;
+
+		BMessage deviation;
+		for(size_t j = 0; j < path.size(); j++) {
+			deviation.AddString("path", path[j].name);
+			deviation.AddInt32("member", path[j].member);
+		}
+		deviation.AddString("name", name);
+
+		std::unordered_map<std::string, int32>::const_iterator found
+			= schema.index.find(name);
+		if(found == schema.index.end()) {
+			deviation.AddInt32("kind", SCHEMA_UNKNOWN_FIELD);
+			deviation.AddUInt32("found_type", header.type);
+			deviations->AddMessage("deviation", &deviation);
+			continue;
+		}
+
+		const schema_field& field = schema.fields[found->second];
+		seen[found->second] = true;
+
+		const schema_type* type = NULL;
+		for(size_t j = 0; j < field.types.size(); j++) {
+			if(field.types[j].type == header.type)
+				type = &field.types[j];
+		}
+		if(type == NULL) {
+			deviation.AddInt32("kind", SCHEMA_TYPE_MISMATCH);
+			deviation.AddUInt32("found_type", header.type);
+			for(size_t j = 0; j < field.types.size(); j++)
+				deviation.AddUInt32("expected_type", field.types[j].type);
+			deviations->AddMessage("deviation", &deviation);
+			continue;
+		}
+
+		if(header.count < type->min_count || header.count > type->max_count) {
+			BMessage count(deviation);
+			count.AddInt32("kind", SCHEMA_COUNT_OUT_OF_RANGE);
+			count.AddString("found", BString() << header.count);
+			count.AddString("expected", CountText(*type));
+			deviations->AddMessage("deviation", &count);
+		}
+
+		// One item out of range is enough to flag the field
+		flat_item item;
+		if(type->values != SCHEMA_VALUES_NONE) {
+			for(status = reader.FirstItem(header, &item); status == B_OK;
+				status = reader.NextItem(header, &item)) {
+				item_storage storage = storage_of(header.type, item.size);
+				if(values_of(storage) != type->values)
+					continue;
+
+				schema_value value = read_value(storage, item.data);
+				if(compare_values(type->values, value, type->min_value) >= 0
+					&& compare_values(type->values, value,
+						type->max_value) <= 0)
+					continue;
+
+				deviation.AddInt32("kind", SCHEMA_VALUE_OUT_OF_RANGE);
+				deviation.AddInt32("item", item.index);
+				deviation.AddString("found", value_text(type->values, value));
+				deviation.AddString("expected", ValueText(*type));
+				deviations->AddMessage("deviation", &deviation);
+				break;
+			}
+		}
+
+		if(header.type != B_MESSAGE_TYPE || type->nested < 0)
+			continue;
+
+		for(status = reader.FirstItem(header, &item); status == B_OK;
+			status = reader.NextItem(header, &item)) {
+			location step = { name, item.index };
+			path.push_back(step);
+			status_t checkStatus = _Check(type->nested, item.data, item.size,
+				path, deviations);
+			path.pop_back();
+			if(checkStatus != B_OK)
+				return checkStatus;
+		}
+		if(status != B_BAD_INDEX)
+			return status;
+	}
+
+	for(size_t i = 0; i < schema.fields.size(); i++) {
+		if(seen[i] || IsOptional(schema, schema.fields[i]))
+			continue;
+
+		BMessage deviation;
+		for(size_t j = 0; j < path.size(); j++) {
+			deviation.AddString("path", path[j].name);
+			deviation.AddInt32("member", path[j].member);
+		}
+		deviation.AddString("name", schema.fields[i].name.c_str());
+		deviation.AddInt32("kind", SCHEMA_MISSING_FIELD);
+		for(size_t j = 0; j < schema.fields[i].types.size(); j++)
+			deviation.AddUInt32("expected_type", schema.fields[i].types[j].type);
+		deviations->AddMessage("deviation", &deviation);
+	}
+
+	return B_OK;
+}
+
+status_t
+MessageSchema::_Archive(int32 node, BMessage* archive) const
+{
+	const schema_node& schema = fNodes[node];
+	status_t status = archive->AddUInt64("messages", schema.messages);
+	for(size_t i = 0; status == B_OK && i < schema.whats.size(); i++)
+		status = archive->AddUInt32("what", schema.whats[i]);
+
+	for(size_t i = 0; status == B_OK && i < schema.fields.size(); i++) {
+		const schema_field& field = schema.fields[i];
+		BMessage fieldArchive;
+		fieldArchive.AddString("name", field.name.c_str());
+		fieldArchive.AddUInt64("occurrences", field.occurrences);
+
+		for(size_t j = 0; status == B_OK && j < field.types.size(); j++) {
+			const schema_type& type = field.types[j];
+			BMessage typeArchive;
+			typeArchive.AddUInt32("type", type.type);
+			typeArchive.AddUInt64("occurrences", type.occurrences);
+			typeArchive.AddUInt32("min_count", type.min_count);
+			typeArchive.AddUInt32("max_count", type.max_count);
+			typeArchive.AddUInt32("min_size", type.min_size);
+			typeArchive.AddUInt32("max_size", type.max_size);
+			typeArchive.AddInt32("values", type.values);
+			switch(type.values) {
+				case SCHEMA_VALUES_SIGNED:
+					typeArchive.AddInt64("min_value", type.min_value.i);
+					typeArchive.AddInt64("max_value", type.max_value.i);
+					break;
+				case SCHEMA_VALUES_UNSIGNED:
+					typeArchive.AddUInt64("min_value", type.min_value.u);
+					typeArchive.AddUInt64("max_value", type.max_value.u);
+					break;
+				case SCHEMA_VALUES_FLOAT:
+					typeArchive.AddDouble("min_value", type.min_value.f);
+					typeArchive.AddDouble("max_value", type.max_value.f);
+					break;
+			}
+			if(type.nested >= 0) {
+				BMessage nested;
+				status = _Archive(type.nested, &nested);
+				if(status == B_OK)
+					status = typeArchive.AddMessage("schema", &nested);
+			}
+			if(status == B_OK)
+				status = fieldArchive.AddMessage("type", &typeArchive);
+		}
+
+		if(status == B_OK)
+			status = archive->AddMessage("field", &fieldArchive);
+	}
+
+	return status;
+}
+
+status_t
+MessageSchema::_Unarchive(int32 node, const BMessage* archive, int32 depth)
+{
+	if(depth >= kMaxSchemaNesting)
+		return B_BAD_DATA;
+
+	if(archive->FindUInt64("messages", &fNodes[node].messages) != B_OK)
+		return B_BAD_DATA;
+
+	uint32 what;
+	for(int32 i = 0; archive->FindUInt32("what", i, &what) == B_OK; i++)
+		add_whats(fNodes[node], &what, 1);
+
+	BMessage fieldArchive;
+	for(int32 i = 0; archive->FindMessage("field", i, &fieldArchive) == B_OK;
+		i++) {
+		const char* name;
+		if(fieldArchive.FindString("name", &name) != B_OK)
+			return B_BAD_DATA;
+
+		int32 fieldIndex = _FieldFor(node, name);
+		fNodes[node].fields[fieldIndex].occurrences
+			= fieldArchive.GetUInt64("occurrences", 0);
+
+		BMessage typeArchive;
+		for(int32 j = 0; fieldArchive.FindMessage("type", j, &typeArchive)
+			== B_OK; j++) {
+			schema_type type = new_type(typeArchive.GetUInt32("type",
+				B_ANY_TYPE));
+			type.occurrences = typeArchive.GetUInt64("occurrences", 0);
+			type.min_count = typeArchive.GetUInt32("min_count", UINT32_MAX);
+			type.max_count = typeArchive.GetUInt32("max_count", 0);
+			type.min_size = typeArchive.GetUInt32("min_size", UINT32_MAX);
+			type.max_size = typeArchive.GetUInt32("max_size", 0);
+			type.values = typeArchive.GetInt32("values", SCHEMA_VALUES_NONE);
+			switch(type.values) {
+				case SCHEMA_VALUES_SIGNED:
+					type.min_value.i = typeArchive.GetInt64("min_value", 0);
+					type.max_value.i = typeArchive.GetInt64("max_value", 0);
+					break;
+				case SCHEMA_VALUES_UNSIGNED:
+					type.min_value.u = typeArchive.GetUInt64("min_value", 0);
+					type.max_value.u = typeArchive.GetUInt64("max_value", 0);
+					break;
+				case SCHEMA_VALUES_FLOAT:
+					type.min_value.f = typeArchive.GetDouble("min_value", 0);
+					type.max_value.f = typeArchive.GetDouble("max_value", 0);
+					break;
+				default:
+					type.values = SCHEMA_VALUES_NONE;
+					break;
+			}
+
+			BMessage nested;
+			if(typeArchive.FindMessage("schema", &nested) == B_OK) {
+				type.nested = _NewNode();
+				status_t status = _Unarchive(type.nested, &nested, depth + 1);
+				if(status != B_OK)
+					return status;
+			}
+			fNodes[node].fields[fieldIndex].types.push_back(type);
+		}
+	}
+
+	return B_OK;
+}
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef __MESSAGE_SCHEMA_H__
+#define __MESSAGE_SCHEMA_H__
+
+#include <Message.h>
+#include <String.h>
+#include <SupportDefs.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+static const int32 kMaxSchemaNesting = 64;
+static const int32 kMaxSchemaWhats = 8;
+
+// Which member of schema_value holds the range of a type
+enum {
+	SCHEMA_VALUES_NONE = 0,
+	SCHEMA_VALUES_SIGNED,
+	SCHEMA_VALUES_UNSIGNED,
+	SCHEMA_VALUES_FLOAT
+};
+
+// What Check() found wrong with a field, in "kind"; the last two only
+// come from SchemaValidator
+enum {
+	SCHEMA_UNKNOWN_FIELD = 0,
+	SCHEMA_MISSING_FIELD,
+	SCHEMA_TYPE_MISMATCH,
+	SCHEMA_COUNT_OUT_OF_RANGE,
+	SCHEMA_VALUE_OUT_OF_RANGE,
+	SCHEMA_SIZE_OUT_OF_RANGE,
+	SCHEMA_WHAT_MISMATCH
+};
+
+union schema_value {
+	int64		i;
+	uint64		u;
+	double		f;
+};
+
+/*	What was seen of a field under one type: how many items it had, how
+	large they were and, for numbers, the smallest and largest value.
+*/
+struct schema_type {
+	type_code	type;
+	uint64		occurrences;	// messages that had the field with this type
+	uint32		min_count;
+	uint32		max_count;
+	uint32		min_size;		// of a single item, as stored
+	uint32		max_size;
+	int32		values;
+	schema_value min_value;
+	schema_value max_value;
+	int32		nested;			// node of the members, B_MESSAGE_TYPE only
+};
+
+struct schema_field {
+	std::string	name;
+	uint64		occurrences;	// messages that had the field at all
+	std::vector<schema_type> types;
+};
+
+// Everything seen of the messages at one place in the hierarchy
+struct schema_node {
+	uint64		messages;
+	std::vector<uint32> whats;	// the first few different ones
+	std::vector<schema_field> fields;	// in the order they were first seen
+	std::unordered_map<std::string, int32> index;
+};
+
+/*	Schema inferred from any number of flattened messages. Each one is
+	folded into the counts as it is added and not kept, so a schema only
+	grows with the number of different fields. Members of a message field
+	share one node, whatever their index, and a field that was not in
+	every message of its node is optional.
+
+	Schemas built on separate threads can be merged afterwards; the
+	result is the same as if all of the messages had gone into one.
+*/
+class MessageSchema
+{
+public:
+							MessageSchema();
+
+			void			MakeEmpty();
+
+			// A native message; what was read of a damaged one is kept
+			status_t		AddMessage(const void* data, size_t size);
+			void			Merge(const MessageSchema& other);
+
+			uint64			CountMessages() const;
+			const schema_node& Root() const { return fNodes[0]; }
+			const schema_node& NodeAt(int32 index) const
+								{ return fNodes[index]; }
+	static	bool			IsOptional(const schema_node& node,
+								const schema_field& field);
+
+			/*	Adds a "deviation" message for every field of a native
+				message that does not fit: its location as "path" and
+				"member" pairs down to the message and "name", the
+				"kind" of deviation and the "found" and "expected" values
+				as text.
+			*/
+			status_t		Check(const void* data, size_t size,
+								BMessage* deviations) const;
+
+			status_t		Archive(BMessage* archive) const;
+			status_t		SetTo(const BMessage* archive);
+
+	// Ranges as text, "" when nothing was seen
+	static	BString			CountText(const schema_type& type);
+	static	BString			SizeText(const schema_type& type);
+	static	BString			ValueText(const schema_type& type);
+private:
+	struct location {
+		const char*		name;
+		int32			member;
+	};
+
+			int32			_NewNode();
+			int32			_FieldFor(int32 node, const char* name);
+			status_t		_Add(int32 node, const void* data, size_t size,
+								int32 depth);
+			void			_Merge(int32 node, const MessageSchema& other,
+								int32 otherNode);
+			status_t		_Check(int32 node, const void* data, size_t size,
+								std::vector<location>& path,
+								BMessage* deviations) const;
+			status_t		_Archive(int32 node, BMessage* archive) const;
+			status_t		_Unarchive(int32 node, const BMessage* archive,
+								int32 depth);
+private:
+	std::vector<schema_node> fNodes;	// the root first
+};
+
+#endif /* __MESSAGE_SCHEMA_H__ */
@@ -0,0 +1,453 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#include <Debug.h>
+#include <cstring>
+#include "flatmessage.h"
+#include "messagetree.h"
+
+MessageTree::MessageTree(DocumentArena& arena)
+: fArena(arena),
+  fRoot(NULL),
+  fCountFields(0)
+{
+}
+
+status_t
+MessageTree::SetTo(BMessage* root)
+{
+	Unset();
+	if(!root)
+		return B_BAD_VALUE;
+
+	fRoot = _Build(root, NULL, 0);
+	return fRoot ? B_OK : B_NO_MEMORY;
+}
+
+void
+MessageTree::Unset()
+{
+	// The nodes belong to the arena, its owner releases them
+	fRoot = NULL;
+	fCountFields = 0;
+	fFreeMembers.clear();
+}
+
+ssize_t
+MessageTree::FlattenedSize(TreeMessage* message)
+{
+	if(message->size >= 0)
+		return message->size;
+
+	ssize_t size = sizeof(flat_message_header);
+	for(int32 i = 0; i < message->countFields; i++) {
+		ssize_t fieldSize = FlattenedSize(message->fields[i]);
+		if(fieldSize < 0)
+			return fieldSize;
+		size += fieldSize;
+	}
+
+	// Debug builds check the sum at every level against BMessage itself,
+	// nested members included
+	ASSERT(size == message->message->FlattenedSize());
+
+	message->size = size;
+	return size;
+}
+
+ssize_t
+MessageTree::FlattenedSize(TreeField* field)
+{
+	if(field->size >= 0)
+		return field->size;
+
+	const BMessage* message = field->owner->message;
+	type_code type;
+	bool fixedSize = true;
+	if(message->GetInfo(field->name, &type, &fixedSize) != B_OK)
+		return B_NAME_NOT_FOUND;
+
+	// The name is stored with its terminator, variable sized items carry
+	// a 32 bit length in front of each of them
+	ssize_t size = sizeof(flat_field_header) + strlen(field->name) + 1;
+	if(!fixedSize)
+		size += field->count * sizeof(uint32);
+
+	for(int32 i = 0; i < field->count; i++) {
+		if(field->members) {
+			ssize_t memberSize = FlattenedSize(field->members[i]);
+			if(memberSize < 0)
+				return memberSize;
+			size += memberSize;
+			continue;
+		}
+
+		const void* data;
+		ssize_t numBytes;
+		status_t status = message->FindData(field->name, field->type, i,
+			&data, &numBytes);
+		if(status != B_OK)
+			return status;
+		size += numBytes;
+	}
+
+	field->size = size;
+	return size;
+}
+
+void
+MessageTree::Invalidate(TreeField* field)
+{
+	if(!field)
+		return;
+
+	// Member copies above the field are stale after an edit, refresh them
+	// from the root down before dropping the sizes on the way up
+	_Resync(field->owner);
+
+	field->size = -1;
+	_InvalidateSizes(field->owner);
+}
+
+TreeField*
+MessageTree::FindField(TreeMessage* message, const char* name)
+{
+	if(!message || !name)
+		return NULL;
+
+	for(int32 i = 0; i < message->countFields; i++) {
+		if(strcmp(message->fields[i]->name, name) == 0)
+			return message->fields[i];
+	}
+	return NULL;
+}
+
+TreeMessage*
+MessageTree::FindMember(TreeMessage* message, const char* name, int32 member)
+{
+	TreeField* field = FindField(message, name);
+	if(!field || !field->members || member < 0 || member >= field->count)
+		return NULL;
+
+	return field->members[member];
+}
+
+status_t
+MessageTree::AddField(TreeMessage* message, const char* name,
+	TreeField** _field)
+{
+	if(!message || !name || !_field)
+		return B_BAD_VALUE;
+	if(FindField(message, name))
+		return B_NAME_IN_USE;
+
+	_Resync(message);
+
+	type_code type;
+	if(message->message->GetInfo(name, &type) != B_OK)
+		return B_NAME_NOT_FOUND;
+
+	// New names are appended by BMessage, but look the index up anyway
+	char* fieldName;
+	int32 index = 0;
+	while(message->message->GetInfo(B_ANY_TYPE, index, &fieldName, &type)
+		== B_OK && strcmp(fieldName, name) != 0)
+		index++;
+	if(index > message->countFields)
+		return B_BAD_INDEX;
+
+	TreeField** fields = static_cast<TreeField**>(
+		fArena.Allocate(sizeof(TreeField*) * (message->countFields + 1)));
+	if(!fields)
+		return B_NO_MEMORY;
+
+	TreeField* field;
+	status_t status = _BuildField(message, index, &field);
+	if(status != B_OK)
+		return status;
+
+	memcpy(fields, message->fields, sizeof(TreeField*) * index);
+	memcpy(fields + index + 1, message->fields + index,
+		sizeof(TreeField*) * (message->countFields - index));
+	fields[index] = field;
+	fArena.Recycle(message->fields, sizeof(TreeField*) * message->countFields);
+	message->fields = fields;
+	message->countFields++;
+	for(int32 i = index + 1; i < message->countFields; i++)
+		fields[i]->index = i;
+
+	_InvalidateSizes(message);
+	*_field = field;
+	return B_OK;
+}
+
+status_t
+MessageTree::UpdateField(TreeField* field)
+{
+	if(!field)
+		return B_BAD_VALUE;
+
+	_Resync(field->owner);
+
+	type_code type;
+	int32 count;
+	if(field->owner->message->GetInfo(field->name, &type, &count) != B_OK)
+		return B_NAME_NOT_FOUND;
+
+	// Members are decoded again as a whole, their indexes may have moved
+	fCountFields -= _CountFields(field) - 1;
+	_RecycleMembers(field);
+	field->type = type;
+	field->count = count;
+	field->size = -1;
+	status_t status = _BuildMembers(field);
+
+	_InvalidateSizes(field->owner);
+	return status;
+}
+
+status_t
+MessageTree::RemoveField(TreeField* field)
+{
+	if(!field)
+		return B_BAD_VALUE;
+
+	TreeMessage* message = field->owner;
+	int32 index = field->index;
+	if(index < 0 || index >= message->countFields
+		|| message->fields[index] != field)
+		return B_BAD_INDEX;
+
+	_Resync(message);
+
+	fCountFields -= _CountFields(field);
+	message->countFields--;
+	memmove(message->fields + index, message->fields + index + 1,
+		sizeof(TreeField*) * (message->countFields - index));
+	for(int32 i = index; i < message->countFields; i++)
+		message->fields[i]->index = i;
+	_RecycleField(field);
+
+	_InvalidateSizes(message);
+	return B_OK;
+}
+
+status_t
+MessageTree::ReplaceFields(TreeMessage* message)
+{
+	if(!message)
+		return B_BAD_VALUE;
+
+	_Resync(message);
+
+	fCountFields -= _CountFields(message);
+	_RecycleFields(message);
+	status_t status = _BuildFields(message);
+
+	_InvalidateSizes(message);
+	return status;
+}
+
+// #pragma mark - MessageTree::Private
+
+TreeMessage*
+MessageTree::_Build(BMessage* message, TreeField* parent, int32 member)
+{
+	TreeMessage* node = static_cast<TreeMessage*>(
+		fArena.Allocate(sizeof(TreeMessage)));
+	if(!node)
+		return NULL;
+
+	node->message = message;
+	node->parent = parent;
+	node->member = member;
+	node->row = NULL;
+	node->size = -1;
+	if(_BuildFields(node) != B_OK)
+		return NULL;
+
+	return node;
+}
+
+status_t
+MessageTree::_BuildFields(TreeMessage* node)
+{
+	node->countFields = node->message->CountNames(B_ANY_TYPE);
+	node->fields = static_cast<TreeField**>(
+		fArena.Allocate(sizeof(TreeField*) * node->countFields));
+	if(!node->fields && node->countFields > 0)
+		return B_NO_MEMORY;
+	if(node->fields)
+		memset(node->fields, 0, sizeof(TreeField*) * node->countFields);
+
+	int32 i = 0;
+	for(; i < node->countFields; i++) {
+		status_t status = _BuildField(node, i, &node->fields[i]);
+		if(status == B_BAD_INDEX)
+			break;
+		if(status != B_OK)
+			return status;
+	}
+	node->countFields = i;
+
+	return B_OK;
+}
+
+status_t
+MessageTree::_BuildField(TreeMessage* owner, int32 index, TreeField** _field)
+{
+	char* name;
+	type_code type;
+	int32 count;
+	if(owner->message->GetInfo(B_ANY_TYPE, index, &name, &type, &count) != B_OK)
+		return B_BAD_INDEX;
+
+	TreeField* field = static_cast<TreeField*>(
+		fArena.Allocate(sizeof(TreeField)));
+	if(!field)
+		return B_NO_MEMORY;
+
+	field->name = fArena.CopyString(name);
+	field->type = type;
+	field->count = count;
+	field->index = index;
+	field->owner = owner;
+	field->members = NULL;
+	field->row = NULL;
+	field->size = -1;
+	fCountFields++;
+
+	*_field = field;
+	return _BuildMembers(field);
+}
+
+status_t
+MessageTree::_BuildMembers(TreeField* field)
+{
+	field->members = NULL;
+	if(field->type != B_MESSAGE_TYPE)
+		return B_OK;
+
+	field->members = static_cast<TreeMessage**>(
+		fArena.Allocate(sizeof(TreeMessage*) * field->count));
+	if(!field->members)
+		return B_NO_MEMORY;
+	memset(field->members, 0, sizeof(TreeMessage*) * field->count);
+
+	for(int32 j = 0; j < field->count; j++) {
+		BMessage* copy = _NewMember();
+		if(!copy)
+			return B_NO_MEMORY;
+		field->owner->message->FindMessage(field->name, j, copy);
+
+		field->members[j] = _Build(copy, field, j);
+		if(!field->members[j])
+			return B_NO_MEMORY;
+	}
+
+	return B_OK;
+}
+
+BMessage*
+MessageTree::_NewMember()
+{
+	if(fFreeMembers.empty())
+		return fArena.New<BMessage>();
+
+	BMessage* copy = fFreeMembers.back();
+	fFreeMembers.pop_back();
+	return copy;
+}
+
+// Hands the nodes below a message back to the arena; the message node
+// itself stays
+void
+MessageTree::_RecycleFields(TreeMessage* message)
+{
+	if(!message->fields)
+		return;
+
+	for(int32 i = 0; i < message->countFields; i++) {
+		if(message->fields[i])
+			_RecycleField(message->fields[i]);
+	}
+	fArena.Recycle(message->fields, sizeof(TreeField*) * message->countFields);
+	message->fields = NULL;
+	message->countFields = 0;
+}
+
+void
+MessageTree::_RecycleField(TreeField* field)
+{
+	_RecycleMembers(field);
+	if(field->name)
+		fArena.Recycle(const_cast<char*>(field->name), strlen(field->name) + 1);
+	fArena.Recycle(field, sizeof(TreeField));
+}
+
+void
+MessageTree::_RecycleMembers(TreeField* field)
+{
+	if(!field->members)
+		return;
+
+	for(int32 j = 0; j < field->count; j++) {
+		TreeMessage* member = field->members[j];
+		if(!member)
+			continue;
+
+		_RecycleFields(member);
+		member->message->MakeEmpty();
+		fFreeMembers.push_back(member->message);
+		fArena.Recycle(member, sizeof(TreeMessage));
+	}
+	fArena.Recycle(field->members, sizeof(TreeMessage*) * field->count);
+	field->members = NULL;
+}
+
+int32
+MessageTree::_CountFields(TreeMessage* message)
+{
+	int32 count = 0;
+	for(int32 i = 0; i < message->countFields; i++)
+		count += _CountFields(message->fields[i]);
+	return count;
+}
+
+int32
+MessageTree::_CountFields(TreeField* field)
+{
+	int32 count = 1;
+	if(field->members) {
+		for(int32 j = 0; j < field->count; j++)
+			count += _CountFields(field->members[j]);
+	}
+	return count;
+}
+
+void
+MessageTree::_Resync(TreeMessage* message)
+{
+	TreeField* parent = message->parent;
+	if(!parent)
+		return;
+
+	_Resync(parent->owner);
+	parent->owner->message->FindMessage(parent->name, message->member,
+		message->message);
+}
+
+void
+MessageTree::_InvalidateSizes(TreeMessage* message)
+{
+	while(message) {
+		message->size = -1;
+		TreeField* parent = message->parent;
+		if(!parent)
+			break;
+		parent->size = -1;
+		message = parent->owner;
+	}
+}
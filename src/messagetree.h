@@ -0,0 +1,97 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef __MESSAGE_TREE_H__
+#define __MESSAGE_TREE_H__
+
+#include <Message.h>
+#include <vector>
+#include "documentarena.h"
+
+class BRow;
+struct TreeMessage;
+
+struct TreeField {
+	const char*		name;		// owned by the arena
+	type_code		type;
+	int32			count;
+	int32			index;		// position inside the owning message
+	TreeMessage*	owner;
+	TreeMessage**	members;	// decoded members, B_MESSAGE_TYPE only
+	BRow*			row;
+	ssize_t			size;		// flattened size, -1 until computed
+};
+
+struct TreeMessage {
+	BMessage*		message;	// the root is borrowed, members live in the arena
+	TreeField*		parent;		// NULL for the root
+	int32			member;		// index of this member inside the parent field
+	TreeField**		fields;		// in the order of the message
+	int32			countFields;
+	BRow*			row;		// member header row, if the view made one
+	ssize_t			size;		// flattened size, -1 until computed
+};
+
+/*	Decoded view of a message and all of its nested members. Every node,
+	name and member copy is placed in the arena handed to the constructor,
+	so the whole tree goes away with a single DocumentArena::Release().
+
+	Flattened sizes are computed on demand and cached on every node; an
+	edit only has to Invalidate() the field it touched, which drops the
+	cached sizes of that field and of the messages above it.
+
+	Structural edits are followed with AddField(), UpdateField(),
+	RemoveField() or ReplaceFields() on the message that changed, so only
+	that part of the tree is decoded again. Nodes dropped along the way
+	are recycled through the arena, and the member copies they held are
+	kept for the members decoded next.
+*/
+class MessageTree
+{
+public:
+							MessageTree(DocumentArena& arena);
+
+			status_t		SetTo(BMessage* root);
+			void			Unset();
+
+			TreeMessage*	Root() const { return fRoot; }
+			int32			CountFields() const { return fCountFields; }
+
+	static	ssize_t			FlattenedSize(TreeMessage* message);
+	static	ssize_t			FlattenedSize(TreeField* field);
+			void			Invalidate(TreeField* field);
+
+	static	TreeField*		FindField(TreeMessage* message, const char* name);
+	static	TreeMessage*	FindMember(TreeMessage* message, const char* name,
+								int32 member);
+
+			status_t		AddField(TreeMessage* message, const char* name,
+								TreeField** _field);
+			status_t		UpdateField(TreeField* field);
+			status_t		RemoveField(TreeField* field);
+			status_t		ReplaceFields(TreeMessage* message);
+private:
+			TreeMessage*	_Build(BMessage* message, TreeField* parent,
+								int32 member);
+			status_t		_BuildFields(TreeMessage* node);
+			status_t		_BuildField(TreeMessage* owner, int32 index,
+								TreeField** _field);
+			status_t		_BuildMembers(TreeField* field);
+			BMessage*		_NewMember();
+			void			_RecycleFields(TreeMessage* message);
+			void			_RecycleField(TreeField* field);
+			void			_RecycleMembers(TreeField* field);
+	static	int32			_CountFields(TreeMessage* message);
+	static	int32			_CountFields(TreeField* field);
+			void			_Resync(TreeMessage* message);
+	static	void			_InvalidateSizes(TreeMessage* message);
+private:
+	DocumentArena&			fArena;
+	TreeMessage*			fRoot;
+	int32					fCountFields;
+	std::vector<BMessage*>	fFreeMembers;	// emptied copies, in the arena
+};
+
+#endif /* __MESSAGE_TREE_H__ */
@@ -6,6 +6,7 @@
 
 #include "messageview.h"
 #include "gettype.h"
+#include "messageschema.h"
 
 #include <ColumnTypes.h>
 #include <Catalog.h>
@@ -18,20 +19,39 @@
 
 MessageView::MessageView()
 	:
-	BColumnListView("messageview",0)
+	BColumnListView("messageview",0),
+	fDataMessage(NULL),
+	fTree(fArena),
+	fNextMatch(0)
 {
 	SetSelectionMessage(new BMessage(MV_SELECTION_CHANGED));
 	SetInvocationMessage(new BMessage(MV_ROW_CLICKED));
 
 	BIntegerColumn *index_column = new BIntegerColumn(B_TRANSLATE("Index"),70,10,100);
-	BStringColumn *name_column = new BStringColumn(B_TRANSLATE("Name"),200,50,1000,0);
-	BStringColumn *type_column = new BStringColumn(B_TRANSLATE("Type"),200,50,1000,0);
+	NameColumn *name_column = new NameColumn(B_TRANSLATE("Name"),200,50,1000,0,&fNames);
+	InternedColumn *type_column = new InternedColumn(B_TRANSLATE("Type"),200,50,1000,0,&fNames);
 	BIntegerColumn *count_column = new BIntegerColumn(B_TRANSLATE("Number of items"),120,10,150);
+	BSizeColumn *size_column = new BSizeColumn(B_TRANSLATE("Size"),90,10,150,B_ALIGN_RIGHT);
+	fDeviationColumn = new DeviationColumn(B_TRANSLATE("Schema"),250,50,1000,0);
 
 	AddColumn(index_column,0);
 	AddColumn(name_column,1);
 	AddColumn(type_column,2);
 	AddColumn(count_column,3);
+	AddColumn(size_column,4);
+	AddColumn(fDeviationColumn,5);
+
+	// only shown once there is a schema to check against
+	fDeviationColumn->SetVisible(false);
+
+}
+
+
+MessageView::~MessageView()
+{
+
+	// The rows live in the arena, they must go before it does
+	ResetDocument();
 
 }
 
@@ -40,8 +60,14 @@ void
 MessageView::SetDataMessage(BMessage *message)
 {
 
+	ResetDocument();
 	fDataMessage = message;
-	create_data_rows(fDataMessage);
+	if (fTree.SetTo(fDataMessage) != B_OK)
+	{
+		return;
+	}
+
+	create_data_rows(fTree.Root());
 	if (CountRows() == 1)
 	{
 		ExpandOrCollapse(RowAt(0), true);
@@ -62,62 +88,626 @@ void
 MessageView::UpdateData()
 {
 
-	Clear();
-	create_data_rows(fDataMessage);
-	if (CountRows() == 1)
+	SetDataMessage(fDataMessage);
+}
+
+
+void
+MessageView::ResetDocument()
+{
+
+	BColumnListView::Clear();
+	fMatches.clear();
+	fNextMatch = 0;
+	fDeviations.clear();
+	fTree.Unset();
+	fArena.Release();
+	fNames.MakeEmpty();
+}
+
+
+void
+MessageView::GetAllocationReport(BMessage *report) const
+{
+
+	fArena.GetReport(report);
+	report->AddInt32("tree_fields", fTree.CountFields());
+}
+
+
+ssize_t
+MessageView::FlattenedSize() const
+{
+
+	if (fTree.Root() == NULL)
 	{
-		ExpandOrCollapse(RowAt(0), true);
+		return B_NO_INIT;
+	}
+
+	return MessageTree::FlattenedSize(fTree.Root());
+}
+
+
+void
+MessageView::InvalidateSelection()
+{
+
+	MessageRow *row = dynamic_cast<MessageRow*>(CurrentSelection());
+	if (row == NULL)
+	{
+		return;
+	}
+
+	TreeField *field = row->Field();
+	fTree.Invalidate(field);
+
+	// only the sizes on the path to the root have changed
+	update_size(field->row, MessageTree::FlattenedSize(field));
+	update_sizes(field->owner);
+}
+
+
+status_t
+MessageView::ApplyChange(const BMessage *change)
+{
+
+	if (fTree.Root() == NULL)
+	{
+		return B_NO_INIT;
+	}
+
+	// rows may go away below, and the search results are stale anyway
+	ClearMatches();
+	ClearDeviations();
+
+	// find the message that changed
+	TreeMessage *message = find_message(change);
+	if (message == NULL)
+	{
+		return B_NAME_NOT_FOUND;
+	}
+
+	if (change->GetInt32("change", -1) == MV_SUBTREE_REPLACED)
+	{
+		if (message == fTree.Root())
+		{
+			// nothing left to keep, start over with a fresh arena
+			SetDataMessage(fDataMessage);
+			return B_OK;
+		}
+
+		BRow *parent = rows_parent(message);
+		remove_child_rows(parent);
+		status_t status = fTree.ReplaceFields(message);
+		if (status != B_OK)
+		{
+			return status;
+		}
+
+		create_data_rows(message, parent);
+		update_sizes(message);
+		return B_OK;
+	}
+
+	const char *name;
+	for (int32 i = 0; change->FindString("name", i, &name) == B_OK; ++i)
+	{
+		status_t status = apply_field_change(message, name);
+		if (status != B_OK)
+		{
+			return status;
+		}
+	}
+
+	update_sizes(message);
+	return B_OK;
+}
+
+
+void
+MessageView::SetMatches(const BMessage *results)
+{
+
+	ClearMatches();
+	if (fTree.Root() == NULL)
+	{
+		return;
+	}
+
+	// one row per field, however many of its items matched
+	BMessage match;
+	for (int32 i = 0; results->FindMessage("match", i, &match) == B_OK; ++i)
+	{
+		TreeMessage *message = find_message(&match);
+		if (message == NULL)
+		{
+			continue;
+		}
+
+		TreeField *field = MessageTree::FindField(message,
+			match.GetString("name", ""));
+		if (field == NULL || field->row == NULL)
+		{
+			continue;
+		}
+
+		NameField *name_field = static_cast<NameField*>(field->row->GetField(1));
+		name_field->SetMatched(true);
+		fMatches.push_back(field->row);
 	}
+
+	Invalidate();
 }
 
+
 void
-MessageView::create_data_rows(BMessage *message, BRow *parent)
+MessageView::ClearMatches()
 {
 
-	char *name;
-	type_code type;
-	int32 count;
+	for (size_t i = 0; i < fMatches.size(); ++i)
+	{
+		static_cast<NameField*>(fMatches[i]->GetField(1))->SetMatched(false);
+	}
 
-	for (int32 i=0; message->GetInfo(B_ANY_TYPE, i, &name, &type, &count) == B_OK; ++i)
+	if (!fMatches.empty())
 	{
+		Invalidate();
+	}
+
+	fMatches.clear();
+	fNextMatch = 0;
+}
+
+
+bool
+MessageView::SelectNextMatch()
+{
 
-		BRow *row = new BRow();
-		BString type_name = get_type(type);
+	if (fMatches.empty())
+	{
+		return false;
+	}
 
-		BIntegerField *index_field = new BIntegerField(i);
-		BStringField *name_field = new BStringField(name);
-		BStringField *type_field = new BStringField(get_type(type).String());
-		BIntegerField *count_field = new BIntegerField(count);
+	BRow *row = fMatches[fNextMatch];
+	fNextMatch = (fNextMatch + 1) % fMatches.size();
 
-		row->SetField(index_field,0);
-		row->SetField(name_field,1);
-		row->SetField(type_field,2);
-		row->SetField(count_field,3);
+	reveal_row(row);
+	return true;
+}
 
-		AddRow(row, parent);
 
-		if (type_name == "B_MESSAGE_TYPE")
+// location is laid out like a search match: "path" and "member" down to
+// the message, then the field "name"
+bool
+MessageView::SelectField(const BMessage *location)
+{
+
+	TreeMessage *message = find_message(location);
+	if (message == NULL)
+	{
+		return false;
+	}
+
+	TreeField *field = MessageTree::FindField(message,
+		location->GetString("name", ""));
+	if (field == NULL || field->row == NULL)
+	{
+		return false;
+	}
+
+	reveal_row(field->row);
+	return true;
+}
+
+
+// Each deviation is laid out like a search match, with a "text" that ends
+// up in the schema column of its row. Fields that are missing, and a
+// 'what' that is not the expected one, are shown on the row of the message.
+void
+MessageView::SetDeviations(const BMessage *deviations)
+{
+
+	ClearDeviations();
+	fDeviationColumn->SetVisible(true);
+	if (fTree.Root() == NULL)
+	{
+		return;
+	}
+
+	BMessage deviation;
+	for (int32 i = 0; deviations->FindMessage("deviation", i, &deviation) == B_OK; ++i)
+	{
+		TreeMessage *message = find_message(&deviation);
+		if (message == NULL)
 		{
-			BRow *parent_row = row;
+			continue;
+		}
 
-			for (int32 message_nr = 0; message_nr < count; ++message_nr)
+		BRow *row;
+		BString prefix;
+		int32 kind = deviation.GetInt32("kind", -1);
+		if (kind == SCHEMA_MISSING_FIELD || kind == SCHEMA_WHAT_MISMATCH)
+		{
+			row = rows_parent(message);
+
+			// the document itself has no row, its deviations go to the
+			// first top level row and say whom they are about
+			if (row == NULL)
 			{
-				if (count > 1)
-				{
-					BRow *header_row = new BRow();
-					BIntegerField *header_index_field = new BIntegerField(message_nr);
-					header_row->SetField(header_index_field,0);
-					AddRow(header_row,row);
+				row = RowAt(0);
+				prefix = B_TRANSLATE("Message: ");
+			}
+		}
+		else
+		{
+			TreeField *field = MessageTree::FindField(message,
+				deviation.GetString("name", ""));
+			row = field != NULL ? field->row : NULL;
+		}
+		if (row == NULL)
+		{
+			continue;
+		}
+
+		BStringField *text_field = static_cast<BStringField*>(row->GetField(5));
+		if (text_field == NULL)
+		{
+			text_field = new(fArena) ArenaStringField("");
+			row->SetField(text_field, 5);
+		}
+
+		BString text(text_field->String());
+		if (text.Length() > 0)
+		{
+			text << "; ";
+		}
+		else
+		{
+			fDeviations.push_back(row);
+		}
+		text << prefix << deviation.GetString("text", "");
+		text_field->SetString(text.String());
+	}
+
+	Invalidate();
+}
+
+
+void
+MessageView::ClearDeviations()
+{
+
+	for (size_t i = 0; i < fDeviations.size(); ++i)
+	{
+		static_cast<BStringField*>(fDeviations[i]->GetField(5))->SetString("");
+	}
+
+	if (!fDeviations.empty())
+	{
+		Invalidate();
+	}
+
+	fDeviations.clear();
+}
+
+
+void
+MessageView::reveal_row(BRow *row)
+{
+
+	// open up everything above the row so it can be seen
+	BRow *parent;
+	bool visible;
+	for (BRow *child = row; FindParent(child, &parent, &visible)
+		&& parent != NULL; child = parent)
+	{
+		ExpandOrCollapse(parent, true);
+	}
+
+	DeselectAll();
+	AddToSelection(row);
+	ScrollTo(row);
+}
+
+
+TreeMessage *
+MessageView::find_message(const BMessage *path) const
+{
+
+	TreeMessage *message = fTree.Root();
+	const char *path_name;
+	for (int32 i = 0; message != NULL
+		&& path->FindString("path", i, &path_name) == B_OK; ++i)
+	{
+		message = MessageTree::FindMember(message, path_name,
+			path->GetInt32("member", i, -1));
+	}
+
+	return message;
+}
+
 
-					parent_row = header_row;
-				}
+void
+MessageView::create_data_rows(TreeMessage *message, BRow *parent)
+{
+
+	for (int32 i = 0; i < message->countFields; ++i)
+	{
+		create_field_rows(message->fields[i], parent);
+	}
 
-				BMessage *member_message = new BMessage();
-				message->FindMessage(name, message_nr, member_message);
+}
+
+
+void
+MessageView::create_field_rows(TreeField *field, BRow *parent)
+{
 
-				create_data_rows(member_message, parent_row);
+	BRow *row = new(fArena) MessageRow(field);
+	if (row == NULL)
+	{
+		return;
+	}
+
+	row->SetField(new(fArena) ArenaIntegerField(field->index),0);
+	BString type_name = get_type(field->type);
+	row->SetField(new(fArena) NameField(field->name,
+		fNames.Intern(field->name)),1);
+	row->SetField(new(fArena) InternedField(type_name.String(),
+		fNames.Intern(type_name.String())),2);
+	row->SetField(new(fArena) ArenaIntegerField(field->count),3);
+	row->SetField(new(fArena) ArenaSizeField(
+		MessageTree::FlattenedSize(field)),4);
+
+	AddRow(row, parent);
+	field->row = row;
+
+	create_member_rows(field);
+
+}
+
+
+void
+MessageView::create_member_rows(TreeField *field)
+{
+
+	if (field->type != B_MESSAGE_TYPE || field->members == NULL)
+	{
+		return;
+	}
+
+	BRow *parent_row = field->row;
+
+	for (int32 message_nr = 0; message_nr < field->count; ++message_nr)
+	{
+		if (field->count > 1)
+		{
+			BRow *header_row = new(fArena) MessageRow(field, message_nr);
+			if (header_row == NULL)
+			{
+				return;
 			}
+
+			header_row->SetField(new(fArena) ArenaIntegerField(message_nr),0);
+			header_row->SetField(new(fArena) ArenaSizeField(
+				MessageTree::FlattenedSize(field->members[message_nr])),4);
+			AddRow(header_row,field->row);
+			field->members[message_nr]->row = header_row;
+
+			parent_row = header_row;
+		}
+
+		create_data_rows(field->members[message_nr], parent_row);
+	}
+
+}
+
+
+void
+MessageView::remove_rows(BRow *row)
+{
+
+	remove_child_rows(row);
+	RemoveRow(row);
+	delete row;
+
+}
+
+
+void
+MessageView::remove_child_rows(BRow *parent)
+{
+
+	for (int32 i = CountRows(parent) - 1; i >= 0; --i)
+	{
+		remove_rows(RowAt(i, parent));
+	}
+
+}
+
+
+status_t
+MessageView::apply_field_change(TreeMessage *message, const char *name)
+{
+
+	TreeField *field = MessageTree::FindField(message, name);
+	if (field == NULL)
+	{
+		status_t status = fTree.AddField(message, name, &field);
+		if (status == B_NAME_NOT_FOUND)
+		{
+			// added and removed again before we got here
+			return B_OK;
+		}
+		if (status != B_OK)
+		{
+			return status;
+		}
+
+		create_field_rows(field, rows_parent(message));
+		return B_OK;
+	}
+
+	status_t status = fTree.UpdateField(field);
+	if (status == B_NAME_NOT_FOUND)
+	{
+		// the last item went away and the field with it
+		int32 index = field->index;
+		remove_rows(field->row);
+		status = fTree.RemoveField(field);
+		if (status != B_OK)
+		{
+			return status;
+		}
+
+		// the fields behind it have moved up by one
+		for (int32 i = index; i < message->countFields; ++i)
+		{
+			BRow *row = message->fields[i]->row;
+			static_cast<BIntegerField*>(row->GetField(0))->SetValue(i);
+			UpdateRow(row);
+		}
+		return B_OK;
+	}
+	if (status != B_OK)
+	{
+		return status;
+	}
+
+	BRow *row = field->row;
+	static_cast<BIntegerField*>(row->GetField(3))->SetValue(field->count);
+	update_size(row, MessageTree::FlattenedSize(field));
+
+	if (field->type == B_MESSAGE_TYPE)
+	{
+		remove_child_rows(row);
+		create_member_rows(field);
+	}
+
+	return B_OK;
+}
+
+
+BRow *
+MessageView::rows_parent(TreeMessage *message) const
+{
+
+	// members of a single item field hang right below the field row
+	if (message->row != NULL)
+	{
+		return message->row;
+	}
+
+	return message->parent != NULL ? message->parent->row : NULL;
+}
+
+
+void
+MessageView::update_size(BRow *row, ssize_t size)
+{
+
+	if (row == NULL || size < 0)
+	{
+		return;
+	}
+
+	BSizeField *size_field = static_cast<BSizeField*>(row->GetField(4));
+	if (size_field != NULL)
+	{
+		size_field->SetSize(size);
+		UpdateRow(row);
+	}
+}
+
+
+void
+MessageView::update_sizes(TreeMessage *message)
+{
+
+	while (message != NULL)
+	{
+		update_size(message->row, MessageTree::FlattenedSize(message));
+
+		TreeField *parent = message->parent;
+		if (parent == NULL)
+		{
+			break;
 		}
+
+		update_size(parent->row, MessageTree::FlattenedSize(parent));
+		message = parent->owner;
+	}
+}
+
+
+InternedColumn::InternedColumn(const char *title, float width, float minWidth,
+	float maxWidth, uint32 truncate, StringTable *table)
+	:
+	BStringColumn(title, width, minWidth, maxWidth, truncate),
+	fTable(table)
+{
+}
+
+
+int
+InternedColumn::CompareFields(BField *field1, BField *field2)
+{
+
+	// Only interned cells are ever put in these columns
+	return fTable->Rank(static_cast<InternedField*>(field1)->Id())
+		- fTable->Rank(static_cast<InternedField*>(field2)->Id());
+}
+
+
+NameColumn::NameColumn(const char *title, float width, float minWidth,
+	float maxWidth, uint32 truncate, StringTable *table)
+	:
+	InternedColumn(title, width, minWidth, maxWidth, truncate, table)
+{
+}
+
+
+void
+NameColumn::DrawField(BField *field, BRect rect, BView *parent)
+{
+
+	NameField *name_field = dynamic_cast<NameField*>(field);
+	if (name_field != NULL && name_field->IsMatched())
+	{
+		rgb_color color = mix_color(ui_color(B_LIST_BACKGROUND_COLOR),
+			ui_color(B_CONTROL_HIGHLIGHT_COLOR), 96);
+		parent->SetHighColor(color);
+		parent->SetLowColor(color);
+		parent->FillRect(rect);
+		parent->SetHighColor(ui_color(B_LIST_ITEM_TEXT_COLOR));
+	}
+
+	InternedColumn::DrawField(field, rect, parent);
+}
+
+
+DeviationColumn::DeviationColumn(const char *title, float width,
+	float minWidth, float maxWidth, uint32 truncate)
+	:
+	BStringColumn(title, width, minWidth, maxWidth, truncate)
+{
+}
+
+
+void
+DeviationColumn::DrawField(BField *field, BRect rect, BView *parent)
+{
+
+	BStringField *text_field = static_cast<BStringField*>(field);
+	if (text_field->String()[0] != '\0')
+	{
+		rgb_color color = mix_color(ui_color(B_LIST_BACKGROUND_COLOR),
+			ui_color(B_FAILURE_COLOR), 64);
+		parent->SetHighColor(color);
+		parent->SetLowColor(color);
+		parent->FillRect(rect);
+		parent->SetHighColor(ui_color(B_LIST_ITEM_TEXT_COLOR));
 	}
 
+	BStringColumn::DrawField(field, rect, parent);
 }
@@ -8,26 +8,155 @@
 #define MESSAGEVIEW_H
 
 #include <private/interface/ColumnListView.h>
+#include <private/interface/ColumnTypes.h>
 #include <Message.h>
+#include <vector>
+
+#include "documentarena.h"
+#include "messagetree.h"
+#include "sortkeys.h"
 
 
 enum
 {
 	MV_ROW_CLICKED ='mv00',
-	MV_SELECTION_CHANGED
+	MV_SELECTION_CHANGED,
+	MV_MESSAGE_CHANGED
+};
+
+
+/*
+ * Change descriptors carried by MV_MESSAGE_CHANGED in "change". The
+ * message that changed is found through the "path" (field name) and
+ * "member" (int32) pairs from the root down, the fields through "name".
+ * The view checks each name against the message itself, so adding to a
+ * name that already exists shows up as a count change and removing the
+ * last item removes the field.
+ */
+enum
+{
+	MV_FIELD_ADDED = 0,
+	MV_FIELD_REMOVED,
+	MV_FIELD_COUNT_CHANGED,
+	MV_SUBTREE_REPLACED
 };
 
 
+class MessageRow : public ArenaObject<BRow> {
+public:
+	MessageRow(TreeField *field, int32 member = -1)
+		: fField(field), fMember(member) {}
+
+	TreeField		*Field() const { return fField; }
+	int32			Member() const { return fMember; }
+
+private:
+	TreeField		*fField;
+	int32			fMember;	// member header rows only
+};
+
+// String cell that sorts on the rank of its text in a StringTable
+class InternedField : public ArenaObject<BStringField> {
+public:
+	InternedField(const char *text, int32 id)
+		: ArenaObject<BStringField>(text), fId(id) {}
+
+	int32			Id() const { return fId; }
+
+private:
+	int32			fId;
+};
+
+// Name cell of a field row, flagged while the field matches a search
+class NameField : public InternedField {
+public:
+	NameField(const char *name, int32 id)
+		: InternedField(name, id), fMatched(false) {}
+
+	bool			IsMatched() const { return fMatched; }
+	void			SetMatched(bool matched) { fMatched = matched; }
+
+private:
+	bool			fMatched;
+};
+
+
+// Compares InternedField cells by rank instead of by their text
+class InternedColumn : public BStringColumn {
+public:
+	InternedColumn(const char *title, float width, float minWidth,
+		float maxWidth, uint32 truncate, StringTable *table);
+
+	virtual int		CompareFields(BField *field1, BField *field2);
+
+private:
+	StringTable		*fTable;
+};
+
+
+class NameColumn : public InternedColumn {
+public:
+	NameColumn(const char *title, float width, float minWidth,
+		float maxWidth, uint32 truncate, StringTable *table);
+
+	virtual void	DrawField(BField *field, BRect rect, BView *parent);
+};
+
+
+// Shows why a row deviates from the schema, on a warning background
+class DeviationColumn : public BStringColumn {
+public:
+	DeviationColumn(const char *title, float width, float minWidth,
+		float maxWidth, uint32 truncate);
+
+	virtual void	DrawField(BField *field, BRect rect, BView *parent);
+};
+
+typedef ArenaObject<BIntegerField> ArenaIntegerField;
+typedef ArenaObject<BStringField> ArenaStringField;
+typedef ArenaObject<BSizeField> ArenaSizeField;
+
+
 class MessageView : public BColumnListView {
 public:
 	MessageView();
+	virtual			~MessageView();
 	void 			SetDataMessage(BMessage *message);
 	virtual	void	MessageDropped(BMessage* msg, BPoint point);
 	void 			UpdateData();
+	void			ResetDocument();
+	void			GetAllocationReport(BMessage *report) const;
+	ssize_t			FlattenedSize() const;
+	void			InvalidateSelection();
+	status_t		ApplyChange(const BMessage *change);
+	void			SetMatches(const BMessage *results);
+	void			ClearMatches();
+	bool			SelectNextMatch();
+	bool			SelectField(const BMessage *location);
+	void			SetDeviations(const BMessage *deviations);
+	void			ClearDeviations();
+	BMessage		*DataMessage() const { return fDataMessage; }
 
 private:
-	void create_data_rows(BMessage *message, BRow *parent = NULL);
+	TreeMessage *find_message(const BMessage *path) const;
+	void reveal_row(BRow *row);
+	void create_data_rows(TreeMessage *message, BRow *parent = NULL);
+	void create_field_rows(TreeField *field, BRow *parent);
+	void create_member_rows(TreeField *field);
+	void remove_rows(BRow *row);
+	void remove_child_rows(BRow *parent);
+	status_t apply_field_change(TreeMessage *message, const char *name);
+	BRow *rows_parent(TreeMessage *message) const;
+	void update_size(BRow *row, ssize_t size);
+	void update_sizes(TreeMessage *message);
 	BMessage *fDataMessage;
+	DocumentArena fArena;
+	MessageTree fTree;
+	StringTable fNames;	// field and type names, for sorting
+	std::vector<BRow*> fMatches;
+	size_t fNextMatch;
+	BColumn *fDeviationColumn;
+	std::vector<BRow*> fDeviations;
 };
 
 #endif
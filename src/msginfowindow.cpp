@@ -14,7 +14,8 @@
 #undef B_TRANSLATION_CONTEXT
 #define B_TRANSLATION_CONTEXT "MessageInfoWindow"
 
-MsgInfoWindow::MsgInfoWindow(BRect frame, BMessage* data)
+MsgInfoWindow::MsgInfoWindow(BRect frame, BMessage* data,
+	const BMessage* allocationReport, ssize_t flattenedSize)
 : BWindow(frame, B_TRANSLATE("Message information"), B_FLOATING_WINDOW,
 	B_ASYNCHRONOUS_CONTROLS | B_AUTO_UPDATE_SIZE_LIMITS)
 {
@@ -77,19 +78,41 @@ MsgInfoWindow::MsgInfoWindow(BRect frame, BMessage* data)
 	scriptingInfoBox->SetLabel(B_TRANSLATE("Scripting information"));
 	scriptingInfoBox->AddChild(scriptingInfoView);
 
+	fTcAllocations = new BTextControl(B_TRANSLATE("Decoded objects"), "", NULL);
+	fTcAllocations->SetEnabled(false);
+	fTcArenaBlocks = new BTextControl(B_TRANSLATE("Heap blocks"), "", NULL);
+	fTcArenaBlocks->SetEnabled(false);
+	fTcArenaBytes = new BTextControl(B_TRANSLATE("Memory in use"), "", NULL);
+	fTcArenaBytes->SetEnabled(false);
+
+	BView* memoryInfoView = new BView(NULL, B_SUPPORTS_LAYOUT);
+	BLayoutBuilder::Group<>(memoryInfoView, B_VERTICAL)
+		.SetInsets(B_USE_SMALL_INSETS, 0, B_USE_SMALL_INSETS, B_USE_SMALL_INSETS)
+		.Add(fTcAllocations)
+		.Add(fTcArenaBlocks)
+		.Add(fTcArenaBytes)
+	.End();
+	BBox* memoryInfoBox = new BBox("");
+	memoryInfoBox->SetLabel(B_TRANSLATE("Memory information"));
+	memoryInfoBox->AddChild(memoryInfoView);
+
 	BLayoutBuilder::Group<>(this, B_VERTICAL)
 		.SetInsets(B_USE_SMALL_INSETS)
 		.Add(fTcWhat)
 		.Add(generalInfoBox)
 		.Add(deliveryInfoBox)
 		.Add(scriptingInfoBox)
+		.Add(memoryInfoBox)
 	.End();
 
-	InitUIData(const_cast<const BMessage*>(data));
+	InitUIData(const_cast<const BMessage*>(data), flattenedSize);
+	InitAllocationData(allocationReport);
+	if(!allocationReport || allocationReport->IsEmpty())
+		memoryInfoBox->Hide();
 }
 
 void
-MsgInfoWindow::InitUIData(const BMessage* data)
+MsgInfoWindow::InitUIData(const BMessage* data, ssize_t flattenedSize)
 {
 	BString whatData;
 	whatData.SetToFormat("0x%.1x", data->what);
@@ -102,8 +125,13 @@ MsgInfoWindow::InitUIData(const BMessage* data)
 	countNamesData.SetToFormat("%d", data->CountNames(B_ANY_TYPE));
 	fTcCountNames->SetText(countNamesData.String());
 
+	// The message view keeps the size cached, only walk the message when
+	// nobody handed it to us
+	if(flattenedSize < 0)
+		flattenedSize = data->FlattenedSize();
+
 	BString flattenedSizeData;
-	flattenedSizeData.SetToFormat(B_TRANSLATE("%zd bytes"), data->FlattenedSize());
+	flattenedSizeData.SetToFormat(B_TRANSLATE("%zd bytes"), flattenedSize);
 	fTcFlattenedSize->SetText(flattenedSizeData.String());
 
 	fCbWasDelivered->SetValue(data->WasDelivered() ? B_CONTROL_ON : B_CONTROL_OFF);
@@ -134,6 +162,31 @@ MsgInfoWindow::InitUIData(const BMessage* data)
 	// copy = NULL;
 }
 
+void
+MsgInfoWindow::InitAllocationData(const BMessage* report)
+{
+	if(!report)
+		return;
+
+	/* Every decoded node, name and row is one arena allocation; they are
+	   served from a handful of heap blocks instead of one heap call each */
+	BString allocationsData;
+	allocationsData.SetToFormat("%" B_PRIu64,
+		report->GetUInt64("allocations", 0));
+	fTcAllocations->SetText(allocationsData.String());
+
+	BString blocksData;
+	blocksData.SetToFormat("%" B_PRIu64, report->GetUInt64("blocks", 0));
+	fTcArenaBlocks->SetText(blocksData.String());
+
+	BString bytesData;
+	bytesData.SetToFormat(B_TRANSLATE("%" B_PRIu64 " of %" B_PRIu64
+		" bytes, %" B_PRIu64 " of them freed by edits"),
+		report->GetUInt64("bytes_used", 0), report->GetUInt64("block_bytes", 0),
+		report->GetUInt64("bytes_wasted", 0));
+	fTcArenaBytes->SetText(bytesData.String());
+}
+
 const char*
 MsgInfoWindow::StringForSpecifierWhat(uint32 what)
 {
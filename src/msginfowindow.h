@@ -16,9 +16,12 @@
 class MsgInfoWindow : public BWindow
 {
 public:
-					MsgInfoWindow(BRect frame, BMessage* data);
+					MsgInfoWindow(BRect frame, BMessage* data,
+						const BMessage* allocationReport = NULL,
+						ssize_t flattenedSize = -1);
 private:
-			void 	InitUIData(const BMessage* data);
+			void 	InitUIData(const BMessage* data, ssize_t flattenedSize);
+			void	InitAllocationData(const BMessage* report);
 	const 	char* 	StringForSpecifierWhat(uint32 what);
 private:
 	BCheckBox* 		fCbIsSystem;
@@ -29,6 +32,9 @@ private:
 	BTextControl* 	fTcWhat;
 	BTextControl* 	fTcCountNames;
 	BTextControl* 	fTcFlattenedSize;
+	BTextControl*	fTcAllocations;
+	BTextControl*	fTcArenaBlocks;
+	BTextControl*	fTcArenaBytes;
 };
 
 #endif /* __MSG_INFO_WINDOW__ */
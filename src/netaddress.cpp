@@ -0,0 +1,239 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#include <arpa/inet.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <net/if_dl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include "netaddress.h"
+
+static const char kHexDigits[] = "0123456789abcdef";
+
+/*	Appends to a fixed buffer and quietly drops whatever does not fit, one
+	byte is always kept back for the terminator.
+*/
+class TextWriter
+{
+public:
+	TextWriter(char* text, size_t size)
+	: fStart(text),
+	  fPosition(text),
+	  fEnd(text + size - 1)
+	{
+	}
+
+	void Put(char c)
+	{
+		if(fPosition < fEnd)
+			*fPosition++ = c;
+	}
+
+	void PutDecimal(uint32 value)
+	{
+		char digits[10];
+		int32 count = 0;
+		do {
+			digits[count++] = '0' + value % 10;
+			value /= 10;
+		} while(value != 0);
+		while(count > 0)
+			Put(digits[--count]);
+	}
+
+	// Without leading zeros, as RFC 5952 wants it
+	void PutHex16(uint16 value)
+	{
+		bool leading = true;
+		for(int32 shift = 12; shift >= 0; shift -= 4) {
+			uint8 digit = (value >> shift) & 0xf;
+			if(leading && digit == 0 && shift != 0)
+				continue;
+			leading = false;
+			Put(kHexDigits[digit]);
+		}
+	}
+
+	void PutHex8(uint8 value)
+	{
+		Put(kHexDigits[value >> 4]);
+		Put(kHexDigits[value & 0xf]);
+	}
+
+	void PutDotted(const uint8* bytes)
+	{
+		for(int32 i = 0; i < 4; i++) {
+			if(i > 0)
+				Put('.');
+			PutDecimal(bytes[i]);
+		}
+	}
+
+	ssize_t Finish()
+	{
+		*fPosition = '\0';
+		return fPosition - fStart;
+	}
+private:
+	char*	fStart;
+	char*	fPosition;
+	char*	fEnd;
+};
+
+// Copies what the item has of T, the rest stays zero. Fails when the item
+// ends before the first needed bytes.
+template<typename T>
+static bool
+copy_address(T* address, const void* data, ssize_t length, size_t needed)
+{
+	if(length < 0 || (size_t)length < needed)
+		return false;
+
+	memset(address, 0, sizeof(T));
+	memcpy(address, data, std::min((size_t)length, sizeof(T)));
+	return true;
+}
+
+static void
+write_inet6(TextWriter& writer, const uint8* bytes)
+{
+	uint16 groups[8];
+	for(int32 i = 0; i < 8; i++)
+		groups[i] = bytes[2 * i] << 8 | bytes[2 * i + 1];
+
+	// IPv4 mapped addresses keep the dotted quad (RFC 5952, 5)
+	static const uint8 kMappedPrefix[12]
+		= { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff };
+	if(memcmp(bytes, kMappedPrefix, sizeof(kMappedPrefix)) == 0) {
+		writer.Put(':');
+		writer.Put(':');
+		writer.PutHex16(0xffff);
+		writer.Put(':');
+		writer.PutDotted(bytes + 12);
+		return;
+	}
+
+	// The longest run of at least two zero groups becomes "::", the first
+	// one if there are several (RFC 5952, 4.2)
+	int32 bestStart = -1;
+	int32 bestLength = 1;
+	for(int32 i = 0; i < 8;) {
+		if(groups[i] != 0) {
+			i++;
+			continue;
+		}
+		int32 start = i;
+		while(i < 8 && groups[i] == 0)
+			i++;
+		if(i - start > bestLength) {
+			bestStart = start;
+			bestLength = i - start;
+		}
+	}
+
+	for(int32 i = 0; i < 8;) {
+		if(i == bestStart) {
+			writer.Put(':');
+			writer.Put(':');
+			i += bestLength;
+			continue;
+		}
+		if(i > 0 && i != bestStart + bestLength)
+			writer.Put(':');
+		writer.PutHex16(groups[i]);
+		i++;
+	}
+}
+
+ssize_t
+format_sockaddr(const void* data, ssize_t length, char* text, size_t size)
+{
+	if(size == 0)
+		return -1;
+
+	TextWriter writer(text, size);
+
+	sockaddr header;
+	if(!copy_address(&header, data, length,
+			offsetof(sockaddr, sa_family) + sizeof(header.sa_family))) {
+		writer.Finish();
+		return -1;
+	}
+
+	switch(header.sa_family) {
+		case AF_INET:
+		{
+			sockaddr_in address;
+			if(!copy_address(&address, data, length,
+					offsetof(sockaddr_in, sin_addr) + sizeof(in_addr)))
+				break;
+
+			writer.PutDotted((const uint8*)&address.sin_addr);
+			if(address.sin_port != 0) {
+				writer.Put(':');
+				writer.PutDecimal(ntohs(address.sin_port));
+			}
+			return writer.Finish();
+		}
+
+		case AF_INET6:
+		{
+			sockaddr_in6 address;
+			if(!copy_address(&address, data, length,
+					offsetof(sockaddr_in6, sin6_addr) + sizeof(in6_addr)))
+				break;
+
+			bool port = address.sin6_port != 0;
+			if(port)
+				writer.Put('[');
+			write_inet6(writer, address.sin6_addr.s6_addr);
+			if(address.sin6_scope_id != 0) {
+				writer.Put('%');
+				writer.PutDecimal(address.sin6_scope_id);
+			}
+			if(port) {
+				writer.Put(']');
+				writer.Put(':');
+				writer.PutDecimal(ntohs(address.sin6_port));
+			}
+			return writer.Finish();
+		}
+
+		case AF_LINK:
+		{
+			sockaddr_dl address;
+			if(!copy_address(&address, data, length,
+					offsetof(sockaddr_dl, sdl_data)))
+				break;
+
+			// Name and address must both lie inside the item
+			size_t available = std::min((size_t)length, sizeof(address))
+				- offsetof(sockaddr_dl, sdl_data);
+			if((size_t)address.sdl_nlen + address.sdl_alen > available)
+				break;
+
+			const uint8* bytes = LLADDR(&address);
+			for(int32 i = 0; i < address.sdl_alen; i++) {
+				if(i > 0)
+					writer.Put(':');
+				writer.PutHex8(bytes[i]);
+			}
+			if(address.sdl_alen == 0) {
+				for(int32 i = 0; i < address.sdl_nlen
+						&& address.sdl_data[i] != '\0'; i++)
+					writer.Put(address.sdl_data[i]);
+			}
+			return writer.Finish();
+		}
+
+		default:
+			return writer.Finish();
+	}
+
+	writer.Finish();
+	return -1;
+}
@@ -0,0 +1,32 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef __NET_ADDRESS_H__
+#define __NET_ADDRESS_H__
+
+#include <SupportDefs.h>
+
+/*	Text form of a flattened socket address, as stored in a
+	B_NETWORK_ADDRESS_TYPE item. Unlike BNetworkAddress::ToString() this
+	neither allocates nor copies the whole sockaddr_storage, and it never
+	asks the resolver or the network stack, so it can be run over long
+	address lists.
+
+	IPv4 and IPv6 addresses get their port when it is set, IPv6 ones in
+	the RFC 5952 form ("[2001:db8::1]:80", "::ffff:10.0.0.1") with a
+	numeric scope. Link level addresses are written as colon separated
+	hex bytes, or as the interface name when they have none.
+*/
+
+// Fits the longest text format_sockaddr() writes, terminator included
+static const size_t kSockaddrTextSize = 160;
+
+// Returns the length of the text, 0 for families that have no address
+// form, or -1 when the item is too short for what its family needs. The
+// text is always terminated and cut short to fit into size bytes.
+ssize_t		format_sockaddr(const void* data, ssize_t length, char* text,
+				size_t size);
+
+#endif /* __NET_ADDRESS_H__ */
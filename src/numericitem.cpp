@@ -0,0 +1,91 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#include <cstring>
+#include <ctime>
+#include "numericitem.h"
+
+item_storage
+storage_of(type_code type, ssize_t size)
+{
+	switch(type) {
+		case B_INT8_TYPE:
+			return size == 1 ? STORAGE_INT8 : STORAGE_NONE;
+		case B_INT16_TYPE:
+			return size == 2 ? STORAGE_INT16 : STORAGE_NONE;
+		case B_INT32_TYPE:
+			return size == 4 ? STORAGE_INT32 : STORAGE_NONE;
+		case B_INT64_TYPE:
+		case B_OFF_T_TYPE:
+			return size == 8 ? STORAGE_INT64 : STORAGE_NONE;
+		case B_UINT8_TYPE:
+			return size == 1 ? STORAGE_UINT8 : STORAGE_NONE;
+		case B_UINT16_TYPE:
+			return size == 2 ? STORAGE_UINT16 : STORAGE_NONE;
+		case B_UINT32_TYPE:
+			return size == 4 ? STORAGE_UINT32 : STORAGE_NONE;
+		case B_UINT64_TYPE:
+			return size == 8 ? STORAGE_UINT64 : STORAGE_NONE;
+		case B_SIZE_T_TYPE:
+			return size == 4 ? STORAGE_UINT32
+				: size == 8 ? STORAGE_UINT64 : STORAGE_NONE;
+		case B_SSIZE_T_TYPE:
+		case B_TIME_TYPE:
+			return size == 4 ? STORAGE_INT32
+				: size == 8 ? STORAGE_INT64 : STORAGE_NONE;
+		case B_FLOAT_TYPE:
+			return size == 4 ? STORAGE_FLOAT : STORAGE_NONE;
+		case B_DOUBLE_TYPE:
+			return size == 8 ? STORAGE_DOUBLE : STORAGE_NONE;
+		default:
+			return STORAGE_NONE;
+	}
+}
+
+ssize_t
+native_size(type_code type)
+{
+	switch(type) {
+		case B_INT8_TYPE:
+		case B_UINT8_TYPE:
+			return 1;
+		case B_INT16_TYPE:
+		case B_UINT16_TYPE:
+			return 2;
+		case B_INT32_TYPE:
+		case B_UINT32_TYPE:
+		case B_FLOAT_TYPE:
+			return 4;
+		case B_INT64_TYPE:
+		case B_UINT64_TYPE:
+		case B_OFF_T_TYPE:
+		case B_DOUBLE_TYPE:
+			return 8;
+		case B_SIZE_T_TYPE:
+		case B_SSIZE_T_TYPE:
+			return sizeof(size_t);
+		case B_TIME_TYPE:
+			return sizeof(time_t);
+		default:
+			return 0;
+	}
+}
+
+status_t
+gather_items(const BMessage& message, const char* name, type_code type,
+	int32 first, int32 count, ssize_t itemSize, uint8* buffer)
+{
+	for(int32 i = 0; i < count; i++) {
+		const void* data;
+		ssize_t size;
+		status_t status = message.FindData(name, type, first + i, &data, &size);
+		if(status != B_OK)
+			return status;
+		if(size != itemSize)
+			return B_BAD_DATA;
+		memcpy(buffer + i * itemSize, data, itemSize);
+	}
+	return B_OK;
+}
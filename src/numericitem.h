@@ -0,0 +1,46 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef __NUMERIC_ITEM_H__
+#define __NUMERIC_ITEM_H__
+
+#include <Message.h>
+#include <SupportDefs.h>
+
+/*	How the items of a numeric field are laid out in memory, shared by the
+	code that works on whole numeric fields at once.
+*/
+enum item_storage {
+	STORAGE_NONE = 0,
+	STORAGE_INT8,
+	STORAGE_INT16,
+	STORAGE_INT32,
+	STORAGE_INT64,
+	STORAGE_UINT8,
+	STORAGE_UINT16,
+	STORAGE_UINT32,
+	STORAGE_UINT64,
+	STORAGE_FLOAT,
+	STORAGE_DOUBLE
+};
+
+// size_t, ssize_t and time_t items take the size of the platform that
+// wrote them
+item_storage	storage_of(type_code type, ssize_t size);
+ssize_t			native_size(type_code type);
+
+// Copies items first to first + count - 1 into one buffer
+status_t		gather_items(const BMessage& message, const char* name,
+					type_code type, int32 first, int32 count, ssize_t itemSize,
+					uint8* buffer);
+
+// GCC vector extensions; 16 bytes are SSE2 on x86 and NEON on ARM
+template<typename T>
+struct Vector {
+	typedef T type __attribute__((vector_size(16)));
+	static const size_t kLanes = 16 / sizeof(T);
+};
+
+#endif /* __NUMERIC_ITEM_H__ */
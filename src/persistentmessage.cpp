@@ -0,0 +1,410 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include "persistentmessage.h"
+
+PersistentItem::PersistentItem(const void* data, ssize_t size)
+: fData(NULL),
+  fSize(0)
+{
+	if(size > 0) {
+		fData = static_cast<uint8*>(malloc(size));
+		if(fData) {
+			memcpy(fData, data, size);
+			fSize = size;
+		}
+	}
+}
+
+PersistentItem::PersistentItem(PersistentMessage* message)
+: fData(NULL),
+  fSize(0),
+  fMessage(message)
+{
+}
+
+PersistentItem::~PersistentItem()
+{
+	free(fData);
+}
+
+// #pragma mark - PersistentField
+
+PersistentField*
+PersistentField::Create(const BMessage& message, const char* name,
+	const PersistentField* previous)
+{
+	type_code type;
+	int32 count;
+	bool fixedSize;
+	if(message.GetInfo(name, &type, &count) != B_OK
+		|| message.GetInfo(name, &type, &fixedSize) != B_OK)
+		return NULL;
+
+	if(previous && (previous->fType != type || previous->fFixedSize != fixedSize))
+		previous = NULL;
+
+	PersistentField* field = new PersistentField(name, type, fixedSize);
+	bool same = previous && previous->CountItems() == count;
+	for(int32 i = 0; i < count; i++) {
+		PersistentItem* old = previous && i < previous->CountItems()
+			? previous->ItemAt(i) : NULL;
+		PersistentItem* item;
+		if(type == B_MESSAGE_TYPE) {
+			BMessage member;
+			message.FindMessage(name, i, &member);
+			BReference<PersistentMessage> decoded(PersistentMessage::Create(
+				member, old ? old->Message() : NULL), true);
+			if(old && decoded.Get() == old->Message())
+				item = old;
+			else
+				item = new PersistentItem(decoded.Get());
+		} else {
+			const void* data;
+			ssize_t size;
+			if(message.FindData(name, type, i, &data, &size) != B_OK) {
+				same = false;
+				break;
+			}
+			if(old && old->Size() == size
+				&& (size == 0 || memcmp(old->Data(), data, size) == 0))
+				item = old;
+			else
+				item = new PersistentItem(data, size);
+		}
+		field->fItems.AddItem(BReference<PersistentItem>(item, item != old));
+		same = same && item == old;
+	}
+
+	if(same) {
+		field->ReleaseReference();
+		field = const_cast<PersistentField*>(previous);
+		field->AcquireReference();
+	}
+	return field;
+}
+
+status_t
+PersistentField::AddTo(BMessage* message) const
+{
+	for(int32 i = 0; i < fItems.CountItems(); i++) {
+		const PersistentItem* item = fItems.ItemAt(i);
+		status_t status;
+		if(item->Message()) {
+			BMessage member;
+			item->Message()->Materialize(&member);
+			status = message->AddMessage(Name(), &member);
+		} else {
+			status = message->AddData(Name(), fType, item->Data(),
+				item->Size(), fFixedSize);
+		}
+		if(status != B_OK)
+			return status;
+	}
+	return B_OK;
+}
+
+PersistentField::PersistentField(const char* name, type_code type,
+	bool fixedSize)
+: fName(name),
+  fType(type),
+  fFixedSize(fixedSize)
+{
+}
+
+PersistentField*
+PersistentField::_Copy() const
+{
+	PersistentField* copy = new PersistentField(Name(), fType, fFixedSize);
+	copy->fItems = fItems;
+	return copy;
+}
+
+// #pragma mark - PersistentMessage
+
+PersistentMessage*
+PersistentMessage::Create(const BMessage& message,
+	const PersistentMessage* previous)
+{
+	PersistentMessage* node = new PersistentMessage(message.what);
+	bool same = previous && previous->fWhat == message.what;
+
+	char* name;
+	type_code type;
+	for(int32 i = 0; message.GetInfo(B_ANY_TYPE, i, &name, &type) == B_OK; i++) {
+		// Names mostly stay where they were
+		const PersistentField* old = NULL;
+		if(previous) {
+			if(i < previous->CountFields()
+				&& strcmp(previous->FieldAt(i)->Name(), name) == 0)
+				old = previous->FieldAt(i);
+			else {
+				int32 index = previous->IndexOf(name);
+				old = index >= 0 ? previous->FieldAt(index) : NULL;
+			}
+		}
+
+		PersistentField* field = PersistentField::Create(message, name, old);
+		if(field)
+			node->fFields.AddItem(BReference<PersistentField>(field, true));
+		same = same && i < previous->CountFields()
+			&& field == previous->FieldAt(i)
+			&& node->CountFields() == i + 1;
+	}
+
+	if(same && node->CountFields() == previous->CountFields()) {
+		node->ReleaseReference();
+		node = const_cast<PersistentMessage*>(previous);
+		node->AcquireReference();
+	}
+	return node;
+}
+
+int32
+PersistentMessage::IndexOf(const char* name) const
+{
+	for(int32 i = 0; i < fFields.CountItems(); i++) {
+		if(strcmp(fFields.ItemAt(i)->Name(), name) == 0)
+			return i;
+	}
+	return -1;
+}
+
+PersistentMessage*
+PersistentMessage::Update(const BMessage& root, const BMessage& change,
+	bool wholeLevel) const
+{
+	return _Update(root, change, 0, wholeLevel);
+}
+
+status_t
+PersistentMessage::Materialize(BMessage* message) const
+{
+	message->what = fWhat;
+	for(int32 i = 0; i < fFields.CountItems(); i++) {
+		status_t status = fFields.ItemAt(i)->AddTo(message);
+		if(status != B_OK)
+			return status;
+	}
+	return B_OK;
+}
+
+status_t
+PersistentMessage::Apply(const PersistentMessage* from,
+	const PersistentMessage* to, BMessage* target, BMessage* changes)
+{
+	if(!from || !to || !target)
+		return B_BAD_VALUE;
+
+	BMessage path;
+	return _Apply(from, to, target, path, changes);
+}
+
+// #pragma mark - PersistentMessage::Private
+
+PersistentMessage::PersistentMessage(uint32 what)
+: fWhat(what)
+{
+}
+
+PersistentMessage*
+PersistentMessage::_Copy() const
+{
+	PersistentMessage* copy = new PersistentMessage(fWhat);
+	copy->fFields = fFields;
+	return copy;
+}
+
+PersistentMessage*
+PersistentMessage::_Update(const BMessage& live, const BMessage& change,
+	int32 depth, bool wholeLevel) const
+{
+	const char* pathName;
+	if(change.FindString("path", depth, &pathName) == B_OK) {
+		// Not there yet: copy this node with one member replaced
+		int32 member = change.GetInt32("member", depth, -1);
+		int32 index = IndexOf(pathName);
+		BMessage child;
+		if(index < 0 || live.FindMessage(pathName, member, &child) != B_OK)
+			return NULL;
+
+		const PersistentField* field = FieldAt(index);
+		if(member < 0 || member >= field->CountItems()
+			|| !field->ItemAt(member)->Message())
+			return NULL;
+
+		BReference<PersistentMessage> updated(field->ItemAt(member)->Message()
+			->_Update(child, change, depth + 1, wholeLevel), true);
+		if(!updated.Get())
+			return NULL;
+
+		PersistentField* fieldCopy = field->_Copy();
+		fieldCopy->fItems.SetItemAt(member, BReference<PersistentItem>(
+			new PersistentItem(updated.Get()), true));
+
+		PersistentMessage* copy = _Copy();
+		copy->fFields.SetItemAt(index,
+			BReference<PersistentField>(fieldCopy, true));
+		return copy;
+	}
+
+	// Everything below this level may have changed, what did not is
+	// still shared with this version
+	if(wholeLevel)
+		return Create(live, this);
+
+	PersistentMessage* copy = _Copy();
+	copy->fWhat = live.what;
+
+	const char* name;
+	for(int32 i = 0; change.FindString("name", i, &name) == B_OK; i++) {
+		int32 index = copy->IndexOf(name);
+		PersistentField* field = PersistentField::Create(live, name,
+			index >= 0 ? copy->FieldAt(index) : NULL);
+		if(!field) {
+			if(index >= 0)
+				copy->fFields.RemoveItemAt(index);
+			continue;
+		}
+
+		// BMessage appends new names after the existing ones
+		if(index >= 0)
+			copy->fFields.SetItemAt(index,
+				BReference<PersistentField>(field, true));
+		else
+			copy->fFields.AddItem(BReference<PersistentField>(field, true));
+	}
+
+	return copy;
+}
+
+status_t
+PersistentMessage::_Apply(const PersistentMessage* from,
+	const PersistentMessage* to, BMessage* target, const BMessage& path,
+	BMessage* changes)
+{
+	target->what = to->fWhat;
+	if(from == to)
+		return B_OK;
+
+	BMessage descriptor(path);
+	bool changed = false;
+
+	// Fields up to the first difference in names stay where they are and
+	// are patched in place
+	int32 fromCount = from->CountFields();
+	int32 toCount = to->CountFields();
+	int32 common = 0;
+	while(common < fromCount && common < toCount
+		&& strcmp(from->FieldAt(common)->Name(), to->FieldAt(common)->Name()) == 0
+		&& from->FieldAt(common)->Type() == to->FieldAt(common)->Type())
+		common++;
+
+	for(int32 i = 0; i < common; i++) {
+		const PersistentField* fromField = from->FieldAt(i);
+		const PersistentField* toField = to->FieldAt(i);
+		if(fromField == toField)
+			continue;
+
+		status_t status = _ApplyItems(fromField, toField, target, path, changes);
+		if(status != B_OK)
+			return status;
+
+		// Changes inside members are reported by the member itself
+		if(toField->Type() != B_MESSAGE_TYPE
+			|| fromField->CountItems() != toField->CountItems()) {
+			descriptor.AddString("name", toField->Name());
+			changed = true;
+		}
+	}
+
+	if(common < fromCount || common < toCount) {
+		// Removing a name moves everything behind it, so the tail is
+		// written again in the order of the target version
+		for(int32 i = fromCount - 1; i >= common; i--)
+			target->RemoveName(from->FieldAt(i)->Name());
+		for(int32 i = common; i < toCount; i++) {
+			status_t status = to->FieldAt(i)->AddTo(target);
+			if(status != B_OK)
+				return status;
+		}
+
+		if(common == fromCount || common == toCount) {
+			// Only added or only removed at the end
+			for(int32 i = common; i < std::max(fromCount, toCount); i++) {
+				descriptor.AddString("name", i < toCount
+					? to->FieldAt(i)->Name() : from->FieldAt(i)->Name());
+			}
+		} else
+			descriptor.AddBool("replaced", true);
+		changed = true;
+	}
+
+	if(changed && changes)
+		changes->AddMessage("change", &descriptor);
+	return B_OK;
+}
+
+status_t
+PersistentMessage::_ApplyItems(const PersistentField* from,
+	const PersistentField* to, BMessage* target, const BMessage& path,
+	BMessage* changes)
+{
+	const char* name = to->Name();
+	int32 fromCount = from->CountItems();
+	int32 toCount = to->CountItems();
+	int32 common = std::min(fromCount, toCount);
+
+	for(int32 i = 0; i < common; i++) {
+		const PersistentItem* fromItem = from->ItemAt(i);
+		const PersistentItem* toItem = to->ItemAt(i);
+		if(fromItem == toItem)
+			continue;
+
+		status_t status;
+		if(fromItem->Message() && toItem->Message()) {
+			BMessage member;
+			status = target->FindMessage(name, i, &member);
+			if(status != B_OK)
+				return status;
+
+			BMessage memberPath(path);
+			memberPath.AddString("path", name);
+			memberPath.AddInt32("member", i);
+			status = _Apply(fromItem->Message(), toItem->Message(), &member,
+				memberPath, changes);
+			if(status == B_OK)
+				status = target->ReplaceMessage(name, i, &member);
+		} else {
+			status = target->ReplaceData(name, to->Type(), i, toItem->Data(),
+				toItem->Size());
+		}
+		if(status != B_OK)
+			return status;
+	}
+
+	for(int32 i = fromCount - 1; i >= toCount; i--)
+		target->RemoveData(name, i);
+
+	for(int32 i = common; i < toCount; i++) {
+		const PersistentItem* item = to->ItemAt(i);
+		status_t status;
+		if(item->Message()) {
+			BMessage member;
+			item->Message()->Materialize(&member);
+			status = target->AddMessage(name, &member);
+		} else {
+			status = target->AddData(name, to->Type(), item->Data(),
+				item->Size(), to->fFixedSize);
+		}
+		if(status != B_OK)
+			return status;
+	}
+
+	return B_OK;
+}
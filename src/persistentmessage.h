@@ -0,0 +1,114 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef __PERSISTENT_MESSAGE_H__
+#define __PERSISTENT_MESSAGE_H__
+
+#include <Message.h>
+#include <Referenceable.h>
+#include <String.h>
+#include "persistentvector.h"
+
+class PersistentMessage;
+
+/*	One item of a field: a copy of its bytes, or the decoded member for
+	B_MESSAGE_TYPE fields.
+*/
+class PersistentItem : public BReferenceable
+{
+public:
+							PersistentItem(const void* data, ssize_t size);
+							PersistentItem(PersistentMessage* message);
+	virtual					~PersistentItem();
+
+			const void*		Data() const { return fData; }
+			ssize_t			Size() const { return fSize; }
+			PersistentMessage*	Message() const { return fMessage.Get(); }
+private:
+			uint8*			fData;
+			ssize_t			fSize;
+			BReference<PersistentMessage> fMessage;
+};
+
+class PersistentField : public BReferenceable
+{
+public:
+	static	PersistentField*	Create(const BMessage& message, const char* name,
+								const PersistentField* previous = NULL);
+
+			const char*		Name() const { return fName.String(); }
+			type_code		Type() const { return fType; }
+			int32			CountItems() const { return fItems.CountItems(); }
+			PersistentItem*	ItemAt(int32 index) const
+								{ return fItems.ItemAt(index); }
+
+			status_t		AddTo(BMessage* message) const;
+private:
+	friend class PersistentMessage;
+							PersistentField(const char* name, type_code type,
+								bool fixedSize);
+			PersistentField*	_Copy() const;
+private:
+			BString			fName;
+			type_code		fType;
+			bool			fFixedSize;
+			PersistentVector<PersistentItem> fItems;
+};
+
+/*	Immutable copy of a message. Edits never touch a node; Update() builds
+	a new root that copies only the messages on the path to the change and
+	shares every other field and member with the version it came from.
+	Fields and items sit in PersistentVectors, so a copied message or field
+	takes over their chunks and only the chunk holding the changed entry
+	is copied on each level.
+
+	Apply() turns the live BMessage of one version into another. Shared
+	nodes are skipped by pointer, so the work follows the size of the
+	difference, and the rows that need patching are reported with the
+	same "path"/"member"/"name" layout the message view uses.
+
+	Create() may be given the node the message was made from; whatever
+	did not change is taken over from it instead of being copied, and
+	when nothing changed at all the previous node itself is returned.
+	Pointers returned by Create() and Update() carry one reference for
+	the caller.
+*/
+class PersistentMessage : public BReferenceable
+{
+public:
+	static	PersistentMessage*	Create(const BMessage& message,
+								const PersistentMessage* previous = NULL);
+
+			uint32			What() const { return fWhat; }
+			int32			CountFields() const { return fFields.CountItems(); }
+			PersistentField*	FieldAt(int32 index) const
+								{ return fFields.ItemAt(index); }
+			int32			IndexOf(const char* name) const;
+
+			PersistentMessage*	Update(const BMessage& root,
+								const BMessage& change, bool wholeLevel) const;
+			status_t		Materialize(BMessage* message) const;
+
+	static	status_t		Apply(const PersistentMessage* from,
+								const PersistentMessage* to, BMessage* target,
+								BMessage* changes);
+private:
+							PersistentMessage(uint32 what);
+			PersistentMessage*	_Copy() const;
+			PersistentMessage*	_Update(const BMessage& live,
+								const BMessage& change, int32 depth,
+								bool wholeLevel) const;
+	static	status_t		_Apply(const PersistentMessage* from,
+								const PersistentMessage* to, BMessage* target,
+								const BMessage& path, BMessage* changes);
+	static	status_t		_ApplyItems(const PersistentField* from,
+								const PersistentField* to, BMessage* target,
+								const BMessage& path, BMessage* changes);
+private:
+			uint32			fWhat;
+			PersistentVector<PersistentField> fFields;
+};
+
+#endif /* __PERSISTENT_MESSAGE_H__ */
@@ -0,0 +1,135 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef __PERSISTENT_VECTOR_H__
+#define __PERSISTENT_VECTOR_H__
+
+#include <Referenceable.h>
+#include <SupportDefs.h>
+
+/*	Array of references kept in a tree of chunks of kChunkSize slots, the
+	index picking one slot per level. Copying the vector only takes over
+	the root; a chunk is copied when it is written to while another
+	vector still holds it, so changing one item of a copy costs one chunk
+	per level and every other chunk stays shared with the original.
+
+	Chunks that only this vector holds are written in place, which keeps
+	filling a new vector with AddItem() linear. RemoveItemAt() moves the
+	items behind the index down, the same as BMessage does for names.
+*/
+template<class T>
+class PersistentVector
+{
+public:
+	static	const int32		kChunkShift = 5;
+	static	const int32		kChunkSize = 1 << kChunkShift;
+
+							PersistentVector();
+
+			int32			CountItems() const { return fCount; }
+			T*				ItemAt(int32 index) const;
+
+			void			SetItemAt(int32 index, const BReference<T>& item);
+			void			AddItem(const BReference<T>& item);
+			void			RemoveItemAt(int32 index);
+private:
+	struct chunk : public BReferenceable {
+		BReference<BReferenceable>	slots[kChunkSize];
+	};
+
+	static	chunk*			_Own(BReference<BReferenceable>& slot);
+			BReference<BReferenceable>&	_Slot(int32 index);
+private:
+			BReference<BReferenceable> fRoot;
+			int32			fCount;
+			int32			fShift;
+};
+
+template<class T>
+PersistentVector<T>::PersistentVector()
+: fCount(0),
+  fShift(0)
+{
+}
+
+template<class T>
+T*
+PersistentVector<T>::ItemAt(int32 index) const
+{
+	const chunk* node = static_cast<const chunk*>(fRoot.Get());
+	for(int32 shift = fShift; shift > 0; shift -= kChunkShift) {
+		node = static_cast<const chunk*>(
+			node->slots[(index >> shift) & (kChunkSize - 1)].Get());
+	}
+	return static_cast<T*>(node->slots[index & (kChunkSize - 1)].Get());
+}
+
+template<class T>
+void
+PersistentVector<T>::SetItemAt(int32 index, const BReference<T>& item)
+{
+	_Slot(index).SetTo(item.Get());
+}
+
+template<class T>
+void
+PersistentVector<T>::AddItem(const BReference<T>& item)
+{
+	if(fCount == kChunkSize << fShift) {
+		// Full: the old root becomes the first slot of a new level
+		chunk* root = new chunk;
+		root->slots[0] = fRoot;
+		fRoot.SetTo(root, true);
+		fShift += kChunkShift;
+	}
+	_Slot(fCount++).SetTo(item.Get());
+}
+
+template<class T>
+void
+PersistentVector<T>::RemoveItemAt(int32 index)
+{
+	for(int32 i = index; i < fCount - 1; i++) {
+		T* next = ItemAt(i + 1);
+		_Slot(i).SetTo(next);
+	}
+	_Slot(--fCount).Unset();
+
+	if(fCount == 0) {
+		fRoot.Unset();
+		fShift = 0;
+	}
+}
+
+// The chunk in that slot, made private to this vector first
+template<class T>
+typename PersistentVector<T>::chunk*
+PersistentVector<T>::_Own(BReference<BReferenceable>& slot)
+{
+	chunk* node = static_cast<chunk*>(slot.Get());
+	if(!node) {
+		node = new chunk;
+		slot.SetTo(node, true);
+	} else if(node->CountReferences() > 1) {
+		chunk* copy = new chunk;
+		for(int32 i = 0; i < kChunkSize; i++)
+			copy->slots[i] = node->slots[i];
+		slot.SetTo(copy, true);
+		node = copy;
+	}
+	return node;
+}
+
+template<class T>
+BReference<BReferenceable>&
+PersistentVector<T>::_Slot(int32 index)
+{
+	chunk* node = _Own(fRoot);
+	for(int32 shift = fShift; shift > 0; shift -= kChunkShift)
+		node = _Own(node->slots[(index >> shift) & (kChunkSize - 1)]);
+	return node->slots[index & (kChunkSize - 1)];
+}
+
+#endif /* __PERSISTENT_VECTOR_H__ */
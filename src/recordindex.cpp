@@ -0,0 +1,433 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#include <Autolock.h>
+#include <ByteOrder.h>
+#include <File.h>
+#include <algorithm>
+#include <cstring>
+#include "blockcontainer.h"
+#include "byteswap.h"
+#include "checksum.h"
+#include "flatmessage.h"
+#include "legacymessage.h"
+#include "recordindex.h"
+
+// Large enough that the headers of small records come in by the thousand
+static const size_t kScanBlockSize = 256 * 1024;
+
+// How long a batch waits for the target's port before it checks whether
+// it is still wanted
+static const bigtime_t kPostTimeout = 100000;
+
+/*	Size of the checksum footer for a record of recordSize bytes at offset:
+	0 when there is none, -1 when the file ends inside what may be one.
+	The bytes at hand come from the scan block, the rest is read.
+*/
+static int32
+footer_size(BPositionIO* file, off_t offset, const uint8* data,
+	size_t available, uint32 recordSize)
+{
+	checksum_footer footer;
+	size_t length = std::min(available, sizeof(footer));
+	if(length > 0)
+		memcpy(&footer, data, length);
+	if(length < sizeof(footer)) {
+		ssize_t bytesRead = file->ReadAt(offset, &footer, sizeof(footer));
+		if(bytesRead < 0)
+			return 0;
+		length = bytesRead;
+	}
+
+	if(length < sizeof(footer)) {
+		uint32 magic = B_HOST_TO_LENDIAN_INT32(kChecksumFooterMagic);
+		return length > 0
+			&& memcmp(&footer, &magic, std::min(length, sizeof(magic))) == 0
+			? -1 : 0;
+	}
+	return B_LENDIAN_TO_HOST_INT32(footer.magic) == kChecksumFooterMagic
+		&& B_LENDIAN_TO_HOST_INT64(footer.length) == recordSize
+		? (int32)sizeof(footer) : 0;
+}
+
+status_t
+native_record(std::vector<uint8>& flat, bool* swapped)
+{
+	uint32 magic = 0;
+	if(flat.size() >= sizeof(magic))
+		memcpy(&magic, flat.data(), sizeof(magic));
+	if(swapped) {
+		*swapped = magic == kFlatMessageFormatSwapped
+			|| magic == (uint32)B_SWAP_INT32(kR5MessageFormat)
+			|| magic == (uint32)B_SWAP_INT32(kDanoMessageFormat);
+	}
+
+	// Unflatten() trusts the sizes in the header, they are checked first
+	if(flattened_message_size(flat.data(), flat.size()) != (ssize_t)flat.size())
+		return B_BAD_DATA;
+
+	status_t status = B_OK;
+	if(is_legacy_message(flat.data(), flat.size())) {
+		std::vector<uint8> upgraded;
+		status = upgrade_legacy_message(flat.data(), flat.size(), upgraded);
+		flat.swap(upgraded);
+	} else if(is_swapped_flat_message(flat.data(), flat.size()))
+		status = swap_flat_message(flat.data(), flat.size());
+
+	return status;
+}
+
+status_t
+unflatten_record(std::vector<uint8>& flat, BMessage* message, bool* swapped)
+{
+	status_t status = native_record(flat, swapped);
+	if(status != B_OK)
+		return status;
+	return message->Unflatten((const char*)flat.data());
+}
+
+// #pragma mark -
+
+RecordIndex::RecordIndex()
+: fScanned(0)
+{
+}
+
+status_t
+RecordIndex::SetTo(BPositionIO* file)
+{
+	Unset();
+	return _Scan(file);
+}
+
+void
+RecordIndex::Unset()
+{
+	fRecords.clear();
+	fScanned = 0;
+}
+
+status_t
+RecordIndex::Update(BPositionIO* file, int32* added, bool* reset)
+{
+	bool rescan = Revalidate(file);
+	int32 count = fRecords.size();
+
+	status_t status = _Scan(file);
+	if(added)
+		*added = fRecords.size() - count;
+	if(reset)
+		*reset = rescan;
+	return status;
+}
+
+bool
+RecordIndex::Revalidate(BPositionIO* file)
+{
+	if(_StillValid(file))
+		return false;
+
+	Unset();
+	return true;
+}
+
+status_t
+RecordIndex::ScanOn(BPositionIO* file, int32 limit, bool* more)
+{
+	return _Scan(file, limit, more);
+}
+
+void
+RecordIndex::AddRecords(const message_record* records, int32 count,
+	off_t scannedSize)
+{
+	fRecords.insert(fRecords.end(), records, records + count);
+	fScanned = scannedSize;
+}
+
+status_t
+RecordIndex::ReadRecord(BPositionIO* file, int32 index, BMessage* message,
+	bool* swapped) const
+{
+	if(index < 0 || index >= (int32)fRecords.size())
+		return B_BAD_INDEX;
+
+	const message_record& record = fRecords[index];
+	std::vector<uint8> flat(record.size);
+	ssize_t bytesRead = file->ReadAt(record.offset, flat.data(), flat.size());
+	if(bytesRead < 0)
+		return bytesRead;
+	if((size_t)bytesRead != flat.size())
+		return B_IO_ERROR;
+
+	return unflatten_record(flat, message, swapped);
+}
+
+// #pragma mark - RecordIndex::Private
+
+bool
+RecordIndex::_StillValid(BPositionIO* file) const
+{
+	off_t size;
+	if(file->GetSize(&size) != B_OK || size < fScanned)
+		return false;
+	if(fRecords.empty())
+		return true;
+
+	// Rewriting a log in place is caught by its last record changing
+	const message_record& last = fRecords.back();
+	uint8 header[sizeof(flat_message_header)];
+	ssize_t bytesRead = file->ReadAt(last.offset, header, sizeof(header));
+	if(bytesRead <= 0)
+		return false;
+
+	uint32 what;
+	ssize_t recordSize = flattened_message_size(header, bytesRead, &what);
+	return recordSize == (ssize_t)last.size && what == last.what;
+}
+
+status_t
+RecordIndex::_Scan(BPositionIO* file, int32 limit, bool* more)
+{
+	if(more)
+		*more = false;
+
+	off_t fileSize;
+	status_t status = file->GetSize(&fileSize);
+	if(status != B_OK)
+		return status;
+
+	std::vector<uint8> block(kScanBlockSize);
+	off_t blockStart = fScanned;
+	size_t blockLength = 0;
+	bool refilled = false;
+	off_t offset = fScanned;
+
+	// The footer of the last record may have been written after it
+	bool afterRecord = !fRecords.empty()
+		&& fScanned == fRecords.back().offset + fRecords.back().size;
+	size_t end = limit >= 0 ? fRecords.size() + limit : SIZE_MAX;
+
+	while(offset < fileSize) {
+		// The footer of the last record still belongs to this scan
+		if(fRecords.size() >= end && !afterRecord) {
+			if(more)
+				*more = true;
+			break;
+		}
+
+		// offset never goes back, the block is behind or around it
+		size_t local = offset - blockStart;
+		size_t available = local < blockLength ? blockLength - local : 0;
+		const uint8* data = available > 0 ? block.data() + local : NULL;
+
+		// Footers written by Kottan are part of the record
+		if(afterRecord) {
+			afterRecord = false;
+			int32 footer = footer_size(file, offset, data, available,
+				fRecords.back().size);
+			if(footer < 0)
+				break;
+			offset += footer;
+			fScanned = offset;
+			continue;
+		}
+
+		uint32 what = 0;
+		ssize_t size = available > 0
+			? flattened_message_size(data, available, &what) : 0;
+		if(size == 0) {
+			// Even a fresh block ends inside the header: still being written
+			if(refilled)
+				break;
+			ssize_t bytesRead = file->ReadAt(offset, block.data(), block.size());
+			if(bytesRead < 0)
+				return bytesRead;
+			blockStart = offset;
+			blockLength = bytesRead;
+			refilled = true;
+			continue;
+		}
+		refilled = false;
+
+		if(size < 0 || (uint64)size > UINT32_MAX) {
+			status = B_BAD_DATA;
+			break;
+		}
+		if(offset + size > fileSize)
+			break;
+
+		message_record record;
+		record.offset = offset;
+		record.size = size;
+		record.what = what;
+		fRecords.push_back(record);
+		offset += size;
+		fScanned = offset;
+		afterRecord = true;
+	}
+
+	return status;
+}
+
+// #pragma mark - RecordScanner
+
+RecordScanner::RecordScanner(BMessenger target)
+: fTarget(target),
+  fLock("record scanner"),
+  fWakeUp(create_sem(0, "record scanner wake up")),
+  fThread(-1),
+  fQuitting(false),
+  fPending(false),
+  fFromStart(true),
+  fGeneration(0)
+{
+	fThread = spawn_thread(_Worker, "record scanner", B_LOW_PRIORITY, this);
+	if(fThread >= 0)
+		resume_thread(fThread);
+}
+
+RecordScanner::~RecordScanner()
+{
+	fLock.Lock();
+	fQuitting = true;
+	fLock.Unlock();
+
+	release_sem(fWakeUp);
+	if(fThread >= 0) {
+		status_t result;
+		wait_for_thread(fThread, &result);
+	}
+	delete_sem(fWakeUp);
+}
+
+uint32
+RecordScanner::Scan(const entry_ref& ref, bool fromStart)
+{
+	BAutolock _(fLock);
+	// Going on from the end waits for a running scan, starting over
+	// stops it
+	if(fromStart) {
+		fGeneration++;
+		fFromStart = true;
+	}
+	fRef = ref;
+	fPending = true;
+	release_sem(fWakeUp);
+	return fGeneration;
+}
+
+void
+RecordScanner::Stop()
+{
+	BAutolock _(fLock);
+	fGeneration++;
+	fPending = false;
+	fFromStart = true;
+}
+
+// #pragma mark - RecordScanner::Private
+
+status_t
+RecordScanner::_Worker(void* data)
+{
+	RecordScanner* scanner = static_cast<RecordScanner*>(data);
+	while(acquire_sem(scanner->fWakeUp) == B_OK) {
+		scanner->fLock.Lock();
+		if(scanner->fQuitting) {
+			scanner->fLock.Unlock();
+			break;
+		}
+		bool pending = scanner->fPending;
+		entry_ref ref = scanner->fRef;
+		bool fromStart = scanner->fFromStart;
+		uint32 generation = scanner->fGeneration;
+		scanner->fPending = false;
+		scanner->fFromStart = false;
+		scanner->fLock.Unlock();
+
+		if(!pending)
+			continue;
+
+		// The receiver missed what was scanned since the last batch
+		if(!scanner->_Run(ref, fromStart, generation))
+			scanner->fIndex.Unset();
+	}
+	return B_OK;
+}
+
+/*	Scans the file in batches and posts each of them. Returns false when
+	a batch could not be delivered, because a newer scan was asked for or
+	the target is gone.
+*/
+bool
+RecordScanner::_Run(const entry_ref& ref, bool fromStart, uint32 generation)
+{
+	BFile file(&ref, B_READ_ONLY);
+	BlockContainerIO container;
+	BPositionIO* source = &file;
+	status_t status = file.InitCheck();
+	if(status == B_OK) {
+		status = container.SetTo(&file);
+		if(status == B_OK)
+			source = &container;
+		else if(status == B_BAD_TYPE)
+			status = B_OK;
+	}
+
+	bool reset = fromStart || fIndex.CountRecords() == 0;
+	if(reset)
+		fIndex.Unset();
+	else if(status == B_OK)
+		reset = fIndex.Revalidate(source);
+
+	// Two records tell a stream from a single message, they go first
+	int32 limit = reset ? 2 : kBatchSize;
+	for(;;) {
+		int32 first = fIndex.CountRecords();
+		bool more = false;
+		if(status == B_OK)
+			status = fIndex.ScanOn(source, limit, &more);
+
+		BMessage batch(RS_RECORDS);
+		batch.AddUInt32("generation", generation);
+		batch.AddInt32("first", first);
+		batch.AddBool("reset", reset);
+		int32 count = fIndex.CountRecords() - first;
+		if(count > 0) {
+			batch.AddData("records", B_RAW_TYPE, fIndex.Records() + first,
+				count * sizeof(message_record));
+		}
+		batch.AddInt64("scanned", fIndex.ScannedSize());
+		batch.AddBool("done", !more);
+		batch.AddInt32("status", status);
+		if(!_Post(&batch, generation))
+			return false;
+		if(!more)
+			return true;
+
+		reset = false;
+		limit = kBatchSize;
+	}
+}
+
+bool
+RecordScanner::_Post(BMessage* batch, uint32 generation)
+{
+	while(_IsCurrent(generation)) {
+		status_t status = fTarget.SendMessage(batch, (BHandler*)NULL,
+			kPostTimeout);
+		if(status != B_TIMED_OUT && status != B_WOULD_BLOCK)
+			return status == B_OK;
+	}
+	return false;
+}
+
+bool
+RecordScanner::_IsCurrent(uint32 generation)
+{
+	BAutolock _(fLock);
+	return !fQuitting && generation == fGeneration;
+}
@@ -0,0 +1,144 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef __RECORD_INDEX_H__
+#define __RECORD_INDEX_H__
+
+#include <DataIO.h>
+#include <Entry.h>
+#include <Locker.h>
+#include <Message.h>
+#include <Messenger.h>
+#include <OS.h>
+#include <SupportDefs.h>
+#include <vector>
+
+enum {
+	RS_RECORDS = 'rs00'		// "generation", "first", "reset", "records",
+							// "scanned", "done", "status"
+};
+
+struct message_record {
+	off_t		offset;
+	uint32		size;
+	uint32		what;
+} _PACKED;
+
+/*	Converts a flattened message of any layout to the native one of this
+	host, in place or by replacing the buffer. swapped tells whether it
+	was written on a host of the other byte order.
+*/
+status_t	native_record(std::vector<uint8>& flat, bool* swapped = NULL);
+
+// Unflattens a message whatever its layout, by way of native_record()
+status_t	unflatten_record(std::vector<uint8>& flat, BMessage* message,
+				bool* swapped = NULL);
+
+/*	Where the flattened messages of a file written as a stream begin: logs
+	append one message after the other, native or legacy and in either
+	byte order, each optionally followed by a checksum footer. The file is
+	read once, front to back, in large blocks; only the headers are looked
+	at and the bodies of large records are skipped over. Update() carries
+	on where the last scan stopped, so appended records cost only their
+	own bytes.
+*/
+class RecordIndex
+{
+public:
+							RecordIndex();
+
+			// Rescans from the start
+			status_t		SetTo(BPositionIO* file);
+			void			Unset();
+
+			/*	Adds the records appended since the last scan. When the
+				file no longer matches the index (it was truncated or
+				rewritten) it is scanned again from the start and reset
+				is set. A record still being written is left for the
+				next update. Returns B_BAD_DATA when bytes that are no
+				message follow the last record.
+			*/
+			status_t		Update(BPositionIO* file, int32* added = NULL,
+								bool* reset = NULL);
+
+			// Drops the index when the file no longer matches it
+			bool			Revalidate(BPositionIO* file);
+			/*	Scans on from the last record for at most limit more;
+				more is set when it stopped there.
+			*/
+			status_t		ScanOn(BPositionIO* file, int32 limit,
+								bool* more);
+			// Appends records scanned by another index of the file
+			void			AddRecords(const message_record* records,
+								int32 count, off_t scannedSize);
+
+			int32			CountRecords() const { return fRecords.size(); }
+			const message_record& RecordAt(int32 index) const
+								{ return fRecords[index]; }
+			const message_record* Records() const
+								{ return fRecords.empty() ? NULL : &fRecords[0]; }
+
+			// End of the last complete record
+			off_t			ScannedSize() const { return fScanned; }
+
+			// Reads and unflattens one record, whatever its layout
+			status_t		ReadRecord(BPositionIO* file, int32 index,
+								BMessage* message, bool* swapped = NULL) const;
+private:
+			bool			_StillValid(BPositionIO* file) const;
+			status_t		_Scan(BPositionIO* file, int32 limit = -1,
+								bool* more = NULL);
+private:
+	std::vector<message_record> fRecords;
+			off_t			fScanned;
+};
+
+/*	Keeps a RecordIndex of a file in a thread of its own and posts what
+	it finds to the target as RS_RECORDS batches. The first batch of a
+	scan from the start holds no more than two records, enough to tell a
+	stream from a single message. The thread opens the file itself, a
+	block container is read through a BlockContainerIO of its own.
+
+	Batches carry the generation of the scan. Starting over and Stop()
+	begin a new one and stop a scan that is still running, while going
+	on from the end keeps the generation and runs after it, so the
+	batches of one generation follow each other without gaps. After
+	Stop() the next scan starts over.
+*/
+class RecordScanner
+{
+public:
+	static	const int32		kBatchSize = 4096;
+
+							RecordScanner(BMessenger target);
+							~RecordScanner();
+
+			// From the start, or on from the end of the last scan.
+			// Returns the generation of the batches
+			uint32			Scan(const entry_ref& ref, bool fromStart);
+			void			Stop();
+private:
+	static	status_t		_Worker(void* data);
+			bool			_Run(const entry_ref& ref, bool fromStart,
+								uint32 generation);
+			bool			_Post(BMessage* batch, uint32 generation);
+			bool			_IsCurrent(uint32 generation);
+private:
+			BMessenger		fTarget;
+			BLocker			fLock;
+			sem_id			fWakeUp;
+			thread_id		fThread;
+
+			// Guarded by fLock
+			bool			fQuitting;
+			bool			fPending;
+			bool			fFromStart;
+			entry_ref		fRef;
+			uint32			fGeneration;
+
+			RecordIndex		fIndex;			// the thread's own
+};
+
+#endif /* __RECORD_INDEX_H__ */
@@ -0,0 +1,409 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#include <Catalog.h>
+#include <LayoutBuilder.h>
+#include <Window.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include "recordlistview.h"
+
+#undef B_TRANSLATION_CONTEXT
+#define B_TRANSLATION_CONTEXT "RecordListView"
+
+static const float kMargin = 4.0f;
+
+// Number, offset, size and code, in characters of the fixed font
+static const int32 kOffsetColumn = 9;
+static const int32 kSizeColumn = 22;
+static const int32 kCodeColumn = 34;
+static const int32 kMaxLineLength = 64;
+
+// The scroll bar counts lines, so it drives the view instead of scrolling it
+class RecordScrollBar : public BScrollBar
+{
+public:
+	RecordScrollBar(RecordListView* view)
+		: BScrollBar("recordscrollbar", NULL, 0, 0, B_VERTICAL),
+		  fView(view)
+	{
+	}
+
+	virtual void ValueChanged(float value)
+	{
+		BScrollBar::ValueChanged(value);
+		fView->SetTopLine(static_cast<int32>(value));
+	}
+private:
+	RecordListView*	fView;
+};
+
+RecordListView::RecordListView(const char* name)
+: BView(name, B_WILL_DRAW | B_FRAME_EVENTS | B_NAVIGABLE),
+  fTopLine(0),
+  fSelection(-1),
+  fScrollBar(NULL)
+{
+	SetFont(be_fixed_font);
+	_UpdateFont();
+}
+
+void
+RecordListView::AddRecords(const message_record* records, int32 count)
+{
+	if(count <= 0)
+		return;
+
+	// A list scrolled to its end follows the stream as it grows
+	int32 visible = _VisibleLines();
+	bool atEnd = fTopLine + visible >= (int32)fRecords.size();
+
+	fRecords.insert(fRecords.end(), records, records + count);
+	_UpdateScrollBar();
+	if(atEnd && (int32)fRecords.size() > visible)
+		_ScrollTo(fRecords.size() - visible);
+	Invalidate();
+}
+
+void
+RecordListView::MakeEmpty()
+{
+	fRecords.clear();
+	fTopLine = 0;
+	fSelection = -1;
+	if(fScrollBar)
+		fScrollBar->SetValue(0);
+	_UpdateScrollBar();
+	Invalidate();
+}
+
+void
+RecordListView::Select(int32 index)
+{
+	if(fRecords.empty())
+		return;
+
+	index = std::max((int32)0, std::min(index, (int32)fRecords.size() - 1));
+	if(index == fSelection)
+		return;
+
+	fSelection = index;
+	_ScrollToSelection();
+	Invalidate();
+
+	if(Window()) {
+		BMessage message(RV_RECORD_SELECTED);
+		message.AddInt32("index", index);
+		Window()->PostMessage(&message);
+	}
+}
+
+void
+RecordListView::SetScrollBar(BScrollBar* scrollBar)
+{
+	fScrollBar = scrollBar;
+	_UpdateScrollBar();
+}
+
+void
+RecordListView::SetTopLine(int32 line)
+{
+	int32 count = fRecords.size();
+	int32 visible = _VisibleLines();
+	line = std::max((int32)0, std::min(line, count - visible));
+	if(line == fTopLine)
+		return;
+
+	fTopLine = line;
+	Invalidate();
+}
+
+void
+RecordListView::AttachedToWindow()
+{
+	BView::AttachedToWindow();
+	SetViewColor(B_TRANSPARENT_COLOR);
+	SetLowUIColor(B_LIST_BACKGROUND_COLOR);
+	_UpdateScrollBar();
+}
+
+void
+RecordListView::Draw(BRect updateRect)
+{
+	FillRect(updateRect, B_SOLID_LOW);
+
+	// Column titles on the first line, they do not scroll
+	BRect titles(Bounds());
+	titles.bottom = fLineHeight - 1;
+	if(updateRect.Intersects(titles)) {
+		SetHighColor(tint_color(ui_color(B_PANEL_BACKGROUND_COLOR),
+			B_DARKEN_1_TINT));
+		FillRect(titles);
+		SetHighUIColor(B_PANEL_TEXT_COLOR);
+		float y = fAscent;
+		DrawString(B_TRANSLATE("Record"), BPoint(kMargin, y));
+		DrawString(B_TRANSLATE("Offset"),
+			BPoint(kMargin + kOffsetColumn * fCharWidth, y));
+		DrawString(B_TRANSLATE("Size"),
+			BPoint(kMargin + kSizeColumn * fCharWidth, y));
+		DrawString(B_TRANSLATE("Code"),
+			BPoint(kMargin + kCodeColumn * fCharWidth, y));
+	}
+
+	int32 first = std::max(1, (int32)floorf(updateRect.top / fLineHeight));
+	int32 last = (int32)ceilf(updateRect.bottom / fLineHeight);
+	int32 count = fRecords.size();
+
+	char buffer[kMaxLineLength];
+	for(int32 row = first; row <= last; row++) {
+		int32 index = fTopLine + row - 1;
+		if(index >= count)
+			break;
+
+		float y = row * fLineHeight;
+		if(index == fSelection) {
+			SetHighUIColor(B_LIST_SELECTED_BACKGROUND_COLOR);
+			FillRect(BRect(0, y, Bounds().right, y + fLineHeight - 1));
+			SetHighUIColor(B_LIST_SELECTED_ITEM_TEXT_COLOR);
+		} else
+			SetHighUIColor(B_LIST_ITEM_TEXT_COLOR);
+
+		int32 length = _FormatLine(index, buffer);
+		DrawString(buffer, length, BPoint(kMargin, y + fAscent));
+	}
+}
+
+void
+RecordListView::FrameResized(float width, float height)
+{
+	BView::FrameResized(width, height);
+	_UpdateScrollBar();
+	SetTopLine(fTopLine);
+}
+
+void
+RecordListView::KeyDown(const char* bytes, int32 numBytes)
+{
+	int32 page = std::max(_VisibleLines() - 1, (int32)1);
+	switch(bytes[0]) {
+		case B_UP_ARROW:
+			Select(fSelection - 1);
+			break;
+		case B_DOWN_ARROW:
+			Select(fSelection + 1);
+			break;
+		case B_PAGE_UP:
+			Select(fSelection - page);
+			break;
+		case B_PAGE_DOWN:
+			Select(fSelection + page);
+			break;
+		case B_HOME:
+			Select(0);
+			break;
+		case B_END:
+			Select(fRecords.size() - 1);
+			break;
+		case B_ENTER:
+			_Invoke();
+			break;
+		default:
+			BView::KeyDown(bytes, numBytes);
+			break;
+	}
+}
+
+void
+RecordListView::MessageReceived(BMessage* message)
+{
+	if(message->what == B_MOUSE_WHEEL_CHANGED) {
+		int32 delta = (int32)message->GetFloat("be:wheel_delta_y", 0.0f) * 3;
+		_ScrollTo(fTopLine + delta);
+		return;
+	}
+
+	BView::MessageReceived(message);
+}
+
+void
+RecordListView::MouseDown(BPoint where)
+{
+	MakeFocus(true);
+
+	int32 row = (int32)floorf(where.y / fLineHeight);
+	int32 index = fTopLine + row - 1;
+	if(row <= 0 || index >= (int32)fRecords.size())
+		return;
+
+	Select(index);
+	int32 clicks = 1;
+	if(Window() && Window()->CurrentMessage())
+		Window()->CurrentMessage()->FindInt32("clicks", &clicks);
+	if(clicks == 2)
+		_Invoke();
+}
+
+BSize
+RecordListView::MinSize()
+{
+	return BSize(kMargin * 2 + fCharWidth * (kCodeColumn + 12),
+		fLineHeight * 4);
+}
+
+BSize
+RecordListView::PreferredSize()
+{
+	BSize size = MinSize();
+	size.height = fLineHeight * 16;
+	return size;
+}
+
+// #pragma mark - RecordListView::Private
+
+int32
+RecordListView::_VisibleLines() const
+{
+	// The first line holds the column titles
+	return std::max((int32)0,
+		(int32)floorf((Bounds().Height() + 1) / fLineHeight) - 1);
+}
+
+int32
+RecordListView::_FormatLine(int32 index, char* buffer) const
+{
+	const message_record& record = fRecords[index];
+
+	// Codes made of four printable characters are shown as such
+	char code[16];
+	uint32 what = record.what;
+	bool printable = true;
+	for(int32 i = 0; i < 4; i++) {
+		uint8 c = what >> (24 - i * 8);
+		printable &= c >= 0x20 && c < 0x7f;
+	}
+	if(printable) {
+		snprintf(code, sizeof(code), "'%c%c%c%c'", (char)(what >> 24),
+			(char)(what >> 16), (char)(what >> 8), (char)what);
+	} else
+		snprintf(code, sizeof(code), "0x%08" B_PRIx32, what);
+
+	int32 length = snprintf(buffer, kMaxLineLength,
+		"%7" B_PRId32 "  %012" B_PRIx64 " %11" B_PRIu32 " %s", index,
+		(uint64)record.offset, record.size, code);
+	return std::min(length, kMaxLineLength - 1);
+}
+
+void
+RecordListView::_Invoke()
+{
+	if(fSelection < 0 || !Window())
+		return;
+
+	BMessage message(RV_RECORD_INVOKED);
+	message.AddInt32("index", fSelection);
+	Window()->PostMessage(&message);
+}
+
+void
+RecordListView::_ScrollTo(int32 line)
+{
+	// Through the scroll bar, so that it stays in step
+	if(fScrollBar)
+		fScrollBar->SetValue(line);
+	else
+		SetTopLine(line);
+}
+
+void
+RecordListView::_ScrollToSelection()
+{
+	int32 visible = std::max(_VisibleLines(), (int32)1);
+	if(fSelection < fTopLine)
+		_ScrollTo(fSelection);
+	else if(fSelection >= fTopLine + visible)
+		_ScrollTo(fSelection - visible + 1);
+}
+
+void
+RecordListView::_UpdateFont()
+{
+	font_height height;
+	GetFontHeight(&height);
+	fAscent = ceilf(height.ascent);
+	fLineHeight = ceilf(height.ascent + height.descent + height.leading);
+	fCharWidth = StringWidth("0");
+}
+
+void
+RecordListView::_UpdateScrollBar()
+{
+	if(!fScrollBar)
+		return;
+
+	int32 count = fRecords.size();
+	int32 visible = _VisibleLines();
+	float maximum = count > visible ? count - visible : 0;
+
+	fScrollBar->SetRange(0, maximum);
+	fScrollBar->SetProportion(count > 0
+		? std::min(1.0f, (float)visible / count) : 1.0f);
+	fScrollBar->SetSteps(1, std::max(1.0f, (float)visible - 1));
+}
+
+// #pragma mark - RecordPanel
+
+RecordPanel::RecordPanel(const char* name)
+: BView(name, B_SUPPORTS_LAYOUT),
+  fScanStatus(B_OK)
+{
+	fListView = new RecordListView("recordlist");
+	BScrollBar* scrollBar = new RecordScrollBar(fListView);
+	fListView->SetScrollBar(scrollBar);
+	fStatus = new BStringView("recordstatus", "");
+
+	BLayoutBuilder::Group<>(this, B_VERTICAL, B_USE_SMALL_SPACING)
+		.AddGroup(B_HORIZONTAL, 0)
+			.Add(fListView)
+			.Add(scrollBar)
+		.End()
+		.Add(fStatus);
+}
+
+void
+RecordPanel::AddRecords(const message_record* records, int32 count)
+{
+	fListView->AddRecords(records, count);
+	_UpdateStatus();
+}
+
+void
+RecordPanel::MakeEmpty()
+{
+	fListView->MakeEmpty();
+	fScanStatus = B_OK;
+	_UpdateStatus();
+}
+
+void
+RecordPanel::SetScanStatus(status_t status)
+{
+	fScanStatus = status;
+	_UpdateStatus();
+}
+
+// #pragma mark - RecordPanel::Private
+
+void
+RecordPanel::_UpdateStatus()
+{
+	BString status;
+	status.SetToFormat(B_TRANSLATE("%" B_PRId32 " records"),
+		fListView->CountRecords());
+	if(fScanStatus != B_OK)
+		status << ", " << B_TRANSLATE("unreadable data after the last one");
+	fStatus->SetText(status);
+}
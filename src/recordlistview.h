@@ -0,0 +1,93 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef __RECORD_LIST_VIEW_H__
+#define __RECORD_LIST_VIEW_H__
+
+#include <ScrollBar.h>
+#include <StringView.h>
+#include <View.h>
+#include <vector>
+
+#include "recordindex.h"
+
+enum {
+	RV_RECORD_SELECTED = 'rv00',
+	RV_RECORD_INVOKED
+};
+
+/*	Records of a message stream, one line each: number, offset, size and
+	message code. Like the hex view it formats only the lines on screen
+	and its scroll bar counts lines, so a log of a million records is as
+	quick to scroll as one of ten. The window is told about a new
+	selection with RV_RECORD_SELECTED and its "index", and about a record
+	double clicked or entered with RV_RECORD_INVOKED.
+*/
+class RecordListView : public BView
+{
+public:
+							RecordListView(const char* name);
+
+			void			AddRecords(const message_record* records,
+								int32 count);
+			void			MakeEmpty();
+			int32			CountRecords() const { return fRecords.size(); }
+			const message_record& RecordAt(int32 index) const
+								{ return fRecords[index]; }
+
+			void			Select(int32 index);
+			int32			CurrentSelection() const { return fSelection; }
+
+			void			SetScrollBar(BScrollBar* scrollBar);
+			void			SetTopLine(int32 line);
+
+	virtual	void			AttachedToWindow();
+	virtual	void			Draw(BRect updateRect);
+	virtual	void			FrameResized(float width, float height);
+	virtual	void			KeyDown(const char* bytes, int32 numBytes);
+	virtual	void			MessageReceived(BMessage* message);
+	virtual	void			MouseDown(BPoint where);
+	virtual	BSize			MinSize();
+	virtual	BSize			PreferredSize();
+private:
+			int32			_VisibleLines() const;
+			int32			_FormatLine(int32 index, char* buffer) const;
+			void			_Invoke();
+			void			_ScrollTo(int32 line);
+			void			_ScrollToSelection();
+			void			_UpdateFont();
+			void			_UpdateScrollBar();
+private:
+	std::vector<message_record> fRecords;
+			int32			fTopLine;
+			int32			fSelection;
+
+			BScrollBar*		fScrollBar;
+			float			fLineHeight;
+			float			fCharWidth;
+			float			fAscent;
+};
+
+// The list with its scroll bar and a count of the records
+class RecordPanel : public BView
+{
+public:
+							RecordPanel(const char* name);
+
+			RecordListView*	ListView() const { return fListView; }
+
+			void			AddRecords(const message_record* records,
+								int32 count);
+			void			MakeEmpty();
+			void			SetScanStatus(status_t status);
+private:
+			void			_UpdateStatus();
+private:
+			RecordListView*	fListView;
+			BStringView*	fStatus;
+			status_t		fScanStatus;
+};
+
+#endif /* __RECORD_LIST_VIEW_H__ */
@@ -0,0 +1,364 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#include <Autolock.h>
+#include <NodeMonitor.h>
+#include <Path.h>
+#include <cstring>
+#include "refpathcache.h"
+
+// Replies go out after this many refs, so long fields fill in as they go
+static const size_t kBatchSize = 256;
+
+RefPathCache* RefPathCache::sDefault = NULL;
+
+bool
+RefPathCache::key::operator==(const key& other) const
+{
+	return device == other.device && directory == other.directory
+		&& name == other.name;
+}
+
+size_t
+RefPathCache::key_hash::operator()(const key& k) const
+{
+	// FNV-1a over the name, mixed with the directory
+	size_t hash = 2166136261u;
+	for(const char* c = k.name.String(); *c; c++)
+		hash = (hash ^ (uint8)*c) * 16777619u;
+	return hash ^ (size_t)(k.directory * 31 + k.device);
+}
+
+size_t
+RefPathCache::node_hash::operator()(const node_ref& node) const
+{
+	return (size_t)(node.node * 31 + node.device);
+}
+
+RefPathCache::RefPathCache()
+: BLooper("ref path cache", B_LOW_PRIORITY),
+  fLock("ref path cache")
+{
+	sDefault = this;
+}
+
+RefPathCache::~RefPathCache()
+{
+	stop_watching(this);
+	if(sDefault == this)
+		sDefault = NULL;
+}
+
+bool
+RefPathCache::Lookup(const entry_ref& ref, ref_info* info)
+{
+	BAutolock _(fLock);
+	return _Find(_KeyFor(ref), info);
+}
+
+bool
+RefPathCache::Lookup(const entry_ref& ref, ref_info* info, BMessenger target,
+	int32 cookie)
+{
+	BAutolock _(fLock);
+	if(_Find(_KeyFor(ref), info))
+		return true;
+
+	request queued;
+	queued.ref = ref;
+	queued.target = target;
+	queued.cookie = cookie;
+	fPending.push_back(queued);
+	if(fPending.size() == 1)
+		PostMessage(RPC_RESOLVE);
+	return false;
+}
+
+void
+RefPathCache::Resolve(const entry_ref& ref, ref_info* info)
+{
+	key k = _KeyFor(ref);
+	{
+		BAutolock _(fLock);
+		if(_Find(k, info))
+			return;
+	}
+
+	// The file system is asked without holding the lock
+	ResolveUncached(ref, info);
+	std::vector<node_ref> ancestors;
+	_GetAncestors(*info, &ancestors);
+
+	BAutolock _(fLock);
+	_Store(k, *info, ancestors);
+}
+
+void
+RefPathCache::ResolveUncached(const entry_ref& ref, ref_info* info)
+{
+	BEntry entry(&ref);
+	info->exists = entry.Exists();
+	info->path = "";
+	info->node = node_ref();
+	if(!info->exists)
+		return;
+
+	BPath path;
+	if(entry.GetPath(&path) == B_OK)
+		info->path = path.Path();
+	entry.GetNodeRef(&info->node);
+}
+
+void
+RefPathCache::MessageReceived(BMessage* message)
+{
+	switch(message->what) {
+		case RPC_RESOLVE:
+			_ResolvePending();
+			break;
+		case B_NODE_MONITOR:
+			_NodeMonitor(message);
+			break;
+		default:
+			BLooper::MessageReceived(message);
+	}
+}
+
+// #pragma mark - RefPathCache::Private
+
+RefPathCache::key
+RefPathCache::_KeyFor(const entry_ref& ref)
+{
+	key k;
+	k.device = ref.device;
+	k.directory = ref.directory;
+	k.name = ref.name;
+	return k;
+}
+
+// The directories above the parent of an entry, up to the one below the
+// root, which cannot be moved
+void
+RefPathCache::_GetAncestors(const ref_info& info,
+	std::vector<node_ref>* ancestors)
+{
+	if(!info.exists)
+		return;
+
+	BString path(info.path);
+	for(int32 level = 0; ; level++) {
+		int32 slash = path.FindLast('/');
+		if(slash <= 0)
+			break;
+		path.Truncate(slash);
+		if(level == 0)
+			continue;
+
+		node_ref node;
+		if(BEntry(path.String()).GetNodeRef(&node) == B_OK)
+			ancestors->push_back(node);
+	}
+}
+
+bool
+RefPathCache::_Find(const key& k, ref_info* info)
+{
+	auto found = fIndex.find(k);
+	if(found == fIndex.end())
+		return false;
+
+	fEntries.splice(fEntries.begin(), fEntries, found->second);
+	*info = found->second->info;
+	return true;
+}
+
+void
+RefPathCache::_Store(const key& k, const ref_info& info,
+	const std::vector<node_ref>& ancestors)
+{
+	auto found = fIndex.find(k);
+	if(found != fIndex.end()) {
+		entry& cached = *found->second;
+		for(size_t i = 0; i < ancestors.size(); i++)
+			_Watch(ancestors[i], 0, 1);
+		for(size_t i = 0; i < cached.ancestors.size(); i++)
+			_Watch(cached.ancestors[i], 0, -1);
+		cached.info = info;
+		cached.ancestors = ancestors;
+		return;
+	}
+
+	entry added;
+	added.k = k;
+	added.info = info;
+	added.ancestors = ancestors;
+	fEntries.push_front(added);
+	fIndex[k] = fEntries.begin();
+
+	node_ref directory;
+	directory.device = k.device;
+	directory.node = k.directory;
+	_Watch(directory, 1, 0);
+	for(size_t i = 0; i < ancestors.size(); i++)
+		_Watch(ancestors[i], 0, 1);
+
+	if(fEntries.size() > kMaxEntries)
+		_Drop(--fEntries.end());
+}
+
+// Parents are watched for their contents, ancestors only for their name;
+// the flags of a node change when it stops or starts being either
+void
+RefPathCache::_Watch(const node_ref& node, int32 entries, int32 descendants)
+{
+	watch& watched = fWatched[node];
+	uint32 before = watched.entries > 0 ? B_WATCH_DIRECTORY | B_WATCH_NAME
+		: watched.descendants > 0 ? B_WATCH_NAME : 0;
+	watched.entries += entries;
+	watched.descendants += descendants;
+	uint32 after = watched.entries > 0 ? B_WATCH_DIRECTORY | B_WATCH_NAME
+		: watched.descendants > 0 ? B_WATCH_NAME : 0;
+
+	if(after == 0)
+		fWatched.erase(node);
+	if(after == before)
+		return;
+	if(before != 0)
+		watch_node(&node, B_STOP_WATCHING, this);
+	if(after != 0)
+		watch_node(&node, after, this);
+}
+
+void
+RefPathCache::_Drop(entry_list::iterator it)
+{
+	node_ref directory;
+	directory.device = it->k.device;
+	directory.node = it->k.directory;
+	_Watch(directory, -1, 0);
+	for(size_t i = 0; i < it->ancestors.size(); i++)
+		_Watch(it->ancestors[i], 0, -1);
+
+	fIndex.erase(it->k);
+	fEntries.erase(it);
+}
+
+void
+RefPathCache::_DropDirectory(dev_t device, ino_t directory)
+{
+	for(auto it = fEntries.begin(); it != fEntries.end();) {
+		auto current = it++;
+		if(current->k.device == device && current->k.directory == directory)
+			_Drop(current);
+	}
+}
+
+void
+RefPathCache::_DropBelow(dev_t device, ino_t ancestor)
+{
+	for(auto it = fEntries.begin(); it != fEntries.end();) {
+		auto current = it++;
+		for(size_t i = 0; i < current->ancestors.size(); i++) {
+			if(current->ancestors[i].device == device
+				&& current->ancestors[i].node == ancestor) {
+				_Drop(current);
+				break;
+			}
+		}
+	}
+}
+
+void
+RefPathCache::_ResolvePending()
+{
+	struct reply {
+		BMessenger		target;
+		BMessage		message;
+	};
+
+	std::vector<request> pending;
+	{
+		BAutolock _(fLock);
+		pending.swap(fPending);
+	}
+
+	std::vector<reply> replies;
+	for(size_t i = 0; i < pending.size(); i++) {
+		const request& current = pending[i];
+		ref_info info;
+		Resolve(current.ref, &info);
+
+		size_t target = 0;
+		while(target < replies.size()
+			&& !(replies[target].target == current.target))
+			target++;
+		if(target == replies.size()) {
+			replies.push_back(reply());
+			replies.back().target = current.target;
+			replies.back().message.what = RPC_PATHS_RESOLVED;
+		}
+
+		BMessage& message = replies[target].message;
+		message.AddInt32("cookie", current.cookie);
+		message.AddRef("refs", &current.ref);
+		message.AddString("path", info.path);
+		message.AddBool("exists", info.exists);
+
+		if((i + 1) % kBatchSize == 0 || i + 1 == pending.size()) {
+			for(size_t j = 0; j < replies.size(); j++)
+				replies[j].target.SendMessage(&replies[j].message);
+			replies.clear();
+		}
+	}
+
+	// More may have come in while the file system was busy
+	BAutolock _(fLock);
+	if(!fPending.empty())
+		PostMessage(RPC_RESOLVE);
+}
+
+void
+RefPathCache::_NodeMonitor(BMessage* message)
+{
+	BAutolock _(fLock);
+
+	dev_t device = message->GetInt32("device", -1);
+	int64 directory;
+	switch(message->GetInt32("opcode", 0)) {
+		case B_ENTRY_CREATED:
+		case B_ENTRY_REMOVED:
+			if(message->FindInt64("directory", &directory) == B_OK)
+				_DropDirectory(device, directory);
+			break;
+		case B_ENTRY_MOVED:
+		{
+			if(message->FindInt64("from directory", &directory) == B_OK)
+				_DropDirectory(device, directory);
+			if(message->FindInt64("to directory", &directory) == B_OK)
+				_DropDirectory(device, directory);
+
+			// A watched directory that moved changes the path of everything
+			// cached inside it or further down
+			int64 node;
+			if(message->FindInt64("node", &node) == B_OK) {
+				_DropDirectory(device, node);
+				_DropBelow(device, node);
+			}
+			break;
+		}
+	}
+}
+
+// #pragma mark -
+
+void
+resolve_ref(const entry_ref& ref, ref_info* info)
+{
+	RefPathCache* cache = RefPathCache::Default();
+	if(cache)
+		cache->Resolve(ref, info);
+	else
+		RefPathCache::ResolveUncached(ref, info);
+}
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef __REF_PATH_CACHE_H__
+#define __REF_PATH_CACHE_H__
+
+#include <Entry.h>
+#include <Locker.h>
+#include <Looper.h>
+#include <Messenger.h>
+#include <Node.h>
+#include <String.h>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+enum {
+	RPC_RESOLVE = 'rp00',
+	RPC_PATHS_RESOLVED		// "cookie", "refs", "path" and "exists", in step
+};
+
+struct ref_info {
+	bool			exists;
+	BString			path;	// empty unless exists
+	node_ref		node;
+};
+
+/*	Bounded cache of what entry_refs point to. Looking up a ref that is not
+	in the cache yet returns at once; the ref is resolved by the looper
+	thread, and the target gets RPC_PATHS_RESOLVED with the cookie it
+	passed in, one message per batch. Resolve() is the blocking version
+	for callers that need a single answer right away.
+
+	The parent directory of every cached entry is node monitored; any
+	change in it, or a rename or move of the directory itself, drops the
+	entries below it. The directories further up only have their names
+	watched, so that moving any of them drops every entry whose path ran
+	through it. Entries past kMaxEntries are dropped least recently used
+	first, together with the watches no other entry needs.
+*/
+class RefPathCache : public BLooper
+{
+public:
+	static	const size_t	kMaxEntries = 4096;
+
+							RefPathCache();
+	virtual					~RefPathCache();
+
+	static	RefPathCache*	Default() { return sDefault; }
+
+			bool			Lookup(const entry_ref& ref, ref_info* info);
+			bool			Lookup(const entry_ref& ref, ref_info* info,
+								BMessenger target, int32 cookie);
+			void			Resolve(const entry_ref& ref, ref_info* info);
+	static	void			ResolveUncached(const entry_ref& ref,
+								ref_info* info);
+
+	virtual	void			MessageReceived(BMessage* message);
+private:
+	struct key {
+		dev_t			device;
+		ino_t			directory;
+		BString			name;
+
+		bool			operator==(const key& other) const;
+	};
+
+	struct key_hash {
+		size_t			operator()(const key& k) const;
+	};
+
+	struct node_hash {
+		size_t			operator()(const node_ref& node) const;
+	};
+
+	struct entry {
+		key				k;
+		ref_info		info;
+		std::vector<node_ref> ancestors;	// above the parent directory
+	};
+
+	// How many entries a directory is the parent and an ancestor of
+	struct watch {
+		int32			entries;
+		int32			descendants;
+	};
+
+	struct request {
+		entry_ref		ref;
+		BMessenger		target;
+		int32			cookie;
+	};
+
+	typedef std::list<entry> entry_list;
+
+	static	key				_KeyFor(const entry_ref& ref);
+	static	void			_GetAncestors(const ref_info& info,
+								std::vector<node_ref>* ancestors);
+			bool			_Find(const key& k, ref_info* info);
+			void			_Store(const key& k, const ref_info& info,
+								const std::vector<node_ref>& ancestors);
+			void			_Watch(const node_ref& node, int32 entries,
+								int32 descendants);
+			void			_Drop(entry_list::iterator it);
+			void			_DropDirectory(dev_t device, ino_t directory);
+			void			_DropBelow(dev_t device, ino_t ancestor);
+			void			_ResolvePending();
+			void			_NodeMonitor(BMessage* message);
+private:
+	static	RefPathCache*	sDefault;
+
+			BLocker			fLock;
+			entry_list		fEntries;	// most recent first
+			std::unordered_map<key, entry_list::iterator, key_hash> fIndex;
+			std::unordered_map<node_ref, watch, node_hash> fWatched;
+			std::vector<request> fPending;
+};
+
+// Resolves through the shared cache, or straight away when there is none
+void		resolve_ref(const entry_ref& ref, ref_info* info);
+
+#endif /* __REF_PATH_CACHE_H__ */
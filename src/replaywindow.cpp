@@ -0,0 +1,314 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#include <Alert.h>
+#include <Catalog.h>
+#include <LayoutBuilder.h>
+#include <MenuItem.h>
+#include <Path.h>
+#include <cstdlib>
+#include <cstring>
+
+#include "replaywindow.h"
+#include "whatwindow.h"
+
+#undef B_TRANSLATION_CONTEXT
+#define B_TRANSLATION_CONTEXT "ReplayWindow"
+
+static const char* kDefaultPath = "/tmp/kottan-capture";
+static const float kSpeeds[] = { 1, 2, 10, 0 };
+
+ReplayWindow::ReplayWindow(BRect frame, const entry_ref* stream)
+: BWindow(frame, B_TRANSLATE("Replay stream"), B_TITLED_WINDOW,
+	B_ASYNCHRONOUS_CONTROLS | B_AUTO_UPDATE_SIZE_LIMITS | B_NOT_ZOOMABLE),
+  fReplay(NULL),
+  fSpeed(kSpeeds[0]),
+  fOpenPanel(NULL)
+{
+	fReplay = new MessageReplay(BMessenger(this));
+
+	fStreamName = new BStringView("stream", "");
+	BButton* chooseButton = new BButton("choose",
+		B_TRANSLATE("Choose" B_UTF8_ELLIPSIS), new BMessage(RW_CHOOSE_STREAM));
+	fPath = new BTextControl("path", NULL, kDefaultPath, NULL);
+
+	const char* speedNames[] = {
+		B_TRANSLATE("Recorded pace"),
+		B_TRANSLATE("2× faster"),
+		B_TRANSLATE("10× faster"),
+		B_TRANSLATE("As fast as possible")
+	};
+	BPopUpMenu* speedMenu = new BPopUpMenu("speed");
+	for(size_t i = 0; i < sizeof(kSpeeds) / sizeof(kSpeeds[0]); i++) {
+		BMessage* message = new BMessage(RW_SPEED_CHANGED);
+		message->AddFloat("speed", kSpeeds[i]);
+		BMenuItem* item = new BMenuItem(speedNames[i], message);
+		item->SetMarked(i == 0);
+		speedMenu->AddItem(item);
+	}
+	fSpeedField = new BMenuField("speed", NULL, speedMenu);
+
+	// Several codes can be marked, so the label is kept by hand
+	fFilterMenu = new BPopUpMenu("filter", false, false);
+	fFilterMenu->AddItem(new BMenuItem(B_TRANSLATE("All codes"),
+		new BMessage(RW_FILTER_CHANGED)));
+	fFilterMenu->AddSeparatorItem();
+	int32 count;
+	const predefined_cmds* whats = predefined_whats(&count);
+	for(int32 i = 0; i < count; i++) {
+		BMessage* message = new BMessage(RW_FILTER_CHANGED);
+		message->AddUInt32("what_value", whats[i].command);
+		fFilterMenu->AddItem(new BMenuItem(whats[i].name, message));
+	}
+	BMenuField* filterField = new BMenuField("filter", NULL, fFilterMenu);
+
+	fInterval = new BTextControl("interval", NULL, "1", NULL);
+	fInterval->SetToolTip(B_TRANSLATE("Time between messages that carry no "
+		"\"when\" field, in milliseconds at the recorded pace"));
+
+	fStartButton = new BButton("start", B_TRANSLATE("Start"),
+		new BMessage(RW_START_STOP));
+	fProgress = new BStringView("progress", "");
+	fRate = new BStringView("rate", "");
+	fLateness = new BStringView("lateness", "");
+
+	BLayoutBuilder::Group<>(this, B_VERTICAL, B_USE_DEFAULT_SPACING)
+		.SetInsets(B_USE_WINDOW_INSETS)
+		.AddGrid(B_USE_SMALL_SPACING, B_USE_SMALL_SPACING)
+			.Add(new BStringView("streamlabel", B_TRANSLATE("Stream:")), 0, 0)
+			.AddGroup(B_HORIZONTAL, B_USE_SMALL_SPACING, 1, 0)
+				.Add(fStreamName)
+				.AddGlue()
+				.Add(chooseButton)
+			.End()
+			.Add(new BStringView("pathlabel",
+				B_TRANSLATE("Socket or pipe:")), 0, 1)
+			.Add(fPath, 1, 1)
+			.Add(new BStringView("speedlabel", B_TRANSLATE("Speed:")), 0, 2)
+			.Add(fSpeedField, 1, 2)
+			.Add(new BStringView("filterlabel", B_TRANSLATE("Messages:")), 0, 3)
+			.Add(filterField, 1, 3)
+			.Add(new BStringView("intervallabel",
+				B_TRANSLATE("Interval without \"when\" (ms):")), 0, 4)
+			.Add(fInterval, 1, 4)
+		.End()
+		.Add(fProgress)
+		.Add(fRate)
+		.Add(fLateness)
+		.AddGroup(B_HORIZONTAL)
+			.AddGlue()
+			.Add(fStartButton)
+		.End()
+	.End();
+
+	AddShortcut('W', B_COMMAND_KEY, new BMessage(B_QUIT_REQUESTED));
+
+	_SetStream(stream);
+	_UpdateFilterLabel();
+	_UpdateStatus(NULL);
+}
+
+ReplayWindow::~ReplayWindow()
+{
+	delete fReplay;
+	delete fOpenPanel;
+}
+
+void
+ReplayWindow::MessageReceived(BMessage* msg)
+{
+	switch(msg->what)
+	{
+		case RW_CHOOSE_STREAM:
+		{
+			if(!fOpenPanel) {
+				BMessenger target(this);
+				fOpenPanel = new BFilePanel(B_OPEN_PANEL, &target, NULL,
+					B_FILE_NODE, false, new BMessage(RW_STREAM_CHOSEN));
+			}
+			fOpenPanel->Show();
+			break;
+		}
+
+		case RW_STREAM_CHOSEN:
+		{
+			entry_ref ref;
+			if(msg->FindRef("refs", &ref) == B_OK)
+				_SetStream(&ref);
+			break;
+		}
+
+		case RW_SPEED_CHANGED:
+			fSpeed = msg->GetFloat("speed", kSpeeds[0]);
+			fInterval->SetEnabled(fSpeed > 0);
+			break;
+
+		// A code toggles, "All codes" clears them
+		case RW_FILTER_CHANGED:
+		{
+			BMenuItem* item = fFilterMenu->ItemAt(msg->GetInt32("index", -1));
+			if(item == NULL)
+				break;
+			if(msg->HasUInt32("what_value"))
+				item->SetMarked(!item->IsMarked());
+			else {
+				for(int32 i = 0; i < fFilterMenu->CountItems(); i++)
+					fFilterMenu->ItemAt(i)->SetMarked(false);
+			}
+			_UpdateFilterLabel();
+			break;
+		}
+
+		case RW_START_STOP:
+			if(fReplay->IsRunning()) {
+				fReplay->RequestStop();
+				fStartButton->SetEnabled(false);
+			} else
+				_Start();
+			break;
+
+		case MR_PROGRESS:
+			_UpdateStatus(msg);
+			break;
+
+		case MR_FINISHED:
+		{
+			fReplay->Stop();
+			_UpdateStatus(msg);
+			fStartButton->SetEnabled(true);
+			_UpdateControls();
+
+			status_t status = msg->GetInt32("status", B_OK);
+			if(status != B_OK) {
+				BString text;
+				text.SetToFormat(B_TRANSLATE("The replay stopped: %s"),
+					strerror(status));
+				(new BAlert("", text, B_TRANSLATE("OK"), NULL, NULL,
+					B_WIDTH_AS_USUAL, B_STOP_ALERT))->Go(NULL);
+			}
+			break;
+		}
+
+		default:
+			BWindow::MessageReceived(msg);
+	}
+}
+
+bool
+ReplayWindow::QuitRequested()
+{
+	fReplay->Stop();
+	return true;
+}
+
+// #pragma mark - ReplayWindow::Private
+
+void
+ReplayWindow::_SetStream(const entry_ref* stream)
+{
+	if(stream)
+		fStream = *stream;
+
+	fStreamName->SetText(fStream.name ? fStream.name
+		: B_TRANSLATE("No stream chosen"));
+	_UpdateControls();
+}
+
+void
+ReplayWindow::_Start()
+{
+	replay_options options;
+	options.speed = fSpeed;
+	options.interval = (bigtime_t)(atof(fInterval->Text()) * 1000);
+	for(int32 i = 0; i < fFilterMenu->CountItems(); i++) {
+		BMenuItem* item = fFilterMenu->ItemAt(i);
+		if(item->IsMarked() && item->Message())
+			options.whats.push_back(item->Message()->GetUInt32("what_value", 0));
+	}
+
+	status_t status = fReplay->Start(&fStream, fPath->Text(), options);
+	if(status != B_OK) {
+		BString text;
+		if(status == B_NOT_ALLOWED) {
+			text.SetToFormat(B_TRANSLATE("Nothing reads from the pipe %s."),
+				fPath->Text());
+		} else {
+			text.SetToFormat(B_TRANSLATE("The replay could not be started: %s"),
+				strerror(status));
+		}
+		(new BAlert("", text, B_TRANSLATE("OK"), NULL, NULL,
+			B_WIDTH_AS_USUAL, B_STOP_ALERT))->Go(NULL);
+		return;
+	}
+
+	_UpdateControls();
+}
+
+void
+ReplayWindow::_UpdateFilterLabel()
+{
+	BString label;
+	int32 marked = 0;
+	for(int32 i = 0; i < fFilterMenu->CountItems(); i++) {
+		BMenuItem* item = fFilterMenu->ItemAt(i);
+		if(item->IsMarked()) {
+			if(marked++ == 0)
+				label = item->Label();
+		}
+	}
+
+	if(marked == 0)
+		label = B_TRANSLATE("All codes");
+	else if(marked > 1)
+		label.SetToFormat(B_TRANSLATE("%" B_PRId32 " codes"), marked);
+	fFilterMenu->Superitem()->SetLabel(label);
+}
+
+void
+ReplayWindow::_UpdateControls()
+{
+	bool running = fReplay->IsRunning();
+	fStartButton->SetLabel(running ? B_TRANSLATE("Stop") : B_TRANSLATE("Start"));
+	fStartButton->SetEnabled(running || fStream.name != NULL);
+	fPath->SetEnabled(!running);
+	fSpeedField->SetEnabled(!running);
+	fFilterMenu->Superitem()->SetEnabled(!running);
+	fInterval->SetEnabled(!running && fSpeed > 0);
+}
+
+void
+ReplayWindow::_UpdateStatus(const BMessage* progress)
+{
+	if(!progress) {
+		fProgress->SetText(B_TRANSLATE("Not replaying"));
+		fRate->SetText("");
+		fLateness->SetText("");
+		return;
+	}
+
+	BString text;
+	text.SetToFormat(B_TRANSLATE("Sent %" B_PRId64 " of %" B_PRId64
+		" messages, %" B_PRId64 " filtered out"),
+		progress->GetInt64("sent", 0), progress->GetInt64("total", 0),
+		progress->GetInt64("filtered", 0));
+	fProgress->SetText(text);
+
+	float requested = progress->GetFloat("requested", -1);
+	float achieved = progress->GetFloat("achieved", 0);
+	if(requested < 0) {
+		text.SetToFormat(B_TRANSLATE("Achieved %.0f messages/s, as fast as "
+			"possible was asked for"), achieved);
+	} else {
+		text.SetToFormat(B_TRANSLATE("Achieved %.0f of %.0f messages/s "
+			"asked for"), achieved, requested);
+	}
+	fRate->SetText(text);
+
+	text.SetToFormat(B_TRANSLATE("Late by %" B_PRId64 " µs on average, "
+		"jitter %" B_PRId64 " µs, worst %" B_PRId64 " µs"),
+		progress->GetInt64("late_mean", 0), progress->GetInt64("jitter", 0),
+		progress->GetInt64("late_max", 0));
+	fLateness->SetText(text);
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef __REPLAY_WINDOW_H__
+#define __REPLAY_WINDOW_H__
+
+#include <Button.h>
+#include <Entry.h>
+#include <FilePanel.h>
+#include <MenuField.h>
+#include <PopUpMenu.h>
+#include <StringView.h>
+#include <TextControl.h>
+#include <Window.h>
+
+#include "messagereplay.h"
+
+enum {
+	RW_CHOOSE_STREAM = 'rw00',
+	RW_STREAM_CHOSEN,
+	RW_SPEED_CHANGED,
+	RW_FILTER_CHANGED,
+	RW_START_STOP
+};
+
+/*	Plays a stream file back into a socket or named pipe, at the recorded
+	pace, faster, or as fast as the receiver takes it, optionally only
+	the messages of some of the system codes. Reports how close the
+	replay came to the pace it was asked for.
+*/
+class ReplayWindow : public BWindow
+{
+public:
+					ReplayWindow(BRect frame, const entry_ref* stream);
+					~ReplayWindow();
+
+	virtual void	MessageReceived(BMessage* msg);
+	virtual bool	QuitRequested();
+private:
+			void	_SetStream(const entry_ref* stream);
+			void	_Start();
+			void	_UpdateFilterLabel();
+			void	_UpdateControls();
+			void	_UpdateStatus(const BMessage* progress);
+private:
+	MessageReplay*	fReplay;
+	entry_ref		fStream;
+	float			fSpeed;
+
+	BStringView*	fStreamName;
+	BTextControl*	fPath;
+	BTextControl*	fInterval;
+	BMenuField*		fSpeedField;
+	BPopUpMenu*		fFilterMenu;
+	BButton*		fStartButton;
+	BStringView*	fProgress;
+	BStringView*	fRate;
+	BStringView*	fLateness;
+	BFilePanel*		fOpenPanel;
+};
+
+#endif /* __REPLAY_WINDOW_H__ */
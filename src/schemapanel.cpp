@@ -0,0 +1,343 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#include <Catalog.h>
+#include <LayoutBuilder.h>
+#include <Window.h>
+#include <private/interface/ColumnTypes.h>
+#include <string.h>
+
+#include "gettype.h"
+#include "schemapanel.h"
+
+#undef B_TRANSLATION_CONTEXT
+#define B_TRANSLATION_CONTEXT "SchemaPanel"
+
+// A deviation and where it is, for MessageView::SelectField()
+class DeviationRow : public BRow
+{
+public:
+	DeviationRow(const BMessage& location)
+		: fLocation(location) {}
+
+	const BMessage&	Location() const { return fLocation; }
+
+private:
+	BMessage		fLocation;
+};
+
+static BString
+type_list(const BMessage* deviation, const char* name)
+{
+	BString list;
+	type_code type;
+	for(int32 i = 0; deviation->FindUInt32(name, i, &type) == B_OK; i++) {
+		if(i > 0)
+			list << ", ";
+		list << get_type(type);
+	}
+	return list;
+}
+
+SchemaPanel::SchemaPanel(const char* name)
+: BView(name, B_SUPPORTS_LAYOUT),
+  fScanner(NULL),
+  fThread(-1),
+  fHasSchema(false)
+{
+	fProgress = new BStatusBar("schemaprogress");
+	fProgress->SetMaxValue(1.0f);
+
+	fSchemaList = new BColumnListView("schemalist", 0);
+	fSchemaList->AddColumn(new BStringColumn(B_TRANSLATE("Name"), 150, 50, 1000, 0), 0);
+	fSchemaList->AddColumn(new BStringColumn(B_TRANSLATE("Type"), 130, 50, 1000, 0), 1);
+	fSchemaList->AddColumn(new BStringColumn(B_TRANSLATE("Items"), 60, 10, 150, 0), 2);
+	fSchemaList->AddColumn(new BStringColumn(B_TRANSLATE("Present"), 70, 10, 150, 0), 3);
+	fSchemaList->AddColumn(new BStringColumn(B_TRANSLATE("Range"), 150, 10, 1000, 0), 4);
+
+	fDeviationList = new BColumnListView("deviationlist", 0);
+	fDeviationList->AddColumn(new BStringColumn(B_TRANSLATE("Field"), 150, 50, 1000, 0), 0);
+	fDeviationList->AddColumn(new BStringColumn(B_TRANSLATE("Deviation"), 250, 50, 1000, 0), 1);
+	fDeviationList->SetInvocationMessage(new BMessage(SCHEMA_DEVIATION_SELECTED));
+
+	fDeviationStatus = new BStringView("deviationstatus", "");
+
+	BLayoutBuilder::Group<>(this, B_VERTICAL, B_USE_SMALL_SPACING)
+		.Add(fProgress)
+		.AddSplit(B_VERTICAL, B_USE_SMALL_SPACING)
+			.Add(fSchemaList, 0.6f)
+			.AddGroup(B_VERTICAL, B_USE_SMALL_SPACING, 0.4f)
+				.Add(fDeviationList)
+				.Add(fDeviationStatus)
+			.End()
+		.End();
+}
+
+SchemaPanel::~SchemaPanel()
+{
+	_StopScanning();
+	delete fScanner;
+}
+
+void
+SchemaPanel::DetachedFromWindow()
+{
+	_StopScanning();
+	BView::DetachedFromWindow();
+}
+
+void
+SchemaPanel::MessageReceived(BMessage* msg)
+{
+	switch(msg->what)
+	{
+		case SS_PROGRESS:
+			_ShowProgress(msg);
+			break;
+
+		case SS_FINISHED:
+		{
+			_StopScanning();
+			_ShowProgress(msg);
+
+			BMessage archive;
+			status_t status = msg->GetInt32("status", B_OK);
+			if(status == B_OK)
+				status = msg->FindMessage("schema", &archive);
+			if(status == B_OK)
+				status = fSchema.SetTo(&archive);
+
+			BString text;
+			if(status == B_OK) {
+				fHasSchema = true;
+				_ShowSchema();
+				text.SetToFormat(B_TRANSLATE("%" B_PRId64 " messages in %"
+					B_PRId32 " files of %s"), msg->GetInt64("messages", 0),
+					msg->GetInt32("files", 0) - msg->GetInt32("skipped", 0),
+					fDirectory.name);
+				Window()->PostMessage(SCHEMA_READY);
+			} else if(status != B_CANCELED) {
+				text.SetToFormat(B_TRANSLATE("No schema could be inferred: %s"),
+					strerror(status));
+			}
+			fProgress->SetText(text.String());
+			break;
+		}
+
+		default:
+			BView::MessageReceived(msg);
+			break;
+	}
+}
+
+void
+SchemaPanel::Infer(const entry_ref& directory)
+{
+	_StopScanning();
+	delete fScanner;
+
+	fDirectory = directory;
+	fScanner = new SchemaScanner(BMessenger(this));
+	fProgress->Reset(B_TRANSLATE("Looking for message files" B_UTF8_ELLIPSIS));
+
+	fThread = spawn_thread(_ScanThread, "schema inference", B_LOW_PRIORITY,
+		this);
+	if(fThread < 0) {
+		BString error;
+		error.SetToFormat(B_TRANSLATE("No schema could be inferred: %s"),
+			strerror(fThread));
+		fProgress->SetText(error.String());
+		return;
+	}
+	resume_thread(fThread);
+}
+
+status_t
+SchemaPanel::Check(const void* data, size_t size, BMessage* deviations) const
+{
+	if(!fHasSchema)
+		return B_NO_INIT;
+
+	return fSchema.Check(data, size, deviations);
+}
+
+void
+SchemaPanel::SetDeviations(const BMessage* deviations)
+{
+	fDeviationList->Clear();
+	if(deviations == NULL) {
+		fDeviationStatus->SetText("");
+		return;
+	}
+
+	BMessage deviation;
+	int32 count = 0;
+	for(; deviations->FindMessage("deviation", count, &deviation) == B_OK;
+		count++) {
+		BString path;
+		const char* name;
+		for(int32 i = 0; deviation.FindString("path", i, &name) == B_OK; i++) {
+			path << name << "[" << deviation.GetInt32("member", i, 0)
+				<< "]/";
+		}
+		path << deviation.GetString("name", "");
+
+		BRow* row = new DeviationRow(deviation);
+		row->SetField(new BStringField(path), 0);
+		row->SetField(new BStringField(deviation.GetString("text", "")), 1);
+		fDeviationList->AddRow(row);
+	}
+
+	if(count == 0)
+		fDeviationStatus->SetText(B_TRANSLATE("The message fits the schema"));
+	else {
+		BString status;
+		status.SetToFormat(B_TRANSLATE("%" B_PRId32 " deviations"), count);
+		fDeviationStatus->SetText(status.String());
+	}
+}
+
+bool
+SchemaPanel::SelectedDeviation(BMessage* location) const
+{
+	DeviationRow* row = dynamic_cast<DeviationRow*>(
+		fDeviationList->CurrentSelection());
+	if(row == NULL)
+		return false;
+
+	*location = row->Location();
+	return true;
+}
+
+BString
+SchemaPanel::DeviationText(const BMessage* deviation)
+{
+	BString text;
+	const char* found = deviation->GetString("found", "");
+	const char* expected = deviation->GetString("expected", "");
+
+	switch(deviation->GetInt32("kind", -1)) {
+		case SCHEMA_UNKNOWN_FIELD:
+			text = B_TRANSLATE("Not in the schema");
+			break;
+		case SCHEMA_MISSING_FIELD:
+			text.SetToFormat(B_TRANSLATE("\"%s\" (%s) is missing"),
+				deviation->GetString("name", ""),
+				type_list(deviation, "expected_type").String());
+			break;
+		case SCHEMA_TYPE_MISMATCH:
+			text.SetToFormat(B_TRANSLATE("%s instead of %s"),
+				type_list(deviation, "found_type").String(),
+				type_list(deviation, "expected_type").String());
+			break;
+		case SCHEMA_COUNT_OUT_OF_RANGE:
+			text.SetToFormat(B_TRANSLATE("%s items, expected %s"), found,
+				expected);
+			break;
+		case SCHEMA_VALUE_OUT_OF_RANGE:
+			text.SetToFormat(B_TRANSLATE("Item %" B_PRId32 " is %s, "
+				"expected %s"), deviation->GetInt32("item", 0), found,
+				expected);
+			break;
+		case SCHEMA_SIZE_OUT_OF_RANGE:
+			text.SetToFormat(B_TRANSLATE("Item %" B_PRId32 " is %s bytes "
+				"long, expected %s"), deviation->GetInt32("item", 0), found,
+				expected);
+			break;
+		case SCHEMA_WHAT_MISMATCH:
+			text.SetToFormat(B_TRANSLATE("The message is %s, expected %s"),
+				found, expected);
+			break;
+	}
+	return text;
+}
+
+// #pragma mark - SchemaPanel::Private
+
+status_t
+SchemaPanel::_ScanThread(void* data)
+{
+	SchemaPanel* panel = static_cast<SchemaPanel*>(data);
+	return panel->fScanner->Run(panel->fDirectory);
+}
+
+void
+SchemaPanel::_StopScanning()
+{
+	if(fThread < 0)
+		return;
+
+	fScanner->Cancel();
+
+	// The thread may be waiting for our port to accept a report, let it
+	// through while we wait for it
+	thread_id thread = fThread;
+	fThread = -1;
+	BWindow* window = Window();
+	bool locked = window != NULL && window->IsLocked();
+	if(locked)
+		window->Unlock();
+	status_t result;
+	wait_for_thread(thread, &result);
+	if(locked)
+		window->Lock();
+}
+
+void
+SchemaPanel::_ShowProgress(const BMessage* report)
+{
+	int32 files = report->GetInt32("files", 0);
+	int32 done = report->GetInt32("done", 0);
+
+	BString trailing;
+	trailing << done << " / " << files;
+	fProgress->SetTo(files > 0 ? (float)done / files : 0.0f,
+		B_TRANSLATE("Inferring schema" B_UTF8_ELLIPSIS), trailing.String());
+}
+
+void
+SchemaPanel::_ShowSchema()
+{
+	fSchemaList->Clear();
+	_AddNodeRows(0, NULL);
+}
+
+void
+SchemaPanel::_AddNodeRows(int32 node, BRow* parent)
+{
+	const schema_node& schema = fSchema.NodeAt(node);
+	for(size_t i = 0; i < schema.fields.size(); i++) {
+		const schema_field& field = schema.fields[i];
+		for(size_t j = 0; j < field.types.size(); j++) {
+			const schema_type& type = field.types[j];
+
+			BString present;
+			if(type.occurrences >= schema.messages)
+				present = B_TRANSLATE("always");
+			else {
+				present.SetToFormat("%.0f %%",
+					type.occurrences * 100.0 / schema.messages);
+			}
+
+			BString range = MessageSchema::ValueText(type);
+			if(range.IsEmpty() && type.type != B_MESSAGE_TYPE) {
+				BString sizes = MessageSchema::SizeText(type);
+				if(!sizes.IsEmpty())
+					range.SetToFormat(B_TRANSLATE("%s bytes"), sizes.String());
+			}
+
+			BRow* row = new BRow();
+			row->SetField(new BStringField(field.name.c_str()), 0);
+			row->SetField(new BStringField(get_type(type.type)), 1);
+			row->SetField(new BStringField(MessageSchema::CountText(type)), 2);
+			row->SetField(new BStringField(present), 3);
+			row->SetField(new BStringField(range), 4);
+			fSchemaList->AddRow(row, parent);
+
+			if(type.nested >= 0)
+				_AddNodeRows(type.nested, row);
+		}
+	}
+}
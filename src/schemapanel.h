@@ -0,0 +1,70 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef __SCHEMA_PANEL_H__
+#define __SCHEMA_PANEL_H__
+
+#include <Entry.h>
+#include <StatusBar.h>
+#include <StringView.h>
+#include <View.h>
+#include <private/interface/ColumnListView.h>
+
+#include "messageschema.h"
+#include "schemascanner.h"
+
+enum {
+	SCHEMA_READY = 'scp0',
+	SCHEMA_DEVIATION_SELECTED
+};
+
+/*	The schema inferred from a directory of message files, next to the
+	message it is checked against, and the deviations of that message from
+	it and from the validation schema the window may have.
+	The window hears of a new schema through SCHEMA_READY and of a
+	deviation that was double-clicked through SCHEMA_DEVIATION_SELECTED,
+	whose location SelectedDeviation() then hands out.
+*/
+class SchemaPanel : public BView
+{
+public:
+							SchemaPanel(const char* name);
+	virtual					~SchemaPanel();
+
+	virtual	void			DetachedFromWindow();
+	virtual	void			MessageReceived(BMessage* msg);
+
+			void			Infer(const entry_ref& directory);
+			bool			HasSchema() const { return fHasSchema; }
+			bool			IsScanning() const { return fThread >= 0; }
+
+			// A flattened message, see MessageSchema::Check()
+			status_t		Check(const void* data, size_t size,
+								BMessage* deviations) const;
+			void			SetDeviations(const BMessage* deviations);
+			bool			SelectedDeviation(BMessage* location) const;
+
+	static	BString			DeviationText(const BMessage* deviation);
+private:
+	static	status_t		_ScanThread(void* data);
+
+			void			_StopScanning();
+			void			_ShowProgress(const BMessage* report);
+			void			_ShowSchema();
+			void			_AddNodeRows(int32 node, BRow* parent);
+private:
+			SchemaScanner*	fScanner;
+			thread_id		fThread;
+			entry_ref		fDirectory;
+			MessageSchema	fSchema;
+			bool			fHasSchema;
+
+			BStatusBar*		fProgress;
+			BColumnListView* fSchemaList;
+			BColumnListView* fDeviationList;
+			BStringView*	fDeviationStatus;
+};
+
+#endif /* __SCHEMA_PANEL_H__ */
@@ -0,0 +1,223 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#include <DataIO.h>
+#include <Directory.h>
+#include <Message.h>
+#include <OS.h>
+#include <algorithm>
+
+#include "blockcontainer.h"
+#include "byteswap.h"
+#include "legacymessage.h"
+#include "mappedfile.h"
+#include "schemascanner.h"
+
+static const bigtime_t kReportInterval = 100000;
+
+SchemaScanner::SchemaScanner(BMessenger target)
+: fTarget(target),
+  fCanceled(0),
+  fNextFile(0),
+  fFilesDone(0),
+  fFilesSkipped(0),
+  fMessages(0)
+{
+}
+
+status_t
+SchemaScanner::Run(const entry_ref& directory)
+{
+	fFiles.clear();
+	fNextFile = 0;
+	fFilesDone = 0;
+	fFilesSkipped = 0;
+	fMessages = 0;
+
+	status_t status = BDirectory(&directory).InitCheck();
+	if(status != B_OK) {
+		_Report(SS_FINISHED, status, NULL);
+		return status;
+	}
+
+	_ListFiles(directory, 0);
+	_Report(SS_PROGRESS, B_OK, NULL);
+
+	system_info info;
+	int32 count = 1;
+	if(get_system_info(&info) == B_OK)
+		count = std::max(1, std::min(kMaxWorkers, (int32)info.cpu_count));
+	count = std::max(1, std::min(count, (int32)fFiles.size()));
+
+	// The vector is not resized again, the threads keep their element
+	std::vector<worker> workers(count);
+	int32 running = 0;
+	for(int32 i = 0; i < count; i++) {
+		workers[i].scanner = this;
+		workers[i].thread = spawn_thread(_Worker, "schema scanner",
+			B_LOW_PRIORITY, &workers[i]);
+		if(workers[i].thread < 0)
+			continue;
+		resume_thread(workers[i].thread);
+		running++;
+	}
+	if(running == 0)
+		_ScanFiles(workers[0].schema);
+
+	while(atomic_get(&fFilesDone) < (int32)fFiles.size() && !IsCanceled()) {
+		snooze(kReportInterval);
+		_Report(SS_PROGRESS, B_OK, NULL);
+	}
+
+	MessageSchema& schema = workers[0].schema;
+	for(int32 i = 0; i < count; i++) {
+		if(workers[i].thread < 0)
+			continue;
+		status_t result;
+		wait_for_thread(workers[i].thread, &result);
+		if(i > 0)
+			schema.Merge(workers[i].schema);
+	}
+
+	status = IsCanceled() ? B_CANCELED : B_OK;
+	_Report(SS_FINISHED, status, status == B_OK ? &schema : NULL);
+	return status;
+}
+
+void
+SchemaScanner::Cancel()
+{
+	atomic_set(&fCanceled, 1);
+}
+
+bool
+SchemaScanner::IsCanceled() const
+{
+	return atomic_get(const_cast<int32*>(&fCanceled)) != 0;
+}
+
+// #pragma mark - SchemaScanner::Private
+
+status_t
+SchemaScanner::_Worker(void* data)
+{
+	worker* self = static_cast<worker*>(data);
+	self->scanner->_ScanFiles(self->schema);
+	return B_OK;
+}
+
+void
+SchemaScanner::_ListFiles(const entry_ref& directory, int32 depth)
+{
+	BDirectory folder(&directory);
+	entry_ref ref;
+	while(!IsCanceled() && folder.GetNextRef(&ref) == B_OK) {
+		// Links are not followed, they could lead in circles
+		BEntry entry(&ref);
+		if(entry.IsDirectory()) {
+			if(depth < kMaxDepth)
+				_ListFiles(ref, depth + 1);
+		} else if(entry.IsFile())
+			fFiles.push_back(ref);
+	}
+}
+
+void
+SchemaScanner::_ScanFiles(MessageSchema& schema)
+{
+	int32 index;
+	while(!IsCanceled()
+		&& (index = atomic_add(&fNextFile, 1)) < (int32)fFiles.size()) {
+		if(_AddFile(fFiles[index], schema) != B_OK)
+			atomic_add(&fFilesSkipped, 1);
+		atomic_add(&fFilesDone, 1);
+	}
+}
+
+status_t
+SchemaScanner::_AddFile(const entry_ref& ref, MessageSchema& schema)
+{
+	MappedFile file;
+	status_t status = file.SetTo(&ref);
+	if(status != B_OK)
+		return status;
+
+	const uint8* data = file.Data();
+	size_t size = file.Size();
+
+	std::vector<uint8> inflated;
+	if(is_block_container(data, size)) {
+		BMemoryIO io(data, size);
+		BlockContainerIO container;
+		off_t rawSize;
+		status = container.SetTo(&io);
+		if(status == B_OK)
+			status = container.GetSize(&rawSize);
+		if(status != B_OK)
+			return status;
+
+		inflated.resize(rawSize);
+		if(container.ReadAt(0, inflated.data(), rawSize) != rawSize)
+			return B_BAD_DATA;
+		data = inflated.data();
+		size = inflated.size();
+	}
+
+	// Stream files hold their messages back to back, whatever follows
+	// the last one is not looked at
+	std::vector<uint8> native;
+	int64 messages = 0;
+	size_t offset = 0;
+	while(offset < size && !IsCanceled()) {
+		ssize_t length = flattened_message_size(data + offset, size - offset);
+		if(length <= 0 || (size_t)length > size - offset)
+			break;
+
+		const uint8* message = data + offset;
+		size_t messageSize = length;
+		if(is_legacy_message(message, messageSize)) {
+			status = upgrade_legacy_message(message, messageSize, native);
+			message = native.data();
+			messageSize = native.size();
+		} else if(is_swapped_flat_message(message, messageSize)) {
+			native.assign(message, message + messageSize);
+			status = swap_flat_message(native.data(), messageSize);
+			message = native.data();
+		}
+		if(status == B_OK)
+			status = schema.AddMessage(message, messageSize);
+		if(status != B_OK)
+			break;
+
+		messages++;
+		offset += length;
+	}
+
+	atomic_add64(&fMessages, messages);
+	if(messages > 0)
+		return B_OK;
+	return status != B_OK ? status : B_NOT_A_MESSAGE;
+}
+
+void
+SchemaScanner::_Report(uint32 what, status_t status,
+	const MessageSchema* schema)
+{
+	BMessage report(what);
+	report.AddInt32("status", status);
+	report.AddInt32("files", fFiles.size());
+	report.AddInt32("done", what == SS_FINISHED && status == B_OK
+		? (int32)fFiles.size() : atomic_get(&fFilesDone));
+	report.AddInt32("skipped", atomic_get(&fFilesSkipped));
+	report.AddInt64("messages", atomic_get64(&fMessages));
+
+	if(schema != NULL) {
+		BMessage archive;
+		if(schema->Archive(&archive) == B_OK)
+			report.AddMessage("schema", &archive);
+	}
+
+	fTarget.SendMessage(&report);
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef __SCHEMA_SCANNER_H__
+#define __SCHEMA_SCANNER_H__
+
+#include <Entry.h>
+#include <Messenger.h>
+#include <vector>
+
+#include "messageschema.h"
+
+enum {
+	SS_PROGRESS = 'ss00',
+	SS_FINISHED
+};
+
+/*	Infers a schema from every message file below a directory. The files
+	are listed first, then read on every CPU at once: each thread folds
+	the messages of the files it takes into a schema of its own, so only
+	the file at hand is ever held, and the schemas are merged when all are
+	done. Native, legacy and compressed files are read, several messages
+	back to back included; other files are skipped.
+
+	While it runs it posts SS_PROGRESS with the file counts to the target,
+	then SS_FINISHED with the merged "schema" archive.
+*/
+class SchemaScanner
+{
+public:
+	static	const int32		kMaxWorkers = 16;
+	static	const int32		kMaxDepth = 32;
+
+							SchemaScanner(BMessenger target);
+
+			status_t		Run(const entry_ref& directory);
+			void			Cancel();
+			bool			IsCanceled() const;
+private:
+	struct worker {
+		SchemaScanner*	scanner;
+		MessageSchema	schema;
+		thread_id		thread;
+	};
+
+	static	status_t		_Worker(void* data);
+
+			void			_ListFiles(const entry_ref& directory,
+								int32 depth);
+			void			_ScanFiles(MessageSchema& schema);
+			status_t		_AddFile(const entry_ref& ref,
+								MessageSchema& schema);
+			void			_Report(uint32 what, status_t status,
+								const MessageSchema* schema);
+private:
+			BMessenger		fTarget;
+			int32			fCanceled;
+
+	std::vector<entry_ref>	fFiles;
+			int32			fNextFile;
+			int32			fFilesDone;
+			int32			fFilesSkipped;
+			int64			fMessages;
+};
+
+#endif /* __SCHEMA_SCANNER_H__ */
@@ -0,0 +1,996 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#include <File.h>
+#include <ctype.h>
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gettype.h"
+#include "numericitem.h"
+#include "schemavalidator.h"
+
+static const char* kRangeDash = " \xE2\x80\x93 ";
+static const char* kUnbounded = "\xE2\x88\x9E";
+static const off_t kMaxSourceSize = 1024 * 1024;
+
+// The instructions of a rule, each followed by its operands
+enum {
+	OP_END = 0,
+	OP_TYPE,			// type
+	OP_COUNT,			// min, max
+	OP_LENGTH,			// min, max, terminator size
+	OP_RANGE_SIGNED,	// constant of the min, the max follows it
+	OP_RANGE_UNSIGNED,
+	OP_RANGE_FLOAT,
+	OP_NESTED			// block
+};
+
+// FNV-1a, the names are short
+static uint32
+hash_name(const char* name, uint32 length)
+{
+	uint32 hash = 2166136261u;
+	for(uint32 i = 0; i < length; i++)
+		hash = (hash ^ (uint8)name[i]) * 16777619u;
+	return hash;
+}
+
+// Which range instruction the values of a type are compared with
+static uint32
+range_op(type_code type)
+{
+	switch(storage_of(type, native_size(type))) {
+		case STORAGE_INT8:
+		case STORAGE_INT16:
+		case STORAGE_INT32:
+		case STORAGE_INT64:
+			return OP_RANGE_SIGNED;
+		case STORAGE_UINT8:
+		case STORAGE_UINT16:
+		case STORAGE_UINT32:
+		case STORAGE_UINT64:
+			return OP_RANGE_UNSIGNED;
+		case STORAGE_FLOAT:
+		case STORAGE_DOUBLE:
+			return OP_RANGE_FLOAT;
+		default:
+			return OP_END;
+	}
+}
+
+static bool
+is_unbounded(uint32 op, const schema_value& value)
+{
+	switch(op) {
+		case OP_RANGE_SIGNED:
+			return value.i == INT64_MAX;
+		case OP_RANGE_UNSIGNED:
+			return value.u == UINT64_MAX;
+		default:
+			return isinf(value.f) && value.f > 0;
+	}
+}
+
+static BString
+value_text(uint32 op, const schema_value& value)
+{
+	BString text;
+	switch(op) {
+		case OP_RANGE_SIGNED:
+			text.SetToFormat("%" B_PRId64, value.i);
+			break;
+		case OP_RANGE_UNSIGNED:
+			text.SetToFormat("%" B_PRIu64, value.u);
+			break;
+		case OP_RANGE_FLOAT:
+			text.SetToFormat("%g", value.f);
+			break;
+	}
+	return text;
+}
+
+static BString
+bounds_text(uint32 min, uint32 max)
+{
+	BString text;
+	text << min;
+	if(max == UINT32_MAX)
+		text << kRangeDash << kUnbounded;
+	else if(max != min)
+		text << kRangeDash << max;
+	return text;
+}
+
+// Codes made of four printable characters are shown as such
+static BString
+what_text(uint32 what)
+{
+	bool printable = true;
+	for(int32 i = 0; i < 4; i++) {
+		uint8 c = what >> (24 - i * 8);
+		printable &= c >= 0x20 && c < 0x7f;
+	}
+
+	BString text;
+	if(printable) {
+		text.SetToFormat("'%c%c%c%c'", (char)(what >> 24), (char)(what >> 16),
+			(char)(what >> 8), (char)what);
+	} else
+		text.SetToFormat("0x%08" B_PRIx32, what);
+	return text;
+}
+
+// Index of the first of count items outside of min..max, -1 if there is
+// none; NaN is outside of any range
+template<typename T, typename V>
+static int32
+first_outside(const uint8* data, uint32 count, V min, V max, V* found)
+{
+	for(uint32 i = 0; i < count; i++) {
+		T value;
+		memcpy(&value, data + i * sizeof(T), sizeof(T));
+		if(!((V)value >= min && (V)value <= max)) {
+			*found = value;
+			return i;
+		}
+	}
+	return -1;
+}
+
+static int32
+first_outside(item_storage storage, const uint8* data, uint32 count,
+	const schema_value* bounds, schema_value* found)
+{
+	switch(storage) {
+		case STORAGE_INT8:
+			return first_outside<int8>(data, count, bounds[0].i, bounds[1].i,
+				&found->i);
+		case STORAGE_INT16:
+			return first_outside<int16>(data, count, bounds[0].i, bounds[1].i,
+				&found->i);
+		case STORAGE_INT32:
+			return first_outside<int32>(data, count, bounds[0].i, bounds[1].i,
+				&found->i);
+		case STORAGE_INT64:
+			return first_outside<int64>(data, count, bounds[0].i, bounds[1].i,
+				&found->i);
+		case STORAGE_UINT8:
+			return first_outside<uint8>(data, count, bounds[0].u, bounds[1].u,
+				&found->u);
+		case STORAGE_UINT16:
+			return first_outside<uint16>(data, count, bounds[0].u, bounds[1].u,
+				&found->u);
+		case STORAGE_UINT32:
+			return first_outside<uint32>(data, count, bounds[0].u, bounds[1].u,
+				&found->u);
+		case STORAGE_UINT64:
+			return first_outside<uint64>(data, count, bounds[0].u, bounds[1].u,
+				&found->u);
+		case STORAGE_FLOAT:
+			return first_outside<float>(data, count, bounds[0].f, bounds[1].f,
+				&found->f);
+		case STORAGE_DOUBLE:
+			return first_outside<double>(data, count, bounds[0].f, bounds[1].f,
+				&found->f);
+		default:
+			return -1;
+	}
+}
+
+// #pragma mark - SchemaValidator::Parser
+
+/*	Recursive descent over the source, writing the program as it goes.
+	The rules of a message are kept aside until its closing brace, so
+	those of every block end up next to each other whatever is nested in
+	between.
+*/
+class SchemaValidator::Parser
+{
+public:
+							Parser(SchemaValidator& target,
+								const char* source, size_t length);
+
+			status_t		Parse(BString* error);
+private:
+	enum {
+		TOKEN_END = 0,
+		TOKEN_WORD,
+		TOKEN_STRING,
+		TOKEN_CODE,
+		TOKEN_NUMBER,
+		TOKEN_SYMBOL
+	};
+
+			status_t		_Next();
+			bool			_Is(const char* text) const;
+			status_t		_Expect(const char* symbol);
+			status_t		_Error(const char* text);
+
+			status_t		_Message(int32 depth, int32* index);
+			status_t		_Field(bool required, int32 depth,
+								std::vector<rule>& rules);
+			status_t		_Type(type_code* type);
+			status_t		_What(uint32* what);
+			status_t		_Unsigned(uint32* value);
+			status_t		_Bounds(uint32* min, uint32* max);
+			status_t		_Value(uint32 op, bool open, schema_value* value);
+private:
+			SchemaValidator& fTarget;
+			const char*		fSource;
+			size_t			fLength;
+			size_t			fPosition;
+			int32			fLine;
+
+			int32			fToken;
+			std::string		fText;
+			int32			fTokenLine;
+			BString			fError;
+};
+
+SchemaValidator::Parser::Parser(SchemaValidator& target, const char* source,
+	size_t length)
+: fTarget(target),
+  fSource(source),
+  fLength(length),
+  fPosition(0),
+  fLine(1),
+  fToken(TOKEN_END),
+  fTokenLine(1)
+{
+}
+
+status_t
+SchemaValidator::Parser::Parse(BString* error)
+{
+	status_t status = _Next();
+	if(status == B_OK && !_Is("message"))
+		status = _Error("expected \"message\"");
+	if(status == B_OK)
+		status = _Next();
+
+	int32 index;
+	if(status == B_OK)
+		status = _Message(0, &index);
+	if(status == B_OK && fToken != TOKEN_END)
+		status = _Error("expected the end of the schema");
+
+	if(status != B_OK && error != NULL)
+		*error = fError;
+	return status;
+}
+
+status_t
+SchemaValidator::Parser::_Next()
+{
+	while(fPosition < fLength) {
+		char c = fSource[fPosition];
+		if(c == '#') {
+			while(fPosition < fLength && fSource[fPosition] != '\n')
+				fPosition++;
+		} else if(isspace((uint8)c)) {
+			if(c == '\n')
+				fLine++;
+			fPosition++;
+		} else
+			break;
+	}
+
+	fText.clear();
+	fTokenLine = fLine;
+	if(fPosition >= fLength) {
+		fToken = TOKEN_END;
+		return B_OK;
+	}
+
+	char c = fSource[fPosition];
+	char next = fPosition + 1 < fLength ? fSource[fPosition + 1] : '\0';
+	if(c == '"') {
+		for(fPosition++; ; fPosition++) {
+			if(fPosition >= fLength || fSource[fPosition] == '\n')
+				return _Error("the name is not closed with \"");
+			c = fSource[fPosition];
+			if(c == '"')
+				break;
+			if(c == '\\' && fPosition + 1 < fLength
+				&& fSource[fPosition + 1] != '\n')
+				c = fSource[++fPosition];
+			fText += c;
+		}
+		fPosition++;
+		fToken = TOKEN_STRING;
+	} else if(c == '\'') {
+		if(fPosition + 5 >= fLength || fSource[fPosition + 5] != '\'')
+			return _Error("a code has four characters, as in 'abcd'");
+		fText.assign(fSource + fPosition + 1, 4);
+		fPosition += 6;
+		fToken = TOKEN_CODE;
+	} else if(isalpha((uint8)c) || c == '_') {
+		while(fPosition < fLength && (isalnum((uint8)fSource[fPosition])
+			|| fSource[fPosition] == '_'))
+			fText += fSource[fPosition++];
+		fToken = TOKEN_WORD;
+	} else if(isdigit((uint8)c) || c == '-' || c == '+'
+		|| (c == '.' && isdigit((uint8)next))) {
+		// Whatever can make up a number, up to a ".." that follows it;
+		// the text is converted once it is known which kind it is
+		fText += fSource[fPosition++];
+		while(fPosition < fLength) {
+			c = fSource[fPosition];
+			bool exponent = !fText.empty()
+				&& (fText.back() == 'e' || fText.back() == 'E')
+				&& fText.find_first_of("xX") == std::string::npos;
+			if(c == '.' && fPosition + 1 < fLength
+				&& fSource[fPosition + 1] == '.')
+				break;
+			if(!isalnum((uint8)c) && c != '.'
+				&& !((c == '+' || c == '-') && exponent))
+				break;
+			fText += c;
+			fPosition++;
+		}
+		fToken = TOKEN_NUMBER;
+	} else if(c == '.' && next == '.') {
+		fText = "..";
+		fPosition += 2;
+		fToken = TOKEN_SYMBOL;
+	} else if(strchr("{};*", c) != NULL) {
+		fText = c;
+		fPosition++;
+		fToken = TOKEN_SYMBOL;
+	} else {
+		BString text;
+		text.SetToFormat("unexpected character '%c'", c);
+		return _Error(text.String());
+	}
+	return B_OK;
+}
+
+bool
+SchemaValidator::Parser::_Is(const char* text) const
+{
+	return (fToken == TOKEN_WORD || fToken == TOKEN_SYMBOL)
+		&& fText == text;
+}
+
+status_t
+SchemaValidator::Parser::_Expect(const char* symbol)
+{
+	if(!_Is(symbol)) {
+		BString text;
+		text.SetToFormat("expected \"%s\"", symbol);
+		return _Error(text.String());
+	}
+	return _Next();
+}
+
+status_t
+SchemaValidator::Parser::_Error(const char* text)
+{
+	fError.SetToFormat("line %" B_PRId32 ": %s", fTokenLine, text);
+	return B_BAD_DATA;
+}
+
+// From the optional 'what' to past the closing brace
+status_t
+SchemaValidator::Parser::_Message(int32 depth, int32* index)
+{
+	if(depth >= kMaxSchemaNesting)
+		return _Error("messages are nested too deeply");
+
+	block schema;
+	schema.what = 0;
+	schema.hasWhat = fToken == TOKEN_CODE || fToken == TOKEN_NUMBER;
+	schema.othersAllowed = false;
+
+	status_t status = B_OK;
+	if(schema.hasWhat) {
+		status = _What(&schema.what);
+		if(status == B_OK)
+			status = _Next();
+	}
+	if(status == B_OK)
+		status = _Expect("{");
+	if(status != B_OK)
+		return status;
+
+	// The block is placed before its nested ones, they refer to it by index
+	*index = fTarget.fBlocks.size();
+	fTarget.fBlocks.push_back(schema);
+
+	std::vector<rule> rules;
+	while(status == B_OK && !_Is("}")) {
+		if(_Is("required") || _Is("optional"))
+			status = _Field(_Is("required"), depth, rules);
+		else if(_Is("others")) {
+			status = _Next();
+			if(status == B_OK && _Is("allowed"))
+				schema.othersAllowed = true;
+			else if(status == B_OK && !_Is("reported"))
+				status = _Error("expected \"allowed\" or \"reported\"");
+			if(status == B_OK)
+				status = _Next();
+			if(status == B_OK)
+				status = _Expect(";");
+		} else if(fToken == TOKEN_END)
+			status = _Error("expected \"}\"");
+		else
+			status = _Error("expected \"required\", \"optional\" or \"others\"");
+	}
+	if(status == B_OK)
+		status = _Next();
+	if(status == B_OK && _Is(";"))
+		status = _Next();
+	if(status != B_OK)
+		return status;
+
+	// Twice as many slots as rules keep the probe sequences short, and
+	// always leave a free one to end them
+	uint32 slots = 1;
+	while(slots < rules.size() * 2)
+		slots <<= 1;
+
+	schema.firstRule = fTarget.fRules.size();
+	schema.ruleCount = rules.size();
+	schema.firstSlot = fTarget.fSlots.size();
+	schema.slotMask = slots - 1;
+	fTarget.fSlots.resize(fTarget.fSlots.size() + slots, -1);
+	for(size_t i = 0; i < rules.size(); i++) {
+		uint32 slot = rules[i].hash & schema.slotMask;
+		while(fTarget.fSlots[schema.firstSlot + slot] >= 0)
+			slot = (slot + 1) & schema.slotMask;
+		fTarget.fSlots[schema.firstSlot + slot] = i;
+		fTarget.fRules.push_back(rules[i]);
+	}
+	fTarget.fBlocks[*index] = schema;
+	return B_OK;
+}
+
+// From "required" or "optional" to past the end of the field
+status_t
+SchemaValidator::Parser::_Field(bool required, int32 depth,
+	std::vector<rule>& rules)
+{
+	status_t status = _Next();
+	if(status != B_OK)
+		return status;
+	if(fToken != TOKEN_STRING)
+		return _Error("expected the name of the field in quotes");
+	if(fText.empty() || fText.find('\0') != std::string::npos)
+		return _Error("a field needs a name");
+
+	std::string& names = fTarget.fNames;
+	for(size_t i = 0; i < rules.size(); i++) {
+		if(names.compare(rules[i].name, rules[i].nameLength - 1, fText) == 0) {
+			BString text;
+			text.SetToFormat("\"%s\" is listed twice", fText.c_str());
+			return _Error(text.String());
+		}
+	}
+
+	rule current;
+	current.hash = hash_name(fText.data(), fText.size());
+	current.name = names.size();
+	current.nameLength = fText.size() + 1;
+	current.required = required;
+	names.append(fText);
+	names.push_back('\0');
+
+	status = _Next();
+	if(status == B_OK)
+		status = _Type(&current.type);
+	if(status == B_OK)
+		status = _Next();
+	if(status != B_OK)
+		return status;
+
+	bool hasCount = required;
+	uint32 minCount = 1;
+	uint32 maxCount = UINT32_MAX;
+	bool hasLength = false;
+	uint32 minLength = 0;
+	uint32 maxLength = UINT32_MAX;
+	uint32 rangeOp = OP_END;
+	schema_value bounds[2];
+
+	while(status == B_OK && fToken == TOKEN_WORD) {
+		if(_Is("count")) {
+			status = _Bounds(&minCount, &maxCount);
+			hasCount = true;
+		} else if(_Is("length")) {
+			status = _Bounds(&minLength, &maxLength);
+			hasLength = true;
+		} else if(_Is("range")) {
+			rangeOp = range_op(current.type);
+			if(rangeOp == OP_END)
+				return _Error("\"range\" needs a numeric type");
+			status = _Next();
+			if(status == B_OK)
+				status = _Value(rangeOp, false, &bounds[0]);
+			if(status == B_OK)
+				status = _Expect("..");
+			if(status == B_OK)
+				status = _Value(rangeOp, true, &bounds[1]);
+			if(status == B_OK
+				&& (rangeOp == OP_RANGE_SIGNED ? bounds[0].i > bounds[1].i
+					: rangeOp == OP_RANGE_UNSIGNED ? bounds[0].u > bounds[1].u
+					: !(bounds[0].f <= bounds[1].f)))
+				return _Error("the range ends before it starts");
+		} else {
+			BString text;
+			text.SetToFormat("unknown option \"%s\"", fText.c_str());
+			return _Error(text.String());
+		}
+	}
+	if(status != B_OK)
+		return status;
+
+	int32 nested = -1;
+	if(fToken == TOKEN_CODE || fToken == TOKEN_NUMBER || _Is("{")) {
+		if(current.type != B_MESSAGE_TYPE)
+			return _Error("only B_MESSAGE_TYPE fields can have members");
+		status = _Message(depth + 1, &nested);
+	} else
+		status = _Expect(";");
+	if(status != B_OK)
+		return status;
+
+	std::vector<uint32>& code = fTarget.fCode;
+	current.code = code.size();
+	if(current.type != B_ANY_TYPE) {
+		code.push_back(OP_TYPE);
+		code.push_back(current.type);
+	}
+	if(hasCount) {
+		code.push_back(OP_COUNT);
+		code.push_back(minCount);
+		code.push_back(maxCount);
+	}
+	if(hasLength) {
+		code.push_back(OP_LENGTH);
+		code.push_back(minLength);
+		code.push_back(maxLength);
+		code.push_back(current.type == B_STRING_TYPE ? 1 : 0);
+	}
+	if(rangeOp != OP_END) {
+		code.push_back(rangeOp);
+		code.push_back(fTarget.fConstants.size());
+		fTarget.fConstants.push_back(bounds[0]);
+		fTarget.fConstants.push_back(bounds[1]);
+	}
+	if(nested >= 0) {
+		code.push_back(OP_NESTED);
+		code.push_back(nested);
+	}
+	code.push_back(OP_END);
+
+	rules.push_back(current);
+	return B_OK;
+}
+
+status_t
+SchemaValidator::Parser::_Type(type_code* type)
+{
+	if(fToken == TOKEN_CODE)
+		return _What(type);
+	if(fToken != TOKEN_WORD)
+		return _Error("expected a type, as in B_INT32_TYPE");
+
+	// B_ANY_TYPE is also what names that are not known come back as
+	*type = fText == "B_ANY_TYPE" ? B_ANY_TYPE
+		: TypeCodeForString(fText.c_str());
+	if(*type == B_ANY_TYPE && fText != "B_ANY_TYPE") {
+		BString text;
+		text.SetToFormat("unknown type \"%s\"", fText.c_str());
+		return _Error(text.String());
+	}
+	return B_OK;
+}
+
+status_t
+SchemaValidator::Parser::_What(uint32* what)
+{
+	if(fToken == TOKEN_NUMBER)
+		return _Unsigned(what);
+
+	const uint8* code = (const uint8*)fText.data();
+	*what = (uint32)code[0] << 24 | (uint32)code[1] << 16
+		| (uint32)code[2] << 8 | code[3];
+	return B_OK;
+}
+
+status_t
+SchemaValidator::Parser::_Unsigned(uint32* value)
+{
+	if(fToken != TOKEN_NUMBER || !isdigit((uint8)fText[0]))
+		return _Error("expected a number that is not negative");
+
+	char* end;
+	errno = 0;
+	unsigned long long number = strtoull(fText.c_str(), &end, 0);
+	if(*end != '\0' || errno != 0 || number >= UINT32_MAX)
+		return _Error("expected a number that is not negative");
+	*value = number;
+	return B_OK;
+}
+
+// "N" or "N..M" or "N..*", from the keyword before them to past them
+status_t
+SchemaValidator::Parser::_Bounds(uint32* min, uint32* max)
+{
+	status_t status = _Next();
+	if(status == B_OK)
+		status = _Unsigned(min);
+	if(status == B_OK)
+		status = _Next();
+	if(status != B_OK)
+		return status;
+
+	if(!_Is("..")) {
+		*max = *min;
+		return B_OK;
+	}
+
+	status = _Next();
+	if(status != B_OK)
+		return status;
+	if(_Is("*"))
+		*max = UINT32_MAX;
+	else {
+		status = _Unsigned(max);
+		if(status == B_OK && *max < *min)
+			status = _Error("the range ends before it starts");
+	}
+	if(status == B_OK)
+		status = _Next();
+	return status;
+}
+
+// A bound of a range; "*" is the largest value there is when it is open
+status_t
+SchemaValidator::Parser::_Value(uint32 op, bool open, schema_value* value)
+{
+	if(open && _Is("*")) {
+		if(op == OP_RANGE_SIGNED)
+			value->i = INT64_MAX;
+		else if(op == OP_RANGE_UNSIGNED)
+			value->u = UINT64_MAX;
+		else
+			value->f = HUGE_VAL;
+		return _Next();
+	}
+
+	if(fToken != TOKEN_NUMBER)
+		return _Error("expected a number");
+
+	char* end;
+	errno = 0;
+	if(op == OP_RANGE_SIGNED)
+		value->i = strtoll(fText.c_str(), &end, 0);
+	else if(op == OP_RANGE_UNSIGNED) {
+		value->u = strtoull(fText.c_str(), &end, 0);
+		if(fText[0] == '-')
+			errno = ERANGE;
+	} else
+		value->f = strtod(fText.c_str(), &end);
+	if(*end != '\0' || errno != 0)
+		return _Error("the number does not fit the type of the field");
+	return _Next();
+}
+
+// #pragma mark - SchemaValidator
+
+SchemaValidator::SchemaValidator()
+{
+}
+
+void
+SchemaValidator::MakeEmpty()
+{
+	fBlocks.clear();
+	fRules.clear();
+	fSlots.clear();
+	fCode.clear();
+	fConstants.clear();
+	fNames.clear();
+}
+
+status_t
+SchemaValidator::Compile(const char* source, size_t length, BString* error)
+{
+	MakeEmpty();
+
+	Parser parser(*this, source, length);
+	status_t status = parser.Parse(error);
+	if(status != B_OK)
+		MakeEmpty();
+	return status;
+}
+
+status_t
+SchemaValidator::Load(const char* path, BString* error)
+{
+	MakeEmpty();
+
+	BFile file(path, B_READ_ONLY);
+	off_t size = 0;
+	status_t status = file.InitCheck();
+	if(status == B_OK)
+		status = file.GetSize(&size);
+	if(status == B_OK && size > kMaxSourceSize)
+		status = B_FILE_TOO_LARGE;
+
+	std::vector<char> source(size);
+	if(status == B_OK && file.ReadAt(0, source.data(), size) != size)
+		status = B_IO_ERROR;
+	if(status != B_OK) {
+		if(error != NULL)
+			error->SetTo(strerror(status));
+		return status;
+	}
+
+	return Compile(source.data(), size, error);
+}
+
+ssize_t
+SchemaValidator::Validate(const void* data, size_t size,
+	BMessage* violations) const
+{
+	if(fBlocks.empty())
+		return B_NO_INIT;
+
+	run state;
+	state.violations = violations;
+	state.count = 0;
+	status_t status = _Validate(0, data, size, state);
+	if(status != B_OK)
+		return status;
+	return state.count;
+}
+
+// #pragma mark - SchemaValidator::Private
+
+int32
+SchemaValidator::_FindRule(const block& schema, const char* name,
+	uint32 length) const
+{
+	if(schema.ruleCount == 0)
+		return -1;
+
+	uint32 hash = hash_name(name, length);
+	for(uint32 slot = hash & schema.slotMask; ;
+		slot = (slot + 1) & schema.slotMask) {
+		int32 index = fSlots[schema.firstSlot + slot];
+		if(index < 0)
+			return -1;
+
+		const rule& candidate = fRules[schema.firstRule + index];
+		if(candidate.hash == hash && candidate.nameLength == length + 1
+			&& memcmp(fNames.data() + candidate.name, name, length) == 0)
+			return index;
+	}
+}
+
+status_t
+SchemaValidator::_Validate(int32 index, const void* data, size_t size,
+	run& state) const
+{
+	if((int32)state.path.size() >= kMaxSchemaNesting)
+		return B_BAD_DATA;
+
+	FlatMessageReader reader(data, size);
+	if(reader.InitCheck() != B_OK)
+		return reader.InitCheck();
+
+	const block& schema = fBlocks[index];
+	uint32 what = reader.Header().what;
+	if(schema.hasWhat && what != schema.what) {
+		BMessage violation;
+		violation.AddString("found", what_text(what));
+		violation.AddString("expected", what_text(schema.what));
+		_Report(state, "", SCHEMA_WHAT_MISMATCH, &violation);
+	}
+
+	// The rules met in this message, above those of the ones around it
+	size_t frame = state.seen.size();
+	state.seen.resize(frame + schema.ruleCount, 0);
+
+	status_t status = B_OK;
+	for(int32 i = 0; i < reader.CountFields() && status == B_OK; i++) {
+		flat_field_header header;
+		status = reader.FieldAt(i, &header);
+		if(status != B_OK)
+			break;
+
+		const char* name = reader.FieldName(header);
+		if(!name) {
+			status = B_BAD_DATA;
+			break;
+		}
+
+		int32 found = _FindRule(schema, name, header.name_length - 1);
+		if(found < 0) {
+			if(!schema.othersAllowed) {
+				BMessage violation;
+				violation.AddUInt32("found_type", header.type);
+				_Report(state, name, SCHEMA_UNKNOWN_FIELD, &violation);
+			}
+			continue;
+		}
+
+		state.seen[frame + found] = 1;
+		status = _RunRule(fRules[schema.firstRule + found], reader, header,
+			name, state);
+	}
+
+	for(int32 i = 0; i < schema.ruleCount && status == B_OK; i++) {
+		const rule& current = fRules[schema.firstRule + i];
+		if(state.seen[frame + i] != 0 || !current.required)
+			continue;
+
+		BMessage violation;
+		violation.AddUInt32("expected_type", current.type);
+		_Report(state, fNames.c_str() + current.name, SCHEMA_MISSING_FIELD,
+			&violation);
+	}
+
+	state.seen.resize(frame);
+	return status;
+}
+
+status_t
+SchemaValidator::_RunRule(const rule& current, const FlatMessageReader& reader,
+	const flat_field_header& field, const char* name, run& state) const
+{
+	// The items of a fixed size field are reached without walking them
+	bool fixed = (field.flags & kFlatFieldFixedSize) != 0 && field.count > 0
+		&& field.data_size % field.count == 0;
+	uint32 itemSize = fixed ? field.data_size / field.count : 0;
+
+	flat_item item;
+	status_t status;
+	for(const uint32* code = fCode.data() + current.code; ; ) {
+		switch(code[0]) {
+			case OP_END:
+				return B_OK;
+
+			case OP_TYPE:
+				if(field.type != code[1]) {
+					BMessage violation;
+					violation.AddUInt32("found_type", field.type);
+					violation.AddUInt32("expected_type", code[1]);
+					_Report(state, name, SCHEMA_TYPE_MISMATCH, &violation);
+
+					// Nothing else of the rule applies to another type
+					return B_OK;
+				}
+				code += 2;
+				break;
+
+			case OP_COUNT:
+				if(field.count < code[1] || field.count > code[2]) {
+					BMessage violation;
+					violation.AddString("found", BString() << field.count);
+					violation.AddString("expected",
+						bounds_text(code[1], code[2]));
+					_Report(state, name, SCHEMA_COUNT_OUT_OF_RANGE, &violation);
+				}
+				code += 3;
+				break;
+
+			case OP_LENGTH:
+			{
+				// One item out of range is enough to flag the field
+				int32 index = -1;
+				int64 length = 0;
+				if(fixed) {
+					length = (int64)itemSize - code[3];
+					if(length < code[1] || length > code[2])
+						index = 0;
+				} else {
+					for(status = reader.FirstItem(field, &item); status == B_OK;
+						status = reader.NextItem(field, &item)) {
+						length = (int64)item.size - code[3];
+						if(length < code[1] || length > code[2]) {
+							index = item.index;
+							break;
+						}
+					}
+					if(status != B_OK && status != B_BAD_INDEX)
+						return status;
+				}
+
+				if(index >= 0) {
+					BMessage violation;
+					violation.AddInt32("item", index);
+					violation.AddString("found", BString() << length);
+					violation.AddString("expected",
+						bounds_text(code[1], code[2]));
+					_Report(state, name, SCHEMA_SIZE_OUT_OF_RANGE, &violation);
+				}
+				code += 4;
+				break;
+			}
+
+			case OP_RANGE_SIGNED:
+			case OP_RANGE_UNSIGNED:
+			case OP_RANGE_FLOAT:
+			{
+				const schema_value* bounds = &fConstants[code[1]];
+				schema_value found;
+				int32 index = -1;
+				if(fixed) {
+					index = first_outside(storage_of(field.type, itemSize),
+						reader.FieldData(field), field.count, bounds, &found);
+				} else {
+					for(status = reader.FirstItem(field, &item); status == B_OK;
+						status = reader.NextItem(field, &item)) {
+						if(first_outside(storage_of(field.type, item.size),
+							item.data, 1, bounds, &found) == 0) {
+							index = item.index;
+							break;
+						}
+					}
+					if(status != B_OK && status != B_BAD_INDEX)
+						return status;
+				}
+
+				if(index >= 0) {
+					BString expected = value_text(code[0], bounds[0]);
+					expected << kRangeDash << (is_unbounded(code[0], bounds[1])
+						? BString(kUnbounded) : value_text(code[0], bounds[1]));
+
+					BMessage violation;
+					violation.AddInt32("item", index);
+					violation.AddString("found", value_text(code[0], found));
+					violation.AddString("expected", expected);
+					_Report(state, name, SCHEMA_VALUE_OUT_OF_RANGE, &violation);
+				}
+				code += 2;
+				break;
+			}
+
+			case OP_NESTED:
+			{
+				for(status = reader.FirstItem(field, &item); status == B_OK;
+					status = reader.NextItem(field, &item)) {
+					location step = { name, item.index };
+					state.path.push_back(step);
+					status_t nestedStatus = _Validate(code[1], item.data,
+						item.size, state);
+					state.path.pop_back();
+					if(nestedStatus != B_OK)
+						return nestedStatus;
+				}
+				if(status != B_BAD_INDEX)
+					return status;
+				code += 2;
+				break;
+			}
+
+			default:
+				return B_ERROR;
+		}
+	}
+}
+
+void
+SchemaValidator::_Report(run& state, const char* name, int32 kind,
+	BMessage* violation) const
+{
+	state.count++;
+	if(state.violations == NULL || state.count > kMaxReportedViolations)
+		return;
+
+	for(size_t i = 0; i < state.path.size(); i++) {
+		violation->AddString("path", state.path[i].name);
+		violation->AddInt32("member", state.path[i].member);
+	}
+	violation->AddString("name", name);
+	violation->AddInt32("kind", kind);
+	state.violations->AddMessage("deviation", violation);
+}
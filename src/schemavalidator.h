@@ -0,0 +1,125 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef __SCHEMA_VALIDATOR_H__
+#define __SCHEMA_VALIDATOR_H__
+
+#include <Message.h>
+#include <String.h>
+#include <SupportDefs.h>
+#include <string>
+#include <vector>
+
+#include "flatmessage.h"
+#include "messageschema.h"
+
+/*	A schema written by hand for a kind of message file, compiled into a
+	small program that flattened messages are run through:
+
+		# The settings of an app
+		message 'sett' {
+			required "frame" B_RECT_TYPE;
+			required "recent" B_REF_TYPE count 0..10;
+			optional "volume" B_FLOAT_TYPE range 0..1;
+			optional "title" B_STRING_TYPE length 1..*;
+			optional "tab" B_MESSAGE_TYPE count 1..* {
+				required "label" B_STRING_TYPE;
+				others allowed;
+			}
+		}
+
+	Fields take the type names of gettype.h, B_ANY_TYPE or a 'code'.
+	"count" bounds the number of items, "range" the values of a numeric
+	field and "length" the size of each item in bytes, strings without
+	their terminator; "*" leaves the upper bound open. A required field
+	needs at least one item unless its count says otherwise. A message
+	may be given a 'what', after "message" or after the type of a message
+	field, and has no fields but the ones listed unless "others allowed".
+
+	Validate() reads every field header of a message once and looks its
+	name up in a hash table of the block it is checked against. Numbers
+	are compared where they are stored and only message items are
+	descended into, nothing is unflattened. Validate() does not change the
+	validator, so one compiled program can be shared by any number of
+	threads.
+*/
+class SchemaValidator
+{
+public:
+	static	const int32		kMaxReportedViolations = 1000;
+
+							SchemaValidator();
+
+			bool			IsEmpty() const { return fBlocks.empty(); }
+			void			MakeEmpty();
+
+			// Replaces the program; on failure "error" says what is wrong
+			// on which line and the validator is left empty
+			status_t		Compile(const char* source, size_t length,
+								BString* error);
+			status_t		Load(const char* path, BString* error);
+
+			/*	Returns how many violations a native message has, or an
+				error if it cannot be read. The violations are added in
+				the "deviation" layout of MessageSchema::Check(); beyond
+				kMaxReportedViolations they are only counted.
+			*/
+			ssize_t			Validate(const void* data, size_t size,
+								BMessage* violations = NULL) const;
+private:
+	// A message as the schema expects it, its rules are found by name
+	struct block {
+		uint32			what;
+		bool			hasWhat;
+		bool			othersAllowed;
+		int32			firstRule;
+		int32			ruleCount;
+		int32			firstSlot;
+		uint32			slotMask;
+	};
+
+	struct rule {
+		uint32			hash;
+		uint32			name;			// offset in fNames
+		uint32			nameLength;		// terminator included
+		type_code		type;
+		bool			required;
+		uint32			code;			// first instruction
+	};
+
+	struct location {
+		const char*		name;
+		int32			member;
+	};
+
+	struct run {
+		BMessage*		violations;
+		ssize_t			count;
+		std::vector<location> path;
+		std::vector<uint8> seen;		// rules met, a frame per message
+	};
+
+	class Parser;
+
+			int32			_FindRule(const block& schema, const char* name,
+								uint32 length) const;
+			status_t		_Validate(int32 index, const void* data,
+								size_t size, run& state) const;
+			status_t		_RunRule(const rule& current,
+								const FlatMessageReader& reader,
+								const flat_field_header& field,
+								const char* name, run& state) const;
+			void			_Report(run& state, const char* name, int32 kind,
+								BMessage* violation) const;
+private:
+	std::vector<block>		fBlocks;	// the top message first
+	std::vector<rule>		fRules;
+	std::vector<int32>		fSlots;		// rule indices, -1 when free
+	std::vector<uint32>		fCode;
+	std::vector<schema_value> fConstants;
+	std::string				fNames;
+};
+
+#endif /* __SCHEMA_VALIDATOR_H__ */
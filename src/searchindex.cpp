@@ -0,0 +1,426 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#include <Autolock.h>
+#include <algorithm>
+#include <cctype>
+#include <cfloat>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include "itemdecoder.h"
+#include "refpathcache.h"
+#include "searchindex.h"
+
+static inline void
+append_lowercase(std::string& text, const char* string, size_t length)
+{
+	for(size_t i = 0; i < length; i++)
+		text += static_cast<char>(tolower(static_cast<unsigned char>(string[i])));
+}
+
+// Trigrams never cross the separators between items
+static void
+collect_trigrams(const std::string& text, std::vector<uint32>& grams)
+{
+	const uint8* bytes = reinterpret_cast<const uint8*>(text.data());
+	for(size_t i = 0; i + 2 < text.size(); i++) {
+		if(bytes[i] == 0 || bytes[i + 1] == 0 || bytes[i + 2] == 0)
+			continue;
+		grams.push_back(bytes[i] << 16 | bytes[i + 1] << 8 | bytes[i + 2]);
+	}
+	std::sort(grams.begin(), grams.end());
+	grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+}
+
+// "low..high", either side may be left out
+static bool
+parse_range(const char* query, double* low, double* high)
+{
+	const char* dots = strstr(query, "..");
+	if(!dots)
+		return false;
+
+	*low = -DBL_MAX;
+	*high = DBL_MAX;
+
+	char* end;
+	if(dots != query) {
+		*low = strtod(query, &end);
+		if(end != dots)
+			return false;
+	}
+	if(dots[2] != '\0') {
+		*high = strtod(dots + 2, &end);
+		if(*end != '\0')
+			return false;
+	}
+	return dots != query || dots[2] != '\0';
+}
+
+SearchIndex::SearchIndex(BMessenger target)
+: fTarget(target),
+  fLock("search index"),
+  fWakeUp(create_sem(0, "search index wake up")),
+  fThread(-1),
+  fQuitting(false),
+  fActive(false),
+  fDeadSlots(0),
+  fGeneration(0),
+  fReady(false)
+{
+	fThread = spawn_thread(_Worker, "search index", B_LOW_PRIORITY, this);
+	if(fThread >= 0)
+		resume_thread(fThread);
+}
+
+SearchIndex::~SearchIndex()
+{
+	fLock.Lock();
+	fQuitting = true;
+	fPending.Unset();
+	fLock.Unlock();
+
+	release_sem(fWakeUp);
+	if(fThread >= 0) {
+		status_t result;
+		wait_for_thread(fThread, &result);
+	}
+	delete_sem(fWakeUp);
+
+	for(size_t i = 0; i < fSlots.size(); i++)
+		delete fSlots[i];
+}
+
+void
+SearchIndex::SetTo(PersistentMessage* version)
+{
+	BAutolock _(fLock);
+	fPending.SetTo(version);
+	fReady = false;
+
+	// Nothing is indexed until the first search asks for it
+	if(fActive)
+		release_sem(fWakeUp);
+}
+
+status_t
+SearchIndex::Find(const char* query, BMessage* results)
+{
+	BAutolock _(fLock);
+	if(!fActive) {
+		fActive = true;
+		release_sem(fWakeUp);
+	}
+
+	int32 count = 0;
+	double low, high;
+	if(query != NULL && query[0] != '\0') {
+		if(parse_range(query, &low, &high))
+			_FindRange(low, high, results, count);
+		else {
+			std::string lowercase;
+			append_lowercase(lowercase, query, strlen(query));
+			_FindText(lowercase, results, count);
+		}
+	}
+
+	results->AddInt32("count", std::min(count, kMaxMatches));
+	results->AddBool("truncated", count > kMaxMatches);
+	results->AddBool("ready", fReady);
+	return B_OK;
+}
+
+// #pragma mark - SearchIndex::Private
+
+status_t
+SearchIndex::_Worker(void* data)
+{
+	SearchIndex* index = static_cast<SearchIndex*>(data);
+	while(acquire_sem(index->fWakeUp) == B_OK) {
+		index->fLock.Lock();
+		if(index->fQuitting) {
+			index->fLock.Unlock();
+			break;
+		}
+		BReference<PersistentMessage> version(index->fPending);
+		index->fPending.Unset();
+		index->fLock.Unlock();
+
+		if(!version.Get())
+			continue;
+
+		index->_Index(version.Get());
+		index->fTarget.SendMessage(SI_INDEX_UPDATED);
+	}
+	return B_OK;
+}
+
+void
+SearchIndex::_Index(PersistentMessage* version)
+{
+	fGeneration++;
+
+	// Decoding happens without the lock, searches go on meanwhile
+	std::vector<path_step> path;
+	std::vector<field_slot*> added;
+	std::vector<std::pair<int32, std::vector<path_step> > > moved;
+	_Walk(version, path, added, moved);
+
+	BAutolock _(fLock);
+	for(size_t i = 0; i < moved.size(); i++)
+		fSlots[moved[i].first]->path.swap(moved[i].second);
+
+	for(size_t i = 0; i < added.size(); i++) {
+		int32 slot = fSlots.size();
+		fSlots.push_back(added[i]);
+		fSlotOf[added[i]->field.Get()] = slot;
+		_AddPostings(slot);
+	}
+
+	// Whatever the new version no longer holds goes away
+	for(size_t i = 0; i < fSlots.size(); i++) {
+		field_slot* slot = fSlots[i];
+		if(!slot->live || slot->generation == fGeneration)
+			continue;
+
+		fSlotOf.erase(slot->field.Get());
+		slot->field.Unset();
+		std::string().swap(slot->text);
+		std::vector<uint32>().swap(slot->offsets);
+		std::vector<std::pair<double, int32> >().swap(slot->numbers);
+		slot->live = false;
+		fDeadSlots++;
+	}
+
+	if(fDeadSlots > (int32)fSlots.size() / 2)
+		_Compact();
+
+	fReady = fPending.Get() == NULL;
+}
+
+void
+SearchIndex::_Walk(const PersistentMessage* message,
+	std::vector<path_step>& path, std::vector<field_slot*>& added,
+	std::vector<std::pair<int32, std::vector<path_step> > >& moved)
+{
+	for(int32 i = 0; i < message->CountFields(); i++) {
+		PersistentField* field = message->FieldAt(i);
+
+		std::unordered_map<const PersistentField*, int32>::const_iterator
+			found = fSlotOf.find(field);
+		if(found != fSlotOf.end()) {
+			field_slot* slot = fSlots[found->second];
+			slot->generation = fGeneration;
+
+			// Shared with an earlier version, but members may have moved
+			bool same = slot->path.size() == path.size();
+			for(size_t j = 0; same && j < path.size(); j++) {
+				same = slot->path[j].member == path[j].member
+					&& slot->path[j].name == path[j].name;
+			}
+			if(!same)
+				moved.push_back(std::make_pair(found->second, path));
+		} else {
+			field_slot* slot = _Decode(field, path);
+			slot->generation = fGeneration;
+			added.push_back(slot);
+		}
+
+		if(field->Type() != B_MESSAGE_TYPE)
+			continue;
+
+		for(int32 j = 0; j < field->CountItems(); j++) {
+			const PersistentMessage* member = field->ItemAt(j)->Message();
+			if(!member)
+				continue;
+
+			path_step step;
+			step.name = field->Name();
+			step.member = j;
+			path.push_back(step);
+			_Walk(member, path, added, moved);
+			path.pop_back();
+		}
+	}
+}
+
+SearchIndex::field_slot*
+SearchIndex::_Decode(PersistentField* field,
+	const std::vector<path_step>& path) const
+{
+	field_slot* slot = new field_slot;
+	slot->field.SetTo(field);
+	slot->path = path;
+	slot->live = true;
+
+	append_lowercase(slot->text, field->Name(), strlen(field->Name()));
+	slot->text += '\0';
+
+	slot->offsets.reserve(field->CountItems());
+	for(int32 i = 0; i < field->CountItems(); i++) {
+		const PersistentItem* item = field->ItemAt(i);
+		slot->offsets.push_back(slot->text.size());
+		if(!item->Message()) {
+			BString value;
+			decode_item(field->Type(), item->Data(), item->Size(), value);
+
+			// The index runs in its own thread, it can wait for the path
+			entry_ref ref;
+			if(field->Type() == B_REF_TYPE
+				&& decode_ref(item->Data(), item->Size(), &ref)) {
+				ref_info info;
+				resolve_ref(ref, &info);
+				if(info.exists)
+					value << " " << info.path;
+			}
+			append_lowercase(slot->text, value.String(), value.Length());
+
+			// NaN is in no range and would leave the list unsorted for
+			// the binary search
+			double number;
+			if(decode_number(field->Type(), item->Data(), item->Size(), &number)
+				&& number == number)
+				slot->numbers.push_back(std::make_pair(number, i));
+		}
+		slot->text += '\0';
+	}
+	std::sort(slot->numbers.begin(), slot->numbers.end());
+
+	return slot;
+}
+
+void
+SearchIndex::_AddPostings(int32 slot)
+{
+	std::vector<uint32> grams;
+	collect_trigrams(fSlots[slot]->text, grams);
+
+	// Slots only grow, so every list stays sorted
+	for(size_t i = 0; i < grams.size(); i++)
+		fPostings[grams[i]].push_back(slot);
+}
+
+void
+SearchIndex::_Compact()
+{
+	std::vector<field_slot*> slots;
+	for(size_t i = 0; i < fSlots.size(); i++) {
+		if(fSlots[i]->live)
+			slots.push_back(fSlots[i]);
+		else
+			delete fSlots[i];
+	}
+
+	fSlots.swap(slots);
+	fSlotOf.clear();
+	fPostings.clear();
+	for(size_t i = 0; i < fSlots.size(); i++) {
+		fSlotOf[fSlots[i]->field.Get()] = i;
+		_AddPostings(i);
+	}
+	fDeadSlots = 0;
+}
+
+void
+SearchIndex::_FindText(const std::string& query, BMessage* results,
+	int32& count) const
+{
+	std::vector<int32> candidates;
+	if(query.size() >= 3) {
+		std::vector<uint32> grams;
+		collect_trigrams(query, grams);
+
+		// Intersect the posting lists, shortest first
+		std::vector<const std::vector<int32>*> lists;
+		for(size_t i = 0; i < grams.size(); i++) {
+			std::unordered_map<uint32, std::vector<int32> >::const_iterator
+				found = fPostings.find(grams[i]);
+			if(found == fPostings.end())
+				return;
+			lists.push_back(&found->second);
+		}
+		std::sort(lists.begin(), lists.end(),
+			[](const std::vector<int32>* a, const std::vector<int32>* b) {
+				return a->size() < b->size();
+			});
+
+		candidates = *lists[0];
+		for(size_t i = 1; i < lists.size() && !candidates.empty(); i++) {
+			std::vector<int32> common;
+			std::set_intersection(candidates.begin(), candidates.end(),
+				lists[i]->begin(), lists[i]->end(), std::back_inserter(common));
+			candidates.swap(common);
+		}
+	} else {
+		for(size_t i = 0; i < fSlots.size(); i++)
+			candidates.push_back(i);
+	}
+
+	// Trigrams only narrow it down, the text has the last word
+	std::vector<int32> items;
+	for(size_t i = 0; i < candidates.size() && count < kMaxMatches; i++) {
+		const field_slot& slot = *fSlots[candidates[i]];
+		if(!slot.live)
+			continue;
+
+		items.clear();
+		size_t position = slot.text.find(query);
+		while(position != std::string::npos) {
+			std::vector<uint32>::const_iterator next = std::upper_bound(
+				slot.offsets.begin(), slot.offsets.end(), position);
+			items.push_back(next - slot.offsets.begin() - 1); // -1 is the name
+			if(next == slot.offsets.end())
+				break;
+			position = slot.text.find(query, *next);
+		}
+
+		if(!items.empty()) {
+			_AddMatch(slot, items, results);
+			count += items.size();
+		}
+	}
+}
+
+void
+SearchIndex::_FindRange(double low, double high, BMessage* results,
+	int32& count) const
+{
+	std::vector<int32> items;
+	for(size_t i = 0; i < fSlots.size() && count < kMaxMatches; i++) {
+		const field_slot& slot = *fSlots[i];
+		if(!slot.live || slot.numbers.empty())
+			continue;
+
+		items.clear();
+		std::vector<std::pair<double, int32> >::const_iterator it
+			= std::lower_bound(slot.numbers.begin(), slot.numbers.end(),
+				std::make_pair(low, (int32)-1));
+		for(; it != slot.numbers.end() && it->first <= high; it++)
+			items.push_back(it->second);
+
+		if(!items.empty()) {
+			std::sort(items.begin(), items.end());
+			_AddMatch(slot, items, results);
+			count += items.size();
+		}
+	}
+}
+
+void
+SearchIndex::_AddMatch(const field_slot& slot, const std::vector<int32>& items,
+	BMessage* results) const
+{
+	BMessage match;
+	for(size_t i = 0; i < slot.path.size(); i++) {
+		match.AddString("path", slot.path[i].name.c_str());
+		match.AddInt32("member", slot.path[i].member);
+	}
+	match.AddString("name", slot.field->Name());
+	for(size_t i = 0; i < items.size(); i++)
+		match.AddInt32("item", items[i]);
+
+	results->AddMessage("match", &match);
+}
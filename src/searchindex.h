@@ -0,0 +1,97 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef __SEARCH_INDEX_H__
+#define __SEARCH_INDEX_H__
+
+#include <Locker.h>
+#include <Message.h>
+#include <Messenger.h>
+#include <OS.h>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "persistentmessage.h"
+
+enum {
+	SI_INDEX_UPDATED = 'si00'
+};
+
+/*	Inverted index over the field names and the formatted values of every
+	item, the same text the data view shows. Text is matched by substring,
+	case insensitive, through a trigram index; numeric items are kept
+	sorted per field for range queries.
+
+	Fields are indexed per PersistentField node. A new version of the
+	document only costs the nodes that are not in the index yet, the
+	rest are shared with the previous version and only get their location
+	refreshed. The work happens in a thread of its own, which posts
+	SI_INDEX_UPDATED to the target once it has caught up.
+*/
+class SearchIndex
+{
+public:
+	static	const int32		kMaxMatches = 10000;
+
+							SearchIndex(BMessenger target);
+							~SearchIndex();
+
+			void			SetTo(PersistentMessage* version);
+			status_t		Find(const char* query, BMessage* results);
+private:
+	struct path_step {
+		std::string		name;
+		int32			member;
+	};
+
+	struct field_slot {
+		BReference<PersistentField> field;
+		std::vector<path_step> path;
+		std::string		text;		// lowercase name and items, NUL separated
+		std::vector<uint32> offsets; // start of every item inside text
+		std::vector<std::pair<double, int32> > numbers; // sorted on value
+		uint32			generation;
+		bool			live;
+	};
+
+	static	status_t		_Worker(void* data);
+			void			_Index(PersistentMessage* version);
+			void			_Walk(const PersistentMessage* message,
+								std::vector<path_step>& path,
+								std::vector<field_slot*>& added,
+								std::vector<std::pair<int32,
+									std::vector<path_step> > >& moved);
+			field_slot*		_Decode(PersistentField* field,
+								const std::vector<path_step>& path) const;
+			void			_AddPostings(int32 slot);
+			void			_Compact();
+
+			void			_FindText(const std::string& query,
+								BMessage* results, int32& count) const;
+			void			_FindRange(double low, double high,
+								BMessage* results, int32& count) const;
+			void			_AddMatch(const field_slot& slot,
+								const std::vector<int32>& items,
+								BMessage* results) const;
+private:
+			BMessenger		fTarget;
+			BLocker			fLock;
+			sem_id			fWakeUp;
+			thread_id		fThread;
+			bool			fQuitting;
+			bool			fActive;		// set by the first search
+			BReference<PersistentMessage> fPending;	// guarded by fLock
+
+			// Written by the worker only, read under fLock by Find()
+			std::vector<field_slot*> fSlots;
+			std::unordered_map<const PersistentField*, int32> fSlotOf;
+			std::unordered_map<uint32, std::vector<int32> > fPostings;
+			int32			fDeadSlots;
+			uint32			fGeneration;
+			bool			fReady;
+};
+
+#endif /* __SEARCH_INDEX_H__ */
@@ -0,0 +1,256 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#include <Message.h>
+#include <OS.h>
+#include <algorithm>
+#include <cstdio>
+#include "flatmessage.h"
+#include "sizeprofiler.h"
+
+static const bigtime_t kReportInterval = 250000;
+static const uint32 kTimeCheckInterval = 4096;
+
+static bool
+subtree_greater(const profile_subtree& a, const profile_subtree& b)
+{
+	return a.bytes > b.bytes;
+}
+
+SizeProfiler::SizeProfiler(BMessenger target)
+: fTarget(target),
+  fCanceled(0),
+  fBase(NULL),
+  fSize(0),
+  fDone(0),
+  fNextReport(0),
+  fVisited(0),
+  fTotal(0),
+  fMessages(0)
+{
+}
+
+status_t
+SizeProfiler::Run(const uint8* data, size_t size)
+{
+	fBase = data;
+	fSize = size;
+	fNextReport = system_time() + kReportInterval;
+
+	// A file may hold several messages back to back, profile all of them
+	status_t status = B_OK;
+	size_t offset = 0;
+	while(offset < size && !IsCanceled()) {
+		FlatMessageReader reader(data + offset, size - offset);
+		if(reader.InitCheck() != B_OK) {
+			// Trailing bytes after the first message are not an error
+			if(fMessages == 0)
+				status = reader.InitCheck();
+			break;
+		}
+
+		fTypeBytes[B_MESSAGE_TYPE] += sizeof(flat_message_header);
+		fTotal += reader.FlattenedSize();
+		fPath.clear();
+
+		status = _WalkMessage(data + offset, size - offset, -1, 0);
+		if(status != B_OK)
+			break;
+
+		fMessages++;
+		offset += reader.FlattenedSize();
+		fDone = offset;
+	}
+
+	if(IsCanceled())
+		status = B_CANCELED;
+	_Report(SP_FINISHED, status);
+	return status;
+}
+
+void
+SizeProfiler::Cancel()
+{
+	atomic_set(&fCanceled, 1);
+}
+
+bool
+SizeProfiler::IsCanceled() const
+{
+	return atomic_get(const_cast<int32*>(&fCanceled)) != 0;
+}
+
+// #pragma mark - SizeProfiler::Private
+
+status_t
+SizeProfiler::_WalkMessage(const uint8* data, size_t size, int32 parent,
+	int32 depth)
+{
+	FlatMessageReader reader(data, size);
+	if(reader.InitCheck() != B_OK)
+		return reader.InitCheck();
+
+	for(int32 i = 0; i < reader.CountFields(); i++) {
+		flat_field_header field;
+		status_t status = reader.FieldAt(i, &field);
+		if(status != B_OK)
+			return status;
+
+		const char* name = reader.FieldName(field);
+		if(!name)
+			return B_BAD_DATA;
+
+		uint64 bytes = sizeof(flat_field_header) + field.name_length
+			+ field.data_size;
+		int32 index = _EntryFor(parent, name, field.type);
+		if(index < 0)
+			return B_NO_MEMORY;
+		fEntries[index].bytes += bytes;
+		fEntries[index].items += field.count;
+		fEntries[index].occurrences++;
+
+		if(field.type != B_MESSAGE_TYPE) {
+			fTypeBytes[field.type] += bytes;
+			_MaybeReport();
+			if(IsCanceled())
+				return B_CANCELED;
+			continue;
+		}
+
+		// Nested data is accounted to its own types; the message fields
+		// themselves only own their headers and the item lengths
+		fTypeBytes[B_MESSAGE_TYPE] += bytes;
+
+		// Each level takes a frame of the profiler thread's stack
+		if(depth >= kMaxNesting)
+			return B_BAD_DATA;
+
+		size_t pathLength = fPath.length();
+		flat_item item;
+		for(status = reader.FirstItem(field, &item); status == B_OK;
+			status = reader.NextItem(field, &item)) {
+			fPath.resize(pathLength);
+			if(pathLength > 0)
+				fPath += '/';
+			fPath += name;
+			if(field.count > 1) {
+				char index[16];
+				snprintf(index, sizeof(index), "[%" B_PRId32 "]", item.index);
+				fPath += index;
+			}
+			_AddSubtree(item.size);
+
+			FlatMessageReader nested(item.data, item.size);
+			if(nested.InitCheck() == B_OK)
+				fTypeBytes[B_MESSAGE_TYPE] -= nested.FlattenedSize()
+					- sizeof(flat_message_header);
+
+			fDone = std::max(fDone, (size_t)(item.data - fBase));
+			status_t walkStatus = _WalkMessage(item.data, item.size, index,
+				depth + 1);
+			if(walkStatus != B_OK) {
+				fPath.resize(pathLength);
+				return walkStatus;
+			}
+		}
+		fPath.resize(pathLength);
+
+		if(status != B_BAD_INDEX)
+			return status;
+	}
+
+	return B_OK;
+}
+
+int32
+SizeProfiler::_EntryFor(int32 parent, const char* name, type_code type)
+{
+	std::string key(reinterpret_cast<const char*>(&parent), sizeof(parent));
+	key += name;
+
+	std::unordered_map<std::string, int32>::iterator found
+		= fEntryIndex.find(key);
+	if(found != fEntryIndex.end())
+		return found->second;
+
+	profile_entry entry;
+	entry.name = name;
+	entry.type = type;
+	entry.parent = parent;
+	entry.bytes = 0;
+	entry.items = 0;
+	entry.occurrences = 0;
+
+	int32 index = fEntries.size();
+	fEntries.push_back(entry);
+	fEntryIndex[key] = index;
+	return index;
+}
+
+void
+SizeProfiler::_AddSubtree(uint64 bytes)
+{
+	if((int32)fSubtrees.size() >= kMaxSubtrees) {
+		if(bytes <= fSubtrees.front().bytes)
+			return;
+		std::pop_heap(fSubtrees.begin(), fSubtrees.end(), subtree_greater);
+		fSubtrees.pop_back();
+	}
+
+	profile_subtree subtree;
+	subtree.path = fPath.c_str();
+	subtree.bytes = bytes;
+	fSubtrees.push_back(subtree);
+	std::push_heap(fSubtrees.begin(), fSubtrees.end(), subtree_greater);
+}
+
+void
+SizeProfiler::_MaybeReport()
+{
+	// Asking for the time on every field would cost more than the walk
+	if(++fVisited % kTimeCheckInterval != 0)
+		return;
+
+	bigtime_t now = system_time();
+	if(now < fNextReport)
+		return;
+
+	_Report(SP_PROGRESS, B_OK);
+	fNextReport = now + kReportInterval;
+}
+
+void
+SizeProfiler::_Report(uint32 what, status_t status)
+{
+	BMessage report(what);
+	report.AddInt32("status", status);
+	report.AddUInt64("done", what == SP_FINISHED ? fSize : fDone);
+	report.AddUInt64("size", fSize);
+	report.AddUInt64("total", fTotal);
+	report.AddUInt32("messages", fMessages);
+
+	for(size_t i = 0; i < fEntries.size(); i++) {
+		const profile_entry& entry = fEntries[i];
+		report.AddString("name", entry.name);
+		report.AddUInt32("type", entry.type);
+		report.AddInt32("parent", entry.parent);
+		report.AddUInt64("bytes", entry.bytes);
+		report.AddUInt64("items", entry.items);
+		report.AddUInt64("occurrences", entry.occurrences);
+	}
+
+	for(std::map<type_code, uint64>::const_iterator it = fTypeBytes.begin();
+		it != fTypeBytes.end(); ++it) {
+		report.AddUInt32("type_code", it->first);
+		report.AddUInt64("type_bytes", it->second);
+	}
+
+	for(size_t i = 0; i < fSubtrees.size(); i++) {
+		report.AddString("subtree_path", fSubtrees[i].path);
+		report.AddUInt64("subtree_bytes", fSubtrees[i].bytes);
+	}
+
+	fTarget.SendMessage(&report);
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef __SIZE_PROFILER_H__
+#define __SIZE_PROFILER_H__
+
+#include <Messenger.h>
+#include <String.h>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum {
+	SP_PROGRESS = 'sp00',
+	SP_FINISHED
+};
+
+struct profile_entry {
+	BString		name;
+	type_code	type;
+	int32		parent;		// index of the enclosing field, -1 at the top
+	uint64		bytes;		// headers, name and items, nested data included
+	uint64		items;
+	uint64		occurrences;
+};
+
+struct profile_subtree {
+	BString		path;		// with member indices, e.g. "items[3]/child"
+	uint64		bytes;
+};
+
+/*	Streaming pass over one or more flattened messages in memory. Field
+	occurrences are merged by name and position in the hierarchy (the
+	member index is ignored), bytes are summed per type and the largest
+	nested messages are remembered by their full path. Messages nested
+	deeper than kMaxNesting are B_BAD_DATA. While it runs it posts
+	SP_PROGRESS snapshots to the target, then a SP_FINISHED one.
+*/
+class SizeProfiler
+{
+public:
+	static	const int32		kMaxSubtrees = 50;
+	static	const int32		kMaxNesting = 64;
+
+							SizeProfiler(BMessenger target);
+
+			status_t		Run(const uint8* data, size_t size);
+			void			Cancel();
+			bool			IsCanceled() const;
+private:
+			status_t		_WalkMessage(const uint8* data, size_t size,
+								int32 parent, int32 depth);
+			int32			_EntryFor(int32 parent, const char* name,
+								type_code type);
+			void			_AddSubtree(uint64 bytes);
+			void			_MaybeReport();
+			void			_Report(uint32 what, status_t status);
+private:
+			BMessenger		fTarget;
+			int32			fCanceled;
+
+			const uint8*	fBase;
+			size_t			fSize;
+			size_t			fDone;
+			bigtime_t		fNextReport;
+			uint32			fVisited;
+
+			std::vector<profile_entry>	fEntries;
+			std::unordered_map<std::string, int32> fEntryIndex;
+			std::map<type_code, uint64> fTypeBytes;
+			std::vector<profile_subtree> fSubtrees;	// min-heap on bytes
+			std::string		fPath;
+			uint64			fTotal;
+			uint32			fMessages;
+};
+
+#endif /* __SIZE_PROFILER_H__ */
@@ -0,0 +1,490 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#include <Catalog.h>
+#include <LayoutBuilder.h>
+#include <Path.h>
+#include <StringForSize.h>
+#include <TabView.h>
+#include <private/interface/ColumnTypes.h>
+#include <algorithm>
+#include <vector>
+
+#include "blockcontainer.h"
+#include "gettype.h"
+#include "sizeprofilewindow.h"
+
+#undef B_TRANSLATION_CONTEXT
+#define B_TRANSLATION_CONTEXT "SizeProfileWindow"
+
+static const int32 kTreemapDepth = 4;
+static const float kTreemapMinSide = 4.0f;
+
+static BString
+share_string(uint64 bytes, uint64 total)
+{
+	BString share;
+	share.SetToFormat("%.1f %%", total > 0 ? bytes * 100.0 / total : 0.0);
+	return share;
+}
+
+// #pragma mark - TreemapView
+
+TreemapView::TreemapView()
+: BView("treemap", B_WILL_DRAW | B_FRAME_EVENTS | B_FULL_UPDATE_ON_RESIZE),
+  fTotal(0),
+  fHovered(-1)
+{
+	SetExplicitMinSize(BSize(200, 150));
+}
+
+void
+TreemapView::Draw(BRect updateRect)
+{
+	SetHighUIColor(B_DOCUMENT_BACKGROUND_COLOR);
+	FillRect(updateRect);
+
+	for(size_t i = 0; i < fRoots.size(); i++)
+		_DrawNode(fRoots[i], 0);
+}
+
+void
+TreemapView::FrameResized(float newWidth, float newHeight)
+{
+	_Layout(fRoots, Bounds(), fTotal, 0);
+	BView::FrameResized(newWidth, newHeight);
+}
+
+void
+TreemapView::MouseMoved(BPoint where, uint32 code, const BMessage* dragMessage)
+{
+	// The deepest node under the pointer is the most specific one
+	int32 hovered = -1;
+	const std::vector<int32>* level = &fRoots;
+	for(int32 depth = 0; depth < kTreemapDepth; depth++) {
+		int32 found = -1;
+		for(size_t i = 0; i < level->size(); i++) {
+			if(fNodes[(*level)[i]].frame.Contains(where)) {
+				found = (*level)[i];
+				break;
+			}
+		}
+		if(found < 0)
+			break;
+		hovered = found;
+		level = &fNodes[found].children;
+	}
+
+	if(hovered != fHovered) {
+		fHovered = hovered;
+		if(hovered < 0)
+			SetToolTip((const char*)NULL);
+		else {
+			char size[64];
+			BString tip(_PathFor(hovered));
+			tip << "\n" << BPrivate::string_for_size(fNodes[hovered].bytes,
+				size, sizeof(size));
+			SetToolTip(tip.String());
+		}
+	}
+
+	BView::MouseMoved(where, code, dragMessage);
+}
+
+void
+TreemapView::SetTo(const BMessage* snapshot)
+{
+	fNodes.clear();
+	fRoots.clear();
+	fHovered = -1;
+	fTotal = 0;
+
+	const char* name;
+	for(int32 i = 0; snapshot->FindString("name", i, &name) == B_OK; i++) {
+		node item;
+		item.name = name;
+		item.bytes = snapshot->GetUInt64("bytes", i, 0);
+		item.parent = snapshot->GetInt32("parent", i, -1);
+		fNodes.push_back(item);
+
+		// Parents always come before their children
+		if(item.parent >= 0 && item.parent < i)
+			fNodes[item.parent].children.push_back(i);
+		else {
+			fRoots.push_back(i);
+			fTotal += item.bytes;
+		}
+	}
+
+	_Layout(fRoots, Bounds(), fTotal, 0);
+	Invalidate();
+}
+
+// #pragma mark - TreemapView::Private
+
+void
+TreemapView::_Layout(const std::vector<int32>& children, BRect frame,
+	uint64 total, int32 depth)
+{
+	if(depth >= kTreemapDepth || total == 0)
+		return;
+
+	// Slice and dice: split along the longer side, biggest first
+	std::vector<int32> sorted(children);
+	std::sort(sorted.begin(), sorted.end(), [this](int32 a, int32 b) {
+		return fNodes[a].bytes > fNodes[b].bytes;
+	});
+
+	bool horizontal = frame.Width() >= frame.Height();
+	float length = horizontal ? frame.Width() : frame.Height();
+	float position = horizontal ? frame.left : frame.top;
+	for(size_t i = 0; i < sorted.size(); i++) {
+		node& item = fNodes[sorted[i]];
+		float extent = length * item.bytes / total;
+
+		item.frame = frame;
+		if(horizontal) {
+			item.frame.left = position;
+			item.frame.right = position + extent - 1;
+		} else {
+			item.frame.top = position;
+			item.frame.bottom = position + extent - 1;
+		}
+		position += extent;
+
+		BRect inner = item.frame.InsetByCopy(2, 2);
+		inner.top += depth == 0 ? be_plain_font->Size() + 4 : 0;
+		if(inner.Width() >= kTreemapMinSide && inner.Height() >= kTreemapMinSide)
+			_Layout(item.children, inner, item.bytes, depth + 1);
+	}
+}
+
+void
+TreemapView::_DrawNode(int32 index, int32 depth)
+{
+	const node& item = fNodes[index];
+	if(item.frame.Width() < 1 || item.frame.Height() < 1)
+		return;
+
+	static const rgb_color kPalette[] = {
+		{ 102, 152, 203, 255 }, { 232, 148, 81, 255 }, { 120, 182, 110, 255 },
+		{ 205, 110, 120, 255 }, { 156, 132, 196, 255 }, { 214, 190, 90, 255 }
+	};
+	rgb_color color = kPalette[index % (sizeof(kPalette) / sizeof(kPalette[0]))];
+	color = tint_color(color, 1.0f - depth * 0.12f); // lighter when deeper
+
+	SetHighColor(color);
+	FillRect(item.frame);
+	SetHighUIColor(B_CONTROL_BORDER_COLOR);
+	StrokeRect(item.frame);
+
+	font_height height;
+	GetFontHeight(&height);
+	if(item.frame.Height() > height.ascent + height.descent + 4) {
+		BString label(item.name);
+		be_plain_font->TruncateString(&label, B_TRUNCATE_END,
+			item.frame.Width() - 6);
+		if(label.Length() > 0) {
+			SetHighColor(0, 0, 0);
+			SetLowColor(color);
+			DrawString(label.String(), BPoint(item.frame.left + 3,
+				item.frame.top + height.ascent + 2));
+		}
+	}
+
+	if(depth + 1 < kTreemapDepth) {
+		for(size_t i = 0; i < item.children.size(); i++)
+			_DrawNode(item.children[i], depth + 1);
+	}
+}
+
+BString
+TreemapView::_PathFor(int32 index) const
+{
+	BString path(fNodes[index].name);
+	for(int32 parent = fNodes[index].parent; parent >= 0;
+		parent = fNodes[parent].parent)
+		path.Prepend("/").Prepend(fNodes[parent].name);
+	return path;
+}
+
+// #pragma mark - SizeProfileWindow
+
+SizeProfileWindow::SizeProfileWindow(BRect frame, const entry_ref& ref)
+: BWindow(frame, B_TRANSLATE("Size profile"), B_DOCUMENT_WINDOW,
+	B_ASYNCHRONOUS_CONTROLS | B_AUTO_UPDATE_SIZE_LIMITS),
+  fRef(ref),
+  fProfiler(NULL),
+  fThread(-1)
+{
+	BString title(B_TRANSLATE("Size profile"));
+	title << ": " << ref.name;
+	SetTitle(title.String());
+
+	fProgress = new BStatusBar("progress");
+	fProgress->SetMaxValue(1.0f);
+
+	fFieldList = new BColumnListView(B_TRANSLATE("Fields"), 0, B_NO_BORDER);
+	fFieldList->AddColumn(new BStringColumn(B_TRANSLATE("Name"), 200, 50, 1000, 0), 0);
+	fFieldList->AddColumn(new BStringColumn(B_TRANSLATE("Type"), 150, 50, 1000, 0), 1);
+	fFieldList->AddColumn(new BIntegerColumn(B_TRANSLATE("Occurrences"), 90, 10, 150), 2);
+	fFieldList->AddColumn(new BIntegerColumn(B_TRANSLATE("Items"), 90, 10, 150), 3);
+	fFieldList->AddColumn(new BSizeColumn(B_TRANSLATE("Size"), 90, 10, 150, B_ALIGN_RIGHT), 4);
+	fFieldList->AddColumn(new BStringColumn(B_TRANSLATE("Share"), 70, 10, 100, 0, B_ALIGN_RIGHT), 5);
+	fFieldList->SetSortColumn(fFieldList->ColumnAt(4), false, false);
+
+	fTypeList = new BColumnListView(B_TRANSLATE("Types"), 0, B_NO_BORDER);
+	fTypeList->AddColumn(new BStringColumn(B_TRANSLATE("Type"), 200, 50, 1000, 0), 0);
+	fTypeList->AddColumn(new BSizeColumn(B_TRANSLATE("Size"), 90, 10, 150, B_ALIGN_RIGHT), 1);
+	fTypeList->AddColumn(new BStringColumn(B_TRANSLATE("Share"), 70, 10, 100, 0, B_ALIGN_RIGHT), 2);
+	fTypeList->SetSortColumn(fTypeList->ColumnAt(1), false, false);
+
+	fSubtreeList = new BColumnListView(B_TRANSLATE("Subtrees"), 0, B_NO_BORDER);
+	fSubtreeList->AddColumn(new BStringColumn(B_TRANSLATE("Path"), 300, 50, 2000, 0), 0);
+	fSubtreeList->AddColumn(new BSizeColumn(B_TRANSLATE("Size"), 90, 10, 150, B_ALIGN_RIGHT), 1);
+	fSubtreeList->AddColumn(new BStringColumn(B_TRANSLATE("Share"), 70, 10, 100, 0, B_ALIGN_RIGHT), 2);
+	fSubtreeList->SetSortColumn(fSubtreeList->ColumnAt(1), false, false);
+
+	BTabView* tabView = new BTabView("tabs");
+	tabView->AddTab(fFieldList);
+	tabView->AddTab(fTypeList);
+	tabView->AddTab(fSubtreeList);
+
+	fTreemap = new TreemapView();
+
+	BLayoutBuilder::Group<>(this, B_VERTICAL, B_USE_SMALL_SPACING)
+		.SetInsets(B_USE_SMALL_INSETS)
+		.Add(fProgress)
+		.AddSplit(B_HORIZONTAL, B_USE_SMALL_SPACING)
+			.Add(tabView, 0.6f)
+			.Add(fTreemap, 0.4f)
+		.End()
+	.End();
+
+	AddShortcut('W', B_COMMAND_KEY, new BMessage(B_QUIT_REQUESTED));
+
+	status_t status = fFile.SetTo(&fRef);
+	if(status == B_OK) {
+		fProfiler = new SizeProfiler(BMessenger(this));
+		fThread = spawn_thread(_ProfileThread, "size profiler",
+			B_LOW_PRIORITY, this);
+		if(fThread >= 0)
+			resume_thread(fThread);
+		else
+			status = fThread;
+	}
+
+	if(status != B_OK) {
+		BString error;
+		error.SetToFormat(B_TRANSLATE("Could not read the file: %s"),
+			strerror(status));
+		fProgress->SetText(error.String());
+	}
+}
+
+SizeProfileWindow::~SizeProfileWindow()
+{
+	_StopProfiling();
+	delete fProfiler;
+}
+
+void
+SizeProfileWindow::MessageReceived(BMessage* msg)
+{
+	switch(msg->what)
+	{
+		case SP_PROGRESS:
+			_ShowSnapshot(msg);
+			break;
+
+		case SP_FINISHED:
+		{
+			_ShowSnapshot(msg);
+
+			status_t status = msg->GetInt32("status", B_OK);
+			if(status == B_OK) {
+				BString text;
+				text.SetToFormat(B_TRANSLATE("%" B_PRIu32 " message(s) profiled"),
+					msg->GetUInt32("messages", 0));
+				fProgress->SetText(text.String());
+			} else if(status != B_CANCELED) {
+				BString error;
+				error.SetToFormat(B_TRANSLATE("The file could not be fully "
+					"profiled: %s"), strerror(status));
+				fProgress->SetText(error.String());
+			}
+			break;
+		}
+
+		default:
+			BWindow::MessageReceived(msg);
+			break;
+	}
+}
+
+bool
+SizeProfileWindow::QuitRequested()
+{
+	_StopProfiling();
+	return true;
+}
+
+// #pragma mark - SizeProfileWindow::Private
+
+status_t
+SizeProfileWindow::_ProfileThread(void* data)
+{
+	SizeProfileWindow* window = static_cast<SizeProfileWindow*>(data);
+	const uint8* bytes = window->fFile.Data();
+	size_t size = window->fFile.Size();
+
+	// The sizes are those of the message, not of its compressed blocks.
+	// A container that can not be inflated is profiled as it is and
+	// reported as bad data.
+	std::vector<uint8> inflated;
+	if(is_block_container(bytes, size)) {
+		BMemoryIO io(bytes, size);
+		BlockContainerIO container;
+		off_t rawSize;
+		if(container.SetTo(&io) == B_OK
+			&& container.GetSize(&rawSize) == B_OK) {
+			inflated.resize(rawSize);
+			if(container.ReadAt(0, inflated.data(), rawSize) == rawSize) {
+				bytes = inflated.data();
+				size = inflated.size();
+			}
+		}
+	}
+
+	return window->fProfiler->Run(bytes, size);
+}
+
+void
+SizeProfileWindow::_StopProfiling()
+{
+	if(fThread < 0)
+		return;
+
+	fProfiler->Cancel();
+
+	// The thread may be waiting for our port to accept a report, let it
+	// through while we wait for it
+	thread_id thread = fThread;
+	fThread = -1;
+	bool locked = IsLocked();
+	if(locked)
+		Unlock();
+	status_t result;
+	wait_for_thread(thread, &result);
+	if(locked)
+		Lock();
+}
+
+void
+SizeProfileWindow::_ShowSnapshot(const BMessage* snapshot)
+{
+	uint64 size = snapshot->GetUInt64("size", 0);
+	uint64 done = snapshot->GetUInt64("done", 0);
+	uint64 total = snapshot->GetUInt64("total", 0);
+
+	char doneText[64];
+	char sizeText[64];
+	BString trailing;
+	trailing << BPrivate::string_for_size(done, doneText, sizeof(doneText))
+		<< " / " << BPrivate::string_for_size(size, sizeText, sizeof(sizeText));
+	fProgress->SetTo(size > 0 ? (float)done / size : 1.0f, NULL,
+		trailing.String());
+
+	_ShowEntries(snapshot, total);
+	_ShowTypes(snapshot, total);
+	_ShowSubtrees(snapshot, total);
+	fTreemap->SetTo(snapshot);
+}
+
+void
+SizeProfileWindow::_ShowEntries(const BMessage* snapshot, uint64 total)
+{
+	// Entries only ever get appended, so rows are updated in place and
+	// the selection and scroll position survive each snapshot
+	const char* name;
+	for(int32 i = 0; snapshot->FindString("name", i, &name) == B_OK; i++) {
+		uint64 bytes = snapshot->GetUInt64("bytes", i, 0);
+		uint64 items = snapshot->GetUInt64("items", i, 0);
+		uint64 occurrences = snapshot->GetUInt64("occurrences", i, 0);
+
+		BRow* row;
+		if(i < (int32)fFieldRows.size()) {
+			row = fFieldRows[i];
+			static_cast<BIntegerField*>(row->GetField(2))->SetValue(
+				std::min<uint64>(occurrences, INT32_MAX));
+			static_cast<BIntegerField*>(row->GetField(3))->SetValue(
+				std::min<uint64>(items, INT32_MAX));
+			static_cast<BSizeField*>(row->GetField(4))->SetSize(bytes);
+			static_cast<BStringField*>(row->GetField(5))->SetString(
+				share_string(bytes, total));
+			fFieldList->UpdateRow(row);
+			continue;
+		}
+
+		row = new BRow();
+		row->SetField(new BStringField(name), 0);
+		row->SetField(new BStringField(get_type(
+			snapshot->GetUInt32("type", i, B_ANY_TYPE))), 1);
+		row->SetField(new BIntegerField(std::min<uint64>(occurrences, INT32_MAX)), 2);
+		row->SetField(new BIntegerField(std::min<uint64>(items, INT32_MAX)), 3);
+		row->SetField(new BSizeField(bytes), 4);
+		row->SetField(new BStringField(share_string(bytes, total)), 5);
+
+		int32 parent = snapshot->GetInt32("parent", i, -1);
+		BRow* parentRow = parent >= 0 && parent < (int32)fFieldRows.size()
+			? fFieldRows[parent] : NULL;
+		fFieldList->AddRow(row, parentRow);
+		fFieldRows.push_back(row);
+	}
+}
+
+void
+SizeProfileWindow::_ShowTypes(const BMessage* snapshot, uint64 total)
+{
+	type_code type;
+	for(int32 i = 0; snapshot->FindUInt32("type_code", i, &type) == B_OK; i++) {
+		uint64 bytes = snapshot->GetUInt64("type_bytes", i, 0);
+
+		std::map<type_code, BRow*>::iterator found = fTypeRows.find(type);
+		if(found != fTypeRows.end()) {
+			BRow* row = found->second;
+			static_cast<BSizeField*>(row->GetField(1))->SetSize(bytes);
+			static_cast<BStringField*>(row->GetField(2))->SetString(
+				share_string(bytes, total));
+			fTypeList->UpdateRow(row);
+			continue;
+		}
+
+		BRow* row = new BRow();
+		row->SetField(new BStringField(get_type(type)), 0);
+		row->SetField(new BSizeField(bytes), 1);
+		row->SetField(new BStringField(share_string(bytes, total)), 2);
+		fTypeList->AddRow(row);
+		fTypeRows[type] = row;
+	}
+}
+
+void
+SizeProfileWindow::_ShowSubtrees(const BMessage* snapshot, uint64 total)
+{
+	// Only the largest few are kept, replacing them is cheap
+	fSubtreeList->Clear();
+
+	const char* path;
+	for(int32 i = 0; snapshot->FindString("subtree_path", i, &path) == B_OK; i++) {
+		uint64 bytes = snapshot->GetUInt64("subtree_bytes", i, 0);
+
+		BRow* row = new BRow();
+		row->SetField(new BStringField(path), 0);
+		row->SetField(new BSizeField(bytes), 1);
+		row->SetField(new BStringField(share_string(bytes, total)), 2);
+		fSubtreeList->AddRow(row);
+	}
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef __SIZE_PROFILE_WINDOW_H__
+#define __SIZE_PROFILE_WINDOW_H__
+
+#include <Entry.h>
+#include <StatusBar.h>
+#include <View.h>
+#include <Window.h>
+#include <private/interface/ColumnListView.h>
+#include <map>
+#include <vector>
+
+#include "mappedfile.h"
+#include "sizeprofiler.h"
+
+class TreemapView : public BView
+{
+public:
+					TreemapView();
+
+	virtual void	Draw(BRect updateRect);
+	virtual	void	FrameResized(float newWidth, float newHeight);
+	virtual	void	MouseMoved(BPoint where, uint32 code,
+						const BMessage* dragMessage);
+
+			void	SetTo(const BMessage* snapshot);
+private:
+	struct node {
+		BString		name;
+		uint64		bytes;
+		int32		parent;
+		BRect		frame;
+		std::vector<int32> children;
+	};
+
+			void	_Layout(const std::vector<int32>& children, BRect frame,
+						uint64 total, int32 depth);
+			void	_DrawNode(int32 index, int32 depth);
+			BString	_PathFor(int32 index) const;
+private:
+	std::vector<node>	fNodes;
+	std::vector<int32>	fRoots;
+	uint64				fTotal;
+	int32				fHovered;
+};
+
+class SizeProfileWindow : public BWindow
+{
+public:
+					SizeProfileWindow(BRect frame, const entry_ref& ref);
+	virtual			~SizeProfileWindow();
+
+	virtual void	MessageReceived(BMessage* msg);
+	virtual	bool	QuitRequested();
+private:
+	static	status_t _ProfileThread(void* data);
+
+			void	_StopProfiling();
+			void	_ShowSnapshot(const BMessage* snapshot);
+			void	_ShowEntries(const BMessage* snapshot, uint64 total);
+			void	_ShowTypes(const BMessage* snapshot, uint64 total);
+			void	_ShowSubtrees(const BMessage* snapshot, uint64 total);
+private:
+	entry_ref			fRef;
+	MappedFile			fFile;
+	SizeProfiler*		fProfiler;
+	thread_id			fThread;
+
+	BStatusBar*			fProgress;
+	BColumnListView*	fFieldList;
+	BColumnListView*	fTypeList;
+	BColumnListView*	fSubtreeList;
+	TreemapView*		fTreemap;
+
+	std::vector<BRow*>	fFieldRows;		// same order as the profiler entries
+	std::map<type_code, BRow*> fTypeRows;
+};
+
+#endif /* __SIZE_PROFILE_WINDOW_H__ */
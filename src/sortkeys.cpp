@@ -0,0 +1,180 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#include <algorithm>
+#include <cstring>
+#include <strings.h>
+#include <utility>
+#include "numericitem.h"
+#include "sortkeys.h"
+
+// Case insensitive first, so that equal looking names still have an order
+static int
+compare_text(const char* a, const char* b)
+{
+	int result = strcasecmp(a, b);
+	return result != 0 ? result : strcmp(a, b);
+}
+
+StringTable::StringTable()
+: fRanksValid(true)
+{
+}
+
+int32
+StringTable::Intern(const char* string)
+{
+	auto result = fIds.insert(std::make_pair(std::string(string),
+		(int32)fStrings.size()));
+	if(result.second) {
+		fStrings.push_back(result.first->first.c_str());
+		fRanksValid = false;
+	}
+	return result.first->second;
+}
+
+int32
+StringTable::Rank(int32 id)
+{
+	if(!fRanksValid)
+		_UpdateRanks();
+	return fRanks[id];
+}
+
+void
+StringTable::MakeEmpty()
+{
+	fIds.clear();
+	fStrings.clear();
+	fRanks.clear();
+	fRanksValid = true;
+}
+
+// Sorts the distinct strings only, which are far fewer than the rows
+void
+StringTable::_UpdateRanks()
+{
+	std::vector<int32> order(fStrings.size());
+	for(size_t i = 0; i < order.size(); i++)
+		order[i] = i;
+	std::sort(order.begin(), order.end(), [this](int32 a, int32 b) {
+		return compare_text(fStrings[a], fStrings[b]) < 0;
+	});
+
+	fRanks.resize(order.size());
+	for(size_t i = 0; i < order.size(); i++)
+		fRanks[order[i]] = i;
+	fRanksValid = true;
+}
+
+// #pragma mark - Items
+
+template<typename T>
+static void
+rank_typed(const void* const* items, int32 count, int32* ranks)
+{
+	typedef std::pair<T, int32> key;
+
+	std::vector<key> keys;
+	std::vector<int32> missing;
+	keys.reserve(count);
+	for(int32 i = 0; i < count; i++) {
+		if(!items[i]) {
+			missing.push_back(i);
+			continue;
+		}
+		T value;
+		memcpy(&value, items[i], sizeof(T));
+		keys.push_back(key(value, i));
+	}
+
+	std::sort(keys.begin(), keys.end(), [](const key& a, const key& b) {
+		bool aNaN = a.first != a.first;
+		bool bNaN = b.first != b.first;
+		if(aNaN != bNaN)
+			return bNaN;
+		if(!aNaN && a.first != b.first)
+			return a.first < b.first;
+		return a.second < b.second;
+	});
+
+	int32 position = 0;
+	for(const auto& it : keys)
+		ranks[it.second] = position++;
+	for(int32 index : missing)
+		ranks[index] = position++;
+}
+
+bool
+rank_numbers(type_code type, const void* const* items, const ssize_t* sizes,
+	int32 count, int32* ranks)
+{
+	ssize_t size = -1;
+	for(int32 i = 0; i < count; i++) {
+		if(!items[i])
+			continue;
+		if(size >= 0 && sizes[i] != size)
+			return false;
+		size = sizes[i];
+	}
+
+	switch(storage_of(type, size < 0 ? native_size(type) : size)) {
+		case STORAGE_INT8:
+			rank_typed<int8>(items, count, ranks);
+			break;
+		case STORAGE_INT16:
+			rank_typed<int16>(items, count, ranks);
+			break;
+		case STORAGE_INT32:
+			rank_typed<int32>(items, count, ranks);
+			break;
+		case STORAGE_INT64:
+			rank_typed<int64>(items, count, ranks);
+			break;
+		case STORAGE_UINT8:
+			rank_typed<uint8>(items, count, ranks);
+			break;
+		case STORAGE_UINT16:
+			rank_typed<uint16>(items, count, ranks);
+			break;
+		case STORAGE_UINT32:
+			rank_typed<uint32>(items, count, ranks);
+			break;
+		case STORAGE_UINT64:
+			rank_typed<uint64>(items, count, ranks);
+			break;
+		case STORAGE_FLOAT:
+			rank_typed<float>(items, count, ranks);
+			break;
+		case STORAGE_DOUBLE:
+			rank_typed<double>(items, count, ranks);
+			break;
+		default:
+			return false;
+	}
+	return true;
+}
+
+void
+rank_strings(const char* const* strings, int32 count, int32* ranks)
+{
+	std::vector<int32> order(count);
+	for(int32 i = 0; i < count; i++)
+		order[i] = i;
+
+	std::sort(order.begin(), order.end(), [strings](int32 a, int32 b) {
+		if(!strings[a] != !strings[b])
+			return strings[b] == NULL;
+		if(strings[a]) {
+			int result = compare_text(strings[a], strings[b]);
+			if(result != 0)
+				return result < 0;
+		}
+		return a < b;
+	});
+
+	for(int32 i = 0; i < count; i++)
+		ranks[order[i]] = i;
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef __SORT_KEYS_H__
+#define __SORT_KEYS_H__
+
+#include <SupportDefs.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*	Interns the strings shown in a column so that rows compare by number.
+	Every distinct string gets an id once; Rank() orders the ids the way
+	BStringColumn orders text, case insensitive first, and is worked out
+	again only after new strings came in.
+*/
+class StringTable
+{
+public:
+							StringTable();
+
+			int32			Intern(const char* string);
+			int32			Rank(int32 id);
+			void			MakeEmpty();
+private:
+			void			_UpdateRanks();
+private:
+			std::unordered_map<std::string, int32> fIds;
+			std::vector<const char*> fStrings;	// by id, keys of fIds
+			std::vector<int32> fRanks;			// by id
+			bool			fRanksValid;
+};
+
+/*	Position of every item in value order, so that sorting rows on the
+	value never looks at the items again. Ties go by item index.
+
+	rank_numbers() compares numeric items as numbers, NaN last; it fails
+	for other types or when an item does not have the expected size.
+	Missing items (NULL) sort behind everything else.
+*/
+bool		rank_numbers(type_code type, const void* const* items,
+				const ssize_t* sizes, int32 count, int32* ranks);
+void		rank_strings(const char* const* strings, int32 count,
+				int32* ranks);
+
+#endif /* __SORT_KEYS_H__ */
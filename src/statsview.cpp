@@ -0,0 +1,204 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#include <Catalog.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "statsview.h"
+
+#undef B_TRANSLATION_CONTEXT
+#define B_TRANSLATION_CONTEXT "StatsView"
+
+static const float kMargin = 4.0f;
+static const float kHistogramLines = 3.0f;	// histogram height, in lines
+
+StatsView::StatsView(const char* name)
+: BView(name, B_WILL_DRAW | B_FRAME_EVENTS | B_SUPPORTS_LAYOUT),
+  fToolTipBin(-1)
+{
+	memset(&fStats, 0, sizeof(fStats));
+	_UpdateFont();
+}
+
+void
+StatsView::SetStats(const field_stats& stats)
+{
+	fStats = stats;
+	fToolTipBin = -1;
+	SetToolTip((const char*)NULL);
+	_UpdateSummary();
+	Invalidate();
+}
+
+void
+StatsView::AttachedToWindow()
+{
+	BView::AttachedToWindow();
+	SetViewColor(B_TRANSPARENT_COLOR);
+	SetLowUIColor(B_PANEL_BACKGROUND_COLOR);
+	_UpdateFont();
+}
+
+void
+StatsView::Draw(BRect updateRect)
+{
+	FillRect(updateRect, B_SOLID_LOW);
+
+	SetHighUIColor(B_PANEL_TEXT_COLOR);
+	DrawString(fSummary, BPoint(kMargin, kMargin + fAscent));
+
+	BRect frame = _HistogramFrame();
+	SetHighColor(tint_color(LowColor(), B_DARKEN_1_TINT));
+	FillRect(frame);
+	if(fStats.bins == 0)
+		return;
+
+	uint32 highest = *std::max_element(fStats.histogram,
+		fStats.histogram + fStats.bins);
+	if(highest == 0)
+		return;
+
+	// Any bin that holds an item gets at least a pixel
+	float width = frame.Width() / fStats.bins;
+	SetHighUIColor(B_CONTROL_HIGHLIGHT_COLOR);
+	for(int32 bin = 0; bin < fStats.bins; bin++) {
+		if(fStats.histogram[bin] == 0)
+			continue;
+
+		float height = std::max(1.0f,
+			floorf(frame.Height() * fStats.histogram[bin] / highest));
+		BRect bar(frame.left + floorf(bin * width), frame.bottom - height + 1,
+			frame.left + floorf((bin + 1) * width) - 1, frame.bottom);
+		if(bar.right < bar.left)
+			bar.right = bar.left;
+		FillRect(bar);
+	}
+}
+
+void
+StatsView::FrameResized(float width, float height)
+{
+	BView::FrameResized(width, height);
+	Invalidate();
+}
+
+void
+StatsView::MouseMoved(BPoint where, uint32 transit, const BMessage* dragMessage)
+{
+	int32 bin = _BinAt(where);
+	if(bin != fToolTipBin) {
+		fToolTipBin = bin;
+		if(bin < 0)
+			SetToolTip((const char*)NULL);
+		else
+			SetToolTip(_BinText(bin).String());
+	}
+
+	BView::MouseMoved(where, transit, dragMessage);
+}
+
+BSize
+StatsView::MinSize()
+{
+	return BSize(StringWidth("0") * 24,
+		kMargin * 3 + fLineHeight * (1 + kHistogramLines));
+}
+
+BSize
+StatsView::PreferredSize()
+{
+	BSize size = MinSize();
+	size.width = std::max(size.width, StringWidth(fSummary) + kMargin * 2);
+	return size;
+}
+
+// #pragma mark - StatsView::Private
+
+// Bin i holds the items with i <= (x - min) * bins / range < i + 1
+BString
+StatsView::_BinText(int32 bin) const
+{
+	double range = fStats.max - fStats.min + (fStats.integer ? 1 : 0);
+	double low = fStats.min + range * bin / fStats.bins;
+	double high = fStats.min + range * (bin + 1) / fStats.bins;
+
+	BString text;
+	if(fStats.integer) {
+		low = ceil(low);
+		high = ceil(high) - 1;
+	}
+	if(fStats.integer && low == high) {
+		text.SetToFormat(B_TRANSLATE("%s: %" B_PRIu32 " items"),
+			_FormatValue(low).String(), fStats.histogram[bin]);
+	} else {
+		text.SetToFormat(B_TRANSLATE("%s to %s: %" B_PRIu32 " items"),
+			_FormatValue(low).String(), _FormatValue(high).String(),
+			fStats.histogram[bin]);
+	}
+	return text;
+}
+
+BString
+StatsView::_FormatValue(double value) const
+{
+	BString text;
+	if(fStats.integer && fabs(value) < 1e15)
+		text.SetToFormat("%.0f", value);
+	else
+		text.SetToFormat("%.6g", value);
+	return text;
+}
+
+BRect
+StatsView::_HistogramFrame() const
+{
+	BRect bounds = Bounds();
+	return BRect(kMargin, kMargin * 2 + fLineHeight, bounds.right - kMargin,
+		bounds.bottom - kMargin);
+}
+
+int32
+StatsView::_BinAt(BPoint where) const
+{
+	BRect frame = _HistogramFrame();
+	if(fStats.bins == 0 || !frame.Contains(where))
+		return -1;
+
+	int32 bin = (int32)((where.x - frame.left) * fStats.bins
+		/ (frame.Width() + 1));
+	return std::min(bin, fStats.bins - 1);
+}
+
+void
+StatsView::_UpdateFont()
+{
+	font_height height;
+	GetFontHeight(&height);
+	fAscent = ceilf(height.ascent);
+	fLineHeight = ceilf(height.ascent + height.descent + height.leading);
+}
+
+void
+StatsView::_UpdateSummary()
+{
+	fSummary.SetToFormat(B_TRANSLATE("%" B_PRId32 " items"), fStats.count);
+	if(fStats.finite > 0) {
+		BString figures;
+		figures.SetToFormat(
+			B_TRANSLATE("min %s, max %s, mean %s, std. dev. %s"),
+			_FormatValue(fStats.min).String(), _FormatValue(fStats.max).String(),
+			BString().SetToFormat("%.6g", fStats.mean).String(),
+			BString().SetToFormat("%.6g", fStats.stddev).String());
+		fSummary << "  " << figures;
+	}
+	if(fStats.nans > 0 || fStats.infinities > 0) {
+		BString excluded;
+		excluded.SetToFormat(B_TRANSLATE("NaN %" B_PRId32 ", Inf %" B_PRId32),
+			fStats.nans, fStats.infinities);
+		fSummary << "  " << excluded;
+	}
+	InvalidateLayout();
+}
@@ -0,0 +1,46 @@
+/*
+ * Copyright 2026 Cafeina <cafeina@world>
+ * All rights reserved. Distributed under the terms of the MIT license.
+ *
+ */
+#ifndef __STATS_VIEW_H__
+#define __STATS_VIEW_H__
+
+#include <View.h>
+#include "fieldstats.h"
+
+/*	Summary strip under the item list of a numeric field: one line of
+	figures and the histogram of the finite items. Hovering a bar shows
+	its range and count as a tool tip.
+*/
+class StatsView : public BView
+{
+public:
+							StatsView(const char* name);
+
+			void			SetStats(const field_stats& stats);
+
+	virtual	void			AttachedToWindow();
+	virtual	void			Draw(BRect updateRect);
+	virtual	void			FrameResized(float width, float height);
+	virtual	void			MouseMoved(BPoint where, uint32 transit,
+								const BMessage* dragMessage);
+	virtual	BSize			MinSize();
+	virtual	BSize			PreferredSize();
+private:
+			BString			_BinText(int32 bin) const;
+			BString			_FormatValue(double value) const;
+			BRect			_HistogramFrame() const;
+			int32			_BinAt(BPoint where) const;
+			void			_UpdateFont();
+			void			_UpdateSummary();
+private:
+			field_stats		fStats;
+			BString			fSummary;
+			int32			fToolTipBin;
+
+			float			fLineHeight;
+			float			fAscent;
+};
+
+#endif /* __STATS_VIEW_H__ */
@@ -45,6 +45,13 @@ static predefined_cmds app_defs [] = {
 	// PREDEFINED_ENTRY(B_CONTROL_MODIFIED),
 };
 
+const predefined_cmds*
+predefined_whats(int32* count)
+{
+	*count = sizeof(app_defs) / sizeof(app_defs[0]);
+	return app_defs;
+}
+
 #undef B_TRANSLATION_CONTEXT
 #define B_TRANSLATION_CONTEXT "What window?"
 
@@ -50,4 +50,7 @@ struct predefined_cmds {
 	const char* name;
 };
 
+// The system message codes offered by the window, for other choosers
+const predefined_cmds* predefined_whats(int32* count);
+
 #endif /* __WHAT_WINDOW__*/